@@ -0,0 +1,964 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <logging/log.h>
+#include <zephyr.h>
+#include <string.h>
+#include <sys/ring_buffer.h>
+#include "slm_cmux.h"
+
+LOG_MODULE_REGISTER(cmux, CONFIG_SLM_LOG_LEVEL);
+
+#define BASIC_FLAG		0xF9
+#define ADVANCED_FLAG		0x7E
+#define ADVANCED_ESCAPE		0x7D
+#define ADVANCED_XOR		0x20
+
+/* Address, control, length and message type fields */
+#define EA			0x01
+#define CR			0x02
+#define PF			0x10
+
+#define FCS_INIT		0xFF
+#define FCS_GOOD		0xCF
+
+/* Control channel message types, without EA and C/R bits */
+#define MSG_PN			0x80
+#define MSG_CLD			0xC0
+#define MSG_TEST		0x20
+#define MSG_FCON		0xA0
+#define MSG_FCOFF		0x60
+#define MSG_MSC			0xE0
+#define MSG_NSC			0x10
+
+/* V.24 signals in MSC */
+#define MSC_FC			0x02
+#define MSC_RTC			0x04
+#define MSC_RTR			0x08
+#define MSC_DV			0x80
+
+/* Parameter negotiation. The convergence layer values for credit based
+ * flow control are the ones used by Bluetooth RFCOMM, with the initial
+ * credits in the window size field.
+ */
+#define PN_LEN			8
+#define PN_CL_MASK		0xF0
+#define PN_CL_CREDIT_REQ	0xF0
+#define PN_CL_CREDIT_RSP	0xE0
+#define PN_K_MASK		0x07
+
+#define CREDITS_MAX		255
+#define CREDIT_TIMEOUT		K_SECONDS(10)
+
+/* Worst case initial credits must fit the receive buffer */
+BUILD_ASSERT(CONFIG_SLM_CMUX_BUF_SIZE >= 2 * CONFIG_SLM_CMUX_N1_MAX,
+	     "Receive buffer must hold at least two frames");
+
+enum decoder_state {
+	DEC_FLAG,
+	DEC_ADDR,
+	DEC_CTRL,
+	DEC_LEN,
+	DEC_LEN2,
+	DEC_CREDITS,
+	DEC_DATA,
+	DEC_FCS,
+	DEC_END
+};
+
+/**@brief Data link connection. */
+struct dlc {
+	bool open;
+	bool credit_fc;	/* Credit based flow control negotiated */
+	bool peer_fc;	/* Peer does not accept data, by MSC */
+	bool local_fc;	/* We do not accept data, by MSC */
+	uint16_t n1;	/* Maximum data in frames we send */
+	uint8_t tx_credits; /* Frames we may send */
+	uint8_t rx_credits; /* Frames the peer may send */
+	struct ring_buf rx_buf;
+	struct k_sem tx_sem; /* Given when sending may be possible */
+};
+
+static struct {
+	struct slm_cmux_config cfg;
+	bool running;
+	bool peer_fc;	/* Peer does not accept data, by FCoff */
+	struct slm_cmux_decoder dec;
+	struct dlc dlcs[SLM_CMUX_DLCI_COUNT];
+} cmux;
+
+/* Protects the DLC states */
+static K_MUTEX_DEFINE(cmux_lock);
+/* Serializes the frames on the transport */
+static K_MUTEX_DEFINE(tx_lock);
+
+static uint8_t dec_buf[SLM_CMUX_DECODER_BUF_SIZE(CONFIG_SLM_CMUX_N1_MAX)];
+static uint8_t tx_buf[SLM_CMUX_FRAME_SIZE(CONFIG_SLM_CMUX_N1_MAX)];
+static uint8_t rx_data[SLM_CMUX_DLCI_COUNT - 1][CONFIG_SLM_CMUX_BUF_SIZE];
+
+/* CRC-8, polynomial x^8 + x^2 + x + 1 reflected, from TS 27.010 annex B */
+static const uint8_t crc_table[256] = {
+	0x00, 0x91, 0xE3, 0x72, 0x07, 0x96, 0xE4, 0x75,
+	0x0E, 0x9F, 0xED, 0x7C, 0x09, 0x98, 0xEA, 0x7B,
+	0x1C, 0x8D, 0xFF, 0x6E, 0x1B, 0x8A, 0xF8, 0x69,
+	0x12, 0x83, 0xF1, 0x60, 0x15, 0x84, 0xF6, 0x67,
+	0x38, 0xA9, 0xDB, 0x4A, 0x3F, 0xAE, 0xDC, 0x4D,
+	0x36, 0xA7, 0xD5, 0x44, 0x31, 0xA0, 0xD2, 0x43,
+	0x24, 0xB5, 0xC7, 0x56, 0x23, 0xB2, 0xC0, 0x51,
+	0x2A, 0xBB, 0xC9, 0x58, 0x2D, 0xBC, 0xCE, 0x5F,
+	0x70, 0xE1, 0x93, 0x02, 0x77, 0xE6, 0x94, 0x05,
+	0x7E, 0xEF, 0x9D, 0x0C, 0x79, 0xE8, 0x9A, 0x0B,
+	0x6C, 0xFD, 0x8F, 0x1E, 0x6B, 0xFA, 0x88, 0x19,
+	0x62, 0xF3, 0x81, 0x10, 0x65, 0xF4, 0x86, 0x17,
+	0x48, 0xD9, 0xAB, 0x3A, 0x4F, 0xDE, 0xAC, 0x3D,
+	0x46, 0xD7, 0xA5, 0x34, 0x41, 0xD0, 0xA2, 0x33,
+	0x54, 0xC5, 0xB7, 0x26, 0x53, 0xC2, 0xB0, 0x21,
+	0x5A, 0xCB, 0xB9, 0x28, 0x5D, 0xCC, 0xBE, 0x2F,
+	0xE0, 0x71, 0x03, 0x92, 0xE7, 0x76, 0x04, 0x95,
+	0xEE, 0x7F, 0x0D, 0x9C, 0xE9, 0x78, 0x0A, 0x9B,
+	0xFC, 0x6D, 0x1F, 0x8E, 0xFB, 0x6A, 0x18, 0x89,
+	0xF2, 0x63, 0x11, 0x80, 0xF5, 0x64, 0x16, 0x87,
+	0xD8, 0x49, 0x3B, 0xAA, 0xDF, 0x4E, 0x3C, 0xAD,
+	0xD6, 0x47, 0x35, 0xA4, 0xD1, 0x40, 0x32, 0xA3,
+	0xC4, 0x55, 0x27, 0xB6, 0xC3, 0x52, 0x20, 0xB1,
+	0xCA, 0x5B, 0x29, 0xB8, 0xCD, 0x5C, 0x2E, 0xBF,
+	0x90, 0x01, 0x73, 0xE2, 0x97, 0x06, 0x74, 0xE5,
+	0x9E, 0x0F, 0x7D, 0xEC, 0x99, 0x08, 0x7A, 0xEB,
+	0x8C, 0x1D, 0x6F, 0xFE, 0x8B, 0x1A, 0x68, 0xF9,
+	0x82, 0x13, 0x61, 0xF0, 0x85, 0x14, 0x66, 0xF7,
+	0xA8, 0x39, 0x4B, 0xDA, 0xAF, 0x3E, 0x4C, 0xDD,
+	0xA6, 0x37, 0x45, 0xD4, 0xA1, 0x30, 0x42, 0xD3,
+	0xB4, 0x25, 0x57, 0xC6, 0xB3, 0x22, 0x50, 0xC1,
+	0xBA, 0x2B, 0x59, 0xC8, 0xBD, 0x2C, 0x5E, 0xCF,
+};
+
+static uint8_t fcs_calc(uint8_t fcs, const uint8_t *data, size_t len)
+{
+	while (len--) {
+		fcs = crc_table[fcs ^ *data++];
+	}
+
+	return fcs;
+}
+
+/* Copy to the output, with transparency in the advanced option */
+static int frame_put(enum slm_cmux_mode mode, uint8_t *buf, size_t pos,
+		     size_t size, const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		if (mode == SLM_CMUX_MODE_ADVANCED &&
+		    (data[i] == ADVANCED_FLAG || data[i] == ADVANCED_ESCAPE)) {
+			if (pos + 2 > size) {
+				return -ENOMEM;
+			}
+			buf[pos++] = ADVANCED_ESCAPE;
+			buf[pos++] = data[i] ^ ADVANCED_XOR;
+		} else {
+			if (pos + 1 > size) {
+				return -ENOMEM;
+			}
+			buf[pos++] = data[i];
+		}
+	}
+
+	return pos;
+}
+
+int slm_cmux_frame_encode(enum slm_cmux_mode mode,
+			  const struct slm_cmux_frame *frame,
+			  uint8_t *buf, size_t size)
+{
+	uint8_t hdr[5];
+	size_t hdr_len = 0;
+	size_t len = frame->len;
+	uint8_t flag;
+	uint8_t fcs;
+	int pos = 0;
+
+	if (frame->dlci > 63 || len > 0x7FFF || size < 1) {
+		return -EINVAL;
+	}
+	/* The credit octet is only defined for UIH frames with P/F set */
+	if (frame->has_credits &&
+	    (frame->type != SLM_CMUX_UIH || !frame->pf)) {
+		return -EINVAL;
+	}
+
+	hdr[hdr_len++] = (frame->dlci << 2) | (frame->cr ? CR : 0) | EA;
+	hdr[hdr_len++] = frame->type | (frame->pf ? PF : 0);
+	if (mode == SLM_CMUX_MODE_BASIC) {
+		if (len > 127) {
+			hdr[hdr_len++] = (len << 1) & 0xFE;
+			hdr[hdr_len++] = len >> 7;
+		} else {
+			hdr[hdr_len++] = (len << 1) | EA;
+		}
+	}
+	/* Only the header is protected in UIH frames */
+	fcs = fcs_calc(FCS_INIT, hdr, hdr_len);
+	if (frame->type != SLM_CMUX_UIH) {
+		fcs = fcs_calc(fcs, frame->data, frame->len);
+	}
+	fcs = 0xFF - fcs;
+	if (frame->has_credits) {
+		hdr[hdr_len++] = frame->credits;
+	}
+
+	flag = (mode == SLM_CMUX_MODE_BASIC) ? BASIC_FLAG : ADVANCED_FLAG;
+	buf[pos++] = flag;
+	pos = frame_put(mode, buf, pos, size, hdr, hdr_len);
+	if (pos < 0) {
+		return pos;
+	}
+	pos = frame_put(mode, buf, pos, size, frame->data, frame->len);
+	if (pos < 0) {
+		return pos;
+	}
+	pos = frame_put(mode, buf, pos, size, &fcs, 1);
+	if (pos < 0) {
+		return pos;
+	}
+	if (pos + 1 > size) {
+		return -ENOMEM;
+	}
+	buf[pos++] = flag;
+
+	return pos;
+}
+
+void slm_cmux_decoder_init(struct slm_cmux_decoder *dec,
+			   enum slm_cmux_mode mode,
+			   uint8_t *buf, size_t size)
+{
+	memset(dec, 0, sizeof(*dec));
+	dec->mode = mode;
+	dec->buf = buf;
+	dec->size = size;
+	dec->state = DEC_FLAG;
+}
+
+void slm_cmux_decoder_credits_set(struct slm_cmux_decoder *dec, uint8_t dlci,
+				  bool enable)
+{
+	if (enable) {
+		dec->credit_dlcis |= BIT64(dlci);
+	} else {
+		dec->credit_dlcis &= ~BIT64(dlci);
+	}
+}
+
+/* Whether a UIH frame with P/F set starts with a credit octet */
+static bool dec_has_credits(const struct slm_cmux_decoder *dec)
+{
+	return (dec->ctrl == (SLM_CMUX_UIH | PF)) &&
+	       (dec->credit_dlcis & BIT64(dec->addr >> 2));
+}
+
+static void frame_fill(const struct slm_cmux_decoder *dec,
+		       struct slm_cmux_frame *frame,
+		       const uint8_t *data, uint16_t len)
+{
+	frame->dlci = dec->addr >> 2;
+	frame->cr = (dec->addr & CR) != 0;
+	frame->type = dec->ctrl & ~PF;
+	frame->pf = (dec->ctrl & PF) != 0;
+	frame->has_credits = dec_has_credits(dec);
+	frame->credits = frame->has_credits ? dec->credits : 0;
+	frame->data = data;
+	frame->len = len;
+}
+
+static int decode_basic(struct slm_cmux_decoder *dec, uint8_t byte,
+			struct slm_cmux_frame *frame)
+{
+	switch (dec->state) {
+	case DEC_FLAG:
+		if (byte == BASIC_FLAG) {
+			dec->state = DEC_ADDR;
+		}
+		break;
+	case DEC_ADDR:
+		/* Repeated flags between frames */
+		if (byte == BASIC_FLAG) {
+			break;
+		}
+		dec->addr = byte;
+		dec->fcs = crc_table[FCS_INIT ^ byte];
+		dec->state = DEC_CTRL;
+		break;
+	case DEC_CTRL:
+		dec->ctrl = byte;
+		dec->fcs = crc_table[dec->fcs ^ byte];
+		dec->state = DEC_LEN;
+		break;
+	case DEC_LEN:
+	case DEC_LEN2:
+		dec->fcs = crc_table[dec->fcs ^ byte];
+		if (dec->state == DEC_LEN) {
+			dec->len = byte >> 1;
+		} else {
+			dec->len |= (uint16_t)byte << 7;
+		}
+		if (dec->state == DEC_LEN && !(byte & EA)) {
+			dec->state = DEC_LEN2;
+			break;
+		}
+		if (dec->len > dec->size) {
+			dec->state = DEC_FLAG;
+			return -EMSGSIZE;
+		}
+		dec->pos = 0;
+		if (dec_has_credits(dec)) {
+			dec->state = DEC_CREDITS;
+		} else {
+			dec->state = dec->len ? DEC_DATA : DEC_FCS;
+		}
+		break;
+	case DEC_CREDITS:
+		/* Not protected, like the rest of the UIH information */
+		dec->credits = byte;
+		dec->state = dec->len ? DEC_DATA : DEC_FCS;
+		break;
+	case DEC_DATA:
+		dec->buf[dec->pos++] = byte;
+		if ((dec->ctrl & ~PF) != SLM_CMUX_UIH) {
+			dec->fcs = crc_table[dec->fcs ^ byte];
+		}
+		if (dec->pos == dec->len) {
+			dec->state = DEC_FCS;
+		}
+		break;
+	case DEC_FCS:
+		if (crc_table[dec->fcs ^ byte] != FCS_GOOD) {
+			dec->state = DEC_FLAG;
+			return -EBADMSG;
+		}
+		dec->state = DEC_END;
+		break;
+	case DEC_END:
+		if (byte != BASIC_FLAG) {
+			dec->state = DEC_FLAG;
+			return -EBADMSG;
+		}
+		/* The closing flag may also open the next frame */
+		dec->state = DEC_ADDR;
+		frame_fill(dec, frame, dec->buf, dec->len);
+		return 1;
+	default:
+		dec->state = DEC_FLAG;
+		break;
+	}
+
+	return 0;
+}
+
+static int decode_advanced(struct slm_cmux_decoder *dec, uint8_t byte,
+			   struct slm_cmux_frame *frame)
+{
+	size_t hdr_len = 2;
+	uint8_t fcs;
+	size_t len;
+
+	if (byte == ADVANCED_FLAG) {
+		size_t pos = dec->pos;
+
+		dec->pos = 0;
+		dec->escape = false;
+		if (dec->state == DEC_FLAG || pos == 0) {
+			/* Opening or repeated flag */
+			dec->state = DEC_DATA;
+			return 0;
+		}
+		/* Address, control and FCS at least */
+		if (pos < 3) {
+			return -EBADMSG;
+		}
+		dec->addr = dec->buf[0];
+		dec->ctrl = dec->buf[1];
+		if (dec_has_credits(dec)) {
+			if (pos < 4) {
+				return -EBADMSG;
+			}
+			dec->credits = dec->buf[hdr_len++];
+		}
+		len = pos - hdr_len - 1;
+		fcs = fcs_calc(FCS_INIT, dec->buf, 2);
+		if ((dec->ctrl & ~PF) != SLM_CMUX_UIH) {
+			fcs = fcs_calc(fcs, dec->buf + 2, len);
+		}
+		if (crc_table[fcs ^ dec->buf[pos - 1]] != FCS_GOOD) {
+			return -EBADMSG;
+		}
+		frame_fill(dec, frame, dec->buf + hdr_len, len);
+		return 1;
+	}
+
+	if (dec->state == DEC_FLAG) {
+		return 0;
+	}
+	if (byte == ADVANCED_ESCAPE) {
+		dec->escape = true;
+		return 0;
+	}
+	if (dec->escape) {
+		byte ^= ADVANCED_XOR;
+		dec->escape = false;
+	}
+	if (dec->pos >= dec->size) {
+		dec->state = DEC_FLAG;
+		return -EMSGSIZE;
+	}
+	dec->buf[dec->pos++] = byte;
+
+	return 0;
+}
+
+int slm_cmux_decode(struct slm_cmux_decoder *dec, uint8_t byte,
+		    struct slm_cmux_frame *frame)
+{
+	if (dec->mode == SLM_CMUX_MODE_ADVANCED) {
+		return decode_advanced(dec, byte, frame);
+	}
+
+	return decode_basic(dec, byte, frame);
+}
+
+static int frame_send(const struct slm_cmux_frame *frame)
+{
+	int ret;
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+	ret = slm_cmux_frame_encode(cmux.cfg.mode, frame, tx_buf,
+				    sizeof(tx_buf));
+	if (ret > 0) {
+		ret = cmux.cfg.write(tx_buf, ret);
+	}
+	k_mutex_unlock(&tx_lock);
+	if (ret < 0) {
+		LOG_WRN("Frame not sent: %d", ret);
+	}
+
+	return ret;
+}
+
+/* Response to SABM or DISC. The multiplexer is always the responder. */
+static int rsp_frame_send(uint8_t dlci, uint8_t type, bool pf)
+{
+	struct slm_cmux_frame frame = {
+		.dlci = dlci,
+		.type = type,
+		.cr = true,
+		.pf = pf,
+	};
+
+	return frame_send(&frame);
+}
+
+/* Control channel message */
+static int msg_send(uint8_t type, bool command, const uint8_t *value,
+		    uint8_t len)
+{
+	uint8_t msg[CONFIG_SLM_CMUX_N1_MAX];
+	struct slm_cmux_frame frame = {
+		.dlci = SLM_CMUX_DLCI_CTRL,
+		.type = SLM_CMUX_UIH,
+		.data = msg,
+	};
+
+	if (len > 127 || len + 2 > cmux.cfg.n1) {
+		return -EMSGSIZE;
+	}
+	msg[0] = type | (command ? CR : 0) | EA;
+	msg[1] = (len << 1) | EA;
+	memcpy(&msg[2], value, len);
+	frame.len = len + 2;
+
+	return frame_send(&frame);
+}
+
+static int msc_send(uint8_t dlci)
+{
+	uint8_t value[2];
+
+	value[0] = (dlci << 2) | CR | EA;
+	value[1] = MSC_DV | MSC_RTR | MSC_RTC | EA;
+	if (cmux.dlcs[dlci].local_fc) {
+		value[1] |= MSC_FC;
+	}
+
+	return msg_send(MSG_MSC, true, value, sizeof(value));
+}
+
+/* Credits that can be given to the peer, must be called locked */
+static uint8_t credits_get(struct dlc *dlc, bool batch)
+{
+	uint32_t max = ring_buf_space_get(&dlc->rx_buf) / cmux.cfg.n1;
+	uint32_t grant;
+
+	max = MIN(max, CREDITS_MAX);
+	if (max <= dlc->rx_credits) {
+		return 0;
+	}
+	grant = max - dlc->rx_credits;
+	/* Avoid a frame for every credit */
+	if (batch && grant < MAX(1, CONFIG_SLM_CMUX_BUF_SIZE /
+				 cmux.cfg.n1 / 2)) {
+		return 0;
+	}
+	dlc->rx_credits += grant;
+
+	return grant;
+}
+
+static void credits_send(uint8_t dlci, uint8_t credits)
+{
+	struct slm_cmux_frame frame = {
+		.dlci = dlci,
+		.type = SLM_CMUX_UIH,
+		.pf = true,
+		.has_credits = true,
+		.credits = credits,
+	};
+
+	(void)frame_send(&frame);
+}
+
+static void dlc_close(uint8_t dlci, bool notify)
+{
+	struct dlc *dlc = &cmux.dlcs[dlci];
+
+	k_mutex_lock(&cmux_lock, K_FOREVER);
+	if (!dlc->open) {
+		k_mutex_unlock(&cmux_lock);
+		return;
+	}
+	dlc->open = false;
+	dlc->credit_fc = false;
+	slm_cmux_decoder_credits_set(&cmux.dec, dlci, false);
+	dlc->peer_fc = false;
+	dlc->local_fc = false;
+	dlc->tx_credits = 0;
+	dlc->rx_credits = 0;
+	dlc->n1 = cmux.cfg.n1;
+	k_mutex_unlock(&cmux_lock);
+	/* Wake up a sender */
+	k_sem_give(&dlc->tx_sem);
+	LOG_DBG("DLCI %d closed", dlci);
+	if (notify && cmux.cfg.state_changed) {
+		cmux.cfg.state_changed(dlci, false);
+	}
+}
+
+static void mux_close(bool notify)
+{
+	for (int i = SLM_CMUX_DLCI_COUNT - 1; i >= 0; i--) {
+		dlc_close(i, notify);
+	}
+	cmux.running = false;
+	LOG_INF("Multiplexer closed");
+}
+
+static void sabm_handle(uint8_t dlci, bool pf)
+{
+	struct dlc *dlc;
+	uint8_t credits = 0;
+
+	if (dlci >= SLM_CMUX_DLCI_COUNT ||
+	    (dlci != SLM_CMUX_DLCI_CTRL && !cmux.dlcs[0].open)) {
+		(void)rsp_frame_send(dlci, SLM_CMUX_DM, pf);
+		return;
+	}
+	dlc = &cmux.dlcs[dlci];
+	k_mutex_lock(&cmux_lock, K_FOREVER);
+	if (!dlc->open && dlci != SLM_CMUX_DLCI_CTRL) {
+		ring_buf_reset(&dlc->rx_buf);
+	}
+	dlc->open = true;
+	if (dlc->credit_fc) {
+		credits = credits_get(dlc, false);
+	}
+	k_mutex_unlock(&cmux_lock);
+
+	(void)rsp_frame_send(dlci, SLM_CMUX_UA, pf);
+	LOG_DBG("DLCI %d open", dlci);
+	if (dlci != SLM_CMUX_DLCI_CTRL) {
+		(void)msc_send(dlci);
+		/* The rest of the credits, after the initial ones in PN */
+		if (credits) {
+			credits_send(dlci, credits);
+		}
+	}
+	if (cmux.cfg.state_changed) {
+		cmux.cfg.state_changed(dlci, true);
+	}
+}
+
+static void disc_handle(uint8_t dlci, bool pf)
+{
+	if (dlci >= SLM_CMUX_DLCI_COUNT || !cmux.dlcs[dlci].open) {
+		(void)rsp_frame_send(dlci, SLM_CMUX_DM, pf);
+		return;
+	}
+	(void)rsp_frame_send(dlci, SLM_CMUX_UA, pf);
+	if (dlci == SLM_CMUX_DLCI_CTRL) {
+		mux_close(true);
+	} else {
+		dlc_close(dlci, true);
+	}
+}
+
+static void pn_handle(const uint8_t *value, uint8_t len)
+{
+	uint8_t rsp[PN_LEN];
+	uint8_t dlci;
+	uint16_t n1;
+	struct dlc *dlc;
+
+	if (len < PN_LEN) {
+		return;
+	}
+	dlci = value[0] & 0x3F;
+	if (dlci == SLM_CMUX_DLCI_CTRL || dlci >= SLM_CMUX_DLCI_COUNT) {
+		(void)rsp_frame_send(dlci, SLM_CMUX_DM, false);
+		return;
+	}
+	dlc = &cmux.dlcs[dlci];
+	memcpy(rsp, value, PN_LEN);
+
+	n1 = value[4] | (value[5] << 8);
+	if (n1 == 0 || n1 > cmux.cfg.n1) {
+		n1 = cmux.cfg.n1;
+	}
+	rsp[4] = n1 & 0xFF;
+	rsp[5] = n1 >> 8;
+
+	k_mutex_lock(&cmux_lock, K_FOREVER);
+	dlc->n1 = n1;
+	/* UIH frames only */
+	rsp[1] = 0;
+	if ((value[1] & PN_CL_MASK) == PN_CL_CREDIT_REQ) {
+		dlc->credit_fc = true;
+		dlc->tx_credits = value[7] & PN_K_MASK;
+		dlc->rx_credits = 0;
+		dlc->rx_credits = MIN(credits_get(dlc, false), PN_K_MASK);
+		rsp[1] = PN_CL_CREDIT_RSP;
+		rsp[7] = dlc->rx_credits;
+	} else {
+		dlc->credit_fc = false;
+	}
+	slm_cmux_decoder_credits_set(&cmux.dec, dlci, dlc->credit_fc);
+	k_mutex_unlock(&cmux_lock);
+	LOG_DBG("DLCI %d N1 %d credits %d", dlci, n1, dlc->credit_fc);
+
+	(void)msg_send(MSG_PN, false, rsp, PN_LEN);
+}
+
+static void msc_handle(const uint8_t *value, uint8_t len)
+{
+	uint8_t dlci;
+
+	if (len < 2) {
+		return;
+	}
+	dlci = value[0] >> 2;
+	if (dlci != SLM_CMUX_DLCI_CTRL && dlci < SLM_CMUX_DLCI_COUNT) {
+		struct dlc *dlc = &cmux.dlcs[dlci];
+
+		k_mutex_lock(&cmux_lock, K_FOREVER);
+		dlc->peer_fc = (value[1] & MSC_FC) != 0;
+		k_mutex_unlock(&cmux_lock);
+		k_sem_give(&dlc->tx_sem);
+	}
+
+	(void)msg_send(MSG_MSC, false, value, len);
+}
+
+static void msg_handle(uint8_t type, const uint8_t *value, uint8_t len)
+{
+	/* Responses to our MSC commands need no action */
+	if (!(type & CR)) {
+		return;
+	}
+
+	switch (type & ~(CR | EA)) {
+	case MSG_PN:
+		pn_handle(value, len);
+		break;
+	case MSG_MSC:
+		msc_handle(value, len);
+		break;
+	case MSG_CLD:
+		(void)msg_send(MSG_CLD, false, NULL, 0);
+		mux_close(true);
+		break;
+	case MSG_TEST:
+		(void)msg_send(MSG_TEST, false, value, len);
+		break;
+	case MSG_FCON:
+	case MSG_FCOFF:
+		cmux.peer_fc = ((type & ~(CR | EA)) == MSG_FCOFF);
+		for (int i = 1; i < SLM_CMUX_DLCI_COUNT; i++) {
+			k_sem_give(&cmux.dlcs[i].tx_sem);
+		}
+		(void)msg_send(type & ~CR, false, NULL, 0);
+		break;
+	default:
+		LOG_DBG("Unsupported message 0x%02x", type);
+		(void)msg_send(MSG_NSC, false, &type, 1);
+		break;
+	}
+}
+
+static void ctrl_handle(const uint8_t *data, uint16_t len)
+{
+	/* A frame may carry several messages */
+	while (len >= 2) {
+		uint8_t type = data[0];
+		uint16_t value_len = data[1] >> 1;
+		uint16_t hdr_len = 2;
+
+		if (!(type & EA)) {
+			LOG_DBG("Multi-octet message types not supported");
+			return;
+		}
+		if (!(data[1] & EA)) {
+			if (len < 3) {
+				return;
+			}
+			value_len |= (uint16_t)data[2] << 7;
+			hdr_len = 3;
+		}
+		if (hdr_len + value_len > len || value_len > 127) {
+			LOG_DBG("Malformed message");
+			return;
+		}
+		msg_handle(type, data + hdr_len, value_len);
+		if (!cmux.running) {
+			return;
+		}
+		data += hdr_len + value_len;
+		len -= hdr_len + value_len;
+	}
+}
+
+static void data_handle(uint8_t dlci, const struct slm_cmux_frame *frame)
+{
+	struct dlc *dlc = &cmux.dlcs[dlci];
+	const uint8_t *data = frame->data;
+	uint16_t len = frame->len;
+	uint32_t written = 0;
+	bool fc_changed = false;
+
+	k_mutex_lock(&cmux_lock, K_FOREVER);
+	if (dlc->credit_fc && frame->has_credits) {
+		dlc->tx_credits = MIN(dlc->tx_credits + frame->credits,
+				      CREDITS_MAX);
+		k_sem_give(&dlc->tx_sem);
+	}
+	if (len > 0) {
+		if (dlc->credit_fc && dlc->rx_credits > 0) {
+			dlc->rx_credits--;
+		}
+		written = ring_buf_put(&dlc->rx_buf, data, len);
+		if (!dlc->credit_fc && !dlc->local_fc &&
+		    ring_buf_space_get(&dlc->rx_buf) < cmux.cfg.n1) {
+			dlc->local_fc = true;
+			fc_changed = true;
+		}
+	}
+	k_mutex_unlock(&cmux_lock);
+
+	if (written < len) {
+		LOG_WRN("DLCI %d overflow, %d dropped", dlci, len - written);
+	}
+	if (fc_changed) {
+		(void)msc_send(dlci);
+	}
+	if (len > 0 && cmux.cfg.rx_ready) {
+		cmux.cfg.rx_ready(dlci);
+	}
+}
+
+static void frame_handle(const struct slm_cmux_frame *frame)
+{
+	uint8_t dlci = frame->dlci;
+
+	switch (frame->type) {
+	case SLM_CMUX_SABM:
+		sabm_handle(dlci, frame->pf);
+		break;
+	case SLM_CMUX_DISC:
+		disc_handle(dlci, frame->pf);
+		break;
+	case SLM_CMUX_UIH:
+	case SLM_CMUX_UI:
+		if (dlci >= SLM_CMUX_DLCI_COUNT || !cmux.dlcs[dlci].open) {
+			LOG_DBG("DLCI %d not open", dlci);
+			break;
+		}
+		if (dlci == SLM_CMUX_DLCI_CTRL) {
+			ctrl_handle(frame->data, frame->len);
+		} else {
+			data_handle(dlci, frame);
+		}
+		break;
+	default:
+		/* UA and DM, the multiplexer does not send commands */
+		break;
+	}
+}
+
+int slm_cmux_start(const struct slm_cmux_config *cfg)
+{
+	if (cfg == NULL || cfg->write == NULL || cfg->n1 == 0 ||
+	    cfg->n1 > CONFIG_SLM_CMUX_N1_MAX) {
+		return -EINVAL;
+	}
+	if (cmux.running) {
+		return -EBUSY;
+	}
+
+	cmux.cfg = *cfg;
+	cmux.peer_fc = false;
+	slm_cmux_decoder_init(&cmux.dec, cfg->mode, dec_buf, sizeof(dec_buf));
+	for (int i = 0; i < SLM_CMUX_DLCI_COUNT; i++) {
+		struct dlc *dlc = &cmux.dlcs[i];
+
+		memset(dlc, 0, sizeof(*dlc));
+		dlc->n1 = cfg->n1;
+		k_sem_init(&dlc->tx_sem, 0, 1);
+		if (i != SLM_CMUX_DLCI_CTRL) {
+			ring_buf_init(&dlc->rx_buf, sizeof(rx_data[0]),
+				      rx_data[i - 1]);
+		}
+	}
+	cmux.running = true;
+	LOG_INF("Multiplexer started, N1 %d", cfg->n1);
+
+	return 0;
+}
+
+void slm_cmux_stop(void)
+{
+	if (cmux.running) {
+		mux_close(false);
+	}
+}
+
+bool slm_cmux_is_open(uint8_t dlci)
+{
+	return cmux.running && dlci < SLM_CMUX_DLCI_COUNT &&
+	       cmux.dlcs[dlci].open;
+}
+
+void slm_cmux_input(const uint8_t *data, size_t len)
+{
+	struct slm_cmux_frame frame;
+	int ret;
+
+	for (size_t i = 0; i < len && cmux.running; i++) {
+		ret = slm_cmux_decode(&cmux.dec, data[i], &frame);
+		if (ret == 1) {
+			frame_handle(&frame);
+		} else if (ret < 0) {
+			LOG_DBG("Frame dropped: %d", ret);
+		}
+	}
+}
+
+int slm_cmux_send(uint8_t dlci, const uint8_t *data, size_t len)
+{
+	struct dlc *dlc;
+	struct slm_cmux_frame frame = {
+		.dlci = dlci,
+		.type = SLM_CMUX_UIH,
+	};
+	uint8_t credits;
+	bool allowed;
+	int ret;
+
+	if (dlci == SLM_CMUX_DLCI_CTRL || dlci >= SLM_CMUX_DLCI_COUNT) {
+		return -EINVAL;
+	}
+	dlc = &cmux.dlcs[dlci];
+
+	while (len > 0) {
+		/* Wait until the peer accepts a frame */
+		while (true) {
+			if (!cmux.running || !dlc->open) {
+				return -ENOTCONN;
+			}
+			k_mutex_lock(&cmux_lock, K_FOREVER);
+			if (dlc->credit_fc) {
+				allowed = (dlc->tx_credits > 0);
+			} else {
+				allowed = !dlc->peer_fc && !cmux.peer_fc;
+			}
+			if (allowed) {
+				credits = 0;
+				if (dlc->credit_fc) {
+					dlc->tx_credits--;
+					credits = credits_get(dlc, false);
+				}
+				frame.len = MIN(len, dlc->n1);
+			}
+			k_mutex_unlock(&cmux_lock);
+			if (allowed) {
+				break;
+			}
+			if (k_sem_take(&dlc->tx_sem, CREDIT_TIMEOUT) != 0) {
+				LOG_WRN("DLCI %d send timeout", dlci);
+				return -EAGAIN;
+			}
+		}
+
+		/* Give credits with the data when possible */
+		frame.data = data;
+		frame.pf = (credits > 0);
+		frame.has_credits = (credits > 0);
+		frame.credits = credits;
+		ret = frame_send(&frame);
+		if (ret < 0) {
+			return ret;
+		}
+		data += frame.len;
+		len -= frame.len;
+	}
+
+	return 0;
+}
+
+int slm_cmux_recv(uint8_t dlci, uint8_t *buf, size_t size)
+{
+	struct dlc *dlc;
+	uint32_t len;
+	uint8_t credits = 0;
+	bool fc_changed = false;
+
+	if (dlci == SLM_CMUX_DLCI_CTRL || dlci >= SLM_CMUX_DLCI_COUNT) {
+		return -EINVAL;
+	}
+	dlc = &cmux.dlcs[dlci];
+
+	k_mutex_lock(&cmux_lock, K_FOREVER);
+	len = ring_buf_get(&dlc->rx_buf, buf, size);
+	if (dlc->open && dlc->credit_fc) {
+		credits = credits_get(dlc, true);
+	} else if (dlc->open && dlc->local_fc &&
+		   ring_buf_space_get(&dlc->rx_buf) >= 2 * cmux.cfg.n1) {
+		dlc->local_fc = false;
+		fc_changed = true;
+	}
+	k_mutex_unlock(&cmux_lock);
+
+	if (credits) {
+		credits_send(dlci, credits);
+	}
+	if (fc_changed) {
+		(void)msc_send(dlci);
+	}
+
+	return len;
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef SLM_CMUX_
+#define SLM_CMUX_
+
+/**@file slm_cmux.h
+ *
+ * @brief 3GPP TS 27.010 multiplexer for serial LTE modem
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Control channel */
+#define SLM_CMUX_DLCI_CTRL	0
+/** Channel for AT commands, responses and notifications */
+#define SLM_CMUX_DLCI_AT	1
+/** Channel for data mode */
+#define SLM_CMUX_DLCI_DATA	2
+/** Number of channels, including the control channel */
+#define SLM_CMUX_DLCI_COUNT	3
+
+/** Default maximum frame size, basic option */
+#define SLM_CMUX_N1_BASIC	31
+/** Default maximum frame size, advanced option */
+#define SLM_CMUX_N1_ADVANCED	64
+
+/** Worst-case framing overhead: flags, address, control, length, credits
+ *  and FCS, with every octet escaped in the advanced option.
+ */
+#define SLM_CMUX_FRAME_OVERHEAD	16
+/** Size of a buffer that holds any encoded frame with N1 octets of data */
+#define SLM_CMUX_FRAME_SIZE(n1)	(2 * (n1) + SLM_CMUX_FRAME_OVERHEAD)
+/** Size of the decoder buffer for frames with N1 octets of data */
+#define SLM_CMUX_DECODER_BUF_SIZE(n1)	((n1) + 4)
+
+/**@brief Frame options. */
+enum slm_cmux_mode {
+	SLM_CMUX_MODE_BASIC,
+	SLM_CMUX_MODE_ADVANCED
+};
+
+/**@brief Frame types, as encoded in the control field without P/F bit. */
+enum slm_cmux_frame_type {
+	SLM_CMUX_SABM = 0x2F,
+	SLM_CMUX_UA = 0x63,
+	SLM_CMUX_DM = 0x0F,
+	SLM_CMUX_DISC = 0x43,
+	SLM_CMUX_UIH = 0xEF,
+	SLM_CMUX_UI = 0x03
+};
+
+/**@brief Multiplexer frame. */
+struct slm_cmux_frame {
+	uint8_t dlci;
+	uint8_t type;
+	bool cr;
+	bool pf;
+	/** Credit octet before the information field, only in UIH frames
+	 *  with the P/F bit set on channels with credit based flow control.
+	 *  It is not counted in the length field.
+	 */
+	bool has_credits;
+	uint8_t credits;
+	const uint8_t *data;
+	uint16_t len;
+};
+
+/**@brief Frame decoder state. */
+struct slm_cmux_decoder {
+	enum slm_cmux_mode mode;
+	uint8_t *buf;
+	size_t size;
+	uint8_t state;
+	uint8_t addr;
+	uint8_t ctrl;
+	uint8_t fcs;
+	bool escape;
+	size_t pos;
+	uint16_t len;
+	uint8_t credits;
+	/** Channels with credit based flow control, one bit per DLCI. */
+	uint64_t credit_dlcis;
+};
+
+/**@brief Transport for encoded frames. */
+typedef int (*slm_cmux_write_t)(const uint8_t *data, size_t len);
+
+/**@brief Called when data can be read from a channel. */
+typedef void (*slm_cmux_rx_ready_t)(uint8_t dlci);
+
+/**@brief Called when a channel is opened or closed. The multiplexer
+ *  has stopped when the control channel is closed.
+ */
+typedef void (*slm_cmux_state_t)(uint8_t dlci, bool open);
+
+/**@brief Multiplexer configuration. */
+struct slm_cmux_config {
+	enum slm_cmux_mode mode;
+	/** Maximum number of data octets in a frame. */
+	uint16_t n1;
+	slm_cmux_write_t write;
+	slm_cmux_rx_ready_t rx_ready;
+	slm_cmux_state_t state_changed;
+};
+
+/**
+ * @brief Encode a frame.
+ *
+ * @param mode Frame option.
+ * @param frame Frame to encode.
+ * @param buf Output buffer, see @ref SLM_CMUX_FRAME_SIZE.
+ * @param size Size of the output buffer.
+ *
+ * @retval Length of the encoded frame if successful.
+ *         Otherwise, a (negative) error code is returned.
+ */
+int slm_cmux_frame_encode(enum slm_cmux_mode mode,
+			  const struct slm_cmux_frame *frame,
+			  uint8_t *buf, size_t size);
+
+/**
+ * @brief Initialize a frame decoder.
+ *
+ * @param dec Decoder.
+ * @param mode Frame option.
+ * @param buf Buffer for the data of one frame.
+ * @param size Size of the buffer, see @ref SLM_CMUX_DECODER_BUF_SIZE.
+ */
+void slm_cmux_decoder_init(struct slm_cmux_decoder *dec,
+			   enum slm_cmux_mode mode,
+			   uint8_t *buf, size_t size);
+
+/**
+ * @brief Set whether a channel uses credit based flow control.
+ *
+ * On such channels, UIH frames with the P/F bit set carry a credit octet.
+ *
+ * @param dec Decoder.
+ * @param dlci Channel.
+ * @param enable Whether the channel uses credit based flow control.
+ */
+void slm_cmux_decoder_credits_set(struct slm_cmux_decoder *dec, uint8_t dlci,
+				  bool enable);
+
+/**
+ * @brief Decode one received octet.
+ *
+ * @param dec Decoder.
+ * @param byte Received octet.
+ * @param frame Decoded frame, valid until the next call.
+ *
+ * @retval 1 If a frame was decoded.
+ *         0 If more octets are needed.
+ *         Otherwise, a (negative) error code is returned and the frame
+ *         is dropped.
+ */
+int slm_cmux_decode(struct slm_cmux_decoder *dec, uint8_t byte,
+		    struct slm_cmux_frame *frame);
+
+/**
+ * @brief Start the multiplexer. The channels are opened by the host.
+ *
+ * @param cfg Configuration.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_cmux_start(const struct slm_cmux_config *cfg);
+
+/**
+ * @brief Stop the multiplexer and close all channels.
+ */
+void slm_cmux_stop(void);
+
+/**
+ * @brief Check whether a channel is open.
+ *
+ * @param dlci Channel.
+ *
+ * @retval true If the channel is open, false otherwise.
+ */
+bool slm_cmux_is_open(uint8_t dlci);
+
+/**
+ * @brief Pass on octets received from the transport.
+ *
+ * Must be called from a thread that does not wait for the multiplexer,
+ * because flow control information is received here.
+ *
+ * @param data Received octets.
+ * @param len Number of octets.
+ */
+void slm_cmux_input(const uint8_t *data, size_t len);
+
+/**
+ * @brief Send data on a channel.
+ *
+ * Blocks while the peer does not accept more data on the channel.
+ *
+ * @param dlci Channel.
+ * @param data Data to send.
+ * @param len Length of the data.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_cmux_send(uint8_t dlci, const uint8_t *data, size_t len);
+
+/**
+ * @brief Read received data from a channel.
+ *
+ * @param dlci Channel.
+ * @param buf Buffer for the data.
+ * @param size Size of the buffer.
+ *
+ * @retval Number of octets read, 0 if there is no data.
+ *         Otherwise, a (negative) error code is returned.
+ */
+int slm_cmux_recv(uint8_t dlci, uint8_t *buf, size_t size);
+
+/** @} */
+
+#endif /* SLM_CMUX_ */
@@ -733,6 +733,13 @@ int slm_at_httpc_uninit(void)
 	return err;
 }
 
+/**@brief API to check whether HTTP request payload is pending
+ */
+bool slm_at_httpc_payload_pending(void)
+{
+	return (httpc.pl_len > 0);
+}
+
 /**@brief API to list HTTP AT commands
  */
 void slm_at_httpc_clac(void)
@@ -28,6 +28,15 @@
  */
 int slm_at_httpc_parse(const char *at_cmd, size_t length);
 
+/**
+ * @brief Check whether HTTPC is waiting for request payload.
+ *
+ * While waiting, input that is not an HTTPC AT command is sent as payload.
+ *
+ * @retval true If HTTPC is waiting for payload, false otherwise.
+ */
+bool slm_at_httpc_payload_pending(void);
+
 /**
  * @brief Initialize HTTPC AT command parser.
  *
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* All SLM AT commands, sorted by name for slm_util_at_cmd_find(). Commands
+ * of the service modules are passed on to the parser of the module.
+ *
+ * Define SLM_AT_CMD(name, handler) before including this file. The list is
+ * included by the command table in slm_at_host.c, and by the tests, so that
+ * the tests check the commands that are built.
+ */
+
+SLM_AT_CMD("AT#XACCEPT", tcpip_parse)
+SLM_AT_CMD("AT#XBIND", tcpip_parse)
+SLM_AT_CMD("AT#XCLAC", at_clac)
+SLM_AT_CMD("AT#XCONNECT", tcpip_parse)
+SLM_AT_CMD("AT#XFOTA", fota_parse)
+#if defined(CONFIG_SLM_FTPC)
+SLM_AT_CMD("AT#XFTP", ftp_parse)
+#endif
+SLM_AT_CMD("AT#XGETADDRINFO", tcpip_parse)
+#if defined(CONFIG_SLM_GPS)
+SLM_AT_CMD("AT#XGPS", gps_parse)
+#endif
+#if defined(CONFIG_SLM_HTTPC)
+SLM_AT_CMD("AT#XHTTPCCON", slm_at_httpc_parse)
+SLM_AT_CMD("AT#XHTTPCREQ", slm_at_httpc_parse)
+#endif
+SLM_AT_CMD("AT#XLISTEN", tcpip_parse)
+#if defined(CONFIG_SLM_MQTTC)
+SLM_AT_CMD("AT#XMQTTCON", mqtt_parse)
+SLM_AT_CMD("AT#XMQTTPUB", mqtt_parse)
+SLM_AT_CMD("AT#XMQTTSUB", mqtt_parse)
+SLM_AT_CMD("AT#XMQTTUNSUB", mqtt_parse)
+#endif
+SLM_AT_CMD("AT#XPING", icmp_parse)
+SLM_AT_CMD("AT#XRECV", tcpip_parse)
+SLM_AT_CMD("AT#XRECVFROM", tcpip_parse)
+SLM_AT_CMD("AT#XRESET", at_reset)
+SLM_AT_CMD("AT#XSEND", tcpip_parse)
+SLM_AT_CMD("AT#XSENDTO", tcpip_parse)
+SLM_AT_CMD("AT#XSLEEP", at_sleep)
+SLM_AT_CMD("AT#XSLMUART", at_slmuart)
+SLM_AT_CMD("AT#XSLMVER", at_slmver)
+SLM_AT_CMD("AT#XSOCKET", tcpip_parse)
+SLM_AT_CMD("AT#XSOCKETOPT", tcpip_parse)
+SLM_AT_CMD("AT#XTCPCLI", tcp_proxy_parse)
+SLM_AT_CMD("AT#XTCPRECV", tcp_proxy_parse)
+SLM_AT_CMD("AT#XTCPSEND", tcp_proxy_parse)
+SLM_AT_CMD("AT#XTCPSVR", tcp_proxy_parse)
+SLM_AT_CMD("AT#XUDPCLI", udp_proxy_parse)
+SLM_AT_CMD("AT#XUDPSEND", udp_proxy_parse)
+SLM_AT_CMD("AT#XUDPSVR", udp_proxy_parse)
+#if defined(CONFIG_SLM_NATIVE_TLS)
+SLM_AT_CMD("AT%CMNG", cmng_parse)
+#endif
+#if defined(CONFIG_SLM_CMUX)
+SLM_AT_CMD("AT+CMUX", at_cmux)
+#endif
@@ -6,6 +6,7 @@
 
 #include <zephyr.h>
 #include <stdio.h>
+#include <limits.h>
 #include <ctype.h>
 #include <logging/log.h>
 #include <drivers/uart.h>
@@ -14,6 +15,7 @@
 #include <modem/at_cmd.h>
 #include <modem/at_notif.h>
 #include <power/reboot.h>
+#include <sys/ring_buffer.h>
 
 LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
 
@@ -39,6 +41,9 @@ LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
 #if defined(CONFIG_SLM_HTTPC)
 #include "slm_at_httpc.h"
 #endif
+#if defined(CONFIG_SLM_CMUX)
+#include "slm_cmux.h"
+#endif
 
 #define OK_STR		"OK\r\n"
 #define ERROR_STR	"ERROR\r\n"
@@ -51,6 +56,7 @@ LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
 #define AT_CMD_RESET	"AT#XRESET"
 #define AT_CMD_CLAC	"AT#XCLAC"
 #define AT_CMD_SLMUART	"AT#XSLMUART"
+#define AT_CMD_CMUX	"AT+CMUX"
 
 #define SLM_UART_BAUDRATE                                           \
 	"#XSLMUART: (1200, 2400, 4800, 9600, 14400, 19200, 38400, " \
@@ -60,6 +66,27 @@ LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
 #define UART_RX_BUF_NUM	2
 #define UART_RX_LEN	256
 #define UART_RX_TIMEOUT 1
+#define UART_RX_DISABLE_TIMEOUT	K_MSEC(100)
+
+#define DATAMODE_TERMINATOR	CONFIG_SLM_DATAMODE_TERMINATOR
+
+BUILD_ASSERT(CONFIG_SLM_DATAMODE_BUF_SIZE >= 2 * UART_RX_LEN,
+	     "Data mode buffer must hold at least two UART RX buffers");
+
+/* Return values of the command handlers, in addition to 0 for responding
+ * "OK" and negative error codes for responding "ERROR". Any other positive
+ * value means that the handler has sent its response or data.
+ */
+#define CMD_RSP_SENT	1
+#define CMD_RX_OFF	INT_MAX	/* No response, and UART RX stays disabled */
+
+/**@brief SLM AT command. */
+struct slm_at_cmd {
+	/** Command name in upper case. Must be the first member. */
+	const char *name;
+	/** Command handler. */
+	int (*handler)(const char *at_cmd, size_t length);
+};
 
 /** @brief Termination Modes. */
 enum term_modes {
@@ -82,6 +109,7 @@ static const struct device *uart_dev;
 static uint8_t at_buf[AT_MAX_CMD_LEN];
 static size_t at_buf_len;
 static struct k_work cmd_send_work;
+static struct k_work datamode_send_work;
 static const char termination[3] = { '\0', '\r', '\n' };
 
 static uint8_t uart_rx_buf[UART_RX_BUF_NUM][UART_RX_LEN];
@@ -89,6 +117,36 @@ static uint8_t *next_buf = uart_rx_buf[1];
 static uint8_t *uart_tx_buf;
 
 static K_SEM_DEFINE(tx_done, 0, 1);
+static K_SEM_DEFINE(uart_rx_disabled, 0, 1);
+
+/* Data mode: raw UART input waiting to be passed on to the handler */
+RING_BUF_DECLARE(datamode_buf, CONFIG_SLM_DATAMODE_BUF_SIZE);
+static slm_datamode_handler_t datamode_handler;
+static struct slm_util_term datamode_term;
+static struct k_delayed_work datamode_term_work;
+static bool datamode_terminated;
+static bool datamode_rx_stopped;
+
+#if defined(CONFIG_SLM_CMUX)
+#define CMUX_WQ_STACK_SIZE	KB(2)
+#define CMUX_WQ_PRIORITY	K_PRIO_COOP(7)
+#define CMUX_RX_BUF_SIZE	(4 * UART_RX_LEN)
+
+/* Frames are decoded in a work queue of their own, so that flow control
+ * information is received while the other work items wait to send.
+ */
+static K_THREAD_STACK_DEFINE(cmux_wq_stack, CMUX_WQ_STACK_SIZE);
+static struct k_work_q cmux_wq;
+static struct k_work cmux_rx_work;
+static struct k_work cmux_at_work;
+RING_BUF_DECLARE(cmux_rx_buf, CMUX_RX_BUF_SIZE);
+static bool cmux_rx_stopped;
+static bool cmux_active;
+static struct slm_cmux_config cmux_cfg = {
+	.mode = SLM_CMUX_MODE_BASIC,
+	.n1 = SLM_CMUX_N1_BASIC
+};
+#endif
 
 /* global functions defined in different files */
 void enter_idle(void);
@@ -100,7 +158,7 @@ extern struct at_param_list at_param_list;
 /* forward declaration */
 void slm_at_host_uninit(void);
 
-void rsp_send(const uint8_t *str, size_t len)
+static int uart_send(const uint8_t *str, size_t len)
 {
 	int ret;
 
@@ -110,7 +168,7 @@ void rsp_send(const uint8_t *str, size_t len)
 	if (uart_tx_buf == NULL) {
 		LOG_WRN("No ram buffer");
 		k_sem_give(&tx_done);
-		return;
+		return -ENOMEM;
 	}
 
 	LOG_HEXDUMP_DBG(str, len, "TX");
@@ -122,6 +180,51 @@ void rsp_send(const uint8_t *str, size_t len)
 		k_free(uart_tx_buf);
 		k_sem_give(&tx_done);
 	}
+
+	return ret;
+}
+
+void rsp_send(const uint8_t *str, size_t len)
+{
+#if defined(CONFIG_SLM_CMUX)
+	if (cmux_active) {
+		int ret = slm_cmux_send(SLM_CMUX_DLCI_AT, str, len);
+
+		if (ret) {
+			LOG_WRN("Response dropped: %d", ret);
+		}
+		return;
+	}
+#endif
+	(void)uart_send(str, len);
+}
+
+/* Stop receiving, to be enabled again with uart_rx_restart() */
+static void uart_rx_stop(void)
+{
+	k_sem_reset(&uart_rx_disabled);
+	uart_rx_disable(uart_dev);
+}
+
+static int uart_rx_restart(void)
+{
+	/* The driver only accepts a new start once it reports RX disabled */
+	if (k_sem_take(&uart_rx_disabled, UART_RX_DISABLE_TIMEOUT) != 0) {
+		LOG_WRN("UART RX not disabled");
+	}
+
+	return uart_rx_enable(uart_dev, uart_rx_buf[0],
+			      sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT);
+}
+
+int datamode_rsp_send(const uint8_t *data, size_t len)
+{
+#if defined(CONFIG_SLM_CMUX)
+	if (cmux_active) {
+		return slm_cmux_send(SLM_CMUX_DLCI_DATA, data, len);
+	}
+#endif
+	return uart_send(data, len);
 }
 
 static int set_uart_baudrate(uint32_t baudrate)
@@ -203,6 +306,10 @@ static void handle_at_clac(void)
 #if defined(CONFIG_SLM_HTTPC)
 	slm_at_httpc_clac();
 #endif
+#if defined(CONFIG_SLM_CMUX)
+	rsp_send(AT_CMD_CMUX, sizeof(AT_CMD_CMUX) - 1);
+	rsp_send("\r\n", 2);
+#endif
 }
 
 static int handle_at_sleep(const char *at_cmd, enum shutdown_modes *mode)
@@ -316,178 +423,325 @@ static int handle_at_slmuart(const char *at_cmd, uint32_t *baudrate)
 	return ret;
 }
 
-static void cmd_send(struct k_work *work)
+static int at_slmver(const char *at_cmd, size_t length)
 {
-	size_t chars;
-	char str[24];
-	static char buf[AT_MAX_CMD_LEN];
-	enum at_cmd_state state;
+	ARG_UNUSED(at_cmd);
+	ARG_UNUSED(length);
+
+	rsp_send(SLM_VERSION, sizeof(SLM_VERSION) - 1);
+	return 0;
+}
+
+static int at_slmuart(const char *at_cmd, size_t length)
+{
+	uint32_t baudrate = 0;
 	int err;
 
-	ARG_UNUSED(work);
+	ARG_UNUSED(length);
 
-	/* Make sure the string is 0-terminated */
-	at_buf[MIN(at_buf_len, AT_MAX_CMD_LEN - 1)] = 0;
+	err = handle_at_slmuart(at_cmd, &baudrate);
+	if (err) {
+		return err;
+	}
+	rsp_send(OK_STR, sizeof(OK_STR) - 1);
+	if (baudrate > 0) {
+		k_sleep(K_MSEC(50));
+		set_uart_baudrate(baudrate);
+	}
 
-	LOG_HEXDUMP_DBG(at_buf, at_buf_len, "RX");
+	return CMD_RSP_SENT;
+}
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLMVER)) {
-		rsp_send(SLM_VERSION, sizeof(SLM_VERSION) - 1);
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+static int at_reset(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(at_cmd);
+	ARG_UNUSED(length);
+
+	rsp_send(OK_STR, sizeof(OK_STR) - 1);
+	k_sleep(K_MSEC(50));
+	slm_at_host_uninit();
+	enter_sleep(false);
+	sys_reboot(SYS_REBOOT_COLD);
+
+	return CMD_RX_OFF;
+}
+
+static int at_clac(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(at_cmd);
+	ARG_UNUSED(length);
+
+	handle_at_clac();
+	return 0;
+}
+
+static int at_sleep(const char *at_cmd, size_t length)
+{
+	enum shutdown_modes mode = SHUTDOWN_MODE_INVALID;
+	int err;
+
+	ARG_UNUSED(length);
+
+	err = handle_at_sleep(at_cmd, &mode);
+	if (err) {
+		return err;
+	}
+	if (mode == SHUTDOWN_MODE_INVALID) {
+		/*Test command*/
+		return 0;
 	}
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLMUART)) {
-		uint32_t baudrate;
+	/*Entered IDLE*/
+	return CMD_RX_OFF;
+}
 
-		err = handle_at_slmuart(at_buf, &baudrate);
-		if (err != 0) {
-			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-			goto done;
-		} else {
-			rsp_send(OK_STR, sizeof(OK_STR) - 1);
-			k_sleep(K_MSEC(50));
-			set_uart_baudrate(baudrate);
-			goto done;
-		}
+#if defined(CONFIG_SLM_CMUX)
+static void cmux_rx_ready(uint8_t dlci)
+{
+	if (dlci == SLM_CMUX_DLCI_AT) {
+		k_work_submit(&cmux_at_work);
+	} else if (dlci == SLM_CMUX_DLCI_DATA) {
+		k_work_submit(&datamode_send_work);
 	}
+}
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_RESET)) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		k_sleep(K_MSEC(50));
-		slm_at_host_uninit();
-		enter_sleep(false);
-		sys_reboot(SYS_REBOOT_COLD);
+static void cmux_state_changed(uint8_t dlci, bool open)
+{
+	if (open) {
+		return;
+	}
+	if (dlci == SLM_CMUX_DLCI_DATA && datamode_handler != NULL) {
+		/* Closing the data channel ends the data mode */
+		datamode_terminated = true;
+		k_work_submit(&datamode_send_work);
+	} else if (dlci == SLM_CMUX_DLCI_CTRL) {
+		cmux_active = false;
 	}
+}
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_CLAC)) {
-		handle_at_clac();
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+static int handle_at_cmux(const char *at_cmd)
+{
+	enum at_cmd_type type;
+	uint16_t mode, subset, n1;
+	int param_count;
+	char buf[32];
+	int ret;
+
+	ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
+	if (ret < 0) {
+		LOG_ERR("Failed to parse AT command %d", ret);
+		return -EINVAL;
 	}
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLEEP)) {
-		enum shutdown_modes mode = SHUTDOWN_MODE_INVALID;
+	type = at_parser_cmd_type_get(at_cmd);
+	if (type == AT_CMD_TYPE_READ_COMMAND) {
+		sprintf(buf, "+CMUX: %d,0,,%d\r\n", cmux_cfg.mode,
+			cmux_cfg.n1);
+		rsp_send(buf, strlen(buf));
+		return 0;
+	}
+	if (type == AT_CMD_TYPE_TEST_COMMAND) {
+		sprintf(buf, "+CMUX: (0,1),(0),,(1-%d)\r\n",
+			CONFIG_SLM_CMUX_N1_MAX);
+		rsp_send(buf, strlen(buf));
+		return 0;
+	}
+	if (type != AT_CMD_TYPE_SET_COMMAND) {
+		return -EINVAL;
+	}
+	if (cmux_active) {
+		return -EBUSY;
+	}
 
-		err = handle_at_sleep(at_buf, &mode);
-		if (err) {
-			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-			goto done;
-		} else {
-			if (mode == SHUTDOWN_MODE_INVALID) {
-				/*Test command*/
-				rsp_send(OK_STR, sizeof(OK_STR) - 1);
-				goto done;
-			} else {
-				/*Entered IDLE*/
-				return;
-			}
+	param_count = at_params_valid_count_get(&at_param_list);
+	ret = at_params_short_get(&at_param_list, 1, &mode);
+	if (ret < 0 || mode > SLM_CMUX_MODE_ADVANCED) {
+		return -EINVAL;
+	}
+	/* Only UIH frames are supported */
+	if (param_count > 2) {
+		ret = at_params_short_get(&at_param_list, 2, &subset);
+		if (ret < 0 || subset != 0) {
+			return -EINVAL;
 		}
 	}
-
-	err = slm_at_tcp_proxy_parse(at_buf, at_buf_len);
-	if (err > 0) {
-		goto done;
-	} else if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+	n1 = (mode == SLM_CMUX_MODE_BASIC) ?
+		SLM_CMUX_N1_BASIC : SLM_CMUX_N1_ADVANCED;
+	if (param_count > 4) {
+		ret = at_params_short_get(&at_param_list, 4, &n1);
+		if (ret < 0 || n1 == 0 || n1 > CONFIG_SLM_CMUX_N1_MAX) {
+			return -EINVAL;
+		}
 	}
 
-	err = slm_at_udp_proxy_parse(at_buf, at_buf_len);
-	if (err > 0) {
-		goto done;
-	} else if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+	cmux_cfg.mode = mode;
+	cmux_cfg.n1 = n1;
+	cmux_cfg.write = uart_send;
+	cmux_cfg.rx_ready = cmux_rx_ready;
+	cmux_cfg.state_changed = cmux_state_changed;
+
+	/* Only respond OK once the multiplexer is ready to take frames */
+	ring_buf_reset(&cmux_rx_buf);
+	ret = slm_cmux_start(&cmux_cfg);
+	if (ret) {
+		LOG_ERR("Multiplexer not started: %d", ret);
+		return ret;
 	}
 
-	err = slm_at_tcpip_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+	/* The response is the last output without framing */
+	ret = uart_send(OK_STR, sizeof(OK_STR) - 1);
+	if (ret) {
+		slm_cmux_stop();
+		return ret;
 	}
+	k_sem_take(&tx_done, K_FOREVER);
+	k_sem_give(&tx_done);
+	cmux_active = true;
+
+	return CMD_RSP_SENT;
+}
+
+static int at_cmux(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return handle_at_cmux(at_cmd);
+}
+#endif
+
+static int tcp_proxy_parse(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return slm_at_tcp_proxy_parse(at_cmd);
+}
+
+static int udp_proxy_parse(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return slm_at_udp_proxy_parse(at_cmd);
+}
+
+static int tcpip_parse(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return slm_at_tcpip_parse(at_cmd);
+}
 
 #if defined(CONFIG_SLM_NATIVE_TLS)
-	err = slm_at_cmng_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+static int cmng_parse(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return slm_at_cmng_parse(at_cmd);
+}
 #endif
 
-	err = slm_at_icmp_parse(at_buf);
-	if (err == 0) {
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+static int icmp_parse(const char *at_cmd, size_t length)
+{
+	int err;
 
-	err = slm_at_fota_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+	ARG_UNUSED(length);
+
+	/* Ping sends its own response */
+	err = slm_at_icmp_parse(at_cmd);
+	return (err == 0) ? CMD_RSP_SENT : err;
+}
+
+static int fota_parse(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return slm_at_fota_parse(at_cmd);
+}
 
 #if defined(CONFIG_SLM_GPS)
-	err = slm_at_gps_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+static int gps_parse(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return slm_at_gps_parse(at_cmd);
+}
 #endif
 
 #if defined(CONFIG_SLM_FTPC)
-	err = slm_at_ftp_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+static int ftp_parse(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return slm_at_ftp_parse(at_cmd);
+}
 #endif
 
 #if defined(CONFIG_SLM_MQTTC)
-	err = slm_at_mqtt_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+static int mqtt_parse(const char *at_cmd, size_t length)
+{
+	ARG_UNUSED(length);
+
+	return slm_at_mqtt_parse(at_cmd);
+}
 #endif
 
+/* All SLM AT commands, sorted by name for slm_util_at_cmd_find(). */
+static const struct slm_at_cmd slm_at_cmds[] = {
+#define SLM_AT_CMD(_name, _handler) {_name, _handler},
+#include "slm_at_cmds.h"
+#undef SLM_AT_CMD
+};
+
 #if defined(CONFIG_SLM_HTTPC)
-	err = slm_at_httpc_parse(at_buf, at_buf_len);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+/* Input that is passed on as HTTP request payload */
+static const struct slm_at_cmd httpc_payload = {
+	NULL, slm_at_httpc_parse
+};
+#endif
+
+static const struct slm_at_cmd *cmd_find(const char *at_cmd)
+{
+	const struct slm_at_cmd *cmd;
+
+	cmd = slm_util_at_cmd_find(at_cmd, slm_at_cmds,
+				   ARRAY_SIZE(slm_at_cmds),
+				   sizeof(slm_at_cmds[0]));
+#if defined(CONFIG_SLM_HTTPC)
+	if (cmd == NULL && slm_at_httpc_payload_pending()) {
+		return &httpc_payload;
 	}
 #endif
 
+	return cmd;
+}
+
+/* Returns false if UART RX must stay disabled */
+static bool cmd_handle(void)
+{
+	size_t chars;
+	char str[24];
+	static char buf[AT_MAX_CMD_LEN];
+	const struct slm_at_cmd *cmd;
+	enum at_cmd_state state;
+	int err;
+
+	/* Make sure the string is 0-terminated */
+	at_buf[MIN(at_buf_len, AT_MAX_CMD_LEN - 1)] = 0;
+
+	LOG_HEXDUMP_DBG(at_buf, at_buf_len, "RX");
+
+	cmd = cmd_find(at_buf);
+	if (cmd != NULL) {
+		err = cmd->handler(at_buf, at_buf_len);
+		if (err == CMD_RX_OFF) {
+			return false;
+		} else if (err == 0) {
+			rsp_send(OK_STR, sizeof(OK_STR) - 1);
+		} else if (err < 0) {
+			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
+		}
+		return true;
+	}
+
 	/* Send to modem */
 	err = at_cmd_write(at_buf, buf, AT_MAX_CMD_LEN, &state);
 	if (err < 0) {
@@ -515,9 +769,20 @@ static void cmd_send(struct k_work *work)
 		break;
 	}
 
-done:
-	err = uart_rx_enable(uart_dev, uart_rx_buf[0],
-				sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT);
+	return true;
+}
+
+static void cmd_send(struct k_work *work)
+{
+	int err;
+
+	ARG_UNUSED(work);
+
+	if (!cmd_handle()) {
+		return;
+	}
+
+	err = uart_rx_restart();
 	if (err) {
 		LOG_ERR("UART RX failed: %d", err);
 		rsp_send(FATAL_STR, sizeof(FATAL_STR) - 1);
@@ -595,12 +860,240 @@ static void uart_rx_handler(uint8_t character)
 
 	return;
 send:
-	uart_rx_disable(uart_dev);
+#if defined(CONFIG_SLM_CMUX)
+	/* Already in a thread, and the UART keeps receiving frames */
+	if (cmux_active) {
+		at_buf_len = cmd_len;
+		cmd_len = 0;
+		(void)cmd_handle();
+		return;
+	}
+#endif
+	uart_rx_stop();
 	k_work_submit(&cmd_send_work);
 	at_buf_len = cmd_len;
 	cmd_len = 0;
 }
 
+static void datamode_rx_handler(const uint8_t *data, size_t len)
+{
+	enum slm_util_term_result result;
+	size_t released;
+
+	/* The terminator only counts when it is received on its own */
+	result = slm_util_term_input(&datamode_term, data, len,
+				     k_uptime_get_32(), &released);
+	if (released > 0 &&
+	    ring_buf_put(&datamode_buf, (const uint8_t *)DATAMODE_TERMINATOR,
+			 released) < released) {
+		LOG_WRN("Data mode buffer overflow");
+	}
+	if (result == SLM_UTIL_TERM_COMPLETE) {
+		k_delayed_work_submit(&datamode_term_work,
+				      K_MSEC(CONFIG_SLM_DATAMODE_GUARD_TIME));
+	} else if (result == SLM_UTIL_TERM_DATA &&
+		   ring_buf_put(&datamode_buf, data, len) < len) {
+		LOG_WRN("Data mode buffer overflow");
+	}
+
+	/* Stop receiving until the buffered data is sent. With hardware flow
+	 * control, this also holds the host back.
+	 */
+	if (ring_buf_space_get(&datamode_buf) < UART_RX_LEN &&
+	    !datamode_rx_stopped) {
+		datamode_rx_stopped = true;
+		uart_rx_stop();
+	}
+
+	k_work_submit(&datamode_send_work);
+}
+
+static void datamode_term_check(struct k_work *work)
+{
+	unsigned int key;
+	bool terminated;
+
+	ARG_UNUSED(work);
+
+	key = irq_lock();
+	terminated = slm_util_term_check(&datamode_term, k_uptime_get_32());
+	irq_unlock(key);
+
+	if (terminated && datamode_handler != NULL) {
+		datamode_terminated = true;
+		k_work_submit(&datamode_send_work);
+	}
+}
+
+static void datamode_send(struct k_work *work)
+{
+	slm_datamode_handler_t handler;
+	unsigned int key;
+	uint32_t len;
+	int err;
+
+	ARG_UNUSED(work);
+
+#if defined(CONFIG_SLM_CMUX)
+	/* AT commands are still received on their own channel */
+	if (cmux_active) {
+		static uint8_t buf[UART_RX_LEN];
+		int ret;
+
+		do {
+			ret = slm_cmux_recv(SLM_CMUX_DLCI_DATA, buf,
+					    sizeof(buf));
+			handler = datamode_handler;
+			if (ret > 0 && handler != NULL) {
+				err = handler(buf, ret);
+				if (err < 0) {
+					LOG_WRN("Data mode send failed: %d",
+						err);
+				}
+			}
+		} while (ret > 0);
+	}
+#endif
+
+	/* The AT command buffer is not used in data mode */
+	do {
+		key = irq_lock();
+		len = ring_buf_get(&datamode_buf, at_buf, sizeof(at_buf));
+		irq_unlock(key);
+
+		handler = datamode_handler;
+		if (len > 0 && handler != NULL) {
+			err = handler(at_buf, len);
+			if (err < 0) {
+				LOG_WRN("Data mode send failed: %d", err);
+			}
+		}
+	} while (len > 0);
+
+	if (datamode_terminated) {
+		exit_datamode();
+		rsp_send(OK_STR, sizeof(OK_STR) - 1);
+	}
+
+	if (datamode_rx_stopped) {
+		datamode_rx_stopped = false;
+		err = uart_rx_restart();
+		if (err) {
+			LOG_ERR("UART RX failed: %d", err);
+			rsp_send(FATAL_STR, sizeof(FATAL_STR) - 1);
+		}
+	}
+}
+
+int enter_datamode(slm_datamode_handler_t handler)
+{
+	if (handler == NULL) {
+		return -EINVAL;
+	}
+	if (datamode_handler != NULL) {
+		LOG_WRN("Already in data mode");
+		return -EBUSY;
+	}
+#if defined(CONFIG_SLM_CMUX)
+	if (cmux_active && !slm_cmux_is_open(SLM_CMUX_DLCI_DATA)) {
+		LOG_WRN("Data channel not open");
+		return -ENOTCONN;
+	}
+#endif
+
+	ring_buf_reset(&datamode_buf);
+	slm_util_term_init(&datamode_term, DATAMODE_TERMINATOR,
+			   CONFIG_SLM_DATAMODE_GUARD_TIME, k_uptime_get_32());
+	datamode_terminated = false;
+	datamode_handler = handler;
+	LOG_INF("Enter data mode");
+
+	return 0;
+}
+
+void exit_datamode(void)
+{
+	slm_datamode_handler_t handler = datamode_handler;
+
+	datamode_handler = NULL;
+	datamode_terminated = false;
+	k_delayed_work_cancel(&datamode_term_work);
+	if (handler != NULL) {
+		(void)handler(NULL, 0);
+		LOG_INF("Exit data mode");
+	}
+}
+
+bool in_datamode(void)
+{
+	return (datamode_handler != NULL);
+}
+
+#if defined(CONFIG_SLM_CMUX)
+static void cmux_rx_handler(const uint8_t *data, size_t len)
+{
+	if (ring_buf_put(&cmux_rx_buf, data, len) < len) {
+		LOG_WRN("Multiplexer RX buffer overflow");
+	}
+	if (ring_buf_space_get(&cmux_rx_buf) < UART_RX_LEN &&
+	    !cmux_rx_stopped) {
+		cmux_rx_stopped = true;
+		uart_rx_stop();
+	}
+
+	k_work_submit_to_queue(&cmux_wq, &cmux_rx_work);
+}
+
+static void cmux_rx(struct k_work *work)
+{
+	static uint8_t buf[UART_RX_LEN];
+	unsigned int key;
+	uint32_t len;
+	int err;
+
+	ARG_UNUSED(work);
+
+	do {
+		key = irq_lock();
+		len = ring_buf_get(&cmux_rx_buf, buf, sizeof(buf));
+		irq_unlock(key);
+
+		slm_cmux_input(buf, len);
+	} while (len > 0);
+
+	if (cmux_rx_stopped) {
+		cmux_rx_stopped = false;
+		err = uart_rx_restart();
+		if (err) {
+			LOG_ERR("UART RX failed: %d", err);
+			/* Nothing can be received, leave the multiplexer */
+			exit_datamode();
+			cmux_active = false;
+			slm_cmux_stop();
+			(void)uart_send(FATAL_STR, sizeof(FATAL_STR) - 1);
+		}
+	}
+}
+
+static void cmux_at_recv(struct k_work *work)
+{
+	uint8_t buf[32];
+	int len;
+
+	ARG_UNUSED(work);
+
+	while (cmux_active) {
+		len = slm_cmux_recv(SLM_CMUX_DLCI_AT, buf, sizeof(buf));
+		if (len <= 0) {
+			break;
+		}
+		for (int i = 0; i < len; i++) {
+			uart_rx_handler(buf[i]);
+		}
+	}
+}
+#endif
+
 static void uart_callback(const struct device *dev, struct uart_event *evt,
 			  void *user_data)
 {
@@ -622,6 +1115,20 @@ static void uart_callback(const struct device *dev, struct uart_event *evt,
 		LOG_INF("TX_ABORTED");
 		break;
 	case UART_RX_RDY:
+#if defined(CONFIG_SLM_CMUX)
+		if (cmux_active) {
+			cmux_rx_handler(&evt->data.rx.buf[pos],
+					evt->data.rx.len);
+			pos += evt->data.rx.len;
+			break;
+		}
+#endif
+		if (datamode_handler != NULL) {
+			datamode_rx_handler(&evt->data.rx.buf[pos],
+					    evt->data.rx.len);
+			pos += evt->data.rx.len;
+			break;
+		}
 		for (int i = pos; i < (pos + evt->data.rx.len); i++) {
 			uart_rx_handler(evt->data.rx.buf[i]);
 		}
@@ -643,6 +1150,7 @@ static void uart_callback(const struct device *dev, struct uart_event *evt,
 		break;
 	case UART_RX_DISABLED:
 		LOG_DBG("RX_DISABLED");
+		k_sem_give(&uart_rx_disabled);
 		break;
 	default:
 		break;
@@ -654,6 +1162,13 @@ int slm_at_host_init(void)
 	int err;
 	uint32_t start_time;
 
+	for (size_t i = 1; i < ARRAY_SIZE(slm_at_cmds); i++) {
+		__ASSERT(strcmp(slm_at_cmds[i - 1].name,
+				slm_at_cmds[i].name) < 0,
+			 "AT command table not sorted at %s",
+			 slm_at_cmds[i].name);
+	}
+
 	/* Initialize the UART module */
 #if defined(CONFIG_SLM_CONNECT_UART_0)
 	uart_dev = device_get_binding(DT_LABEL(DT_NODELABEL(uart0)));
@@ -763,6 +1278,14 @@ int slm_at_host_init(void)
 	}
 #endif
 	k_work_init(&cmd_send_work, cmd_send);
+	k_work_init(&datamode_send_work, datamode_send);
+	k_delayed_work_init(&datamode_term_work, datamode_term_check);
+#if defined(CONFIG_SLM_CMUX)
+	k_work_init(&cmux_rx_work, cmux_rx);
+	k_work_init(&cmux_at_work, cmux_at_recv);
+	k_work_q_start(&cmux_wq, cmux_wq_stack,
+		       K_THREAD_STACK_SIZEOF(cmux_wq_stack), CMUX_WQ_PRIORITY);
+#endif
 	k_sem_give(&tx_done);
 	rsp_send(SLM_SYNC_STR, sizeof(SLM_SYNC_STR)-1);
 
@@ -774,6 +1297,11 @@ void slm_at_host_uninit(void)
 {
 	int err;
 
+	exit_datamode();
+#if defined(CONFIG_SLM_CMUX)
+	cmux_active = false;
+	slm_cmux_stop();
+#endif
 	err = slm_at_tcp_proxy_uninit();
 	if (err) {
 		LOG_WRN("TCP Server could not be uninitialized: %d", err);
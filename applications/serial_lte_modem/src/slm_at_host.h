@@ -14,6 +14,7 @@
  */
 
 #include <zephyr/types.h>
+#include <stdbool.h>
 #include <ctype.h>
 #include <modem/at_cmd_parser.h>
 #include <modem/at_cmd.h>
@@ -37,6 +38,59 @@ enum slm_data_type_t {
 	DATATYPE_OMATLV
 };
 
+/**@brief Data mode handler type.
+ *
+ * @param data Raw data received from UART, or NULL when data mode ends.
+ * @param len  Length of the data.
+ *
+ * @retval Number of bytes sent, or a negative error code.
+ */
+typedef int (*slm_datamode_handler_t)(const uint8_t *data, int len);
+
+/**
+ * @brief Enter data mode
+ *
+ * In data mode, the UART input is passed to the handler as is, without
+ * looking for AT commands. The data mode ends when
+ * CONFIG_SLM_DATAMODE_TERMINATOR is received on its own, with a pause in
+ * the input before and after it.
+ *
+ * When the multiplexer is active, the data is received on the data channel
+ * instead, which must be open. The data mode ends when the channel is
+ * closed, and AT commands are still received on the AT channel.
+ *
+ * @param handler Handler for the data received in data mode.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int enter_datamode(slm_datamode_handler_t handler);
+
+/**
+ * @brief Exit data mode
+ *
+ * The handler is called with NULL data before this returns.
+ */
+void exit_datamode(void);
+
+/**
+ * @brief Send data received in data mode
+ *
+ * @param data Data to send to the host.
+ * @param len  Length of the data.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int datamode_rsp_send(const uint8_t *data, size_t len);
+
+/**
+ * @brief Check whether the AT host is in data mode
+ *
+ * @retval true If in data mode, false otherwise.
+ */
+bool in_datamode(void);
+
 /**
  * @brief Initialize AT host for serial LTE modem
  *
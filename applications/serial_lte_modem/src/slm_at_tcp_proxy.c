@@ -19,7 +19,7 @@ LOG_MODULE_REGISTER(tcp_proxy, CONFIG_SLM_LOG_LEVEL);
 
 #define THREAD_STACK_SIZE	(KB(3) + NET_IPV4_MTU)
 #define THREAD_PRIORITY		K_LOWEST_APPLICATION_THREAD_PRIO
-#define DATA_HEX_MAX_SIZE	(2 * NET_IPV4_MTU)
+#define HEX_CHUNK_SIZE		32
 
 /**@brief Proxy operations. */
 enum slm_tcp_proxy_operation {
@@ -60,21 +60,27 @@ static slm_at_cmd_list_t tcp_proxy_at_list[AT_TCP_PROXY_MAX] = {
 	{AT_TCP_RECV, "AT#XTCPRECV", handle_at_tcp_recv},
 };
 
-RING_BUF_DECLARE(data_buf, CONFIG_AT_CMD_RESPONSE_MAX_LEN / 2);
-static uint8_t data_hex[DATA_HEX_MAX_SIZE];
-static struct k_thread tcp_thread;
-static K_THREAD_STACK_DEFINE(tcp_thread_stack, THREAD_STACK_SIZE);
-static k_tid_t tcp_thread_id;
-K_TIMER_DEFINE(conn_timer, NULL, NULL);
-
-static struct sockaddr_in remote;
 static struct tcp_proxy_t {
 	int sock; /* Socket descriptor. */
 	sec_tag_t sec_tag; /* Security tag of the credential */
 	int sock_peer; /* Socket descriptor for peer. */
 	int role; /* Client or Server proxy */
 	bool datamode; /* Data mode flag*/
-} proxy;
+	struct sockaddr_in remote; /* Remote address */
+	struct ring_buf data_buf; /* RX data waiting for AT#XTCPRECV */
+	uint8_t data[CONFIG_SLM_TCP_PROXY_RX_BUF_SIZE];
+	struct k_sem data_fetched; /* Given by AT#XTCPRECV */
+	struct k_timer conn_timer; /* Connection time-out of server */
+	struct k_thread thread;
+	k_tid_t thread_id;
+} proxies[CONFIG_SLM_TCP_PROXY_COUNT];
+
+static K_THREAD_STACK_ARRAY_DEFINE(tcp_thread_stacks,
+				   CONFIG_SLM_TCP_PROXY_COUNT,
+				   THREAD_STACK_SIZE);
+
+/* Proxy in data mode */
+static struct tcp_proxy_t *datamode_proxy;
 
 /* global functions defined in different files */
 void rsp_send(const uint8_t *str, size_t len);
@@ -87,11 +93,105 @@ extern char rsp_buf[CONFIG_AT_CMD_RESPONSE_MAX_LEN];
 /** forward declaration of thread function **/
 static void tcp_thread_func(void *p1, void *p2, void *p3);
 
-static int do_tcp_server_start(uint16_t port, int sec_tag)
+static void proxy_reset(struct tcp_proxy_t *proxy)
+{
+	proxy->sock = INVALID_SOCKET;
+	proxy->sec_tag = INVALID_SEC_TAG;
+	proxy->sock_peer = INVALID_SOCKET;
+	proxy->role = INVALID_ROLE;
+	proxy->datamode = false;
+	ring_buf_reset(&proxy->data_buf);
+}
+
+static struct tcp_proxy_t *proxy_alloc(void)
+{
+	for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+		if (proxies[i].sock == INVALID_SOCKET) {
+			return &proxies[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Find proxy by role and handle, INVALID_ROLE matches any role. Without
+ * a handle, the first proxy with the role is returned.
+ */
+static struct tcp_proxy_t *proxy_find(int role, int handle)
+{
+	for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+		if (proxies[i].sock == INVALID_SOCKET) {
+			continue;
+		}
+		if (role != INVALID_ROLE && proxies[i].role != role) {
+			continue;
+		}
+		if (handle == INVALID_SOCKET || proxies[i].sock == handle) {
+			return &proxies[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void proxy_thread_start(struct tcp_proxy_t *proxy)
+{
+	proxy->thread_id = k_thread_create(&proxy->thread,
+			tcp_thread_stacks[proxy - proxies],
+			K_THREAD_STACK_SIZEOF(tcp_thread_stacks[0]),
+			tcp_thread_func, proxy, NULL, NULL,
+			THREAD_PRIORITY, K_USER, K_NO_WAIT);
+}
+
+static void proxy_thread_stop(struct tcp_proxy_t *proxy)
+{
+	/* The thread returns by itself when it closes the proxy */
+	if (proxy->thread_id != k_current_get()) {
+		k_thread_abort(proxy->thread_id);
+	}
+}
+
+static int do_tcp_send_datamode(struct tcp_proxy_t *proxy,
+				const uint8_t *data, int datalen);
+
+static int tcp_datamode_callback(const uint8_t *data, int len)
+{
+	struct tcp_proxy_t *proxy = datamode_proxy;
+
+	if (proxy == NULL) {
+		return -ENOTCONN;
+	}
+	if (data == NULL) {
+		/* Data mode ended */
+		proxy->datamode = false;
+		datamode_proxy = NULL;
+		return 0;
+	}
+
+	return do_tcp_send_datamode(proxy, data, len);
+}
+
+static int proxy_datamode_enter(struct tcp_proxy_t *proxy)
+{
+	int err;
+
+	err = enter_datamode(tcp_datamode_callback);
+	if (err) {
+		return err;
+	}
+	proxy->datamode = true;
+	datamode_proxy = proxy;
+
+	return 0;
+}
+
+static int do_tcp_server_start(struct tcp_proxy_t *proxy, uint16_t port,
+			       int sec_tag)
 {
 	int ret = 0;
 	struct sockaddr_in local;
 	int addr_len;
+	int sock;
 
 #if defined(CONFIG_SLM_NATIVE_TLS)
 	if (sec_tag != INVALID_SEC_TAG) {
@@ -104,11 +204,11 @@ static int do_tcp_server_start(uint16_t port, int sec_tag)
 #endif
 	/* Open socket */
 	if (sec_tag == INVALID_SEC_TAG) {
-		proxy.sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 	} else {
-		proxy.sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+		sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
 	}
-	if (proxy.sock < 0) {
+	if (sock < 0) {
 		LOG_ERR("socket() failed: %d", -errno);
 		sprintf(rsp_buf, "#XTCPSVR: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
@@ -118,13 +218,13 @@ static int do_tcp_server_start(uint16_t port, int sec_tag)
 	if (sec_tag != INVALID_SEC_TAG) {
 		sec_tag_t sec_tag_list[1] = { sec_tag };
 
-		ret = setsockopt(proxy.sock, SOL_TLS, TLS_SEC_TAG_LIST,
+		ret = setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST,
 				sec_tag_list, sizeof(sec_tag_t));
 		if (ret) {
 			LOG_ERR("set tag list failed: %d", -errno);
 			sprintf(rsp_buf, "#XTCPSVR: %d\r\n", -errno);
 			rsp_send(rsp_buf, strlen(rsp_buf));
-			close(proxy.sock);
+			close(sock);
 			return -errno;
 		}
 	}
@@ -136,106 +236,112 @@ static int do_tcp_server_start(uint16_t port, int sec_tag)
 	ret = modem_info_params_get(&modem_param);
 	if (ret) {
 		LOG_ERR("Unable to obtain modem parameters (%d)", ret);
-		close(proxy.sock);
+		close(sock);
 		return ret;
 	}
 	addr_len = strlen(modem_param.network.ip_address.value_string);
 	if (addr_len == 0) {
 		LOG_ERR("LTE not connected yet");
-		close(proxy.sock);
+		close(sock);
 		return -EINVAL;
 	}
 	if (!check_for_ipv4(modem_param.network.ip_address.value_string,
 			addr_len)) {
 		LOG_ERR("Invalid local address");
-		close(proxy.sock);
+		close(sock);
 		return -EINVAL;
 	}
 	if (inet_pton(AF_INET, modem_param.network.ip_address.value_string,
 		&local.sin_addr) != 1) {
 		LOG_ERR("Parse local IP address failed: %d", -errno);
-		close(proxy.sock);
+		close(sock);
 		return -EINVAL;
 	}
 
-	ret = bind(proxy.sock, (struct sockaddr *)&local,
+	ret = bind(sock, (struct sockaddr *)&local,
 		 sizeof(struct sockaddr_in));
 	if (ret) {
 		LOG_ERR("bind() failed: %d", -errno);
 		sprintf(rsp_buf, "#XTCPSVR: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
-		close(proxy.sock);
+		close(sock);
 		return -errno;
 	}
 
 	/* Enable listen */
-	ret = listen(proxy.sock, 1);
+	ret = listen(sock, 1);
 	if (ret < 0) {
 		LOG_ERR("listen() failed: %d", -errno);
 		sprintf(rsp_buf, "#XTCPSVR: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
-		close(proxy.sock);
+		close(sock);
 		return -errno;
 	}
 
-	tcp_thread_id = k_thread_create(&tcp_thread, tcp_thread_stack,
-			K_THREAD_STACK_SIZEOF(tcp_thread_stack),
-			tcp_thread_func, NULL, NULL, NULL,
-			THREAD_PRIORITY, K_USER, K_NO_WAIT);
-	proxy.role = AT_TCP_ROLE_SERVER;
-	sprintf(rsp_buf, "#XTCPSVR: %d started\r\n", proxy.sock);
+	proxy->sock = sock;
+	proxy->sec_tag = sec_tag;
+	proxy->role = AT_TCP_ROLE_SERVER;
+	proxy_thread_start(proxy);
+	sprintf(rsp_buf, "#XTCPSVR: %d started\r\n", proxy->sock);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
 	return ret;
 }
 
-static int do_tcp_server_stop(int error)
+/* Also called from the proxy thread, so rsp_buf is not used */
+static int do_tcp_server_stop(struct tcp_proxy_t *proxy, int error)
 {
+	char rsp[48];
 	int ret = 0;
 
-	if (proxy.sock > 0) {
-		k_timer_stop(&conn_timer);
-		k_thread_abort(tcp_thread_id);
-		if (proxy.sock_peer != INVALID_SOCKET) {
-			close(proxy.sock_peer);
+	if (proxy->sock != INVALID_SOCKET) {
+		k_timer_stop(&proxy->conn_timer);
+		proxy_thread_stop(proxy);
+		if (proxy->datamode) {
+			exit_datamode();
 		}
-		ret = close(proxy.sock);
+		if (proxy->sock_peer != INVALID_SOCKET) {
+			close(proxy->sock_peer);
+		}
+		ret = close(proxy->sock);
 		if (ret < 0) {
 			LOG_WRN("close() failed: %d", -errno);
 			ret = -errno;
 		}
 #if defined(CONFIG_SLM_NATIVE_TLS)
-		if (proxy.sec_tag != INVALID_SEC_TAG) {
-			ret = slm_tls_unloadcrdl(proxy.sec_tag);
+		if (proxy->sec_tag != INVALID_SEC_TAG) {
+			ret = slm_tls_unloadcrdl(proxy->sec_tag);
 			if (ret < 0) {
 				LOG_ERR("Fail to unload credential: %d", ret);
 			}
 		}
 #endif
-		(void)slm_at_tcp_proxy_init();
+		proxy_reset(proxy);
 		if (error) {
-			sprintf(rsp_buf, "#XTCPSVR: %d stopped\r\n", error);
+			sprintf(rsp, "#XTCPSVR: %d stopped\r\n", error);
 		} else {
-			sprintf(rsp_buf, "#XTCPSVR: stopped\r\n");
+			sprintf(rsp, "#XTCPSVR: stopped\r\n");
 		}
-		rsp_send(rsp_buf, strlen(rsp_buf));
+		rsp_send(rsp, strlen(rsp));
 	}
 
 	return ret;
 }
 
-static int do_tcp_client_connect(const char *url, uint16_t port, int sec_tag)
+static int do_tcp_client_connect(struct tcp_proxy_t *proxy, const char *url,
+				 uint16_t port, int sec_tag)
 {
 	int ret;
+	int sock;
 
 	/* Open socket */
 	if (sec_tag == INVALID_SEC_TAG) {
-		proxy.sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 	} else {
-		proxy.sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+		sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
 
 	}
-	if (proxy.sock < 0) {
+	if (sock < 0) {
 		LOG_ERR("socket() failed: %d", -errno);
 		sprintf(rsp_buf, "#XTCPCLI: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
@@ -244,27 +350,27 @@ static int do_tcp_client_connect(const char *url, uint16_t port, int sec_tag)
 	if (sec_tag != INVALID_SEC_TAG) {
 		sec_tag_t sec_tag_list[1] = { sec_tag };
 
-		ret = setsockopt(proxy.sock, SOL_TLS, TLS_SEC_TAG_LIST,
+		ret = setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST,
 				sec_tag_list, sizeof(sec_tag_t));
 		if (ret) {
 			LOG_ERR("set tag list failed: %d", -errno);
 			sprintf(rsp_buf, "#XTCPCLI: %d\r\n", -errno);
 			rsp_send(rsp_buf, strlen(rsp_buf));
-			close(proxy.sock);
+			close(sock);
 			return -errno;
 		}
 	}
 
 	/* Connect to remote host */
 	if (check_for_ipv4(url, strlen(url))) {
-		remote.sin_family = AF_INET;
-		remote.sin_port = htons(port);
+		proxy->remote.sin_family = AF_INET;
+		proxy->remote.sin_port = htons(port);
 		LOG_DBG("IPv4 Address %s", log_strdup(url));
 		/* NOTE inet_pton() returns 1 as success */
-		ret = inet_pton(AF_INET, url, &remote.sin_addr);
+		ret = inet_pton(AF_INET, url, &proxy->remote.sin_addr);
 		if (ret != 1) {
 			LOG_ERR("inet_pton() failed: %d", ret);
-			close(proxy.sock);
+			close(sock);
 			return -EINVAL;
 		}
 	} else {
@@ -277,77 +383,80 @@ static int do_tcp_client_connect(const char *url, uint16_t port, int sec_tag)
 		ret = getaddrinfo(url, NULL, &hints, &result);
 		if (ret || result == NULL) {
 			LOG_ERR("getaddrinfo() failed: %d", ret);
-			close(proxy.sock);
+			close(sock);
 			return -EINVAL;
 		}
 
-		remote.sin_family = AF_INET;
-		remote.sin_port = htons(port);
-		remote.sin_addr.s_addr =
+		proxy->remote.sin_family = AF_INET;
+		proxy->remote.sin_port = htons(port);
+		proxy->remote.sin_addr.s_addr =
 		((struct sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
 		/* Free the address. */
 		freeaddrinfo(result);
 	}
 
-	ret = connect(proxy.sock, (struct sockaddr *)&remote,
+	ret = connect(sock, (struct sockaddr *)&proxy->remote,
 		sizeof(struct sockaddr_in));
 	if (ret < 0) {
 		LOG_ERR("connect() failed: %d", -errno);
 		sprintf(rsp_buf, "#XTCPCLI: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
-		close(proxy.sock);
+		close(sock);
 		return -errno;
 	}
 
-	tcp_thread_id = k_thread_create(&tcp_thread, tcp_thread_stack,
-			K_THREAD_STACK_SIZEOF(tcp_thread_stack),
-			tcp_thread_func, NULL, NULL, NULL,
-			THREAD_PRIORITY, K_USER, K_NO_WAIT);
-
-	proxy.role = AT_TCP_ROLE_CLIENT;
-	sprintf(rsp_buf, "#XTCPCLI: %d connected\r\n", proxy.sock);
+	proxy->sock = sock;
+	proxy->sec_tag = sec_tag;
+	proxy->role = AT_TCP_ROLE_CLIENT;
+	proxy_thread_start(proxy);
+	sprintf(rsp_buf, "#XTCPCLI: %d connected\r\n", proxy->sock);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
 	return ret;
 }
 
-static int do_tcp_client_disconnect(int error)
+/* Also called from the proxy thread, so rsp_buf is not used */
+static int do_tcp_client_disconnect(struct tcp_proxy_t *proxy, int error)
 {
+	char rsp[48];
 	int ret = 0;
 
-	if (proxy.sock > 0) {
-		k_thread_abort(tcp_thread_id);
-		ret = close(proxy.sock);
+	if (proxy->sock != INVALID_SOCKET) {
+		proxy_thread_stop(proxy);
+		if (proxy->datamode) {
+			exit_datamode();
+		}
+		ret = close(proxy->sock);
 		if (ret < 0) {
 			LOG_WRN("close() failed: %d", -errno);
 			ret = -errno;
 		}
-		(void)slm_at_tcp_proxy_init();
+		proxy_reset(proxy);
 		if (error) {
-			sprintf(rsp_buf, "#XTCPCLI: %d disconnected\r\n",
-				error);
+			sprintf(rsp, "#XTCPCLI: %d disconnected\r\n", error);
 		} else {
-			sprintf(rsp_buf, "#XTCPCLI: disconnected\r\n");
+			sprintf(rsp, "#XTCPCLI: disconnected\r\n");
 		}
-		rsp_send(rsp_buf, strlen(rsp_buf));
+		rsp_send(rsp, strlen(rsp));
 	}
 
 	return ret;
 }
 
-static int do_tcp_send(const uint8_t *data, int datalen)
+static int do_tcp_send(struct tcp_proxy_t *proxy, const uint8_t *data,
+		       int datalen)
 {
 	int ret = 0;
 	uint32_t offset = 0;
 	int sock;
 
-	if (proxy.role == AT_TCP_ROLE_CLIENT &&
-	    proxy.sock != INVALID_SOCKET) {
-		sock = proxy.sock;
-	} else if (proxy.role == AT_TCP_ROLE_SERVER &&
-		   proxy.sock_peer != INVALID_SOCKET) {
-		sock = proxy.sock_peer;
-		k_timer_stop(&conn_timer);
+	if (proxy->role == AT_TCP_ROLE_CLIENT &&
+	    proxy->sock != INVALID_SOCKET) {
+		sock = proxy->sock;
+	} else if (proxy->role == AT_TCP_ROLE_SERVER &&
+		   proxy->sock_peer != INVALID_SOCKET) {
+		sock = proxy->sock_peer;
+		k_timer_stop(&proxy->conn_timer);
 	} else {
 		LOG_ERR("Not connected yet");
 		return -EINVAL;
@@ -358,10 +467,10 @@ static int do_tcp_send(const uint8_t *data, int datalen)
 		if (ret < 0) {
 			LOG_ERR("send() failed: %d", -errno);
 			if (errno != EAGAIN && errno != ETIMEDOUT) {
-				if (proxy.role == AT_TCP_ROLE_CLIENT) {
-					do_tcp_client_disconnect(-errno);
+				if (proxy->role == AT_TCP_ROLE_CLIENT) {
+					do_tcp_client_disconnect(proxy, -errno);
 				} else {
-					do_tcp_server_stop(-errno);
+					do_tcp_server_stop(proxy, -errno);
 				}
 			} else {
 				sprintf(rsp_buf, "#XTCPSEND: %d\r\n", -errno);
@@ -377,9 +486,9 @@ static int do_tcp_send(const uint8_t *data, int datalen)
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
 	/* restart activity timer */
-	if (proxy.role == AT_TCP_ROLE_SERVER) {
-		k_timer_start(&conn_timer, K_SECONDS(CONFIG_SLM_TCP_CONN_TIME),
-			K_NO_WAIT);
+	if (proxy->role == AT_TCP_ROLE_SERVER) {
+		k_timer_start(&proxy->conn_timer,
+			      K_SECONDS(CONFIG_SLM_TCP_CONN_TIME), K_NO_WAIT);
 	}
 
 	if (ret >= 0) {
@@ -389,19 +498,20 @@ static int do_tcp_send(const uint8_t *data, int datalen)
 	}
 }
 
-static int do_tcp_send_datamode(const uint8_t *data, int datalen)
+static int do_tcp_send_datamode(struct tcp_proxy_t *proxy,
+				const uint8_t *data, int datalen)
 {
 	int ret = 0;
 	uint32_t offset = 0;
 	int sock;
 
-	if (proxy.role == AT_TCP_ROLE_CLIENT &&
-	    proxy.sock != INVALID_SOCKET) {
-		sock = proxy.sock;
-	} else if (proxy.role == AT_TCP_ROLE_SERVER &&
-		   proxy.sock_peer != INVALID_SOCKET) {
-		sock = proxy.sock_peer;
-		k_timer_stop(&conn_timer);
+	if (proxy->role == AT_TCP_ROLE_CLIENT &&
+	    proxy->sock != INVALID_SOCKET) {
+		sock = proxy->sock;
+	} else if (proxy->role == AT_TCP_ROLE_SERVER &&
+		   proxy->sock_peer != INVALID_SOCKET) {
+		sock = proxy->sock_peer;
+		k_timer_stop(&proxy->conn_timer);
 	} else {
 		LOG_ERR("Not connected yet");
 		return -EINVAL;
@@ -418,77 +528,105 @@ static int do_tcp_send_datamode(const uint8_t *data, int datalen)
 	}
 
 	/* restart activity timer */
-	if (proxy.role == AT_TCP_ROLE_SERVER) {
-		k_timer_start(&conn_timer, K_SECONDS(CONFIG_SLM_TCP_CONN_TIME),
-			K_NO_WAIT);
+	if (proxy->role == AT_TCP_ROLE_SERVER) {
+		k_timer_start(&proxy->conn_timer,
+			      K_SECONDS(CONFIG_SLM_TCP_CONN_TIME), K_NO_WAIT);
 	}
 
 	return offset;
 }
 
-static int tcp_data_save(uint8_t *data, uint32_t length)
+static uint32_t tcp_data_save_hex(struct tcp_proxy_t *proxy,
+				  const uint8_t *data, uint32_t length)
 {
-	if (ring_buf_space_get(&data_buf) < length) {
-		return -1; /* RX overrun */
+	char hex[2 * HEX_CHUNK_SIZE + 1];
+	uint32_t saved = 0;
+	int ret;
+
+	/* Convert in small chunks, to avoid a buffer for the whole string */
+	for (uint32_t i = 0; i < length; i += HEX_CHUNK_SIZE) {
+		ret = slm_util_htoa(data + i, MIN(HEX_CHUNK_SIZE, length - i),
+				    hex, sizeof(hex));
+		if (ret < 0) {
+			LOG_ERR("hex convert error: %d", ret);
+			break;
+		}
+		saved += ring_buf_put(&proxy->data_buf, hex, ret);
 	}
 
-	return ring_buf_put(&data_buf, data, length);
+	return saved;
 }
 
 static void tcp_thread_func(void *p1, void *p2, void *p3)
 {
-	int ret;
+	struct tcp_proxy_t *proxy = p1;
+	char data[NET_IPV4_MTU];
+	char rsp[48];
 	struct pollfd fds;
-	int sock;
+	uint32_t size;
+	int ret;
 
-	ARG_UNUSED(p1);
 	ARG_UNUSED(p2);
 	ARG_UNUSED(p3);
 
 thread_entry:
-	if (proxy.role == AT_TCP_ROLE_SERVER) {
+	if (proxy->role == AT_TCP_ROLE_SERVER) {
 		socklen_t len = sizeof(struct sockaddr_in);
 		char peer_addr[INET_ADDRSTRLEN];
 
 		/* Accept incoming connection */;
 		LOG_DBG("Accept connection...");
-		proxy.sock_peer = INVALID_SOCKET;
-		ret = accept(proxy.sock, (struct sockaddr *)&remote, &len);
+		proxy->sock_peer = INVALID_SOCKET;
+		ret = accept(proxy->sock, (struct sockaddr *)&proxy->remote,
+			     &len);
 		if (ret < 0) {
 			LOG_ERR("accept() failed: %d", -errno);
-			do_tcp_server_stop(-errno);
+			do_tcp_server_stop(proxy, -errno);
 			return;
 		}
-		if (inet_ntop(AF_INET, &remote.sin_addr, peer_addr,
+		if (inet_ntop(AF_INET, &proxy->remote.sin_addr, peer_addr,
 			INET_ADDRSTRLEN) != NULL) {
-			sprintf(rsp_buf, "#XTCPSVR: %s connected\r\n",
-				peer_addr);
-			rsp_send(rsp_buf, strlen(rsp_buf));
+			sprintf(rsp, "#XTCPSVR: %s connected\r\n", peer_addr);
+			rsp_send(rsp, strlen(rsp));
 		}
-		proxy.sock_peer = ret;
+		proxy->sock_peer = ret;
 		/* Start a one-shot timer to close the connection */
-		k_timer_start(&conn_timer, K_SECONDS(CONFIG_SLM_TCP_CONN_TIME),
-			      K_NO_WAIT);
+		k_timer_start(&proxy->conn_timer,
+			      K_SECONDS(CONFIG_SLM_TCP_CONN_TIME), K_NO_WAIT);
 	}
 
-	if (proxy.role == AT_TCP_ROLE_SERVER) {
-		sock = proxy.sock_peer;
+	if (proxy->role == AT_TCP_ROLE_SERVER) {
+		fds.fd = proxy->sock_peer;
 	} else {
-		sock = proxy.sock;
+		fds.fd = proxy->sock;
 	}
-	fds.fd = sock;
 	fds.events = POLLIN;
-	ring_buf_reset(&data_buf);
+	ring_buf_reset(&proxy->data_buf);
 	while (true) {
-		if (proxy.role == AT_TCP_ROLE_SERVER &&
-			k_timer_status_get(&conn_timer) > 0) {
-			k_timer_stop(&conn_timer);
+		if (proxy->role == AT_TCP_ROLE_SERVER &&
+			k_timer_status_get(&proxy->conn_timer) > 0) {
+			k_timer_stop(&proxy->conn_timer);
 			LOG_INF("Connecion timeout");
-			sprintf(rsp_buf, "#XTCPSVR: timeout\r\n");
-			rsp_send(rsp_buf, strlen(rsp_buf));
-			close(proxy.sock_peer);
+			sprintf(rsp, "#XTCPSVR: timeout\r\n");
+			rsp_send(rsp, strlen(rsp));
+			close(proxy->sock_peer);
 			goto thread_entry;
 		}
+		if (proxy->datamode) {
+			size = sizeof(data);
+		} else {
+			/* Only receive what fits in the RX buffer, also as a
+			 * hexadecimal string. The rest waits in the socket
+			 * until AT#XTCPRECV makes room.
+			 */
+			size = MIN(sizeof(data),
+				   ring_buf_space_get(&proxy->data_buf) / 2);
+		}
+		if (size == 0) {
+			(void)k_sem_take(&proxy->data_fetched,
+				K_SECONDS(CONFIG_SLM_TCP_POLL_TIME));
+			continue;
+		}
 		ret = poll(&fds, 1, MSEC_PER_SEC * CONFIG_SLM_TCP_POLL_TIME);
 		if (ret < 0) {  /* IO error */
 			LOG_WRN("poll() error: %d", ret);
@@ -498,64 +636,54 @@ thread_entry:
 			continue;
 		}
 		LOG_DBG("Poll events 0x%08x", fds.revents);
-		if ((fds.revents & POLLIN) == POLLIN) {
-			char data[NET_IPV4_MTU];
-
-			/* stop activity timer */
-			if (proxy.role == AT_TCP_ROLE_SERVER) {
-				k_timer_stop(&conn_timer);
-			}
-			ret = recv(sock, data, NET_IPV4_MTU, 0);
-			if (ret < 0) {
-				LOG_WRN("recv() error: %d", -errno);
-				continue;
-			}
-			if (ret == 0) {
-				continue;
-			}
-			if (proxy.datamode) {
-				rsp_send(data, ret);
-			} else if (slm_util_hex_check(data, ret)) {
-				ret = slm_util_htoa(data, ret, data_hex,
-					DATA_HEX_MAX_SIZE);
-				if (ret < 0) {
-					LOG_ERR("hex convert error: %d", ret);
-					continue;
-				}
-				if (tcp_data_save(data_hex, ret) < 0) {
-					sprintf(rsp_buf,
-						"#XTCPDATA: overrun\r\n");
-				} else {
-					sprintf(rsp_buf,
-						"#XTCPDATA: %d, %d\r\n",
-						DATATYPE_HEXADECIMAL,
-						ret);
-				}
-				rsp_send(rsp_buf, strlen(rsp_buf));
-			} else {
-				if (tcp_data_save(data, ret) < 0) {
-					sprintf(rsp_buf,
-						"#XTCPDATA: overrun\r\n");
-				} else {
-					sprintf(rsp_buf,
-						"#XTCPDATA: %d, %d\r\n",
-						DATATYPE_PLAINTEXT, ret);
-				}
-				rsp_send(rsp_buf, strlen(rsp_buf));
-			}
-			/* restart activity timer */
-			if (proxy.role == AT_TCP_ROLE_SERVER) {
-				k_timer_start(
-					&conn_timer,
-					K_SECONDS(CONFIG_SLM_TCP_CONN_TIME),
-					K_NO_WAIT);
+		if ((fds.revents & POLLIN) != POLLIN) {
+			continue;
+		}
+		/* stop activity timer */
+		if (proxy->role == AT_TCP_ROLE_SERVER) {
+			k_timer_stop(&proxy->conn_timer);
+		}
+		ret = recv(fds.fd, data, size, 0);
+		if (ret < 0) {
+			LOG_WRN("recv() error: %d", -errno);
+			continue;
+		}
+		if (ret == 0) {
+			LOG_INF("Connection closed by peer");
+			if (proxy->role == AT_TCP_ROLE_CLIENT) {
+				do_tcp_client_disconnect(proxy, -ENOTCONN);
+				return;
 			}
+			sprintf(rsp, "#XTCPSVR: disconnected\r\n");
+			rsp_send(rsp, strlen(rsp));
+			close(proxy->sock_peer);
+			goto thread_entry;
+		}
+		if (proxy->datamode) {
+			(void)datamode_rsp_send(data, ret);
+		} else if (slm_util_hex_check(data, ret)) {
+			ret = tcp_data_save_hex(proxy, data, ret);
+			sprintf(rsp, "#XTCPDATA: %d, %d, %d\r\n",
+				DATATYPE_HEXADECIMAL, ret, proxy->sock);
+			rsp_send(rsp, strlen(rsp));
+		} else {
+			ret = ring_buf_put(&proxy->data_buf, data, ret);
+			sprintf(rsp, "#XTCPDATA: %d, %d, %d\r\n",
+				DATATYPE_PLAINTEXT, ret, proxy->sock);
+			rsp_send(rsp, strlen(rsp));
+		}
+		/* restart activity timer */
+		if (proxy->role == AT_TCP_ROLE_SERVER) {
+			k_timer_start(&proxy->conn_timer,
+				      K_SECONDS(CONFIG_SLM_TCP_CONN_TIME),
+				      K_NO_WAIT);
 		}
 	}
 }
 
 /**@brief handle AT#XTCPSVR commands
  *  AT#XTCPSVR=<op>[,<port>[,[sec_tag]]
+ *  AT#XTCPSVR=0[,<handle>]
  *  AT#XTCPSVR?
  *  AT#XTCPSVR=?
  */
@@ -564,6 +692,8 @@ static int handle_at_tcp_server(enum at_cmd_type cmd_type)
 	int err = -EINVAL;
 	uint16_t op;
 	int param_count = at_params_valid_count_get(&at_param_list);
+	struct tcp_proxy_t *proxy;
+	bool running = false;
 
 	switch (cmd_type) {
 	case AT_CMD_TYPE_SET_COMMAND:
@@ -577,7 +707,7 @@ static int handle_at_tcp_server(enum at_cmd_type cmd_type)
 		if (op == AT_SERVER_START ||
 		    op == AT_SERVER_START_WITH_DATAMODE) {
 			uint16_t port;
-			proxy.sec_tag = INVALID_SEC_TAG;
+			sec_tag_t sec_tag = INVALID_SEC_TAG;
 
 			if (param_count < 3) {
 				return -EINVAL;
@@ -587,31 +717,51 @@ static int handle_at_tcp_server(enum at_cmd_type cmd_type)
 				return err;
 			}
 			if (param_count > 3) {
-				at_params_int_get(&at_param_list, 3,
-						  &proxy.sec_tag);
+				at_params_int_get(&at_param_list, 3, &sec_tag);
+			}
+			proxy = proxy_alloc();
+			if (proxy == NULL) {
+				LOG_WRN("No free TCP proxy");
+				return -ENOMEM;
 			}
-			err = do_tcp_server_start(port, proxy.sec_tag);
+			err = do_tcp_server_start(proxy, port, sec_tag);
 			if (err == 0 && op == AT_SERVER_START_WITH_DATAMODE) {
-				proxy.datamode = true;
+				err = proxy_datamode_enter(proxy);
+				if (err) {
+					(void)do_tcp_server_stop(proxy, err);
+				}
 			}
 		} else if (op == AT_SERVER_STOP) {
-			if (proxy.sock < 0) {
+			int handle = INVALID_SOCKET;
+
+			if (param_count > 2) {
+				at_params_int_get(&at_param_list, 2, &handle);
+			}
+			proxy = proxy_find(AT_TCP_ROLE_SERVER, handle);
+			if (proxy == NULL) {
 				LOG_WRN("Server is not running");
 				return -EINVAL;
 			}
-			err = do_tcp_server_stop(0);
+			err = do_tcp_server_stop(proxy, 0);
 		} break;
 
 	case AT_CMD_TYPE_READ_COMMAND:
-		if (proxy.sock != INVALID_SOCKET &&
-		    proxy.role == AT_TCP_ROLE_SERVER) {
-			sprintf(rsp_buf, "#XTCPSVR: %d, %d, %d\r\n",
-				proxy.sock, proxy.sock_peer, proxy.datamode);
-		} else {
+		for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+			proxy = &proxies[i];
+			if (proxy->sock != INVALID_SOCKET &&
+			    proxy->role == AT_TCP_ROLE_SERVER) {
+				sprintf(rsp_buf, "#XTCPSVR: %d, %d, %d\r\n",
+					proxy->sock, proxy->sock_peer,
+					proxy->datamode);
+				rsp_send(rsp_buf, strlen(rsp_buf));
+				running = true;
+			}
+		}
+		if (!running) {
 			sprintf(rsp_buf, "#XTCPSVR: %d, %d\r\n",
 				INVALID_SOCKET, INVALID_SOCKET);
+			rsp_send(rsp_buf, strlen(rsp_buf));
 		}
-		rsp_send(rsp_buf, strlen(rsp_buf));
 		err = 0;
 		break;
 
@@ -632,6 +782,7 @@ static int handle_at_tcp_server(enum at_cmd_type cmd_type)
 
 /**@brief handle AT#XTCPCLI commands
  *  AT#XTCPCLI=<op>[,<url>,<port>[,[sec_tag]]
+ *  AT#XTCPCLI=0[,<handle>]
  *  AT#XTCPCLI?
  *  AT#XTCPCLI=?
  */
@@ -640,6 +791,8 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type)
 	int err = -EINVAL;
 	uint16_t op;
 	int param_count = at_params_valid_count_get(&at_param_list);
+	struct tcp_proxy_t *proxy;
+	bool connected = false;
 
 	switch (cmd_type) {
 	case AT_CMD_TYPE_SET_COMMAND:
@@ -655,7 +808,7 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type)
 			uint16_t port;
 			char url[TCPIP_MAX_URL];
 			int size = TCPIP_MAX_URL;
-			proxy.sec_tag = INVALID_SEC_TAG;
+			sec_tag_t sec_tag = INVALID_SEC_TAG;
 
 			if (param_count < 4) {
 				return -EINVAL;
@@ -671,31 +824,51 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type)
 				return err;
 			}
 			if (param_count > 4) {
-				at_params_int_get(&at_param_list,
-						  4, &proxy.sec_tag);
+				at_params_int_get(&at_param_list, 4, &sec_tag);
+			}
+			proxy = proxy_alloc();
+			if (proxy == NULL) {
+				LOG_WRN("No free TCP proxy");
+				return -ENOMEM;
 			}
-			err = do_tcp_client_connect(url, port, proxy.sec_tag);
+			err = do_tcp_client_connect(proxy, url, port, sec_tag);
 			if (err == 0 &&
 			    op == AT_CLIENT_CONNECT_WITH_DATAMODE) {
-				proxy.datamode = true;
+				err = proxy_datamode_enter(proxy);
+				if (err) {
+					(void)do_tcp_client_disconnect(proxy,
+								       err);
+				}
 			}
 		} else if (op == AT_CLIENT_DISCONNECT) {
-			if (proxy.sock < 0) {
+			int handle = INVALID_SOCKET;
+
+			if (param_count > 2) {
+				at_params_int_get(&at_param_list, 2, &handle);
+			}
+			proxy = proxy_find(AT_TCP_ROLE_CLIENT, handle);
+			if (proxy == NULL) {
 				LOG_WRN("Client is not connected");
 				return -EINVAL;
 			}
-			err = do_tcp_client_disconnect(0);
+			err = do_tcp_client_disconnect(proxy, 0);
 		} break;
 
 	case AT_CMD_TYPE_READ_COMMAND:
-		if (proxy.sock != INVALID_SOCKET &&
-		    proxy.role == AT_TCP_ROLE_CLIENT) {
-			sprintf(rsp_buf, "#XTCPCLI: %d, %d\r\n",
-				proxy.sock, proxy.datamode);
-		} else {
+		for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+			proxy = &proxies[i];
+			if (proxy->sock != INVALID_SOCKET &&
+			    proxy->role == AT_TCP_ROLE_CLIENT) {
+				sprintf(rsp_buf, "#XTCPCLI: %d, %d\r\n",
+					proxy->sock, proxy->datamode);
+				rsp_send(rsp_buf, strlen(rsp_buf));
+				connected = true;
+			}
+		}
+		if (!connected) {
 			sprintf(rsp_buf, "#XTCPCLI: %d\r\n", INVALID_SOCKET);
+			rsp_send(rsp_buf, strlen(rsp_buf));
 		}
-		rsp_send(rsp_buf, strlen(rsp_buf));
 		err = 0;
 		break;
 
@@ -716,7 +889,7 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type)
 }
 
 /**@brief handle AT#XTCPSEND commands
- *  AT#XTCPSEND=<datatype>,<data>
+ *  AT#XTCPSEND=<datatype>,<data>[,<handle>]
  *  AT#XTCPSEND? READ command not supported
  *  AT#XTCPSEND=? TEST command not supported
  */
@@ -726,6 +899,8 @@ static int handle_at_tcp_send(enum at_cmd_type cmd_type)
 	uint16_t datatype;
 	char data[NET_IPV4_MTU];
 	int size = NET_IPV4_MTU;
+	int handle = INVALID_SOCKET;
+	struct tcp_proxy_t *proxy;
 
 	switch (cmd_type) {
 	case AT_CMD_TYPE_SET_COMMAND:
@@ -740,15 +915,23 @@ static int handle_at_tcp_send(enum at_cmd_type cmd_type)
 		if (err) {
 			return err;
 		}
+		if (at_params_valid_count_get(&at_param_list) > 3) {
+			at_params_int_get(&at_param_list, 3, &handle);
+		}
+		proxy = proxy_find(INVALID_ROLE, handle);
+		if (proxy == NULL) {
+			LOG_ERR("Not connected yet");
+			return -EINVAL;
+		}
 		if (datatype == DATATYPE_HEXADECIMAL) {
 			uint8_t data_hex[size / 2];
 
 			err = slm_util_atoh(data, size, data_hex, size / 2);
 			if (err > 0) {
-				err = do_tcp_send(data_hex, err);
+				err = do_tcp_send(proxy, data_hex, err);
 			}
 		} else {
-			err = do_tcp_send(data, size);
+			err = do_tcp_send(proxy, data, size);
 		}
 		break;
 
@@ -760,7 +943,7 @@ static int handle_at_tcp_send(enum at_cmd_type cmd_type)
 }
 
 /**@brief handle AT#XTCPRECV commands
- *  AT#XTCPRECV[=<length>]
+ *  AT#XTCPRECV[=<length>[,<handle>]]
  *  AT#XTCPRECV? READ command not supported
  *  AT#XTCPRECV=? TEST command not supported
  */
@@ -768,6 +951,8 @@ static int handle_at_tcp_recv(enum at_cmd_type cmd_type)
 {
 	int err = -EINVAL;
 	uint16_t length = 0;
+	int handle = INVALID_SOCKET;
+	struct tcp_proxy_t *proxy;
 
 	switch (cmd_type) {
 	case AT_CMD_TYPE_SET_COMMAND:
@@ -780,12 +965,22 @@ static int handle_at_tcp_recv(enum at_cmd_type cmd_type)
 				return err;
 			}
 		}
-		if (ring_buf_is_empty(&data_buf) == 0) {
-			sz_send = ring_buf_get(&data_buf, rsp_buf,
-					sizeof(rsp_buf));
-			if (length > 0 && sz_send > length) {
-				sz_send = length;
-			}
+		if (at_params_valid_count_get(&at_param_list) > 2) {
+			at_params_int_get(&at_param_list, 2, &handle);
+		}
+		proxy = proxy_find(INVALID_ROLE, handle);
+		if (proxy == NULL) {
+			LOG_ERR("Not connected yet");
+			return -EINVAL;
+		}
+		if (length == 0 || length > sizeof(rsp_buf)) {
+			length = sizeof(rsp_buf);
+		}
+		if (ring_buf_is_empty(&proxy->data_buf) == 0) {
+			sz_send = ring_buf_get(&proxy->data_buf, rsp_buf,
+					length);
+			/* Let the proxy receive again */
+			k_sem_give(&proxy->data_fetched);
 			rsp_send(rsp_buf, sz_send);
 			rsp_send("\r\n", 2);
 		}
@@ -803,7 +998,7 @@ static int handle_at_tcp_recv(enum at_cmd_type cmd_type)
 
 /**@brief API to handle TCP proxy AT commands
  */
-int slm_at_tcp_proxy_parse(const char *at_cmd, uint16_t length)
+int slm_at_tcp_proxy_parse(const char *at_cmd)
 {
 	int ret = -ENOENT;
 	enum at_cmd_type type;
@@ -823,11 +1018,6 @@ int slm_at_tcp_proxy_parse(const char *at_cmd, uint16_t length)
 		}
 	}
 
-	/* handle sending in data mode */
-	if (ret == -ENOENT && proxy.datamode) {
-		ret = do_tcp_send_datamode(at_cmd, length);
-	}
-
 	return ret;
 }
 
@@ -845,10 +1035,14 @@ void slm_at_tcp_proxy_clac(void)
  */
 int slm_at_tcp_proxy_init(void)
 {
-	proxy.sock = INVALID_SOCKET;
-	proxy.sock_peer = INVALID_SOCKET;
-	proxy.role = INVALID_ROLE;
-	proxy.datamode = false;
+	for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+		ring_buf_init(&proxies[i].data_buf, sizeof(proxies[i].data),
+			      proxies[i].data);
+		k_sem_init(&proxies[i].data_fetched, 0, 1);
+		k_timer_init(&proxies[i].conn_timer, NULL, NULL);
+		proxy_reset(&proxies[i]);
+	}
+	datamode_proxy = NULL;
 
 	return 0;
 }
@@ -857,12 +1051,15 @@ int slm_at_tcp_proxy_init(void)
  */
 int slm_at_tcp_proxy_uninit(void)
 {
-	if (proxy.role == AT_TCP_ROLE_CLIENT) {
-		return do_tcp_client_disconnect(0);
-	}
-	if (proxy.role == AT_TCP_ROLE_SERVER) {
-		return do_tcp_server_stop(0);
+	int ret = 0;
+
+	for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+		if (proxies[i].role == AT_TCP_ROLE_CLIENT) {
+			ret = do_tcp_client_disconnect(&proxies[i], 0);
+		} else if (proxies[i].role == AT_TCP_ROLE_SERVER) {
+			ret = do_tcp_server_stop(&proxies[i], 0);
+		}
 	}
 
-	return 0;
+	return ret;
 }
@@ -19,14 +19,12 @@
 /**
  * @brief TCP proxy AT command parser.
  *
- * @param at_cmd AT command or data string.
- * @param length AT command or data string length.
+ * @param at_cmd AT command string.
  *
  * @retval 0 If the operation was successful.
  *           Otherwise, negative code means error.
- *           Otherwise, positive code means data is sent in data mode.
  */
-int slm_at_tcp_proxy_parse(const char *at_cmd, uint16_t length);
+int slm_at_tcp_proxy_parse(const char *at_cmd);
 
 /**
  * @brief List TCP proxy AT commands.
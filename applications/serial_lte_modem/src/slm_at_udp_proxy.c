@@ -18,11 +18,10 @@ LOG_MODULE_REGISTER(udp_proxy, CONFIG_SLM_LOG_LEVEL);
 
 #define THREAD_STACK_SIZE	(KB(1) + NET_IPV4_MTU)
 #define THREAD_PRIORITY		K_LOWEST_APPLICATION_THREAD_PRIO
-#define DATA_HEX_MAX_SIZE	(2 * NET_IPV4_MTU)
+#define HEX_CHUNK_SIZE		32
 
 /*
  * Known limitation in this version
- * - Multiple concurrent
  * - Receive more than IPv4 MTU one-time
  * - IPv6 support
  * - does not support proxy
@@ -38,6 +37,12 @@ enum slm_udp_proxy_operation {
 	AT_CLIENT_CONNECT_WITH_DATAMODE = AT_SERVER_START_WITH_DATAMODE
 };
 
+/**@brief Proxy roles. */
+enum slm_udp_proxy_role {
+	AT_UDP_ROLE_CLIENT,
+	AT_UDP_ROLE_SERVER
+};
+
 /**@brief List of supported AT commands. */
 enum slm_udp_proxy_at_cmd_type {
 	AT_UDP_SERVER,
@@ -58,14 +63,21 @@ static slm_at_cmd_list_t udp_proxy_at_list[AT_UDP_PROXY_MAX] = {
 	{AT_UDP_SEND, "AT#XUDPSEND", handle_at_udp_send},
 };
 
-static uint8_t data_hex[DATA_HEX_MAX_SIZE];
-static struct k_thread udp_thread;
-static K_THREAD_STACK_DEFINE(udp_thread_stack, THREAD_STACK_SIZE);
-static k_tid_t udp_thread_id;
+static struct udp_proxy_t {
+	int sock; /* Socket descriptor. */
+	int role; /* Client or Server proxy */
+	bool datamode; /* Data mode flag*/
+	struct sockaddr_in remote; /* Remote address */
+	struct k_thread thread;
+	k_tid_t thread_id;
+} proxies[CONFIG_SLM_UDP_PROXY_COUNT];
 
-static struct sockaddr_in remote;
-static int udp_sock;
-static bool udp_datamode;
+static K_THREAD_STACK_ARRAY_DEFINE(udp_thread_stacks,
+				   CONFIG_SLM_UDP_PROXY_COUNT,
+				   THREAD_STACK_SIZE);
+
+/* Proxy in data mode */
+static struct udp_proxy_t *datamode_proxy;
 
 /* global functions defined in different files */
 void rsp_send(const uint8_t *str, size_t len);
@@ -78,15 +90,117 @@ extern char rsp_buf[CONFIG_AT_CMD_RESPONSE_MAX_LEN];
 /** forward declaration of thread function **/
 static void udp_thread_func(void *p1, void *p2, void *p3);
 
-static int do_udp_server_start(uint16_t port)
+static void proxy_reset(struct udp_proxy_t *proxy)
+{
+	proxy->sock = INVALID_SOCKET;
+	proxy->role = INVALID_ROLE;
+	proxy->datamode = false;
+	proxy->remote.sin_family = AF_UNSPEC;
+	proxy->remote.sin_port = INVALID_PORT;
+}
+
+static struct udp_proxy_t *proxy_alloc(void)
+{
+	for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+		if (proxies[i].sock == INVALID_SOCKET) {
+			return &proxies[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Find proxy by role and handle, INVALID_ROLE matches any role. Without
+ * a handle, the first proxy with the role is returned.
+ */
+static struct udp_proxy_t *proxy_find(int role, int handle)
+{
+	for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+		if (proxies[i].sock == INVALID_SOCKET) {
+			continue;
+		}
+		if (role != INVALID_ROLE && proxies[i].role != role) {
+			continue;
+		}
+		if (handle == INVALID_SOCKET || proxies[i].sock == handle) {
+			return &proxies[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void proxy_thread_start(struct udp_proxy_t *proxy)
+{
+	proxy->thread_id = k_thread_create(&proxy->thread,
+			udp_thread_stacks[proxy - proxies],
+			K_THREAD_STACK_SIZEOF(udp_thread_stacks[0]),
+			udp_thread_func, proxy, NULL, NULL,
+			THREAD_PRIORITY, K_USER, K_NO_WAIT);
+}
+
+static int do_udp_send_datamode(struct udp_proxy_t *proxy,
+				const uint8_t *data, int datalen);
+
+static int udp_datamode_callback(const uint8_t *data, int len)
+{
+	struct udp_proxy_t *proxy = datamode_proxy;
+
+	if (proxy == NULL) {
+		return -ENOTCONN;
+	}
+	if (data == NULL) {
+		/* Data mode ended */
+		proxy->datamode = false;
+		datamode_proxy = NULL;
+		return 0;
+	}
+
+	return do_udp_send_datamode(proxy, data, len);
+}
+
+static int proxy_datamode_enter(struct udp_proxy_t *proxy)
+{
+	int err;
+
+	err = enter_datamode(udp_datamode_callback);
+	if (err) {
+		return err;
+	}
+	proxy->datamode = true;
+	datamode_proxy = proxy;
+
+	return 0;
+}
+
+static int proxy_close(struct udp_proxy_t *proxy)
+{
+	int ret;
+
+	k_thread_abort(proxy->thread_id);
+	if (proxy->datamode) {
+		exit_datamode();
+	}
+	ret = close(proxy->sock);
+	if (ret < 0) {
+		LOG_WRN("close() failed: %d", -errno);
+		ret = -errno;
+	}
+	proxy_reset(proxy);
+
+	return ret;
+}
+
+static int do_udp_server_start(struct udp_proxy_t *proxy, uint16_t port)
 {
 	int ret = 0;
 	struct sockaddr_in local;
 	int addr_len;
+	int sock;
 
 	/* Open socket */
-	udp_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	if (udp_sock < 0) {
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
 		LOG_ERR("socket() failed: %d", -errno);
 		sprintf(rsp_buf, "#XUDPSVR: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
@@ -99,62 +213,54 @@ static int do_udp_server_start(uint16_t port)
 	ret = modem_info_params_get(&modem_param);
 	if (ret) {
 		LOG_ERR("Unable to obtain modem parameters (%d)", ret);
-		close(udp_sock);
+		close(sock);
 		return ret;
 	}
 	addr_len = strlen(modem_param.network.ip_address.value_string);
 	if (addr_len == 0) {
 		LOG_ERR("LTE not connected yet");
-		close(udp_sock);
+		close(sock);
 		return -EINVAL;
 	}
 	if (!check_for_ipv4(modem_param.network.ip_address.value_string,
 			addr_len)) {
 		LOG_ERR("Invalid local address");
-		close(udp_sock);
+		close(sock);
 		return -EINVAL;
 	}
 	if (inet_pton(AF_INET, modem_param.network.ip_address.value_string,
 		&local.sin_addr) != 1) {
 		LOG_ERR("Parse local IP address failed: %d", -errno);
-		close(udp_sock);
+		close(sock);
 		return -EINVAL;
 	}
 
-	ret = bind(udp_sock, (struct sockaddr *)&local,
+	ret = bind(sock, (struct sockaddr *)&local,
 		 sizeof(struct sockaddr_in));
 	if (ret) {
 		LOG_ERR("bind() failed: %d", -errno);
 		sprintf(rsp_buf, "#XUDPSVR: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
-		close(udp_sock);
+		close(sock);
 		return -errno;
 	}
 
-	udp_thread_id = k_thread_create(&udp_thread, udp_thread_stack,
-			K_THREAD_STACK_SIZEOF(udp_thread_stack),
-			udp_thread_func, NULL, NULL, NULL,
-			THREAD_PRIORITY, K_USER, K_NO_WAIT);
-
-	sprintf(rsp_buf, "#XUDPSVR: %d started\r\n", udp_sock);
+	proxy->sock = sock;
+	proxy->role = AT_UDP_ROLE_SERVER;
+	proxy_thread_start(proxy);
+	sprintf(rsp_buf, "#XUDPSVR: %d started\r\n", proxy->sock);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 	LOG_DBG("UDP server started");
 
 	return ret;
 }
 
-static int do_udp_server_stop(int error)
+static int do_udp_server_stop(struct udp_proxy_t *proxy, int error)
 {
 	int ret = 0;
 
-	if (udp_sock > 0) {
-		k_thread_abort(udp_thread_id);
-		ret = close(udp_sock);
-		if (ret < 0) {
-			LOG_WRN("close() failed: %d", -errno);
-			ret = -errno;
-		}
-		(void)slm_at_udp_proxy_init();
+	if (proxy->sock != INVALID_SOCKET) {
+		ret = proxy_close(proxy);
 		if (error) {
 			sprintf(rsp_buf, "#XUDPSVR: %d stopped\r\n", error);
 		} else {
@@ -166,18 +272,20 @@ static int do_udp_server_stop(int error)
 	return ret;
 }
 
-static int do_udp_client_connect(const char *url, uint16_t port, int sec_tag)
+static int do_udp_client_connect(struct udp_proxy_t *proxy, const char *url,
+				 uint16_t port, int sec_tag)
 {
 	int ret;
+	int sock;
 
 	/* Open socket */
 	if (sec_tag == INVALID_SEC_TAG) {
-		udp_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	} else {
-		udp_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_DTLS_1_2);
+		sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_DTLS_1_2);
 
 	}
-	if (udp_sock < 0) {
+	if (sock < 0) {
 		LOG_ERR("socket() failed: %d", -errno);
 		sprintf(rsp_buf, "#XUDPCLI: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
@@ -186,27 +294,27 @@ static int do_udp_client_connect(const char *url, uint16_t port, int sec_tag)
 	if (sec_tag != INVALID_SEC_TAG) {
 		sec_tag_t sec_tag_list[1] = { sec_tag };
 
-		ret = setsockopt(udp_sock, SOL_TLS, TLS_SEC_TAG_LIST,
+		ret = setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST,
 				sec_tag_list, sizeof(sec_tag_t));
 		if (ret) {
 			LOG_ERR("set tag list failed: %d", -errno);
 			sprintf(rsp_buf, "#XUDPCLI: %d\r\n", -errno);
 			rsp_send(rsp_buf, strlen(rsp_buf));
-			close(udp_sock);
+			close(sock);
 			return -errno;
 		}
 	}
 
 	/* Connect to remote host */
 	if (check_for_ipv4(url, strlen(url))) {
-		remote.sin_family = AF_INET;
-		remote.sin_port = htons(port);
+		proxy->remote.sin_family = AF_INET;
+		proxy->remote.sin_port = htons(port);
 		LOG_DBG("IPv4 Address %s", log_strdup(url));
 		/* NOTE inet_pton() returns 1 as success */
-		ret = inet_pton(AF_INET, url, &remote.sin_addr);
+		ret = inet_pton(AF_INET, url, &proxy->remote.sin_addr);
 		if (ret != 1) {
 			LOG_ERR("inet_pton() failed: %d", ret);
-			close(udp_sock);
+			close(sock);
 			return -EINVAL;
 		}
 	} else {
@@ -219,51 +327,43 @@ static int do_udp_client_connect(const char *url, uint16_t port, int sec_tag)
 		ret = getaddrinfo(url, NULL, &hints, &result);
 		if (ret || result == NULL) {
 			LOG_ERR("getaddrinfo() failed: %d", ret);
-			close(udp_sock);
+			close(sock);
 			return -EINVAL;
 		}
 
-		remote.sin_family = AF_INET;
-		remote.sin_port = htons(port);
-		remote.sin_addr.s_addr =
+		proxy->remote.sin_family = AF_INET;
+		proxy->remote.sin_port = htons(port);
+		proxy->remote.sin_addr.s_addr =
 		((struct sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
 		/* Free the address. */
 		freeaddrinfo(result);
 	}
 
-	ret = connect(udp_sock, (struct sockaddr *)&remote,
+	ret = connect(sock, (struct sockaddr *)&proxy->remote,
 		sizeof(struct sockaddr_in));
 	if (ret < 0) {
 		LOG_ERR("connect() failed: %d", -errno);
 		sprintf(rsp_buf, "#XUDPCLI: %d\r\n", -errno);
 		rsp_send(rsp_buf, strlen(rsp_buf));
-		close(udp_sock);
+		close(sock);
 		return -errno;
 	}
 
-	udp_thread_id = k_thread_create(&udp_thread, udp_thread_stack,
-			K_THREAD_STACK_SIZEOF(udp_thread_stack),
-			udp_thread_func, NULL, NULL, NULL,
-			THREAD_PRIORITY, K_USER, K_NO_WAIT);
-
-	sprintf(rsp_buf, "#XUDPCLI: %d connected\r\n", udp_sock);
+	proxy->sock = sock;
+	proxy->role = AT_UDP_ROLE_CLIENT;
+	proxy_thread_start(proxy);
+	sprintf(rsp_buf, "#XUDPCLI: %d connected\r\n", proxy->sock);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
 	return ret;
 }
 
-static int do_udp_client_disconnect(void)
+static int do_udp_client_disconnect(struct udp_proxy_t *proxy)
 {
 	int ret = 0;
 
-	if (udp_sock > 0) {
-		k_thread_abort(udp_thread_id);
-		ret = close(udp_sock);
-		if (ret < 0) {
-			LOG_WRN("close() failed: %d", -errno);
-			ret = -errno;
-		}
-		(void)slm_at_udp_proxy_init();
+	if (proxy->sock != INVALID_SOCKET) {
+		ret = proxy_close(proxy);
 		sprintf(rsp_buf, "#XUDPCLI: disconnected\r\n");
 		rsp_send(rsp_buf, strlen(rsp_buf));
 	}
@@ -271,23 +371,24 @@ static int do_udp_client_disconnect(void)
 	return ret;
 }
 
-static int do_udp_send(const uint8_t *data, int datalen)
+static int do_udp_send(struct udp_proxy_t *proxy, const uint8_t *data,
+		       int datalen)
 {
 	int ret = 0;
 	uint32_t offset = 0;
 
-	if (udp_sock == INVALID_SOCKET) {
-		LOG_ERR("Not connected yet");
-		return -EINVAL;
-	}
-
 	while (offset < datalen) {
-		ret = sendto(udp_sock, data + offset, datalen - offset, 0,
-			(struct sockaddr *)&remote, sizeof(remote));
+		ret = sendto(proxy->sock, data + offset, datalen - offset, 0,
+			(struct sockaddr *)&proxy->remote,
+			sizeof(proxy->remote));
 		if (ret < 0) {
 			LOG_ERR("send() failed: %d", -errno);
 			if (errno != EAGAIN && errno != ETIMEDOUT) {
-				do_udp_server_stop(-errno);
+				if (proxy->role == AT_UDP_ROLE_CLIENT) {
+					do_udp_client_disconnect(proxy);
+				} else {
+					do_udp_server_stop(proxy, -errno);
+				}
 			} else {
 				sprintf(rsp_buf, "#XUDPSEND: %d\r\n", -errno);
 				rsp_send(rsp_buf, strlen(rsp_buf));
@@ -307,14 +408,21 @@ static int do_udp_send(const uint8_t *data, int datalen)
 	}
 }
 
-static int do_udp_send_datamode(const uint8_t *data, int datalen)
+static int do_udp_send_datamode(struct udp_proxy_t *proxy,
+				const uint8_t *data, int datalen)
 {
 	int ret = 0;
 	uint32_t offset = 0;
 
+	if (proxy->remote.sin_family == AF_UNSPEC) {
+		LOG_ERR("No remote yet");
+		return -EINVAL;
+	}
+
 	while (offset < datalen) {
-		ret = sendto(udp_sock, data + offset, datalen - offset, 0,
-			(struct sockaddr *)&remote, sizeof(remote));
+		ret = sendto(proxy->sock, data + offset, datalen - offset, 0,
+			(struct sockaddr *)&proxy->remote,
+			sizeof(proxy->remote));
 		if (ret < 0) {
 			LOG_ERR("send() failed: %d", -errno);
 			ret = -errno;
@@ -326,19 +434,37 @@ static int do_udp_send_datamode(const uint8_t *data, int datalen)
 	return offset;
 }
 
+static void udp_data_send_hex(const uint8_t *data, uint32_t length)
+{
+	char hex[2 * HEX_CHUNK_SIZE + 1];
+	int ret;
+
+	/* Convert in small chunks, to avoid a buffer for the whole string */
+	for (uint32_t i = 0; i < length; i += HEX_CHUNK_SIZE) {
+		ret = slm_util_htoa(data + i, MIN(HEX_CHUNK_SIZE, length - i),
+				    hex, sizeof(hex));
+		if (ret < 0) {
+			LOG_WRN("hex convert error: %d", ret);
+			break;
+		}
+		rsp_send(hex, ret);
+	}
+}
+
 static void udp_thread_func(void *p1, void *p2, void *p3)
 {
+	struct udp_proxy_t *proxy = p1;
 	int ret;
 	int size = sizeof(struct sockaddr_in);
 	char data[NET_IPV4_MTU];
+	char rsp[48];
 
-	ARG_UNUSED(p1);
 	ARG_UNUSED(p2);
 	ARG_UNUSED(p3);
 
 	do {
-		ret = recvfrom(udp_sock, data, NET_IPV4_MTU, 0,
-			(struct sockaddr *)&remote, &size);
+		ret = recvfrom(proxy->sock, data, NET_IPV4_MTU, 0,
+			(struct sockaddr *)&proxy->remote, &size);
 		if (ret < 0) {
 			LOG_WRN("recv() error: %d", -errno);
 			continue;
@@ -346,24 +472,18 @@ static void udp_thread_func(void *p1, void *p2, void *p3)
 		if (ret == 0) {
 			continue;
 		}
-		if (udp_datamode) {
-			rsp_send(data, ret);
+		if (proxy->datamode) {
+			(void)datamode_rsp_send(data, ret);
 		} else if (slm_util_hex_check(data, ret)) {
-			ret = slm_util_htoa(data, ret, data_hex,
-				DATA_HEX_MAX_SIZE);
-			if (ret > 0) {
-				sprintf(rsp_buf, "#XUDPRECV: %d, %d\r\n",
-					DATATYPE_HEXADECIMAL, ret);
-				rsp_send(rsp_buf, strlen(rsp_buf));
-				rsp_send(data_hex, ret);
-				rsp_send("\r\n", 2);
-			} else {
-				LOG_WRN("hex convert error: %d", ret);
-			}
+			sprintf(rsp, "#XUDPRECV: %d, %d, %d\r\n",
+				DATATYPE_HEXADECIMAL, 2 * ret, proxy->sock);
+			rsp_send(rsp, strlen(rsp));
+			udp_data_send_hex(data, ret);
+			rsp_send("\r\n", 2);
 		} else {
-			sprintf(rsp_buf, "#XUDPRECV: %d, %d\r\n",
-				DATATYPE_PLAINTEXT, ret);
-			rsp_send(rsp_buf, strlen(rsp_buf));
+			sprintf(rsp, "#XUDPRECV: %d, %d, %d\r\n",
+				DATATYPE_PLAINTEXT, ret, proxy->sock);
+			rsp_send(rsp, strlen(rsp));
 			rsp_send(data, ret);
 			rsp_send("\r\n", 2);
 		}
@@ -374,7 +494,8 @@ static void udp_thread_func(void *p1, void *p2, void *p3)
 
 /**@brief handle AT#XUDPSVR commands
  *  AT#XUDPSVR=<op>[,<port>]
- *  AT#XUDPSVR? READ command not supported
+ *  AT#XUDPSVR=0[,<handle>]
+ *  AT#XUDPSVR?
  *  AT#XUDPSVR=?
  */
 static int handle_at_udp_server(enum at_cmd_type cmd_type)
@@ -382,6 +503,8 @@ static int handle_at_udp_server(enum at_cmd_type cmd_type)
 	int err = -EINVAL;
 	uint16_t op;
 	int param_count = at_params_valid_count_get(&at_param_list);
+	struct udp_proxy_t *proxy;
+	bool running = false;
 
 	switch (cmd_type) {
 	case AT_CMD_TYPE_SET_COMMAND:
@@ -403,31 +526,47 @@ static int handle_at_udp_server(enum at_cmd_type cmd_type)
 			if (err) {
 				return err;
 			}
-			if (udp_sock > 0) {
-				LOG_WRN("Server is running");
-				return -EINVAL;
+			proxy = proxy_alloc();
+			if (proxy == NULL) {
+				LOG_WRN("No free UDP proxy");
+				return -ENOMEM;
 			}
-			err = do_udp_server_start(port);
+			err = do_udp_server_start(proxy, port);
 			if (err == 0 && op == AT_SERVER_START_WITH_DATAMODE) {
-				udp_datamode = true;
+				err = proxy_datamode_enter(proxy);
+				if (err) {
+					(void)do_udp_server_stop(proxy, err);
+				}
 			}
 		} else if (op == AT_SERVER_STOP) {
-			if (udp_sock < 0) {
+			int handle = INVALID_SOCKET;
+
+			if (param_count > 2) {
+				at_params_int_get(&at_param_list, 2, &handle);
+			}
+			proxy = proxy_find(AT_UDP_ROLE_SERVER, handle);
+			if (proxy == NULL) {
 				LOG_WRN("Server is not running");
 				return -EINVAL;
 			}
-			err = do_udp_server_stop(0);
+			err = do_udp_server_stop(proxy, 0);
 		} break;
 
 	case AT_CMD_TYPE_READ_COMMAND:
-		if (udp_sock != INVALID_SOCKET) {
-			sprintf(rsp_buf, "#XUDPSVR: %d, %d\r\n",
-				udp_sock, udp_datamode);
-		} else {
-			sprintf(rsp_buf, "#XUDPSVR: %d\r\n",
-				INVALID_SOCKET);
+		for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+			proxy = &proxies[i];
+			if (proxy->sock != INVALID_SOCKET &&
+			    proxy->role == AT_UDP_ROLE_SERVER) {
+				sprintf(rsp_buf, "#XUDPSVR: %d, %d\r\n",
+					proxy->sock, proxy->datamode);
+				rsp_send(rsp_buf, strlen(rsp_buf));
+				running = true;
+			}
+		}
+		if (!running) {
+			sprintf(rsp_buf, "#XUDPSVR: %d\r\n", INVALID_SOCKET);
+			rsp_send(rsp_buf, strlen(rsp_buf));
 		}
-		rsp_send(rsp_buf, strlen(rsp_buf));
 		err = 0;
 		break;
 
@@ -448,7 +587,8 @@ static int handle_at_udp_server(enum at_cmd_type cmd_type)
 
 /**@brief handle AT#XUDPCLI commands
  *  AT#XUDPCLI=<op>[,<url>,<port>[,<sec_tag>]
- *  AT#XUDPCLI? READ command not supported
+ *  AT#XUDPCLI=0[,<handle>]
+ *  AT#XUDPCLI?
  *  AT#XUDPCLI=?
  */
 static int handle_at_udp_client(enum at_cmd_type cmd_type)
@@ -456,6 +596,8 @@ static int handle_at_udp_client(enum at_cmd_type cmd_type)
 	int err = -EINVAL;
 	uint16_t op;
 	int param_count = at_params_valid_count_get(&at_param_list);
+	struct udp_proxy_t *proxy;
+	bool connected = false;
 
 	switch (cmd_type) {
 	case AT_CMD_TYPE_SET_COMMAND:
@@ -489,28 +631,48 @@ static int handle_at_udp_client(enum at_cmd_type cmd_type)
 			if (param_count > 4) {
 				at_params_int_get(&at_param_list, 4, &sec_tag);
 			}
-			err = do_udp_client_connect(url, port, sec_tag);
+			proxy = proxy_alloc();
+			if (proxy == NULL) {
+				LOG_WRN("No free UDP proxy");
+				return -ENOMEM;
+			}
+			err = do_udp_client_connect(proxy, url, port, sec_tag);
 			if (err == 0 &&
 			    op == AT_CLIENT_CONNECT_WITH_DATAMODE) {
-				udp_datamode = true;
+				err = proxy_datamode_enter(proxy);
+				if (err) {
+					(void)do_udp_client_disconnect(proxy);
+				}
 			}
 		} else if (op == AT_CLIENT_DISCONNECT) {
-			if (udp_sock < 0) {
+			int handle = INVALID_SOCKET;
+
+			if (param_count > 2) {
+				at_params_int_get(&at_param_list, 2, &handle);
+			}
+			proxy = proxy_find(AT_UDP_ROLE_CLIENT, handle);
+			if (proxy == NULL) {
 				LOG_WRN("Client is not connected");
 				return -EINVAL;
 			}
-			err = do_udp_client_disconnect();
+			err = do_udp_client_disconnect(proxy);
 		} break;
 
 	case AT_CMD_TYPE_READ_COMMAND:
-		if (udp_sock != INVALID_SOCKET) {
-			sprintf(rsp_buf, "#XUDPCLI: %d, %d\r\n",
-				udp_sock, udp_datamode);
-		} else {
-			sprintf(rsp_buf, "#XUDPCLI: %d\r\n",
-				INVALID_SOCKET);
+		for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+			proxy = &proxies[i];
+			if (proxy->sock != INVALID_SOCKET &&
+			    proxy->role == AT_UDP_ROLE_CLIENT) {
+				sprintf(rsp_buf, "#XUDPCLI: %d, %d\r\n",
+					proxy->sock, proxy->datamode);
+				rsp_send(rsp_buf, strlen(rsp_buf));
+				connected = true;
+			}
+		}
+		if (!connected) {
+			sprintf(rsp_buf, "#XUDPCLI: %d\r\n", INVALID_SOCKET);
+			rsp_send(rsp_buf, strlen(rsp_buf));
 		}
-		rsp_send(rsp_buf, strlen(rsp_buf));
 		err = 0;
 		break;
 
@@ -531,7 +693,7 @@ static int handle_at_udp_client(enum at_cmd_type cmd_type)
 }
 
 /**@brief handle AT#XUDPSEND commands
- *  AT#XUDPSEND=<datatype>,<data>
+ *  AT#XUDPSEND=<datatype>,<data>[,<handle>]
  *  AT#XUDPSEND? READ command not supported
  *  AT#XUDPSEND=? TEST command not supported
  */
@@ -541,10 +703,8 @@ static int handle_at_udp_send(enum at_cmd_type cmd_type)
 	uint16_t datatype;
 	char data[NET_IPV4_MTU];
 	int size = NET_IPV4_MTU;
-
-	if (remote.sin_family == AF_UNSPEC || remote.sin_port == INVALID_PORT) {
-		return err;
-	}
+	int handle = INVALID_SOCKET;
+	struct udp_proxy_t *proxy;
 
 	switch (cmd_type) {
 	case AT_CMD_TYPE_SET_COMMAND:
@@ -559,15 +719,25 @@ static int handle_at_udp_send(enum at_cmd_type cmd_type)
 		if (err) {
 			return err;
 		}
+		if (at_params_valid_count_get(&at_param_list) > 3) {
+			at_params_int_get(&at_param_list, 3, &handle);
+		}
+		proxy = proxy_find(INVALID_ROLE, handle);
+		if (proxy == NULL ||
+		    proxy->remote.sin_family == AF_UNSPEC ||
+		    proxy->remote.sin_port == INVALID_PORT) {
+			LOG_ERR("Not connected yet");
+			return -EINVAL;
+		}
 		if (datatype == DATATYPE_HEXADECIMAL) {
 			uint8_t data_hex[size / 2];
 
 			err = slm_util_atoh(data, size, data_hex, size / 2);
 			if (err > 0) {
-				err = do_udp_send(data_hex, err);
+				err = do_udp_send(proxy, data_hex, err);
 			}
 		} else {
-			err = do_udp_send(data, size);
+			err = do_udp_send(proxy, data, size);
 		}
 		break;
 
@@ -580,7 +750,7 @@ static int handle_at_udp_send(enum at_cmd_type cmd_type)
 
 /**@brief API to handle UDP Proxy AT commands
  */
-int slm_at_udp_proxy_parse(const char *at_cmd, uint16_t length)
+int slm_at_udp_proxy_parse(const char *at_cmd)
 {
 	int ret = -ENOENT;
 	enum at_cmd_type type;
@@ -600,11 +770,6 @@ int slm_at_udp_proxy_parse(const char *at_cmd, uint16_t length)
 		}
 	}
 
-	/* handle sending in data mode */
-	if (ret == -ENOENT && udp_datamode) {
-		ret = do_udp_send_datamode(at_cmd, length);
-	}
-
 	return ret;
 }
 
@@ -622,10 +787,10 @@ void slm_at_udp_proxy_clac(void)
  */
 int slm_at_udp_proxy_init(void)
 {
-	udp_sock = INVALID_SOCKET;
-	udp_datamode = false;
-	remote.sin_family = AF_UNSPEC;
-	remote.sin_port = INVALID_PORT;
+	for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+		proxy_reset(&proxies[i]);
+	}
+	datamode_proxy = NULL;
 
 	return 0;
 }
@@ -634,16 +799,10 @@ int slm_at_udp_proxy_init(void)
  */
 int slm_at_udp_proxy_uninit(void)
 {
-	int ret;
-
-	if (udp_sock > 0) {
-		k_thread_abort(udp_thread_id);
-		ret = close(udp_sock);
-		if (ret < 0) {
-			LOG_WRN("close() failed: %d", -errno);
-			ret = -errno;
+	for (int i = 0; i < ARRAY_SIZE(proxies); i++) {
+		if (proxies[i].sock != INVALID_SOCKET) {
+			(void)proxy_close(&proxies[i]);
 		}
-		udp_sock = INVALID_SOCKET;
 	}
 
 	return 0;
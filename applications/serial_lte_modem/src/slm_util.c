@@ -62,6 +62,99 @@ bool slm_util_cmd_casecmp(const char *cmd, const char *slm_cmd)
 	return true;
 }
 
+static int at_cmd_name_cmp(const void *name, const void *entry)
+{
+	return strcmp(name, *(const char * const *)entry);
+}
+
+/**
+ * @brief Find AT command in a table sorted by command name
+ */
+const void *slm_util_at_cmd_find(const char *cmd, const void *table,
+				 size_t count, size_t size)
+{
+	char name[SLM_AT_CMD_NAME_MAX_LEN + 1];
+	size_t len;
+
+	for (len = 0; ; len++) {
+		char ch = *(cmd + len);
+
+		/* With parameter, SET TEST, "="; READ, "?" */
+		if (ch == '\0' || ch == '=' || ch == '?' ||
+		    ch == '\r' || ch == '\n') {
+			break;
+		}
+		if (len == SLM_AT_CMD_NAME_MAX_LEN) {
+			return NULL;
+		}
+		name[len] = toupper((int)ch);
+	}
+	name[len] = '\0';
+
+	return bsearch(name, table, count, size, at_cmd_name_cmp);
+}
+
+/**
+ * @brief Start the data mode terminator detection
+ */
+void slm_util_term_init(struct slm_util_term *term, const char *pattern,
+			uint32_t guard_time, uint32_t now)
+{
+	term->pattern = pattern;
+	term->len = strlen(pattern);
+	term->guard_time = guard_time;
+	term->matched = 0;
+	term->last_rx = now;
+}
+
+/**
+ * @brief Check data mode input for the terminator
+ */
+enum slm_util_term_result slm_util_term_input(struct slm_util_term *term,
+					      const uint8_t *data, size_t len,
+					      uint32_t now, size_t *released)
+{
+	bool silent = (now - term->last_rx >= term->guard_time);
+
+	term->last_rx = now;
+	*released = 0;
+
+	/* A pause within the pattern means that it was data */
+	if (term->matched > 0 && silent) {
+		*released = term->matched;
+		term->matched = 0;
+	}
+
+	/* The pattern only starts after a pause */
+	if ((term->matched == 0 && !silent) || len == 0 ||
+	    len > term->len - term->matched ||
+	    memcmp(data, term->pattern + term->matched, len) != 0) {
+		*released += term->matched;
+		term->matched = 0;
+		return SLM_UTIL_TERM_DATA;
+	}
+
+	term->matched += len;
+
+	return (term->matched == term->len) ?
+		SLM_UTIL_TERM_COMPLETE : SLM_UTIL_TERM_PARTIAL;
+}
+
+/**
+ * @brief Check whether the terminator has been received
+ */
+bool slm_util_term_check(struct slm_util_term *term, uint32_t now)
+{
+	if (term->len == 0 || term->matched != term->len ||
+	    now - term->last_rx < term->guard_time) {
+		return false;
+	}
+
+	term->matched = 0;
+
+	return true;
+}
+
 /**
  * @brief Detect hexdecimal data type
  */
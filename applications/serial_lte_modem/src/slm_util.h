@@ -15,6 +15,7 @@
 
 #include <zephyr/types.h>
 #include <ctype.h>
+#include <stddef.h>
 #include <stdbool.h>
 
 #define INVALID_SOCKET	-1
@@ -24,6 +25,9 @@
 
 #define TCPIP_MAX_URL	128
 
+/** Maximum length of an AT command name, e.g. "AT#XGETADDRINFO". */
+#define SLM_AT_CMD_NAME_MAX_LEN	24
+
 /**
  * @brief Compare string ignoring case
  *
@@ -44,6 +48,98 @@ bool slm_util_casecmp(const char *str1, const char *str2);
  */
 bool slm_util_cmd_casecmp(const char *cmd, const char *slm_cmd);
 
+/**
+ * @brief Find AT command in a table sorted by command name
+ *
+ * The name of the command is everything before the first '=', '?' or line
+ * termination, and is matched ignoring case. The table entries must start
+ * with a pointer to the command name in upper case, and be sorted by strcmp()
+ * of the names.
+ *
+ * @param cmd Command string received from UART
+ * @param table First entry of the table
+ * @param count Number of entries in the table
+ * @param size Size of one table entry
+ *
+ * @return Matching table entry, or NULL if the command is not in the table.
+ */
+const void *slm_util_at_cmd_find(const char *cmd, const void *table,
+				 size_t count, size_t size);
+
+/** @brief Result of checking data mode input for the terminator. */
+enum slm_util_term_result {
+	/** The input is data. */
+	SLM_UTIL_TERM_DATA,
+	/** The input is held back as the start of the terminator. */
+	SLM_UTIL_TERM_PARTIAL,
+	/** The input completes the terminator, which is held back until
+	 *  the guard time has passed without more input.
+	 */
+	SLM_UTIL_TERM_COMPLETE
+};
+
+/** @brief State of the data mode terminator detection. */
+struct slm_util_term {
+	/** Terminator pattern. */
+	const char *pattern;
+	/** Length of the pattern. */
+	size_t len;
+	/** Silence required before and after the pattern, and the longest
+	 *  pause within it, in milliseconds.
+	 */
+	uint32_t guard_time;
+	/** Number of pattern characters held back. */
+	size_t matched;
+	/** Time of the last input, in milliseconds. */
+	uint32_t last_rx;
+};
+
+/**
+ * @brief Start the data mode terminator detection
+ *
+ * @param term Detection state
+ * @param pattern Terminator pattern
+ * @param guard_time Guard time in milliseconds
+ * @param now Current time in milliseconds
+ */
+void slm_util_term_init(struct slm_util_term *term, const char *pattern,
+			uint32_t guard_time, uint32_t now);
+
+/**
+ * @brief Check data mode input for the terminator
+ *
+ * The terminator is recognized when it is preceded and followed by the
+ * guard time without input. It may be split over any number of inputs.
+ * Input that can be part of the terminator is held back, and released as
+ * data as soon as it turns out not to be.
+ *
+ * @param term Detection state
+ * @param data Received data
+ * @param len Length of the received data
+ * @param now Current time in milliseconds
+ * @param[out] released Number of held back characters, the first ones of
+ *             the pattern, that are data and go before @p data
+ *
+ * @return Whether @p data is data or held back.
+ */
+enum slm_util_term_result slm_util_term_input(struct slm_util_term *term,
+					      const uint8_t *data, size_t len,
+					      uint32_t now, size_t *released);
+
+/**
+ * @brief Check whether the terminator has been received
+ *
+ * Call after the guard time has passed since the input that completed the
+ * terminator.
+ *
+ * @param term Detection state
+ * @param now Current time in milliseconds
+ *
+ * @return true if the whole terminator has been followed by the guard time
+ *         without input, false otherwise.
+ */
+bool slm_util_term_check(struct slm_util_term *term, uint32_t now);
+
 /**
  * @brief Detect hexdecimal data type
  *
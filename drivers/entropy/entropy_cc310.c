@@ -20,17 +20,15 @@
 #include "nrf_cc3xx_platform_entropy.h"
 #endif
 
-static int entropy_cc3xx_rng_get_entropy(
-	const struct device *dev,
-	uint8_t *buffer,
-	uint16_t length)
+#if defined(CONFIG_ENTROPY_CC3XX_POOL)
+#include "entropy_cc3xx_pool.h"
+#endif
+
+static int entropy_cc3xx_trng_get(uint8_t *buffer, size_t length)
 {
 	int res = -EINVAL;
 	size_t olen;
 
-	__ASSERT_NO_MSG(dev != NULL);
-	__ASSERT_NO_MSG(buffer != NULL);
-
 #if defined(CONFIG_SPM)
 	size_t offset = 0;
 	size_t to_copy;
@@ -73,16 +71,57 @@ static int entropy_cc3xx_rng_get_entropy(
 	return res;
 }
 
+static int entropy_cc3xx_rng_get_entropy(
+	const struct device *dev,
+	uint8_t *buffer,
+	uint16_t length)
+{
+	__ASSERT_NO_MSG(dev != NULL);
+	__ASSERT_NO_MSG(buffer != NULL);
+
+#if defined(CONFIG_ENTROPY_CC3XX_POOL)
+	return entropy_cc3xx_pool_get(buffer, length);
+#else
+	return entropy_cc3xx_trng_get(buffer, length);
+#endif
+}
+
+#if defined(CONFIG_ENTROPY_CC3XX_POOL)
+static int entropy_cc3xx_rng_get_entropy_isr(
+	const struct device *dev,
+	uint8_t *buffer,
+	uint16_t length,
+	uint32_t flags)
+{
+	__ASSERT_NO_MSG(dev != NULL);
+	__ASSERT_NO_MSG(buffer != NULL);
+
+	/* The TRNG cannot be used in interrupts, so busy waiting is not
+	 * supported. Only what is left in the pool is returned.
+	 */
+	ARG_UNUSED(flags);
+
+	return entropy_cc3xx_pool_get_isr(buffer, length);
+}
+#endif
+
 static int entropy_cc3xx_rng_init(const struct device *dev)
 {
-	/* No initialization is required */
 	(void)dev;
 
+#if defined(CONFIG_ENTROPY_CC3XX_POOL)
+	return entropy_cc3xx_pool_init(entropy_cc3xx_trng_get);
+#else
+	/* No initialization is required */
 	return 0;
+#endif
 }
 
 static const struct entropy_driver_api entropy_cc3xx_rng_api = {
-	.get_entropy = entropy_cc3xx_rng_get_entropy
+	.get_entropy = entropy_cc3xx_rng_get_entropy,
+#if defined(CONFIG_ENTROPY_CC3XX_POOL)
+	.get_entropy_isr = entropy_cc3xx_rng_get_entropy_isr,
+#endif
 };
 
 #if DT_NODE_HAS_STATUS(DT_NODELABEL(cryptocell), okay)
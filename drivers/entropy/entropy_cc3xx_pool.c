@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr.h>
+#include <spinlock.h>
+#include <sys/util.h>
+#include <tinycrypt/constants.h>
+#include <tinycrypt/ctr_prng.h>
+#include <drivers/entropy_cc3xx.h>
+#include "entropy_cc3xx_pool.h"
+
+/* CTR-DRBG seed length for AES-128 */
+#define SEED_SIZE		(TC_AES_KEY_SIZE + TC_AES_BLOCK_SIZE)
+
+/* Bytes generated by one DRBG request while refilling */
+#define REFILL_CHUNK_SIZE	64
+
+BUILD_ASSERT(CONFIG_ENTROPY_CC3XX_POOL_REFILL_THRESHOLD <
+	     CONFIG_ENTROPY_CC3XX_POOL_SIZE,
+	     "Refill threshold must be lower than the pool size");
+
+static const uint8_t personalization[] = "entropy_cc3xx_pool";
+
+static entropy_cc3xx_source_t seed_source;
+
+/* DRBG, used from threads only */
+static K_MUTEX_DEFINE(drbg_lock);
+static TCCtrPrng_t drbg;
+static bool drbg_seeded;
+static uint32_t drbg_requests;
+
+/* Pool of DRBG output, also used from interrupts */
+static struct k_spinlock pool_lock;
+static uint8_t pool[CONFIG_ENTROPY_CC3XX_POOL_SIZE];
+static size_t pool_fill;
+static struct entropy_cc3xx_pool_stats stats;
+
+static K_THREAD_STACK_DEFINE(pool_stack, CONFIG_ENTROPY_CC3XX_POOL_STACK_SIZE);
+static struct k_work_q pool_work_q;
+static struct k_work refill_work;
+
+static void stats_add(uint32_t *counter)
+{
+	k_spinlock_key_t key = k_spin_lock(&pool_lock);
+
+	(*counter)++;
+
+	k_spin_unlock(&pool_lock, key);
+}
+
+static int drbg_seed(void)
+{
+	uint8_t seed[SEED_SIZE];
+	int err;
+
+	err = seed_source(seed, sizeof(seed));
+	if (err) {
+		goto out;
+	}
+
+	if (!drbg_seeded) {
+		err = tc_ctr_prng_init(&drbg, seed, sizeof(seed),
+				       personalization,
+				       sizeof(personalization));
+	} else {
+		err = tc_ctr_prng_reseed(&drbg, seed, sizeof(seed), NULL, 0);
+	}
+
+	if (err != TC_CRYPTO_SUCCESS) {
+		err = -EIO;
+		goto out;
+	}
+
+	err = 0;
+	drbg_seeded = true;
+	drbg_requests = 0;
+	stats_add(&stats.reseeds);
+
+out:
+	memset(seed, 0, sizeof(seed));
+
+	if (err) {
+		stats_add(&stats.errors);
+	}
+
+	return err;
+}
+
+static int drbg_generate(uint8_t *buf, size_t len)
+{
+	int err;
+
+	k_mutex_lock(&drbg_lock, K_FOREVER);
+
+	if (!drbg_seeded ||
+	    drbg_requests >= CONFIG_ENTROPY_CC3XX_POOL_RESEED_INTERVAL) {
+		err = drbg_seed();
+		if (err) {
+			goto out;
+		}
+	}
+
+	err = tc_ctr_prng_generate(&drbg, NULL, 0, buf, len);
+	if (err == TC_CTR_PRNG_RESEED_REQ) {
+		err = drbg_seed();
+		if (err) {
+			goto out;
+		}
+
+		err = tc_ctr_prng_generate(&drbg, NULL, 0, buf, len);
+	}
+
+	if (err != TC_CRYPTO_SUCCESS) {
+		stats_add(&stats.errors);
+		err = -EIO;
+		goto out;
+	}
+
+	err = 0;
+	drbg_requests++;
+
+out:
+	k_mutex_unlock(&drbg_lock);
+
+	return err;
+}
+
+static size_t pool_take(uint8_t *buf, size_t len)
+{
+	k_spinlock_key_t key = k_spin_lock(&pool_lock);
+	bool refill;
+
+	if (len <= pool_fill) {
+		stats.hits++;
+	} else {
+		stats.misses++;
+		len = pool_fill;
+	}
+
+	/* Take from the end, handed out bytes are not kept. */
+	pool_fill -= len;
+	memcpy(buf, &pool[pool_fill], len);
+	memset(&pool[pool_fill], 0, len);
+
+	stats.min_fill = MIN(stats.min_fill, pool_fill);
+	refill = (pool_fill < CONFIG_ENTROPY_CC3XX_POOL_REFILL_THRESHOLD);
+
+	k_spin_unlock(&pool_lock, key);
+
+	if (refill) {
+		k_work_submit_to_queue(&pool_work_q, &refill_work);
+	}
+
+	return len;
+}
+
+static void refill_work_fn(struct k_work *work)
+{
+	uint8_t chunk[REFILL_CHUNK_SIZE];
+	k_spinlock_key_t key;
+	size_t len;
+
+	key = k_spin_lock(&pool_lock);
+	len = MIN(sizeof(chunk), sizeof(pool) - pool_fill);
+	k_spin_unlock(&pool_lock, key);
+
+	while (len > 0) {
+		if (drbg_generate(chunk, len)) {
+			/* Retried when entropy is requested again. */
+			break;
+		}
+
+		key = k_spin_lock(&pool_lock);
+		len = MIN(len, sizeof(pool) - pool_fill);
+		memcpy(&pool[pool_fill], chunk, len);
+		pool_fill += len;
+		len = MIN(sizeof(chunk), sizeof(pool) - pool_fill);
+		if (len == 0) {
+			stats.refills++;
+		}
+		k_spin_unlock(&pool_lock, key);
+	}
+
+	memset(chunk, 0, sizeof(chunk));
+}
+
+int entropy_cc3xx_pool_init(entropy_cc3xx_source_t source)
+{
+	if (source == NULL) {
+		return -EINVAL;
+	}
+
+	seed_source = source;
+	stats.size = sizeof(pool);
+	stats.min_fill = sizeof(pool);
+
+	/* The DRBG is seeded by the first refill, entropy requested before
+	 * is generated directly.
+	 */
+	k_work_init(&refill_work, refill_work_fn);
+	k_work_q_start(&pool_work_q, pool_stack,
+		       K_THREAD_STACK_SIZEOF(pool_stack),
+		       CONFIG_ENTROPY_CC3XX_POOL_THREAD_PRIORITY);
+	k_work_submit_to_queue(&pool_work_q, &refill_work);
+
+	return 0;
+}
+
+int entropy_cc3xx_pool_get(uint8_t *buf, size_t len)
+{
+	size_t taken = pool_take(buf, len);
+
+	if (taken == len) {
+		return 0;
+	}
+
+	return drbg_generate(buf + taken, len - taken);
+}
+
+int entropy_cc3xx_pool_get_isr(uint8_t *buf, size_t len)
+{
+	return pool_take(buf, len);
+}
+
+int entropy_cc3xx_pool_stats_get(struct entropy_cc3xx_pool_stats *out)
+{
+	k_spinlock_key_t key;
+
+	if (out == NULL) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&pool_lock);
+
+	*out = stats;
+	out->fill = pool_fill;
+
+	k_spin_unlock(&pool_lock, key);
+
+	return 0;
+}
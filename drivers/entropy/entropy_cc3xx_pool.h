@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef ENTROPY_CC3XX_POOL_H_
+#define ENTROPY_CC3XX_POOL_H_
+
+#include <zephyr/types.h>
+
+/** @brief Source of the DRBG seed.
+ *
+ * @param buf Buffer for the entropy.
+ * @param len Number of bytes requested.
+ *
+ * @retval 0 If the buffer was filled.
+ * @return Negative error code otherwise.
+ */
+typedef int (*entropy_cc3xx_source_t)(uint8_t *buf, size_t len);
+
+/** @brief Initialize the entropy pool and start filling it.
+ *
+ * @param source Source of the DRBG seed.
+ *
+ * @retval 0 If the operation was successful.
+ */
+int entropy_cc3xx_pool_init(entropy_cc3xx_source_t source);
+
+/** @brief Get entropy from a thread.
+ *
+ * Bytes missing in the pool are generated by the DRBG directly.
+ *
+ * @param buf Buffer for the entropy.
+ * @param len Number of bytes requested.
+ *
+ * @retval 0 If the buffer was filled.
+ * @return Negative error code otherwise.
+ */
+int entropy_cc3xx_pool_get(uint8_t *buf, size_t len);
+
+/** @brief Get entropy from the pool only.
+ *
+ * Can be used in interrupts.
+ *
+ * @param buf Buffer for the entropy.
+ * @param len Number of bytes requested.
+ *
+ * @return Number of bytes stored in the buffer.
+ */
+int entropy_cc3xx_pool_get_isr(uint8_t *buf, size_t len);
+
+#endif /* ENTROPY_CC3XX_POOL_H_ */
@@ -5,13 +5,17 @@
  */
 
 #include <errno.h>
+#include <string.h>
 
+#include <zephyr.h>
+#include <sys/util.h>
 #include <mpsl.h>
 #include <mpsl_timeslot.h>
 #include <hal/nrf_timer.h>
 
 #include "multithreading_lock.h"
 #include "soc_flash_nrf.h"
+#include <drivers/flash_sync_mpsl.h>
 
 #define LOG_LEVEL CONFIG_FLASH_LOG_LEVEL
 #include <logging/log.h>
@@ -27,24 +31,58 @@ LOG_MODULE_REGISTER(flash_sync_mpsl);
 #define TIMESLOT_LENGTH_SLACK_US 100
 #endif
 
+#define TIMESLOT_LENGTH_MAX_US CONFIG_SOC_FLASH_NRF_RADIO_SYNC_MPSL_MAX_LENGTH_US
+
+/* Number of flash operation types with tracked timings. The flash driver
+ * uses one handler for writes and one for erases.
+ */
+#define OP_TIMING_COUNT 2
+
+/* Step time estimates follow longer steps at once and shorter steps
+ * slowly, to stay on the safe side of the timeslot end.
+ */
+#define STEP_TIME_DECAY 8
+
+/* Timings measured for one type of flash operation. */
+struct op_timing {
+	/* Handler of the operation type. */
+	int (*handler)(void *context);
+	/* Estimated duration of one step, like a word write. */
+	uint32_t step_us;
+	/* Flash time the last operation of this type took. */
+	uint32_t op_us;
+};
+
 struct mpsl_context {
 	/* This semaphore is taken with a timeout when the flash operation starts. */
 	struct k_sem timeout_sem;
 	mpsl_timeslot_session_id_t session_id; /* Timeslot session ID. */
 	/* The flash operation may be split into multiple requests.
-	 * This represents the length of such a request. */
+	 * This represents the minimum length of such a request. */
 	uint32_t request_length_us;
+	/* Flash time of the requested timeslots, adapted to the operation
+	 * and to how timeslots are granted. */
+	uint32_t budget_us;
 	/* Argument passed to nrf_flash_sync_exe(). */
 	struct flash_op_desc *op_desc;
+	/* Timings of the current operation type. */
+	struct op_timing *timing;
+	/* Timeslot time when the last step began. */
+	uint32_t step_begin_us;
+	/* Flash time used by the current operation. */
+	uint32_t op_us;
 	mpsl_timeslot_request_t timeslot_request;
 	/* Return parameter for the timeslot session. */
 	mpsl_timeslot_signal_return_param_t return_param;
 	int status; /* Return value for nrf_flash_sync_exe(). */
 	/* Indicate timeout condition to the timeslot callback. */
 	atomic_t timeout_occured;
+	struct flash_sync_mpsl_stats stats;
 };
 
 static struct mpsl_context _context;
+static struct op_timing op_timings[OP_TIMING_COUNT];
+static uint8_t op_timing_next;
 
 /**
  * Get time in microseconds since the beginning of the timeslot.
@@ -57,8 +95,43 @@ static uint32_t get_timeslot_time_us(void)
 	return nrf_timer_cc_get(NRF_TIMER0, NRF_TIMER_CC_CHANNEL0);
 }
 
+static struct op_timing *op_timing_get(int (*handler)(void *context))
+{
+	struct op_timing *timing;
+
+	for (size_t i = 0; i < ARRAY_SIZE(op_timings); i++) {
+		if (op_timings[i].handler == handler) {
+			return &op_timings[i];
+		}
+	}
+
+	timing = &op_timings[op_timing_next];
+	op_timing_next = (op_timing_next + 1) % ARRAY_SIZE(op_timings);
+
+	timing->handler = handler;
+	timing->step_us = 0;
+	timing->op_us = 0;
+
+	return timing;
+}
+
+static void timeslot_length_set(uint32_t budget_us)
+{
+	uint32_t max_us = MAX(_context.request_length_us,
+			      TIMESLOT_LENGTH_MAX_US);
+
+	_context.budget_us = MIN(MAX(budget_us, _context.request_length_us),
+				 max_us);
+	_context.timeslot_request.params.earliest.length_us =
+		_context.budget_us + TIMESLOT_LENGTH_SLACK_US;
+}
+
 static void reschedule_next_timeslot(void)
 {
+	_context.stats.blocked++;
+
+	/* Shorter timeslots are easier to fit between radio events. */
+	timeslot_length_set(_context.budget_us / 2);
 	_context.timeslot_request.params.earliest.priority =
 		MPSL_TIMESLOT_PRIORITY_HIGH;
 
@@ -79,9 +152,23 @@ timeslot_callback(mpsl_timeslot_session_id_t session_id, uint32_t signal)
 	}
 
 	switch (signal) {
-	case MPSL_TIMESLOT_SIGNAL_START:
-		if (_context.op_desc->handler(_context.op_desc->context) ==
-		    FLASH_OP_DONE) {
+	case MPSL_TIMESLOT_SIGNAL_START: {
+		int ret;
+		uint32_t used_us;
+
+		_context.stats.timeslots++;
+		_context.step_begin_us = 0;
+
+		/* The handler runs as many steps as fit in the timeslot,
+		 * see nrf_flash_sync_check_time_limit().
+		 */
+		ret = _context.op_desc->handler(_context.op_desc->context);
+
+		used_us = get_timeslot_time_us();
+		_context.op_us += used_us;
+		_context.stats.busy_us += used_us;
+
+		if (ret == FLASH_OP_DONE) {
 			_context.status = 0;
 			_context.return_param.callback_action =
 				MPSL_TIMESLOT_SIGNAL_ACTION_END;
@@ -91,6 +178,9 @@ timeslot_callback(mpsl_timeslot_session_id_t session_id, uint32_t signal)
 			_context.timeslot_request.params.earliest.priority =
 				MPSL_TIMESLOT_PRIORITY_NORMAL;
 
+			/* The timeslot was used up, ask for a longer one. */
+			timeslot_length_set(_context.budget_us * 2);
+
 			_context.return_param.callback_action =
 				MPSL_TIMESLOT_SIGNAL_ACTION_REQUEST;
 			_context.return_param.params.request.p_next =
@@ -98,6 +188,7 @@ timeslot_callback(mpsl_timeslot_session_id_t session_id, uint32_t signal)
 		}
 
 		break;
+	}
 
 	case MPSL_TIMESLOT_SIGNAL_SESSION_IDLE:
 		/* All requests are done, that means we are done. */
@@ -153,15 +244,23 @@ int nrf_flash_sync_exe(struct flash_op_desc *op_desc)
 		return -ENOMEM;
 	}
 
+	uint32_t start_cycles = k_cycle_get_32();
+	struct op_timing *timing = op_timing_get(op_desc->handler);
 	mpsl_timeslot_request_t *req = &_context.timeslot_request;
+
 	req->request_type = MPSL_TIMESLOT_REQ_TYPE_EARLIEST;
 	req->params.earliest.hfclk = MPSL_TIMESLOT_HFCLK_CFG_NO_GUARANTEE;
 	req->params.earliest.priority = MPSL_TIMESLOT_PRIORITY_NORMAL;
-	req->params.earliest.length_us =
-		_context.request_length_us + TIMESLOT_LENGTH_SLACK_US;
 	req->params.earliest.timeout_us = MPSL_TIMESLOT_EARLIEST_TIMEOUT_MAX_US;
 
+	/* Ask for a timeslot that fits the whole operation if the previous
+	 * operation of the same type did, so that it is done in one go.
+	 */
+	timeslot_length_set(timing->op_us + timing->step_us);
+
 	_context.op_desc = op_desc;
+	_context.timing = timing;
+	_context.op_us = 0;
 	_context.status = -ETIMEDOUT;
 	atomic_clear(&_context.timeout_occured);
 
@@ -177,6 +276,7 @@ int nrf_flash_sync_exe(struct flash_op_desc *op_desc)
 	if (k_sem_take(&_context.timeout_sem, K_MSEC(FLASH_TIMEOUT_MS)) < 0) {
 		LOG_ERR("timeout");
 		atomic_set(&_context.timeout_occured, 1);
+		_context.stats.timeouts++;
 	}
 
 	/* This will cancel the timeslot if it is still in progress. */
@@ -191,17 +291,60 @@ int nrf_flash_sync_exe(struct flash_op_desc *op_desc)
 		k_sem_reset(&_context.timeout_sem);
 	}
 
+	if (_context.status == 0) {
+		uint32_t latency_us = k_cyc_to_us_floor32(k_cycle_get_32() -
+							  start_cycles);
+
+		timing->op_us = _context.op_us;
+
+		_context.stats.operations++;
+		_context.stats.latency_total_us += latency_us;
+		_context.stats.latency_max_us =
+			MAX(_context.stats.latency_max_us, latency_us);
+	}
+
 	return _context.status;
 }
 
 void nrf_flash_sync_get_timestamp_begin(void)
 {
-	/* Not needed for this driver. */
+	_context.step_begin_us = get_timeslot_time_us();
 }
 
 bool nrf_flash_sync_check_time_limit(uint32_t iteration)
 {
+	struct op_timing *timing = _context.timing;
 	uint32_t now_us = get_timeslot_time_us();
-	uint32_t time_per_iteration_us = now_us / iteration;
-	return now_us + time_per_iteration_us >= _context.request_length_us;
+	uint32_t step_us = now_us - _context.step_begin_us;
+
+	ARG_UNUSED(iteration);
+
+	_context.step_begin_us = now_us;
+	_context.stats.steps++;
+
+	if (step_us >= timing->step_us) {
+		timing->step_us = step_us;
+	} else {
+		timing->step_us -= (timing->step_us - step_us) /
+				   STEP_TIME_DECAY;
+	}
+
+	/* Stop if the next step would not end in the timeslot. */
+	return now_us + timing->step_us > _context.budget_us;
+}
+
+int flash_sync_mpsl_stats_get(struct flash_sync_mpsl_stats *stats)
+{
+	if (stats == NULL) {
+		return -EINVAL;
+	}
+
+	*stats = _context.stats;
+
+	return 0;
+}
+
+void flash_sync_mpsl_stats_reset(void)
+{
+	memset(&_context.stats, 0, sizeof(_context.stats));
 }
@@ -27,6 +27,15 @@
  * MTU for this driver is configurable. Longer frames received from PC will be
  * discarted, so make sure that software on PC side is configured with the same
  * MTU.
+ *
+ * RTT has no interrupt, so the down channel is polled. The polling period is
+ * short when frames are transferred and it is doubled after each poll that
+ * found no data, up to the idle period. Sending a frame also shortens the
+ * period, because a response is likely to come.
+ *
+ * Encoded frames are collected in a transmit buffer and written to RTT when
+ * the buffer is full or when the network stack stops sending, so a burst of
+ * frames takes a single RTT write.
  */
 
 #define LOG_MODULE_NAME eth_rtt
@@ -64,11 +73,8 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 /** Size of the buffer used to gather data received from RTT. */
 #define RX_BUFFER_SIZE (CONFIG_ETH_RTT_MTU + RX_BUFFER_OVERHEAD)
 
-/** Number of poll periods that must pass to assume that transfer is
- *  not running for now.
- */
-#define ACTIVE_POLL_COUNT (CONFIG_ETH_POLL_PERIOD_MS / \
-			   CONFIG_ETH_POLL_ACTIVE_PERIOD_MS)
+/** Size of the buffer used to collect encoded frames before writing to RTT. */
+#define TX_BUFFER_SIZE CONFIG_ETH_RTT_TX_BUFFER_SIZE
 
 BUILD_ASSERT(CONFIG_ETH_RTT_CHANNEL < SEGGER_RTT_MAX_NUM_UP_BUFFERS,
 		 "RTT channel number used in RTT network driver "
@@ -83,10 +89,13 @@ struct eth_rtt_context {
 	/** Network interface associated with this driver. */
 	struct net_if *iface;
 
-	/** Counter that counts down number of polls that must be done before
-	 *  assuming that transfer is not running for now.
+	/** Current RTT polling period in milliseconds. It is between
+	 *  CONFIG_ETH_POLL_ACTIVE_PERIOD_MS and CONFIG_ETH_POLL_PERIOD_MS.
 	 */
-	uint16_t active_poll_counter;
+	uint16_t poll_period_ms;
+
+	/** Lock that protects poll_period_ms and the poll timer. */
+	struct k_spinlock poll_lock;
 
 	/** CRC of currently sending frame to RTT. */
 	uint16_t crc;
@@ -104,6 +113,20 @@ struct eth_rtt_context {
 	/** Number of bytes currently occupied in rx_buffer. */
 	size_t rx_buffer_length;
 
+	/** Buffer that collects SLIP encoded frames before they are written
+	 *  to RTT up channel.
+	 */
+	uint8_t tx_buffer[TX_BUFFER_SIZE];
+
+	/** Number of bytes currently occupied in tx_buffer. */
+	size_t tx_buffer_length;
+
+	/** Mutex that protects tx_buffer and CRC of currently sending frame. */
+	struct k_mutex tx_mutex;
+
+	/** Work that writes collected frames to RTT. */
+	struct k_work tx_work;
+
 	/** Up buffer used by RTT library */
 	uint8_t rtt_up_buffer[CONFIG_ETH_RTT_UP_BUFFER_SIZE];
 
@@ -126,6 +149,16 @@ static const uint8_t reset_frame_data[] = {
 /** Static context for this driver. */
 static struct eth_rtt_context context_data;
 
+/** Delayed work used to do polling RTT down channel */
+static struct k_delayed_work eth_rtt_poll_work;
+
+/** Work queue that writes collected frames to RTT. Writing may block until
+ *  the PC reads the up buffer, so it is not done in the system work queue.
+ */
+static struct k_work_q eth_rtt_tx_work_q;
+
+static K_THREAD_STACK_DEFINE(eth_rtt_tx_stack, CONFIG_ETH_RTT_TX_STACK_SIZE);
+
 /** Utility function to dump all transferred data. */
 static void dbg_hex_dump(const char *prefix, const uint8_t *data, size_t length)
 {
@@ -165,6 +198,59 @@ static void dbg_hex_dump_end(const char *prefix)
 
 /*********** OUTPUT PART OF THE DRIVER (from network stack to RTT) ***********/
 
+/** Writes data collected in tx_buffer to RTT up channel.
+ *  @param context   Driver context.
+ */
+static void rtt_flush(struct eth_rtt_context *context)
+{
+	if (context->tx_buffer_length > 0) {
+		SEGGER_RTT_Write(CONFIG_ETH_RTT_CHANNEL, context->tx_buffer,
+				 context->tx_buffer_length);
+		dbg_hex_dump("RTT<", context->tx_buffer,
+			     context->tx_buffer_length);
+		context->tx_buffer_length = 0;
+	}
+}
+
+/** Adds data to tx_buffer. Collected data are written to RTT up channel
+ *  when there is no space left for new data. Data that do not fit in empty
+ *  tx_buffer are written directly.
+ *  @param context   Driver context.
+ *  @param data      Points data to send.
+ *  @param len       Number of bytes to send.
+ */
+static void rtt_write(struct eth_rtt_context *context, const uint8_t *data,
+		      size_t len)
+{
+	if (context->tx_buffer_length + len > sizeof(context->tx_buffer)) {
+		rtt_flush(context);
+	}
+
+	if (len >= sizeof(context->tx_buffer)) {
+		SEGGER_RTT_Write(CONFIG_ETH_RTT_CHANNEL, data, len);
+		dbg_hex_dump("RTT<", data, len);
+		return;
+	}
+
+	memcpy(&context->tx_buffer[context->tx_buffer_length], data, len);
+	context->tx_buffer_length += len;
+}
+
+/** Work handler that writes frames collected in tx_buffer to RTT. It is
+ *  submitted after each frame and runs with lower priority than the network
+ *  stack, so it runs when the network stack has no more frames to send for
+ *  now.
+ */
+static void tx_work_handler(struct k_work *work)
+{
+	struct eth_rtt_context *context =
+		CONTAINER_OF(work, struct eth_rtt_context, tx_work);
+
+	k_mutex_lock(&context->tx_mutex, K_FOREVER);
+	rtt_flush(context);
+	k_mutex_unlock(&context->tx_mutex);
+}
+
 /** Sends start of frame (SLIP_END) to RTT up channel.
  *  @param context   Driver context.
  */
@@ -172,9 +258,8 @@ static void rtt_send_begin(struct eth_rtt_context *context)
 {
 	uint8_t data = SLIP_END;
 
-	SEGGER_RTT_Write(CONFIG_ETH_RTT_CHANNEL, &data, sizeof(data));
 	dbg_hex_dump_begin("RTT<");
-	dbg_hex_dump("RTT<", &data, sizeof(data));
+	rtt_write(context, &data, sizeof(data));
 	context->crc = 0xFFFF;
 }
 
@@ -196,34 +281,23 @@ static void rtt_send_fragment(struct eth_rtt_context *context, const uint8_t *pt
 	for (; ptr < end; ptr++) {
 		if (*ptr == SLIP_END || *ptr == SLIP_ESC) {
 			if (ptr > plain_begin) {
-				SEGGER_RTT_Write(CONFIG_ETH_RTT_CHANNEL,
-						 plain_begin,
-						 ptr - plain_begin);
-				dbg_hex_dump("RTT<", plain_begin,
-					     ptr - plain_begin);
+				rtt_write(context, plain_begin,
+					  ptr - plain_begin);
 			}
 
 			if (*ptr == SLIP_END) {
-				SEGGER_RTT_Write(CONFIG_ETH_RTT_CHANNEL,
-						 end_stuffed,
-						 sizeof(end_stuffed));
-				dbg_hex_dump("RTT<", end_stuffed,
-					     sizeof(end_stuffed));
+				rtt_write(context, end_stuffed,
+					  sizeof(end_stuffed));
 			} else if (*ptr == SLIP_ESC) {
-				SEGGER_RTT_Write(CONFIG_ETH_RTT_CHANNEL,
-						 esc_stuffed,
-						 sizeof(esc_stuffed));
-				dbg_hex_dump("RTT<", esc_stuffed,
-					     sizeof(esc_stuffed));
+				rtt_write(context, esc_stuffed,
+					  sizeof(esc_stuffed));
 			}
 			plain_begin = ptr + 1;
 		}
 	}
 
 	if (ptr > plain_begin) {
-		SEGGER_RTT_Write(CONFIG_ETH_RTT_CHANNEL, plain_begin,
-				 ptr - plain_begin);
-		dbg_hex_dump("RTT<", plain_begin, ptr - plain_begin);
+		rtt_write(context, plain_begin, ptr - plain_begin);
 	}
 }
 
@@ -236,8 +310,7 @@ static void rtt_send_end(struct eth_rtt_context *context)
 	uint8_t data = SLIP_END;
 
 	rtt_send_fragment(context, crc_buffer, sizeof(crc_buffer));
-	SEGGER_RTT_Write(CONFIG_ETH_RTT_CHANNEL, &data, sizeof(data));
-	dbg_hex_dump("RTT<", &data, sizeof(data));
+	rtt_write(context, &data, sizeof(data));
 	dbg_hex_dump_end("RTT<");
 }
 
@@ -250,6 +323,7 @@ static int eth_send(const struct device *dev, struct net_pkt *pkt)
 {
 	struct eth_rtt_context *context = dev->data;
 	struct net_buf *frag;
+	k_spinlock_key_t key;
 
 	if (LOG_LEVEL >= LOG_LEVEL_DBG) {
 
@@ -265,6 +339,8 @@ static int eth_send(const struct device *dev, struct net_pkt *pkt)
 		return -ENODATA;
 	}
 
+	k_mutex_lock(&context->tx_mutex, K_FOREVER);
+
 	dbg_hex_dump_begin("ETH>");
 	rtt_send_begin(context);
 
@@ -276,6 +352,22 @@ static int eth_send(const struct device *dev, struct net_pkt *pkt)
 	dbg_hex_dump_end("ETH>");
 	rtt_send_end(context);
 
+	k_mutex_unlock(&context->tx_mutex);
+
+	/* Next frames from the network stack will be written together. */
+	k_work_submit_to_queue(&eth_rtt_tx_work_q, &context->tx_work);
+
+	/* Response to the frame is likely, so start polling faster. */
+	key = k_spin_lock(&context->poll_lock);
+
+	if (context->poll_period_ms > CONFIG_ETH_POLL_ACTIVE_PERIOD_MS) {
+		context->poll_period_ms = CONFIG_ETH_POLL_ACTIVE_PERIOD_MS;
+		k_delayed_work_submit(&eth_rtt_poll_work,
+				      K_MSEC(context->poll_period_ms));
+	}
+
+	k_spin_unlock(&context->poll_lock, key);
+
 	return 0;
 }
 
@@ -407,9 +499,6 @@ static void decode_new_slip_data(struct eth_rtt_context *context,
 	}
 }
 
-/** Delayed work used to do polling RTT down channel */
-static struct k_delayed_work eth_rtt_poll_work;
-
 /** Work handler that is submitted to system workqueue by the poll timer.
  *  It is responsible for reading all available data from RTT down buffer.
  */
@@ -417,7 +506,7 @@ static void poll_work_handler(struct k_work *work)
 {
 	struct eth_rtt_context *context = &context_data;
 	bool active = false;
-	k_timeout_t period = K_MSEC(CONFIG_ETH_POLL_PERIOD_MS);
+	k_spinlock_key_t key;
 	unsigned num;
 
 	do {
@@ -438,15 +527,19 @@ static void poll_work_handler(struct k_work *work)
 		}
 	} while (num > 0);
 
+	key = k_spin_lock(&context->poll_lock);
+
 	if (active) {
-		context->active_poll_counter = ACTIVE_POLL_COUNT;
-		period = K_MSEC(CONFIG_ETH_POLL_ACTIVE_PERIOD_MS);
-	} else if (context->active_poll_counter > 0) {
-		context->active_poll_counter--;
-		period = K_MSEC(CONFIG_ETH_POLL_ACTIVE_PERIOD_MS);
+		context->poll_period_ms = CONFIG_ETH_POLL_ACTIVE_PERIOD_MS;
+	} else {
+		context->poll_period_ms = MIN(2 * context->poll_period_ms,
+					      CONFIG_ETH_POLL_PERIOD_MS);
 	}
 
-	k_delayed_work_submit(&eth_rtt_poll_work, period);
+	k_delayed_work_submit(&eth_rtt_poll_work,
+			      K_MSEC(context->poll_period_ms));
+
+	k_spin_unlock(&context->poll_lock, key);
 }
 
 /******** COMMON PART OF THE DRIVER (initialization on configuration) ********/
@@ -468,7 +561,7 @@ static void eth_iface_init(struct net_if *iface)
 
 	context->init_done = true;
 	context->iface = iface;
-	context->active_poll_counter = 0;
+	context->poll_period_ms = CONFIG_ETH_POLL_PERIOD_MS;
 
 #if defined(CONFIG_ETH_RTT_MAC_ADDR)
 	if (CONFIG_ETH_RTT_MAC_ADDR[0] != 0) {
@@ -493,7 +586,7 @@ static void eth_iface_init(struct net_if *iface)
 
 	k_delayed_work_init(&eth_rtt_poll_work, poll_work_handler);
 	k_delayed_work_submit(&eth_rtt_poll_work,
-			      K_MSEC(CONFIG_ETH_POLL_PERIOD_MS));
+			      K_MSEC(context->poll_period_ms));
 
 	LOG_INF("Initialized '%s': "
 		"MAC addr %02X:%02X:%02X:%02X:%02X:%02X, "
@@ -504,9 +597,12 @@ static void eth_iface_init(struct net_if *iface)
 		context->mac_addr[5], CONFIG_ETH_RTT_MTU,
 		CONFIG_ETH_RTT_CHANNEL, sizeof(*context));
 
+	k_mutex_lock(&context->tx_mutex, K_FOREVER);
 	rtt_send_begin(context);
 	rtt_send_fragment(context, reset_frame_data, sizeof(reset_frame_data));
 	rtt_send_end(context);
+	rtt_flush(context);
+	k_mutex_unlock(&context->tx_mutex);
 }
 
 /** Returns network driver capabilities. Currently no additional capabilities
@@ -524,6 +620,13 @@ static int eth_rtt_init(const struct device *dev)
 {
 	struct eth_rtt_context *context = dev->data;
 
+	k_mutex_init(&context->tx_mutex);
+	k_work_init(&context->tx_work, tx_work_handler);
+	k_work_q_start(&eth_rtt_tx_work_q, eth_rtt_tx_stack,
+		       K_THREAD_STACK_SIZEOF(eth_rtt_tx_stack),
+		       CONFIG_ETH_RTT_TX_THREAD_PRIORITY);
+	k_thread_name_set(&eth_rtt_tx_work_q.thread, "eth_rtt_tx");
+
 	SEGGER_RTT_ConfigUpBuffer(CONFIG_ETH_RTT_CHANNEL, CHANNEL_NAME,
 				  context->rtt_up_buffer,
 				  sizeof(context->rtt_up_buffer),
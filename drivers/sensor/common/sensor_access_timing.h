@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef SENSOR_ACCESS_TIMING_H__
+#define SENSOR_ACCESS_TIMING_H__
+
+#include <kernel.h>
+
+/* Timing of the SPI accesses to a sensor that needs a delay between two
+ * accesses. Instead of waiting for the delay at the end of each access, the
+ * driver records when the access ended, and the next access only waits for
+ * the part of the delay that has not passed yet.
+ */
+struct sensor_access_timing {
+	uint32_t end_cycles;	/* Cycle count at the end of the last access. */
+	uint32_t gap_us;	/* Delay required before the next access. */
+};
+
+/* Waits of at least two system clock ticks are done by sleeping instead of
+ * busy waiting. Shorter waits would be extended too much by the tick
+ * rounding.
+ */
+#define SENSOR_ACCESS_SLEEP_MIN_US \
+	(2 * USEC_PER_SEC / CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+
+static inline void sensor_access_wait_us(uint32_t us)
+{
+	if ((us >= SENSOR_ACCESS_SLEEP_MIN_US) && !k_is_in_isr()) {
+		k_usleep(us);
+	} else {
+		k_busy_wait(us);
+	}
+}
+
+/* Record the end of an access, and the delay the sensor needs before the
+ * next access can start.
+ */
+static inline void sensor_access_end(struct sensor_access_timing *timing,
+				     uint32_t gap_us)
+{
+	timing->end_cycles = k_cycle_get_32();
+	timing->gap_us = gap_us;
+}
+
+/* Wait for what remains of the delay required after the last access. */
+static inline void sensor_access_gap_wait(
+	const struct sensor_access_timing *timing)
+{
+	uint32_t cycles = k_cycle_get_32() - timing->end_cycles;
+	uint32_t elapsed_us;
+
+	/* The access may have ended just before the cycle counter ticked, so
+	 * one cycle less than counted is certain to have passed. With a slow
+	 * cycle counter, such as the RTC, this cycle is longer than the delay.
+	 */
+	elapsed_us = (cycles > 0) ? k_cyc_to_us_floor32(cycles - 1) : 0;
+
+	if (elapsed_us < timing->gap_us) {
+		sensor_access_wait_us(timing->gap_us - elapsed_us);
+	}
+}
+
+#endif /* SENSOR_ACCESS_TIMING_H__ */
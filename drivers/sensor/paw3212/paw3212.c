@@ -13,6 +13,8 @@
 #include <sys/byteorder.h>
 #include <sensor/paw3212.h>
 
+#include "sensor_access_timing.h"
+
 #include <logging/log.h>
 LOG_MODULE_REGISTER(paw3212, CONFIG_PAW3212_LOG_LEVEL);
 
@@ -122,6 +124,7 @@ struct paw3212_data {
 	struct k_work                trigger_handler_work;
 	struct k_delayed_work        init_work;
 	enum async_init_step         async_init_step;
+	struct sensor_access_timing  access_timing;
 	int                          err;
 	bool                         ready;
 };
@@ -174,7 +177,9 @@ static int spi_cs_ctrl(struct paw3212_data *dev_data, bool enable)
 	int val = (enable) ? (0) : (1);
 	int err;
 
-	if (!enable) {
+	if (enable) {
+		sensor_access_gap_wait(&dev_data->access_timing);
+	} else {
 		k_busy_wait(T_NCS_SCLK);
 	}
 
@@ -218,7 +223,7 @@ static int reg_read(struct paw3212_data *dev_data, uint8_t reg, uint8_t *buf)
 		return err;
 	}
 
-	k_busy_wait(T_SRAD);
+	sensor_access_wait_us(T_SRAD);
 
 	/* Read register value. */
 	struct spi_buf rx_buf = {
@@ -241,7 +246,7 @@ static int reg_read(struct paw3212_data *dev_data, uint8_t reg, uint8_t *buf)
 		return err;
 	}
 
-	k_busy_wait(T_SRX);
+	sensor_access_end(&dev_data->access_timing, T_SRX);
 
 	return 0;
 }
@@ -276,14 +281,14 @@ static int reg_write(struct paw3212_data *dev_data, uint8_t reg, uint8_t val)
 		return err;
 	}
 
-	k_busy_wait(T_SCLK_NCS_WR);
+	sensor_access_wait_us(T_SCLK_NCS_WR);
 
 	err = spi_cs_ctrl(dev_data, false);
 	if (err) {
 		return err;
 	}
 
-	k_busy_wait(T_SWX);
+	sensor_access_end(&dev_data->access_timing, T_SWX);
 
 	return 0;
 }
@@ -13,6 +13,8 @@
 #include <sys/byteorder.h>
 #include <sensor/pmw3360.h>
 
+#include "sensor_access_timing.h"
+
 #include <logging/log.h>
 LOG_MODULE_REGISTER(pmw3360, CONFIG_PMW3360_LOG_LEVEL);
 
@@ -140,6 +142,7 @@ struct pmw3360_data {
 	struct k_work                trigger_handler_work;
 	struct k_delayed_work        init_work;
 	enum async_init_step         async_init_step;
+	struct sensor_access_timing  access_timing;
 	int                          err;
 	bool                         ready;
 	bool                         last_read_burst;
@@ -185,7 +188,9 @@ static int spi_cs_ctrl(struct pmw3360_data *dev_data, bool enable)
 	int val = (enable) ? (0) : (1);
 	int err;
 
-	if (!enable) {
+	if (enable) {
+		sensor_access_gap_wait(&dev_data->access_timing);
+	} else {
 		k_busy_wait(T_NCS_SCLK);
 	}
 
@@ -229,7 +234,7 @@ static int reg_read(struct pmw3360_data *dev_data, uint8_t reg, uint8_t *buf)
 		return err;
 	}
 
-	k_busy_wait(T_SRAD);
+	sensor_access_wait_us(T_SRAD);
 
 	/* Read register value. */
 	struct spi_buf rx_buf = {
@@ -252,7 +257,7 @@ static int reg_read(struct pmw3360_data *dev_data, uint8_t reg, uint8_t *buf)
 		return err;
 	}
 
-	k_busy_wait(T_SRX);
+	sensor_access_end(&dev_data->access_timing, T_SRX);
 
 	dev_data->last_read_burst = false;
 
@@ -289,14 +294,14 @@ static int reg_write(struct pmw3360_data *dev_data, uint8_t reg, uint8_t val)
 		return err;
 	}
 
-	k_busy_wait(T_SCLK_NCS_WR);
+	sensor_access_wait_us(T_SCLK_NCS_WR);
 
 	err = spi_cs_ctrl(dev_data, false);
 	if (err) {
 		return err;
 	}
 
-	k_busy_wait(T_SWX);
+	sensor_access_end(&dev_data->access_timing, T_SWX);
 
 	dev_data->last_read_burst = false;
 
@@ -344,7 +349,10 @@ static int motion_burst_read(struct pmw3360_data *dev_data, uint8_t *data,
 		return err;
 	}
 
-	k_busy_wait(T_SRAD_MOTBR);
+	/* The delay is shorter than a system clock tick with the usual tick
+	 * rates, so the CPU busy waits for it.
+	 */
+	sensor_access_wait_us(T_SRAD_MOTBR);
 
 	const struct spi_buf rx_buf = {
 		.buf = data,
@@ -366,7 +374,7 @@ static int motion_burst_read(struct pmw3360_data *dev_data, uint8_t *data,
 	if (err) {
 		return err;
 	}
-	k_busy_wait(T_BEXIT);
+	sensor_access_end(&dev_data->access_timing, T_BEXIT);
 
 	dev_data->last_read_burst = true;
 
@@ -419,7 +427,7 @@ static int burst_write(struct pmw3360_data *dev_data, uint8_t reg, const uint8_t
 		return err;
 	}
 
-	k_busy_wait(T_BEXIT);
+	sensor_access_end(&dev_data->access_timing, T_BEXIT);
 
 	dev_data->last_read_burst = false;
 
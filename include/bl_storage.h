@@ -7,6 +7,7 @@
 #ifndef BL_STORAGE_H_
 #define BL_STORAGE_H_
 
+#include <stdbool.h>
 #include <zephyr/types.h>
 #include <string.h>
 
@@ -17,6 +18,9 @@ extern "C" {
 
 #define EHASHFF 113 /* A hash contains too many 0xFs. */
 
+/** Length of the image hash stored in a validation cache entry. */
+#define VALIDATION_CACHE_HASH_LEN 16
+
 /** @defgroup bl_storage Bootloader storage (protected data).
  * @{
  */
@@ -106,6 +110,48 @@ uint16_t get_monotonic_counter(void);
  */
 int set_monotonic_counter(uint16_t new_counter);
 
+/**
+ * @brief Get the number of validation cache entries.
+ *
+ * @return The number of entries. If the provision page does not contain the
+ *         information, 0 is returned.
+ */
+uint16_t num_validation_cache_entries(void);
+
+/**
+ * @brief Check if an image has already been validated.
+ *
+ * The validation cache holds the hashes of images which have passed full
+ * signature validation. An entry is only used if the public key that was used
+ * to validate the image has not been invalidated since.
+ *
+ * @param[in]  hash     The hash of the image. Only the first
+ *                      @ref VALIDATION_CACHE_HASH_LEN bytes are used.
+ * @param[in]  version  The version of the image.
+ *
+ * @retval true   The image has been validated before.
+ * @retval false  There is no cache entry for the image.
+ */
+bool validation_cache_check(const uint8_t *hash, uint16_t version);
+
+/**
+ * @brief Add an image to the validation cache.
+ *
+ * Each entry is written to the next free slots and can not be erased.
+ *
+ * @param[in]  hash     The hash of the image. Only the first
+ *                      @ref VALIDATION_CACHE_HASH_LEN bytes are used.
+ * @param[in]  version  The version of the image.
+ * @param[in]  key_idx  Index of the public key the image was validated with.
+ *
+ * @retval 0        The entry was stored successfully.
+ * @retval -EINVAL  @p version is invalid (cannot be 0xFFFF).
+ * @retval -ENOMEM  There are no more free entries (see
+ *                  @option{CONFIG_SB_NUM_VALIDATION_CACHE_ENTRIES}).
+ */
+int validation_cache_store(const uint8_t *hash, uint16_t version,
+			   uint16_t key_idx);
+
   /** @} */
 
 #ifdef __cplusplus
@@ -117,12 +117,39 @@ struct bt_mesh_light_ctrl_srv_reg_cfg {
 	uint8_t accuracy;
 };
 
+/** Fixed point illumination regulator coefficients.
+ *
+ *  All coefficients are in Q16.16 format, and are derived from the
+ *  floating point coefficients in @ref bt_mesh_light_ctrl_srv_reg_cfg.
+ */
+struct bt_mesh_light_ctrl_srv_reg_q16 {
+	/** Regulator upwards integral coefficient */
+	int32_t kiu;
+	/** Regulator downwards integral coefficient */
+	int32_t kid;
+	/** Regulator upwards propotional coefficient */
+	int32_t kpu;
+	/** Regulator downwards propotional coefficient */
+	int32_t kpd;
+};
+
 /** Illumination regulator */
 struct bt_mesh_light_ctrl_srv_reg {
 	/** Regulator step timer */
 	struct k_delayed_work timer;
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_FIXED
+	/** Internal integral sum, in Q16.16 format. */
+	uint32_t i;
+	/** Fixed point coefficients */
+	struct bt_mesh_light_ctrl_srv_reg_q16 q16;
+#else
 	/** Internal integral sum. */
 	float i;
+#endif
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_ADAPTIVE
+	/** Current step interval (in milliseconds) */
+	uint32_t interval;
+#endif
 	/** Previous output */
 	uint16_t prev;
 	/** Regulator configuration */
@@ -55,6 +55,9 @@
 #include <bluetooth/mesh/scene_cli.h>
 #include <bluetooth/mesh/scene_srv.h>
 
+/* Publication scheduler */
+#include <bluetooth/mesh/pub_sched.h>
+
 /** @brief Check whether the model publishes to a unicast address.
  *
  * @param[in] mod Model to check
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/**
+ * @file
+ * @defgroup bt_mesh_pub_sched Bluetooth Mesh publication scheduler
+ * @{
+ * @brief API for the node-wide model publication scheduler.
+ */
+
+#ifndef BT_MESH_PUB_SCHED_H__
+#define BT_MESH_PUB_SCHED_H__
+
+#include <bluetooth/mesh.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Publication scheduler statistics. */
+struct bt_mesh_pub_sched_stats {
+	/** Number of messages sent by the models on this node. */
+	uint32_t msgs;
+	/** Number of publications deferred to a shared publication slot. */
+	uint32_t deferred;
+	/** Number of deferred publications that were replaced by a newer
+	 *  message with the same opcode from the same model before their slot.
+	 */
+	uint32_t superseded;
+	/** Number of publications that failed, including deferred
+	 *  publications that failed when their slot came.
+	 */
+	uint32_t failed;
+	/** Number of publication slots that have been served. */
+	uint32_t slots;
+	/** Estimated advertising airtime spent on the sent messages, including
+	 *  retransmissions (in microseconds).
+	 */
+	uint64_t airtime_us;
+};
+
+/** @brief Get the publication scheduler statistics.
+ *
+ *  @param[out] stats Statistics structure to fill.
+ */
+void bt_mesh_pub_sched_stats_get(struct bt_mesh_pub_sched_stats *stats);
+
+/** @brief Reset the publication scheduler statistics. */
+void bt_mesh_pub_sched_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BT_MESH_PUB_SCHED_H__ */
+
+/** @} */
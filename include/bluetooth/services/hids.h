@@ -176,6 +176,60 @@ typedef void (*bt_hids_rep_handler_t) (struct bt_hids_rep *rep,
 				       struct bt_conn *conn,
 				       bool write);
 
+#if CONFIG_BT_HIDS_COALESCE
+/** @brief Input Report merge callback.
+ *
+ * Called when an Input Report is sent while the previous notifications of
+ * the same report are still queued, and another report is already waiting
+ * for them. The callback is called with interrupts locked, so it must be
+ * short.
+ *
+ * @param pending Report waiting to be sent. The callback merges @p rep into
+ *                it.
+ * @param rep     New report.
+ * @param len     Length of the reports.
+ *
+ * @retval true If @p rep was merged into @p pending.
+ * @retval false If the reports can't be merged, for instance because @p rep
+ *         changes a button state. The waiting report is then sent before
+ *         @p rep.
+ */
+typedef bool (*bt_hids_rep_merge_t)(uint8_t *pending, uint8_t const *rep,
+				    uint8_t len);
+
+/** @brief Report coalescing state. The members are internal to the service.
+ */
+struct bt_hids_coalesce {
+	/** Lock protecting the coalescing state. */
+	struct k_spinlock lock;
+
+	/** Number of notifications that are not yet sent. */
+	uint8_t in_flight;
+
+	/** Number of queued notifications that complete a report sent by the
+	 *  application.
+	 */
+	uint8_t cb_owed;
+
+	/** Number of notifications that are not yet sent, per connection. */
+	uint8_t conn_in_flight[CONFIG_BT_MAX_CONN];
+
+	/** Number of queued notifications that complete a report sent by the
+	 *  application, per connection.
+	 */
+	uint8_t conn_cb_owed[CONFIG_BT_MAX_CONN];
+
+	/** Number of reports merged into the waiting report. */
+	uint8_t merged;
+
+	/** Connection of the waiting report, or NULL for all connections. */
+	struct bt_conn *conn;
+
+	/** Callback for the sent reports. */
+	bt_gatt_complete_func_t cb;
+};
+#endif
+
 /** @brief Input Report.
  */
 struct bt_hids_inp_rep {
@@ -226,6 +280,20 @@ struct bt_hids_inp_rep {
 
 	/** Callback with the notification event. */
 	bt_hids_notify_handler_t handler;
+
+#if CONFIG_BT_HIDS_COALESCE
+	/** Callback merging two reports, or NULL to never merge this report.
+	 *  Only reports up to CONFIG_BT_HIDS_COALESCE_REP_LEN bytes
+	 *  long are merged.
+	 */
+	bt_hids_rep_merge_t merge;
+
+	/** Report coalescing state. */
+	struct bt_hids_coalesce coalesce;
+
+	/** Report waiting for the queued notifications. */
+	uint8_t pending[CONFIG_BT_HIDS_COALESCE_REP_LEN];
+#endif
 };
 
 
@@ -277,6 +345,17 @@ struct bt_hids_boot_mouse_inp_rep {
 
 	/** Callback with the notification event. */
 	bt_hids_notify_handler_t handler;
+
+#if CONFIG_BT_HIDS_COALESCE
+	/** Report coalescing state. */
+	struct bt_hids_coalesce coalesce;
+
+	/** Waiting X axis movement. */
+	int16_t x_delta;
+
+	/** Waiting Y axis movement. */
+	int16_t y_delta;
+#endif
 };
 
 /** @brief Boot Keyboard Input Report.
@@ -467,6 +546,12 @@ struct bt_hids_conn_data {
 	/** Protocol Mode context data. */
 	uint8_t pm_ctx_value;
 
+	/** Bitmap of the Input Reports the peer is subscribed to. */
+	uint16_t sub_bitmap;
+
+	/** Subscription state generation the bitmap is valid for. */
+	atomic_val_t sub_gen;
+
 	/** HIDS Boot Mouse Input Report Context. */
 	uint8_t hids_boot_mouse_inp_rep_ctx[BT_HIDS_BOOT_MOUSE_REP_LEN];
 
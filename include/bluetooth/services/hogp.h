@@ -207,7 +207,19 @@ struct bt_hogp {
 		 * current state of this process.
 		 */
 		uint8_t rep_idx;
+#if defined(CONFIG_BT_HOGP_READ_MULTIPLE)
+		/** First value read with the current request. */
+		uint16_t item;
+		/** Number of values read with the current request. */
+		uint8_t count;
+		/** Handles read with the current request. */
+		uint16_t handles[CONFIG_BT_HOGP_READ_MULTIPLE_HANDLES];
+#endif
 	} init_repref;
+#if defined(CONFIG_BT_HOGP_CACHE)
+	/** Work item used for returning the cached Report Map. */
+	struct k_work map_work;
+#endif
 
 	struct {
 		/** Keyboard input boot report. Input and Output keyboard
@@ -524,6 +536,26 @@ int bt_hogp_suspend(struct bt_hogp *hogp);
  */
 int bt_hogp_exit_suspend(struct bt_hogp *hogp);
 
+#if defined(CONFIG_BT_HOGP_CACHE) || defined(__DOXYGEN__)
+/**
+ * @brief Remove the cached information of a peer.
+ *
+ * Call this function from the bond_deleted callback of the connection
+ * authentication callbacks, so that the cached information of a peer is
+ * dropped together with its bond.
+ *
+ * @param id   Local identity of the bond.
+ * @param peer Peer address, or BT_ADDR_LE_ANY to remove all peers of the
+ *             identity.
+ */
+void bt_hogp_cache_bond_deleted(uint8_t id, const bt_addr_le_t *peer);
+#else
+static inline void bt_hogp_cache_bond_deleted(uint8_t id,
+					      const bt_addr_le_t *peer)
+{
+}
+#endif
+
 
 /**
  * @brief Get the connection object from the HIDS client.
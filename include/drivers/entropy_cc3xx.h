@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/**
+ * @file entropy_cc3xx.h
+ *
+ * @brief Public APIs for the CC3xx entropy driver.
+ */
+
+#ifndef ZEPHYR_INCLUDE_ENTROPY_CC3XX_H_
+#define ZEPHYR_INCLUDE_ENTROPY_CC3XX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/types.h>
+
+/**
+ * @defgroup entropy_cc3xx CC3xx entropy driver
+ * @{
+ */
+
+/** @brief Entropy pool statistics. */
+struct entropy_cc3xx_pool_stats {
+	/** Number of bytes in the pool. */
+	size_t fill;
+	/** Lowest number of bytes in the pool since initialization. */
+	size_t min_fill;
+	/** Size of the pool. */
+	size_t size;
+	/** Requests served from the pool. */
+	uint32_t hits;
+	/** Requests for more bytes than the pool held. */
+	uint32_t misses;
+	/** Background refills of the pool. */
+	uint32_t refills;
+	/** Times the DRBG was seeded from the TRNG. */
+	uint32_t reseeds;
+	/** Failures of the TRNG or the DRBG. */
+	uint32_t errors;
+};
+
+/** @brief Get the entropy pool statistics.
+ *
+ * @param stats Pointer to the statistics.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL If @p stats is NULL.
+ */
+int entropy_cc3xx_pool_stats_get(struct entropy_cc3xx_pool_stats *stats);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_ENTROPY_CC3XX_H_ */
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/**
+ * @file flash_sync_mpsl.h
+ *
+ * @brief Public APIs for the flash driver synchronization using MPSL.
+ */
+
+#ifndef ZEPHYR_INCLUDE_FLASH_SYNC_MPSL_H_
+#define ZEPHYR_INCLUDE_FLASH_SYNC_MPSL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/types.h>
+
+/**
+ * @defgroup flash_sync_mpsl Flash synchronization using MPSL
+ * @{
+ */
+
+/** @brief Flash synchronization statistics. */
+struct flash_sync_mpsl_stats {
+	/** Flash operations completed. */
+	uint32_t operations;
+	/** Flash operations that did not complete in time. */
+	uint32_t timeouts;
+	/** Timeslots granted. */
+	uint32_t timeslots;
+	/** Timeslot requests that were blocked or cancelled. */
+	uint32_t blocked;
+	/** Steps, like word writes, done in the timeslots. */
+	uint32_t steps;
+	/** Time spent in the timeslots, in microseconds. */
+	uint32_t busy_us;
+	/** Longest time a flash operation took, in microseconds. */
+	uint32_t latency_max_us;
+	/** Total time the flash operations took, in microseconds. */
+	uint32_t latency_total_us;
+};
+
+/** @brief Get the flash synchronization statistics.
+ *
+ * The statistics are updated while flash operations are in progress.
+ *
+ * @param stats Pointer to the statistics.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EINVAL If @p stats is NULL.
+ */
+int flash_sync_mpsl_stats_get(struct flash_sync_mpsl_stats *stats);
+
+/** @brief Reset the flash synchronization statistics. */
+void flash_sync_mpsl_stats_reset(void);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_FLASH_SYNC_MPSL_H_ */
@@ -200,6 +200,59 @@ struct esb_payload {
 	uint8_t data[CONFIG_ESB_MAX_PAYLOAD_LENGTH]; /**< The payload data. */
 };
 
+/** @brief Reference to a received payload in the RX FIFO.
+ *
+ *  The payload data is owned by the RX FIFO, and is only valid until
+ *  @ref esb_rx_commit is called.
+ */
+struct esb_payload_ref {
+	const uint8_t *data; /**< The payload data. */
+	uint8_t length; /**< Length of the payload data. */
+	uint8_t pipe;   /**< Pipe the payload was received on. */
+	int8_t rssi;    /**< RSSI for the received packet. */
+	uint8_t noack;  /**< Flag indicating that this packet was not
+			 *  acknowledged.
+			 */
+	uint8_t pid;    /**< PID assigned during communication. */
+};
+
+#if defined(CONFIG_ESB_PIPE_STATS)
+/** Number of bins in the RSSI histogram of @ref esb_pipe_stats. */
+#define ESB_PIPE_STATS_RSSI_BINS 10
+/** Width of each RSSI histogram bin, in dB. */
+#define ESB_PIPE_STATS_RSSI_BIN_WIDTH 10
+
+/** @brief Link statistics for a pipe. */
+struct esb_pipe_stats {
+	/** Number of payloads that were transmitted successfully. */
+	uint32_t tx_success;
+	/** Number of payloads that failed after all retransmits. */
+	uint32_t tx_failed;
+	/** Number of transmission attempts, including retransmits and the
+	 *  attempts on the other channels when channel hopping is enabled.
+	 */
+	uint32_t tx_attempts;
+	/** Number of new packets received. */
+	uint32_t rx_packets;
+	/** Number of retransmitted packets received and discarded. */
+	uint32_t rx_retransmits;
+	/** Histogram of the RSSI of received packets and acknowledgments.
+	 *  Bin n counts the packets received with an RSSI from
+	 *  -(n * @ref ESB_PIPE_STATS_RSSI_BIN_WIDTH) dBm and down, and the
+	 *  last bin also counts all weaker packets.
+	 */
+	uint32_t rssi_hist[ESB_PIPE_STATS_RSSI_BINS];
+	/** Moving average of the time from the first transmission attempt of
+	 *  a payload until it is acknowledged, in microseconds.
+	 */
+	uint32_t ack_latency_avg_us;
+	/** Longest time from the first transmission attempt of a payload
+	 *  until it is acknowledged, in microseconds.
+	 */
+	uint32_t ack_latency_max_us;
+};
+#endif /* defined(CONFIG_ESB_PIPE_STATS) */
+
 /** @brief Enhanced ShockBurst event. */
 struct esb_evt {
 	enum esb_evt_id evt_id;	/**< Enhanced ShockBurst event ID. */
@@ -243,6 +296,10 @@ struct esb_config {
 };
 
 /** @brief Initialize the Enhanced ShockBurst module.
+ *
+ *  When CONFIG_ESB_CHANNEL_HOPPING is enabled and a hop table is set, the
+ *  retransmit parameters must let the PTX sweep the hop table within the
+ *  PRX dwell time, see @ref esb_set_hopping_channels.
  *
  *  @param  config	Parameters for initializing the module.
  *
@@ -299,6 +356,67 @@ int esb_write_payload(const struct esb_payload *payload);
  */
 int esb_read_rx_payload(struct esb_payload *payload);
 
+/** @brief Claim a buffer in the TX FIFO.
+ *
+ *  The claimed buffer is transmitted directly by the radio, without any
+ *  intermediate copies. It can hold up to CONFIG_ESB_MAX_PAYLOAD_LENGTH
+ *  bytes, and is queued for transmission by calling @ref esb_tx_commit
+ *  with the same pipe. Claiming again before committing returns the same
+ *  buffer.
+ *
+ *  The TX FIFO has a single producer. This function and
+ *  @ref esb_tx_commit must not be called concurrently with each other or
+ *  with @ref esb_write_payload.
+ *
+ *  @param[in]  pipe	Pipe to use for the payload.
+ *  @param[out] data	Pointer to the claimed payload buffer.
+ *
+ * @retval 0 If successful.
+ * @retval -EACCES If the module is not initialized.
+ * @retval -EINVAL If @p data is NULL or @p pipe is invalid.
+ * @retval -ENOMEM If the TX FIFO is full.
+ */
+int esb_tx_claim(uint8_t pipe, uint8_t **data);
+
+/** @brief Commit the buffer claimed with @ref esb_tx_claim.
+ *
+ *  The payload is queued in the same way as with @ref esb_write_payload.
+ *
+ *  @param[in] pipe	Pipe to use for the payload.
+ *  @param[in] length	Length of the payload data.
+ *  @param[in] noack	Flag indicating that this packet will not be
+ *			acknowledged.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_tx_commit(uint8_t pipe, uint8_t length, bool noack);
+
+/** @brief Claim the oldest payload in the RX FIFO.
+ *
+ *  The payload is referenced in place, and stays in the RX FIFO until
+ *  @ref esb_rx_commit is called. Claiming again before committing returns
+ *  the same payload.
+ *
+ *  @param[out] payload	Reference to the received payload.
+ *
+ * @retval 0 If successful.
+ * @retval -EACCES If the module is not initialized.
+ * @retval -EINVAL If @p payload is NULL.
+ * @retval -ENODATA If the RX FIFO is empty.
+ */
+int esb_rx_claim(struct esb_payload_ref *payload);
+
+/** @brief Release the payload claimed with @ref esb_rx_claim.
+ *
+ *  The payload buffer is returned to the RX FIFO, and can no longer be
+ *  accessed.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_rx_commit(void);
+
 /** @brief Start transmitting data.
  *
  * @retval 0 If successful.
@@ -322,7 +440,10 @@ int esb_stop_rx(void);
 
 /** @brief Flush the TX buffer.
  *
- * This function clears the TX FIFO buffer.
+ * This function clears the TX FIFO buffer. If the radio is transmitting a
+ * payload, the payload is removed when the transmission ends, and the
+ * transmission is not retried. A payload that has been claimed with
+ * @ref esb_tx_claim but not committed must be claimed again.
  *
  * @retval 0 If successful.
  *           Otherwise, a (negative) error code is returned.
@@ -330,8 +451,14 @@ int esb_stop_rx(void);
 int esb_flush_tx(void);
 
 /** @brief Pop the first item from the TX buffer.
+ *
+ * When CONFIG_ESB_TX_QUEUE_PER_PIPE is enabled, the item is popped from the
+ * TX FIFO of the last transmission, so that a payload that failed can be
+ * dropped. If that FIFO is empty, the item is popped from the TX FIFO that
+ * is to be transmitted next.
  *
  * @retval 0 If successful.
+ * @retval -EBUSY If the radio is transmitting the item.
  *           Otherwise, a (negative) error code is returned.
  */
 int esb_pop_tx(void);
@@ -416,6 +543,9 @@ int esb_update_prefix(uint8_t pipe, uint8_t prefix);
  *  stop RX before changing the channel. After changing the channel, operation
  *  can be resumed.
  *
+ *  When CONFIG_ESB_CHANNEL_HOPPING is enabled, this function disables
+ *  channel hopping.
+ *
  *  @param[in] channel	Channel to use for radio.
  *
  * @retval 0 If successful.
@@ -432,6 +562,34 @@ int esb_set_rf_channel(uint32_t channel);
  */
 int esb_get_rf_channel(uint32_t *channel);
 
+#if defined(CONFIG_ESB_CHANNEL_HOPPING)
+/** @brief Set the channels to hop between.
+ *
+ *  The PTX and PRX must use the same hop table. The module starts on the
+ *  first channel in the table. Channel hopping is disabled until this
+ *  function is called, and when @ref esb_set_rf_channel is called.
+ *
+ *  The PRX dwell time must be longer than the time it takes the PTX to
+ *  sweep the hop table with the retransmit parameters set with
+ *  @ref esb_init, so this function must be called after @ref esb_init.
+ *  With CONFIG_ESB_ADAPTIVE_RETRANSMIT, the sweep time is computed with
+ *  CONFIG_ESB_ADAPTIVE_RETRANSMIT_DELAY_MAX as the retransmit delay.
+ *
+ *  The module must be in an idle state to call this function.
+ *
+ *  @param[in] channels	Hop table, or NULL to disable channel hopping.
+ *  @param[in] count	Number of channels in the hop table, at most
+ *			CONFIG_ESB_CHANNEL_HOPPING_TABLE_SIZE. Set to 0 to
+ *			stay on the channel set with @ref esb_set_rf_channel.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If a channel is invalid, or if the PTX sweep takes longer
+ *                 than the PRX dwell time.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_set_hopping_channels(const uint8_t *channels, uint8_t count);
+#endif /* defined(CONFIG_ESB_CHANNEL_HOPPING) */
+
 /** @brief Set the radio output power.
  *
  *  @param[in] tx_output_power	Output power.
@@ -446,6 +604,9 @@ int esb_set_tx_power(enum esb_tx_power tx_output_power);
  *  @param[in] delay	Delay between retransmissions.
  *
  * @retval 0 If successful.
+ * @retval -EINVAL If the delay is too short, or if channel hopping is
+ *                 enabled and the PTX sweep would take longer than the PRX
+ *                 dwell time.
  *           Otherwise, a (negative) error code is returned.
  */
 int esb_set_retransmit_delay(uint16_t delay);
@@ -455,6 +616,8 @@ int esb_set_retransmit_delay(uint16_t delay);
  *  @param[in] count	Number of retransmissions.
  *
  * @retval 0 If successful.
+ * @retval -EINVAL If channel hopping is enabled and the PTX sweep would take
+ *                 longer than the PRX dwell time.
  *           Otherwise, a (negative) error code is returned.
  */
 int esb_set_retransmit_count(uint16_t count);
@@ -482,6 +645,21 @@ int esb_set_bitrate(enum esb_bitrate bitrate);
  */
 int esb_reuse_pid(uint8_t pipe);
 
+#if defined(CONFIG_ESB_PIPE_STATS)
+/** @brief Get the link statistics for a pipe.
+ *
+ *  @param[in]  pipe	Pipe.
+ *  @param[out] stats	Link statistics.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If @p stats is NULL or @p pipe is invalid.
+ */
+int esb_pipe_stats_get(uint8_t pipe, struct esb_pipe_stats *stats);
+
+/** @brief Reset the link statistics for all pipes. */
+void esb_pipe_stats_reset(void);
+#endif /* defined(CONFIG_ESB_PIPE_STATS) */
+
 /** @} */
 
 #ifdef __cplusplus
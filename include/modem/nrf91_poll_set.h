@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NRF91_POLL_SET_H__
+#define NRF91_POLL_SET_H__
+
+#include <kernel.h>
+#include <net/socket.h>
+#include <bsd_limits.h>
+#include <nrf_socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file nrf91_poll_set.h
+ *
+ * @defgroup nrf91_poll_set nRF91 socket poll sets
+ * @{
+ * @brief Persistent sets of nRF91 sockets to wait for.
+ *
+ * Sockets are added to a poll set once and the set is then waited for
+ * any number of times. Unlike poll(), the sockets are not looked up and
+ * their events are not translated in each call, and only the sockets
+ * that are ready are returned.
+ *
+ * Remove a socket from all sets before closing it.
+ */
+
+/** @brief Operations on a poll set. See @ref nrf91_poll_set_ctl. */
+enum nrf91_poll_set_op {
+	/** Add a socket to the set. */
+	NRF91_POLL_SET_ADD,
+	/** Change the events that are waited for on a socket in the set. */
+	NRF91_POLL_SET_MOD,
+	/** Remove a socket from the set. */
+	NRF91_POLL_SET_DEL,
+};
+
+/** @brief Poll set. The members are internal to the library. */
+struct nrf91_poll_set {
+	/** Sockets as registered by the application. */
+	struct zsock_pollfd fds[BSD_MAX_SOCKET_COUNT];
+	/** The same sockets, translated for the modem. */
+	struct nrf_pollfd nrf_fds[BSD_MAX_SOCKET_COUNT];
+	/** Number of sockets in the set. */
+	int count;
+	/** Socket that the next wait looks at first, so that the sockets
+	 *  that are not returned when too many are ready are not starved.
+	 */
+	int next;
+	/** Protects the set. */
+	struct k_mutex lock;
+};
+
+/**
+ * @brief Initialize an empty poll set.
+ *
+ * @param set Poll set.
+ *
+ * @return 0 on success, -1 with errno set to EINVAL if @p set is NULL.
+ */
+int nrf91_poll_set_init(struct nrf91_poll_set *set);
+
+/**
+ * @brief Add a socket to a poll set, change or remove it.
+ *
+ * @param set    Poll set.
+ * @param op     Operation.
+ * @param fd     Socket.
+ * @param events Events to wait for, POLLIN and POLLOUT. Ignored when the
+ *               socket is removed.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -1 If the operation failed. errno is set to EEXIST if the socket
+ *         is added twice, ENOENT if it is not in the set, ENOMEM if the set
+ *         is full, EBADF or ENOTSUP if @p fd is not an nRF91 socket, or
+ *         EINVAL if the parameters are invalid.
+ */
+int nrf91_poll_set_ctl(struct nrf91_poll_set *set, enum nrf91_poll_set_op op,
+		       int fd, short events);
+
+/**
+ * @brief Wait for the sockets in a poll set.
+ *
+ * The set can be changed while a thread is waiting for it. The change
+ * takes effect in the next call.
+ *
+ * @param set       Poll set.
+ * @param ready     Array filled with the sockets that are ready, with
+ *                  their events and returned events, like in poll().
+ * @param max_ready Number of entries in @p ready. If more sockets are
+ *                  ready, they are returned in the next call.
+ * @param timeout   Timeout in milliseconds, or -1 to wait forever.
+ *
+ * @return Number of sockets in @p ready, 0 on timeout, or -1 with errno
+ *         set on error.
+ */
+int nrf91_poll_set_wait(struct nrf91_poll_set *set, struct zsock_pollfd *ready,
+			int max_ready, int timeout);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRF91_POLL_SET_H__ */
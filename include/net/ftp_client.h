@@ -219,6 +219,34 @@ enum ftp_trasfer_type {
  */
 typedef void (*ftp_client_callback_t)(const uint8_t *msg, uint16_t len);
 
+/**
+ * @brief FTP data producer for streaming uploads.
+ *
+ * @param offset Offset in the file of the data to be produced
+ * @param buf Buffer for the data
+ * @param size Size of the buffer
+ * @param user_data User data passed to @ref ftp_put_stream
+ *
+ * @retval Length of the data produced, 0 at end of file.
+ *         Otherwise, a negative value aborts the transfer.
+ */
+typedef int (*ftp_client_producer_t)(size_t offset, uint8_t *buf,
+				     size_t size, void *user_data);
+
+/**
+ * @brief FTP data consumer for streaming downloads.
+ *
+ * @param offset Offset in the file of the data received
+ * @param data Data received
+ * @param len Length of the data
+ * @param user_data User data passed to @ref ftp_get_stream
+ *
+ * @retval 0 to continue the transfer.
+ *         Otherwise, a negative value aborts the transfer.
+ */
+typedef int (*ftp_client_consumer_t)(size_t offset, const uint8_t *data,
+				     size_t len, void *user_data);
+
 /**@brief Initialize the FTP client library.
  *
  * @param ctrl_callback Callback for FTP command result.
@@ -333,6 +361,15 @@ int ftp_rename(const char *old_name, const char *new_name);
  */
 int ftp_delete(const char *file);
 
+/**@brief Get the size of a file
+ *
+ * @param file Target file name
+ * @param size Size of the file, set if the server replies with 213
+ *
+ * @retval ftp_return_code or negative if error
+ */
+int ftp_size(const char *file, size_t *size);
+
 /**@brief Get a file
  *
  * @param file Target file name
@@ -341,6 +378,25 @@ int ftp_delete(const char *file);
  */
 int ftp_get(const char *file);
 
+/**@brief Get a file in chunks
+ * The data is passed to the consumer in chunks of up to
+ * CONFIG_FTP_CLIENT_DATA_BUF_SIZE bytes.
+ *
+ * Other commands can be issued from other threads while the file is being
+ * received. Their replies are received after the transfer completes.
+ *
+ * @param file Target file name
+ * @param offset Offset to start from, using REST if not zero. Advanced by
+ *               the data received, so that a failed transfer can be resumed
+ *               by calling again after reconnecting.
+ * @param consumer Consumer of the data
+ * @param user_data User data passed to the consumer
+ *
+ * @retval ftp_return_code or negative if error
+ */
+int ftp_get_stream(const char *file, size_t *offset,
+		   ftp_client_consumer_t consumer, void *user_data);
+
 /**@brief Put data to a file
  * If file does not exist, create the file
  *
@@ -350,7 +406,22 @@ int ftp_get(const char *file);
  *
  * @retval ftp_return_code or negative if error
  */
-int ftp_put(const char *file, const uint8_t *data, uint16_t length);
+int ftp_put(const char *file, const uint8_t *data, size_t length);
+
+/**@brief Put data to a file in chunks
+ * If file does not exist, create the file
+ *
+ * @param file Target file name
+ * @param offset Offset to start from, using REST if not zero. Advanced by
+ *               the data sent. After a failed transfer, get the size stored
+ *               by the server with @ref ftp_size to resume.
+ * @param producer Producer of the data
+ * @param user_data User data passed to the producer
+ *
+ * @retval ftp_return_code or negative if error
+ */
+int ftp_put_stream(const char *file, size_t *offset,
+		   ftp_client_producer_t producer, void *user_data);
 
 
 #ifdef __cplusplus
@@ -100,18 +100,81 @@ struct ical_parser_evt {
 typedef int (*icalendar_parser_callback_t)(
 	const struct ical_parser_evt *event);
 
+/**
+ * @brief Slice of an iCalendar property.
+ *
+ * A property value is passed on without copying, in one or more slices of
+ * the parsed data. Folded lines and the boundaries of the data passed to
+ * @ref ical_parser_parse split the value into slices.
+ */
+struct ical_property {
+	/** Property name, null-terminated. */
+	const char *name;
+	/** Property parameters as in the content line, null-terminated. */
+	const char *params;
+	/** Slice of the property value, not null-terminated. */
+	const char *value;
+	/** Length of the slice. */
+	size_t len;
+	/** Offset of the slice in the property value. */
+	size_t offset;
+	/** Last slice of the property value, possibly empty. */
+	bool last;
+};
+
+/**
+ * @brief iCalendar property handler.
+ *
+ * Through this callback, the application receives every property in the
+ * data stream, slice by slice.
+ *
+ * @param[in] prop  Slice of the property.
+ *
+ * @return Zero to continue the parsing, non-zero otherwise.
+ */
+typedef int (*icalendar_property_callback_t)(
+	const struct ical_property *prop);
+
 /**
  * @brief iCalendar parser instance.
  */
 struct icalendar_parser {
-	/** Internal Buffer for parsing incoming data stream */
-	char buf[CONFIG_ICAL_PARSER_BUFFER_SIZE + 1];
-	/** Offset of unparsed data in buf. */
-	size_t offset;
+	/** Content line parser state. */
+	uint8_t state;
+	/** A line break was received, the line may be folded. */
+	bool eol;
+	/** Inside a quoted parameter value. */
+	bool quoted;
+	/** Name of the current property. */
+	char name[CONFIG_ICAL_PARSER_NAME_SIZE + 1];
+	/** Length of the name. */
+	size_t name_len;
+	/** Parameters of the current property. */
+	char params[CONFIG_ICAL_PARSER_PARAMS_SIZE + 1];
+	/** Length of the parameters. */
+	size_t params_len;
+	/** Length of the value parsed so far. */
+	size_t value_len;
+	/** Component field the value is stored in, if any. */
+	const void *field;
+	/** Value of a BEGIN or END property. */
+	char token[16];
 	/** begin of iCalendar object delimiter pair */
 	bool icalobject_begin;
+	/** Nesting depth of components in the iCalendar object. */
+	uint8_t depth;
+	/** A supported component is being parsed. */
+	bool in_component;
+	/** Component being parsed. */
+	struct ical_parser_evt evt;
 	/** Event handler. */
 	icalendar_parser_callback_t callback;
+	/** Property handler. */
+	icalendar_property_callback_t prop_callback;
+	/** A callback stopped the parsing in the last call of
+	 *  @ref ical_parser_parse.
+	 */
+	bool stopped;
 };
 
 /**
@@ -125,14 +188,32 @@ struct icalendar_parser {
 int ical_parser_init(struct icalendar_parser *ical,
 		     icalendar_parser_callback_t callback);
 
+/**
+ * @brief Set a callback for every parsed property.
+ *
+ * @param[in,out] ical iCalendar parser instance.
+ * @param[in] callback Callback for sending properties, or NULL.
+ *
+ * @return 0 If successful, or an error code on failure.
+ */
+int ical_parser_property_callback_set(struct icalendar_parser *ical,
+				      icalendar_property_callback_t callback);
+
 /**
  * @brief Parse the iCalendar data stream. Return the parsed bytes.
  *
+ * The data can be split at any point, for example as received. Nothing is
+ * buffered, so all of it is parsed unless a callback stops the parsing.
+ * The last property of the stream is reported when the next line begins,
+ * as the line could be folded, except for BEGIN and END properties.
+ *
  * @param[in,out] ical iCalendar parser instance.
  * @param[in] data Input data to be parsed.
  * @param[in] len  Length of input data stream.
  *
- * @retval size_t  Parsed bytes.
+ * @retval size_t  Parsed bytes. Less than @p len if a callback stopped the
+ *                 parsing, except when it stopped at the end of @p data.
+ *                 The stopped member of @p ical tells in both cases.
  */
 size_t ical_parser_parse(struct icalendar_parser *ical,
 			const char *data, size_t len);
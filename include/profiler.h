@@ -196,6 +196,38 @@ static inline void profiler_log_send(struct log_event_buf *buf,
 #endif
 
 
+#ifdef CONFIG_PROFILER_NORDIC_BACKEND_MEMORY
+/** @brief Read trace data sent by the memory backend.
+ *
+ * @param buf Buffer for the data.
+ * @param size Size of the buffer.
+ *
+ * @return Number of bytes read.
+ */
+size_t profiler_nordic_mem_data_read(uint8_t *buf, size_t size);
+
+
+/** @brief Read event descriptions sent by the memory backend.
+ *
+ * @param buf Buffer for the data.
+ * @param size Size of the buffer.
+ *
+ * @return Number of bytes read.
+ */
+size_t profiler_nordic_mem_info_read(uint8_t *buf, size_t size);
+
+
+/** @brief Pass a host command to the memory backend.
+ *
+ * @param command Command, as sent by the host tools.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -ENOBUFS If the command buffer is full.
+ */
+int profiler_nordic_mem_command_write(uint8_t command);
+#endif
+
+
 /**
  * @}
  */
@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <init.h>
+#include <modem/nrf91_poll_set.h>
 #include <net/socket_offload.h>
 #include <nrf_socket.h>
 #include <nrf_errno.h>
@@ -501,6 +502,40 @@ static int nrf_to_z_addrinfo(struct zsock_addrinfo *z_out,
 	return 0;
 }
 
+/* Objects of the stream sockets. The type is tracked, because the modem
+ * does not report it.
+ */
+static atomic_t stream_objs[BSD_MAX_SOCKET_COUNT];
+
+static void stream_obj_add(void *obj)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(stream_objs); i++) {
+		if (atomic_cas(&stream_objs[i], 0, (atomic_val_t)obj)) {
+			return;
+		}
+	}
+}
+
+static void stream_obj_remove(void *obj)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(stream_objs); i++) {
+		if (atomic_cas(&stream_objs[i], (atomic_val_t)obj, 0)) {
+			return;
+		}
+	}
+}
+
+static bool stream_obj_is(void *obj)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(stream_objs); i++) {
+		if (atomic_get(&stream_objs[i]) == (atomic_val_t)obj) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static int nrf91_socket_offload_socket(int family, int type, int proto)
 {
 	int retval;
@@ -575,6 +610,9 @@ static int nrf91_socket_offload_accept(void *obj, struct sockaddr *addr,
 		}
 	}
 
+	/* Only stream sockets accept connections. */
+	stream_obj_add(SD_TO_OBJ(new_sd));
+
 	z_finalize_fd(fd, SD_TO_OBJ(new_sd),
 		      (const struct fd_op_vtable *)&nrf91_socket_fd_op_vtable);
 
@@ -821,88 +859,214 @@ error:
 	return retval;
 }
 
+/* Buffers used by `sendmsg` to gather messages from their parts. */
+K_MEM_SLAB_DEFINE(nrf91_sendmsg_slab,
+		  ROUND_UP(CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE, sizeof(void *)),
+		  CONFIG_BSD_LIBRARY_SENDMSG_BUF_COUNT, sizeof(void *));
+
+static void *sendmsg_buf_alloc(size_t len, bool nonblock)
+{
+	void *buf;
+
+	if ((len <= CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE) &&
+	    (k_mem_slab_alloc(&nrf91_sendmsg_slab, &buf, K_NO_WAIT) == 0)) {
+		return buf;
+	}
+
+	/* The message is too large for the pool or the pool is empty. */
+	buf = k_malloc(len);
+	if ((buf != NULL) || (len > CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE) ||
+	    nonblock) {
+		return buf;
+	}
+
+	if (k_mem_slab_alloc(&nrf91_sendmsg_slab, &buf, K_FOREVER) != 0) {
+		return NULL;
+	}
+
+	return buf;
+}
+
+static void sendmsg_buf_free(void *buf)
+{
+	char *pool_begin = nrf91_sendmsg_slab.buffer;
+	char *pool_end = pool_begin + nrf91_sendmsg_slab.num_blocks *
+					  nrf91_sendmsg_slab.block_size;
+
+	if (((char *)buf >= pool_begin) && ((char *)buf < pool_end)) {
+		k_mem_slab_free(&nrf91_sendmsg_slab, &buf);
+	} else {
+		k_free(buf);
+	}
+}
+
+static bool sendmsg_nonblock(void *obj, int flags)
+{
+	int sock_flags;
+
+	if (flags & MSG_DONTWAIT) {
+		return true;
+	}
+
+	sock_flags = nrf_fcntl(OBJ_TO_SD(obj), NRF_F_GETFL, 0);
+
+	return (sock_flags > 0) && (sock_flags & NRF_O_NONBLOCK);
+}
+
+static ssize_t sendmsg_buf_send(void *obj, const uint8_t *buf, size_t len,
+				int flags, bool nonblock,
+				const struct msghdr *msg)
+{
+	size_t offset = 0;
+	ssize_t ret;
+
+	/* Datagrams are sent in one call. Stream sockets may need more calls
+	 * to send the whole message, unless the caller does not want to wait.
+	 */
+	do {
+		ret = nrf91_socket_offload_sendto(obj, buf + offset,
+						  len - offset, flags,
+						  msg->msg_name,
+						  msg->msg_namelen);
+		if (ret < 0) {
+			return (offset > 0) ? offset : ret;
+		}
+
+		offset += ret;
+	} while ((offset < len) && (ret > 0) && !nonblock);
+
+	return offset;
+}
+
+/* Stream sockets keep no message boundaries, so the parts can be sent one
+ * by one when there is no buffer to gather them.
+ */
+static ssize_t sendmsg_parts_send(void *obj, const struct msghdr *msg,
+				  int flags, bool nonblock)
+{
+	size_t sent = 0;
+	ssize_t ret;
+	int i;
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		if (msg->msg_iov[i].iov_len == 0) {
+			continue;
+		}
+
+		ret = sendmsg_buf_send(obj, msg->msg_iov[i].iov_base,
+				       msg->msg_iov[i].iov_len, flags,
+				       nonblock, msg);
+		if (ret < 0) {
+			return (sent > 0) ? sent : ret;
+		}
+
+		sent += ret;
+
+		if (ret < msg->msg_iov[i].iov_len) {
+			break;
+		}
+	}
+
+	return sent;
+}
+
 static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 					    int flags)
 {
-	ssize_t len = 0;
+	const struct iovec *part = NULL;
+	size_t parts = 0;
+	size_t len = 0;
+	bool nonblock;
 	ssize_t ret;
-	ssize_t offset;
+	uint8_t *buf;
 	int i;
-	static K_MUTEX_DEFINE(sendmsg_lock);
-	static uint8_t buf[CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE];
 
 	if (msg == NULL) {
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* The standard POSIX definition of sendmsg says it should return
-	 * EWOULDBLOCK if the socket is in NONBLOCK mode and handed too much data.
-	 * This implementation doesn't meet that requirement and will always
-	 * block, even in NONBLOCK mode.  See POSIX.1-2017:
-	 * <http://pubs.opengroup.org/onlinepubs/9699919799/functions/sendmsg.html>
-	 */
-
-	/* Try to reduce number of `sendto` calls - copy data if they fit into
-	 * a single buffer
-	 */
+	nonblock = sendmsg_nonblock(obj, flags);
 
 	for (i = 0; i < msg->msg_iovlen; i++) {
+		if (msg->msg_iov[i].iov_len > 0) {
+			part = &msg->msg_iov[i];
+			parts++;
+		}
+
 		len += msg->msg_iov[i].iov_len;
 	}
 
-	if (len <= sizeof(buf)) {
-		/* Protect `buf` access with a mutex. */
-		k_mutex_lock(&sendmsg_lock, K_FOREVER);
-		len = 0;
-
-		for (i = 0; i < msg->msg_iovlen; i++) {
-			memcpy(buf + len, msg->msg_iov[i].iov_base,
-			       msg->msg_iov[i].iov_len);
-			len += msg->msg_iov[i].iov_len;
-		}
+	/* A message in a single part is sent without copying. */
+	if (parts <= 1) {
+		buf = (part != NULL) ? part->iov_base : NULL;
+		return sendmsg_buf_send(obj, buf, len, flags, nonblock, msg);
+	}
 
-		offset = 0;
-		ret = 0;
-		while ((offset < len) && (ret >= 0)) {
-			ret = nrf91_socket_offload_sendto(obj,
-				(buf + offset), (len - offset), flags,
-				msg->msg_name, msg->msg_namelen);
-			if (ret > 0) {
-				offset += ret;
-			}
+	/* Otherwise the parts are gathered in a buffer, so that the message
+	 * is sent in one call and datagram boundaries are kept. The buffers
+	 * are taken from a pool, so that sockets do not wait for each other.
+	 */
+	buf = sendmsg_buf_alloc(len, nonblock);
+	if (buf == NULL) {
+		if (stream_obj_is(obj)) {
+			return sendmsg_parts_send(obj, msg, flags, nonblock);
 		}
 
-		k_mutex_unlock(&sendmsg_lock);
-		return ret;
+		errno = nonblock ? EAGAIN : ENOMEM;
+		return -1;
 	}
 
-	/* If the data won't fit into intermediate buffer, send the buffers
-	 * separately
-	 */
-
 	len = 0;
 
 	for (i = 0; i < msg->msg_iovlen; i++) {
-		if (msg->msg_iov[i].iov_len == 0) {
-			continue;
-		}
+		memcpy(buf + len, msg->msg_iov[i].iov_base,
+		       msg->msg_iov[i].iov_len);
+		len += msg->msg_iov[i].iov_len;
+	}
 
-		offset = 0;
-		while (offset < msg->msg_iov[i].iov_len) {
-			ret = nrf91_socket_offload_sendto(obj,
-				(((uint8_t *) msg->msg_iov[i].iov_base) + offset),
-				(msg->msg_iov[i].iov_len - offset), flags,
-				msg->msg_name, msg->msg_namelen);
-			if (ret < 0) {
-				return ret;
-			}
-			offset += ret;
-			len += ret;
-		}
+	ret = sendmsg_buf_send(obj, buf, len, flags, nonblock, msg);
+
+	sendmsg_buf_free(buf);
+
+	return ret;
+}
+
+static short z_to_nrf_poll_events(short z_events)
+{
+	short nrf_events = 0;
+
+	if (z_events & POLLIN) {
+		nrf_events |= NRF_POLLIN;
+	}
+	if (z_events & POLLOUT) {
+		nrf_events |= NRF_POLLOUT;
+	}
+
+	return nrf_events;
+}
+
+static short nrf_to_z_poll_events(short nrf_events)
+{
+	short z_events = 0;
+
+	if (nrf_events & NRF_POLLIN) {
+		z_events |= POLLIN;
+	}
+	if (nrf_events & NRF_POLLOUT) {
+		z_events |= POLLOUT;
+	}
+	if (nrf_events & NRF_POLLERR) {
+		z_events |= POLLERR;
+	}
+	if (nrf_events & NRF_POLLNVAL) {
+		z_events |= POLLNVAL;
+	}
+	if (nrf_events & NRF_POLLHUP) {
+		z_events |= POLLHUP;
 	}
 
-	return len;
+	return z_events;
 }
 
 static inline int nrf91_socket_offload_poll(struct pollfd *fds, int nfds,
@@ -936,12 +1100,7 @@ static inline int nrf91_socket_offload_poll(struct pollfd *fds, int nfds,
 		}
 
 		/* Translate the API from native to nRF */
-		if (fds[i].events & POLLIN) {
-			tmp[i].events |= NRF_POLLIN;
-		}
-		if (fds[i].events & POLLOUT) {
-			tmp[i].events |= NRF_POLLOUT;
-		}
+		tmp[i].events = z_to_nrf_poll_events(fds[i].events);
 	}
 
 	if (retval > 0) {
@@ -957,24 +1116,175 @@ static inline int nrf91_socket_offload_poll(struct pollfd *fds, int nfds,
 			continue;
 		}
 
-		if (tmp[i].revents & NRF_POLLIN) {
-			fds[i].revents |= POLLIN;
+		fds[i].revents |= nrf_to_z_poll_events(tmp[i].revents);
+	}
+
+	return retval;
+}
+
+int nrf91_poll_set_init(struct nrf91_poll_set *set)
+{
+	if (set == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	set->count = 0;
+	set->next = 0;
+	k_mutex_init(&set->lock);
+
+	return 0;
+}
+
+static int poll_set_find(const struct nrf91_poll_set *set, int fd)
+{
+	for (int i = 0; i < set->count; i++) {
+		if (set->fds[i].fd == fd) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+int nrf91_poll_set_ctl(struct nrf91_poll_set *set, enum nrf91_poll_set_op op,
+		       int fd, short events)
+{
+	int err = 0;
+	void *obj;
+	int i;
+
+	if (set == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	k_mutex_lock(&set->lock, K_FOREVER);
+
+	i = poll_set_find(set, fd);
+
+	switch (op) {
+	case NRF91_POLL_SET_ADD:
+		if (i >= 0) {
+			err = EEXIST;
+			break;
+		}
+
+		if (set->count >= ARRAY_SIZE(set->fds)) {
+			err = ENOMEM;
+			break;
 		}
-		if (tmp[i].revents & NRF_POLLOUT) {
-			fds[i].revents |= POLLOUT;
+
+		/* The socket is looked up only once, when it is added. */
+		obj = z_get_fd_obj(fd, (const struct fd_op_vtable *)
+					       &nrf91_socket_fd_op_vtable,
+				   ENOTSUP);
+		if (obj == NULL) {
+			err = errno;
+			break;
 		}
-		if (tmp[i].revents & NRF_POLLERR) {
-			fds[i].revents |= POLLERR;
+
+		i = set->count++;
+		set->fds[i].fd = fd;
+		set->fds[i].revents = 0;
+		set->nrf_fds[i].fd = OBJ_TO_SD(obj);
+		set->nrf_fds[i].revents = 0;
+		break;
+
+	case NRF91_POLL_SET_MOD:
+		if (i < 0) {
+			err = ENOENT;
 		}
-		if (tmp[i].revents & NRF_POLLNVAL) {
-			fds[i].revents |= POLLNVAL;
+		break;
+
+	case NRF91_POLL_SET_DEL:
+		if (i < 0) {
+			err = ENOENT;
+			break;
 		}
-		if (tmp[i].revents & NRF_POLLHUP) {
-			fds[i].revents |= POLLHUP;
+
+		/* The last socket takes the place of the removed one. */
+		set->count--;
+		set->fds[i] = set->fds[set->count];
+		set->nrf_fds[i] = set->nrf_fds[set->count];
+		if (set->next >= set->count) {
+			set->next = 0;
 		}
+		break;
+
+	default:
+		err = EINVAL;
+		break;
 	}
 
-	return retval;
+	if (!err && (op != NRF91_POLL_SET_DEL)) {
+		set->fds[i].events = events;
+		set->nrf_fds[i].events = z_to_nrf_poll_events(events);
+	}
+
+	k_mutex_unlock(&set->lock);
+
+	if (err) {
+		errno = err;
+		return -1;
+	}
+
+	return 0;
+}
+
+int nrf91_poll_set_wait(struct nrf91_poll_set *set, struct zsock_pollfd *ready,
+			int max_ready, int timeout)
+{
+	struct zsock_pollfd fds[BSD_MAX_SOCKET_COUNT];
+	struct nrf_pollfd nrf_fds[BSD_MAX_SOCKET_COUNT];
+	int count;
+	int start;
+	int retval;
+	int n = 0;
+	int i;
+
+	if ((set == NULL) || (ready == NULL) || (max_ready <= 0)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Wait on a copy, so that the set can be changed meanwhile. */
+	k_mutex_lock(&set->lock, K_FOREVER);
+	count = set->count;
+	start = set->next;
+	memcpy(fds, set->fds, count * sizeof(fds[0]));
+	memcpy(nrf_fds, set->nrf_fds, count * sizeof(nrf_fds[0]));
+	k_mutex_unlock(&set->lock);
+
+	retval = nrf_poll(nrf_fds, count, timeout);
+	if (retval <= 0) {
+		return retval;
+	}
+
+	/* Start after the last socket returned by the previous call, so that
+	 * the sockets that did not fit in it are returned first.
+	 */
+	i = start;
+	for (int j = 0; (j < count) && (n < max_ready); j++) {
+		i = (start + j) % count;
+
+		if (nrf_fds[i].revents == 0) {
+			continue;
+		}
+
+		ready[n].fd = fds[i].fd;
+		ready[n].events = fds[i].events;
+		ready[n].revents = nrf_to_z_poll_events(nrf_fds[i].revents);
+		n++;
+	}
+
+	if (n > 0) {
+		k_mutex_lock(&set->lock, K_FOREVER);
+		set->next = (set->count > 0) ? (i + 1) % set->count : 0;
+		k_mutex_unlock(&set->lock);
+	}
+
+	return n;
 }
 
 static void nrf91_socket_offload_freeaddrinfo(struct zsock_addrinfo *root)
@@ -1160,6 +1470,9 @@ static int nrf91_socket_offload_close(void *obj)
 {
 	int sd = OBJ_TO_SD(obj);
 
+	/* Before the modem can reuse the descriptor. */
+	stream_obj_remove(obj);
+
 	return nrf_close(sd);
 }
 
@@ -1210,6 +1523,10 @@ static int nrf91_socket_create(int family, int type, int proto)
 		return -1;
 	}
 
+	if (type == SOCK_STREAM) {
+		stream_obj_add(SD_TO_OBJ(sd));
+	}
+
 	z_finalize_fd(fd, SD_TO_OBJ(sd),
 		      (const struct fd_op_vtable *)&nrf91_socket_fd_op_vtable);
 
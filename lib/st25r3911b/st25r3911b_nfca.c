@@ -68,9 +68,6 @@ LOG_MODULE_DECLARE(st25r3911b);
 #define NFCA_SEL_RSP_TAG_PLATFORM_MASK 0x60
 #define NFCA_SEL_RSP_TAG_PLATFORM_SHIFT 5
 
-/* NFC-A CRC initial value. NFC Forum Digital 2.0 6.4.1.3. */
-#define NFCA_CRC_INITIAL_VALUE 0x6363
-
 #define RXS_TIMEOUT 200
 
 extern const k_tid_t thread;
@@ -382,27 +379,25 @@ static uint8_t bcc_calculate(uint8_t *buf, uint8_t len)
 static int read_rx_data(uint8_t *data, size_t len)
 {
 	int err;
-	uint8_t fifo_status;
+	uint8_t fifo_status[2];
 	uint32_t received;
 
-	/* Check number of bytes in FIFO */
-	err = st25r3911b_reg_read(ST25R3911B_REG_FIFO_STATUS_1, &fifo_status);
+	/* Check number of bytes in FIFO, number of incomplete bit in FIFO
+	 * and parity missing. Both status registers are read in one
+	 * transaction.
+	 */
+	err = st25r3911b_multiple_reg_read(ST25R3911B_REG_FIFO_STATUS_1,
+					   fifo_status, sizeof(fifo_status));
 	if (err) {
 		return err;
 	}
 
-	nfca.fifo.bytes_to_read = fifo_status;
+	nfca.fifo.bytes_to_read = fifo_status[0];
 	received = nfca.transfer.received_byte;
 
-	/* Check number of incomplete bit in FIFO and parity missing */
-	err = st25r3911b_reg_read(ST25R3911B_REG_FIFO_STATUS_2, &fifo_status);
-	if (err) {
-		return err;
-	}
-
-	nfca.fifo.incomplete_bits = (fifo_status & ST25R3911B_REG_FIFO_STATUS_2_FIFO_LB_MASK) >>
+	nfca.fifo.incomplete_bits = (fifo_status[1] & ST25R3911B_REG_FIFO_STATUS_2_FIFO_LB_MASK) >>
 				     ST25R3911B_REG_FIFO_STATUS_2_FIFO_LB0;
-	nfca.fifo.parity_miss    = fifo_status & ST25R3911B_REG_FIFO_STATUS_2_NP_LB;
+	nfca.fifo.parity_miss    = fifo_status[1] & ST25R3911B_REG_FIFO_STATUS_2_NP_LB;
 
 	/* Check buffer size */
 	if (len - received < nfca.fifo.bytes_to_read) {
@@ -584,13 +579,39 @@ static int on_rx_complete(void)
 	return err;
 }
 
+static int fifo_bytes_get(uint8_t *bytes)
+{
+	int err;
+
+	err = st25r3911b_reg_read(ST25R3911B_REG_FIFO_STATUS_1, bytes);
+	if (err) {
+		return err;
+	}
+
+	if (*bytes > ST25R3911B_MAX_FIFO_LEN) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
 static int tx_fifo_water(void)
 {
+	int err;
 	uint8_t *buff;
 	uint8_t bytes_to_send;
+	uint8_t fifo_bytes;
+
+	/* The FIFO keeps draining until this interrupt is handled, so fill
+	 * all free space in one SPI burst instead of only the water level.
+	 */
+	err = fifo_bytes_get(&fifo_bytes);
+	if (err) {
+		return err;
+	}
 
 	bytes_to_send = MIN(nfca.transfer.tx_buf->len - nfca.transfer.written_byte,
-			    nfca.water_lvl.tx);
+			    ST25R3911B_MAX_FIFO_LEN - fifo_bytes);
 
 	buff = nfca.transfer.tx_buf->data + nfca.transfer.written_byte;
 
@@ -601,15 +622,30 @@ static int tx_fifo_water(void)
 
 static int rx_fifo_water(void)
 {
+	int err;
 	uint8_t *buf;
-	uint32_t bytes_to_receive = nfca.water_lvl.rx;
+	uint8_t fifo_bytes;
+	uint32_t bytes_to_receive;
+
+	/* The FIFO keeps filling until this interrupt is handled, so read
+	 * all received bytes in one SPI burst instead of only the water level.
+	 */
+	err = fifo_bytes_get(&fifo_bytes);
+	if (err) {
+		return err;
+	}
+
+	bytes_to_receive = fifo_bytes;
+
+	if (nfca.transfer.rx_buf->len - nfca.transfer.received_byte <
+	    bytes_to_receive) {
+		return -ENOMEM;
+	}
 
 	buf = nfca.transfer.rx_buf->data + nfca.transfer.received_byte;
 
 	nfca.transfer.received_byte += bytes_to_receive;
 
-	__ASSERT_NO_MSG(nfca.transfer.rx_buf->len > nfca.transfer.received_byte);
-
 	return st25r3911b_fifo_read(buf, bytes_to_receive);
 }
 
@@ -1221,29 +1257,3 @@ int st25r3911b_nfca_tag_sleep(void)
 
 	return 0;
 }
-
-int st25r3911b_nfca_crc_calculate(const uint8_t *data, size_t len,
-				  struct st25r3911b_nfca_crc *crc_val)
-{
-	if ((!data) || (!crc_val) || (len <= 0)) {
-		return -EINVAL;
-	}
-
-	uint32_t crc = NFCA_CRC_INITIAL_VALUE;
-	uint8_t *crc_pos = crc_val->crc;
-
-	do {
-		uint8_t byte;
-
-		byte = *data++;
-		byte = (byte ^ (uint8_t)(crc & 0x00FF));
-		byte = (byte ^ (byte << 4));
-		crc = (crc >> 8) ^ ((uint32_t)byte << 8) ^
-		      ((uint32_t) byte << 3) ^ ((uint32_t) byte >> 4);
-
-	} while (--len);
-
-	sys_put_be16(crc, crc_pos);
-
-	return 0;
-}
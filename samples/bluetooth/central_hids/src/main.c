@@ -583,11 +583,21 @@ static void pairing_failed(struct bt_conn *conn, enum bt_security_err reason)
 	printk("Pairing failed conn: %s, reason %d\n", addr, reason);
 }
 
+#if defined(CONFIG_BT_HOGP_CACHE)
+static void bond_deleted(uint8_t id, const bt_addr_le_t *peer)
+{
+	bt_hogp_cache_bond_deleted(id, peer);
+}
+#endif
+
 static struct bt_conn_auth_cb conn_auth_callbacks = {
 	.cancel = auth_cancel,
 	.pairing_confirm = pairing_confirm,
 	.pairing_complete = pairing_complete,
-	.pairing_failed = pairing_failed
+	.pairing_failed = pairing_failed,
+#if defined(CONFIG_BT_HOGP_CACHE)
+	.bond_deleted = bond_deleted,
+#endif
 };
 
 
@@ -5,6 +5,7 @@
  */
 
 #include <zephyr/types.h>
+#include <kernel.h>
 #include <sys/printk.h>
 #include <pm_config.h>
 #include <fw_info.h>
@@ -26,8 +27,17 @@ static void validate_and_boot(const struct fw_info *fw_info, uint16_t slot)
 	printk("Attempting to boot from address 0x%x.\n\r",
 		fw_info->address);
 
-	if (!bl_validate_firmware_local(fw_info->address,
-					fw_info)) {
+#ifdef CONFIG_SB_VALIDATION_TIMING
+	uint32_t start = k_cycle_get_32();
+#endif
+	bool valid = bl_validate_firmware_local(fw_info->address, fw_info);
+
+#ifdef CONFIG_SB_VALIDATION_TIMING
+	printk("Validation took %u us.\r\n",
+		k_cyc_to_us_floor32(k_cycle_get_32() - start));
+#endif
+
+	if (!valid) {
 		printk("Failed to validate, permanently invalidating!\n\r");
 		fw_info_invalidate(fw_info);
 		return;
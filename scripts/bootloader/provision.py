@@ -12,28 +12,44 @@ import struct
 from ecdsa import VerifyingKey
 from hashlib import sha256
 
+# Number of 16-bit slots used per validation cache entry: A 16 byte truncated
+# image hash, the image version, the public key index and a 'written' token.
+VALIDATION_CACHE_ENTRY_SLOTS = 11
+
 
 def generate_provision_hex_file(s0_address, s1_address, hashes, provision_address, output, max_size,
-                                num_counter_slots_version):
+                                num_counter_slots_version, num_validation_cache_entries=0):
     # Add addresses
     provision_data = struct.pack('III', s0_address, s1_address, len(hashes))
     for mhash in hashes:
         provision_data += struct.pack('I', 0xFFFFFFFF) # Invalidation token
         provision_data += mhash
 
-    num_counters = 1 if num_counter_slots_version > 0 else 0
+    num_validation_cache_slots = num_validation_cache_entries * VALIDATION_CACHE_ENTRY_SLOTS
+    num_counters = int(num_counter_slots_version > 0) + int(num_validation_cache_slots > 0)
     provision_data += struct.pack('H', 1) # Type "counter collection"
     provision_data += struct.pack('H', num_counters)
 
-    if num_counters == 1:
+    if num_counter_slots_version > 0:
         if num_counter_slots_version % 2 == 1:
             num_counter_slots_version += 1
             print(f"Monotonic counter slots rounded up to {num_counter_slots_version}")
         provision_data += struct.pack('H', 1) # counter description
         provision_data += struct.pack('H', num_counter_slots_version)
 
-    assert (len(provision_data) + (2 * num_counter_slots_version)) <= max_size, """Provisioning data doesn't fit.
-Reduce the number of public keys or counter slots and try again."""
+    if num_validation_cache_slots > 0:
+        if num_validation_cache_slots % 2 == 1:
+            num_validation_cache_slots += 1
+        # The validation cache follows the (erased) version counter slots.
+        provision_data += struct.pack('H', 0xFFFF) * num_counter_slots_version
+        provision_data += struct.pack('H', 2) # counter description "validation cache"
+        provision_data += struct.pack('H', num_validation_cache_slots)
+        num_unwritten_slots = num_validation_cache_slots
+    else:
+        num_unwritten_slots = num_counter_slots_version
+
+    assert (len(provision_data) + (2 * num_unwritten_slots)) <= max_size, """Provisioning data doesn't fit.
+Reduce the number of public keys, counter slots or validation cache entries and try again."""
 
     ih = IntelHex()
     ih.frombytes(provision_data, offset=provision_address)
@@ -56,6 +72,8 @@ def parse_args():
                         help="Maximum total size of the provision data, including the counter slots.")
     parser.add_argument("--num-counter-slots-version", required=False, type=int, default=0,
                         help="Number of monotonic counter slots for version number.")
+    parser.add_argument("--num-validation-cache-entries", required=False, type=int, default=0,
+                        help="Number of entries in the validation cache.")
     return parser.parse_args()
 
 
@@ -86,7 +104,8 @@ def main():
                                 provision_address=provision_address,
                                 output=args.output,
                                 max_size=args.max_size,
-                                num_counter_slots_version=args.num_counter_slots_version)
+                                num_counter_slots_version=args.num_counter_slots_version,
+                                num_validation_cache_entries=args.num_validation_cache_entries)
 
 
 if __name__ == "__main__":
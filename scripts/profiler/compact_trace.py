@@ -0,0 +1,96 @@
+#
+# Copyright (c) 2020 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+
+from events import Event
+
+# Line sent before event descriptions if the trace is compacted
+FORMAT_COMPACT = '!format,compact'
+
+
+class CompactTraceDecoder():
+    """Decoder of the trace sent with CONFIG_PROFILER_NORDIC_COMPACT.
+
+    Every record starts with the event type ID. Timestamp and data fields
+    follow as zigzag varint encoded deltas to the previous timestamp and
+    to the previous value at the same data field position. Record with ID
+    DROPPED_ID holds the varint encoded number of events that the device
+    dropped.
+    """
+    DROPPED_ID = 0xFF
+    VALUE_MASK = 2**32 - 1
+
+    def __init__(self, registered_events_types):
+        self.registered_events_types = registered_events_types
+        self.dropped_events = 0
+        self.reset()
+
+    def reset(self):
+        # Device resets its encoder when logging is started
+        self.clock_ticks = None
+        self.last_timestamp = 0
+        self.last_data = []
+
+    @staticmethod
+    def _read_varint(read_byte):
+        value = 0
+        shift = 0
+        while True:
+            byte = read_byte()
+            value |= (byte & 0x7f) << shift
+            if byte & 0x80 == 0:
+                return value
+            shift += 7
+
+    @staticmethod
+    def _read_delta(read_byte):
+        value = CompactTraceDecoder._read_varint(read_byte)
+        return (value >> 1) ^ -(value & 1)
+
+    def read_record(self, read_byte):
+        """Read a single record.
+
+        read_byte returns the next byte of the trace. Returns the event
+        with timestamp in clock ticks, or None for records reporting
+        dropped events.
+        """
+        id = read_byte()
+        if id == self.DROPPED_ID:
+            dropped = self._read_varint(read_byte)
+            self.dropped_events += dropped
+            return None
+
+        et = self.registered_events_types[id]
+
+        delta = self._read_delta(read_byte)
+        self.last_timestamp = (self.last_timestamp + delta) & self.VALUE_MASK
+        if self.clock_ticks is None:
+            self.clock_ticks = self.last_timestamp
+        else:
+            self.clock_ticks += delta
+
+        data = []
+        for i, data_type in enumerate(et.data_types):
+            if i == len(self.last_data):
+                self.last_data.append(0)
+            value = (self.last_data[i] + self._read_delta(read_byte)) \
+                    & self.VALUE_MASK
+            self.last_data[i] = value
+            if data_type[0] == 's' and value & (1 << 31):
+                value -= 1 << 32
+            data.append(value)
+
+        return Event(id, self.clock_ticks, data)
+
+    def decode(self, buf):
+        """Decode a complete trace, returns the list of events."""
+        it = iter(buf)
+        events = []
+        while True:
+            try:
+                event = self.read_record(lambda: next(it))
+            except StopIteration:
+                return events
+            if event is not None:
+                events.append(event)
@@ -10,6 +10,7 @@ import sys
 from enum import Enum
 from rtt_nordic_config import RttNordicConfig
 from events import Event, EventType, EventsData
+from compact_trace import CompactTraceDecoder, FORMAT_COMPACT
 import logging
 
 class Command(Enum):
@@ -29,6 +30,7 @@ class RttNordicProfilerHost:
         self.finish_event = finish_event
         self.queue = queue
         self.received_events = EventsData([], {})
+        self.compact_decoder = None
         self.timestamp_overflows = 0
         self.after_half = False
 
@@ -203,6 +205,13 @@ class RttNordicProfilerHost:
             return None, None
         self.desc_buf = self.desc_buf[self.desc_buf.find('\n')+1:]
 
+        # Trace format is announced before event descriptions
+        if desc == FORMAT_COMPACT:
+            self.compact_decoder = CompactTraceDecoder(
+                self.received_events.registered_events_types)
+            self.logger.info("Compact trace format")
+            return self._read_single_event_description()
+
         desc_fields = desc.split(',')
 
         name = desc_fields[0]
@@ -231,6 +240,9 @@ class RttNordicProfilerHost:
         self.logger.info("Ready to start logging events")
 
     def _read_single_event_rtt(self):
+        if self.compact_decoder is not None:
+            return self._read_single_event_compact()
+
         id = int.from_bytes(
             self._read_bytes(1),
             byteorder=self.config['byteorder'],
@@ -265,10 +277,29 @@ class RttNordicProfilerHost:
                                        signed=signum))
         return Event(id, timestamp, data)
 
+    def _read_single_event_compact(self):
+        while True:
+            dropped = self.compact_decoder.dropped_events
+            event = self.compact_decoder.read_record(
+                lambda: self._read_bytes(1)[0])
+            if event is not None:
+                break
+            self.logger.warning("Device dropped {} events".format(
+                self.compact_decoder.dropped_events - dropped))
+            if not self.reading_data and self.bcnt == 0:
+                return None
+
+        # Decoder keeps track of timestamp overflows
+        event.timestamp = self._calculate_timestamp_from_clock_ticks(
+            event.timestamp)
+        return event
+
     def _read_remaining_events(self):
         self.reading_data = False
         while self.bcnt != 0:
             event = self._read_single_event_rtt()
+            if event is None:
+                break
             self.received_events.events.append(event)
             if self.queue is not None:
                 self.queue.put(event)
@@ -294,6 +325,8 @@ class RttNordicProfilerHost:
         sys.exit()
 
     def start_logging_events(self):
+        if self.compact_decoder is not None:
+            self.compact_decoder.reset()
         self._send_command(Command.START)
 
     def stop_logging_events(self):
@@ -58,6 +58,9 @@ BUILD_ASSERT(!IS_ENABLED(CONFIG_BT_PERIPHERAL) ||
 	#define MAX_RX_PACKET_SIZE SDC_DEFAULT_RX_PACKET_SIZE
 #endif
 
+/* Largest HCI ACL data packet the controller passes to the host */
+#define ACL_RX_PACKET_MAX_SIZE (BT_HCI_ACL_HDR_SIZE + MAX_RX_PACKET_SIZE)
+
 #define MASTER_MEM_SIZE (SDC_MEM_PER_MASTER_LINK( \
 	MAX_TX_PACKET_SIZE, \
 	MAX_RX_PACKET_SIZE, \
@@ -77,6 +80,16 @@ BUILD_ASSERT(!IS_ENABLED(CONFIG_BT_PERIPHERAL) ||
 
 static uint8_t sdc_mempool[MEMPOOL_SIZE];
 
+/* Host buffer for the next ACL data packet, allocated ahead so that the
+ * controller can write the packet directly into it.
+ */
+static struct net_buf *acl_rx_buf;
+
+/* Number of connections, as seen in the events passed to the host. The
+ * buffer above is only kept while there is a connection.
+ */
+static uint8_t conn_count;
+
 #if IS_ENABLED(CONFIG_BT_CTLR_ASSERT_HANDLER)
 extern void bt_ctlr_assert_handle(char *file, uint32_t line);
 
@@ -169,18 +182,12 @@ static int hci_driver_send(struct net_buf *buf)
 	return err;
 }
 
-static void data_packet_process(uint8_t *hci_buf)
+static void data_packet_process(struct net_buf *data_buf, uint8_t *hci_buf)
 {
-	struct net_buf *data_buf = bt_buf_get_rx(BT_BUF_ACL_IN, K_FOREVER);
 	struct bt_hci_acl_hdr *hdr = (void *)hci_buf;
 	uint16_t hf, handle, len;
 	uint8_t flags, pb, bc;
 
-	if (!data_buf) {
-		BT_ERR("No data buffer available");
-		return;
-	}
-
 	len = sys_le16_to_cpu(hdr->len);
 	hf = sys_le16_to_cpu(hdr->handle);
 	handle = bt_acl_handle(hf);
@@ -191,7 +198,13 @@ static void data_packet_process(uint8_t *hci_buf)
 	BT_DBG("Data: handle (0x%02x), PB(%01d), BC(%01d), len(%u)", handle,
 	       pb, bc, len);
 
-	net_buf_add_mem(data_buf, &hci_buf[0], len + sizeof(*hdr));
+	if (hci_buf == net_buf_tail(data_buf)) {
+		/* Written in place by the controller. */
+		net_buf_add(data_buf, len + sizeof(*hdr));
+	} else {
+		net_buf_add_mem(data_buf, &hci_buf[0], len + sizeof(*hdr));
+	}
+
 	bt_recv(data_buf);
 }
 
@@ -227,7 +240,46 @@ static bool event_packet_is_discardable(const uint8_t *hci_buf)
 	}
 }
 
-static void event_packet_process(uint8_t *hci_buf)
+static void conn_count_update(const uint8_t *hci_buf)
+{
+	struct bt_hci_evt_hdr *hdr = (void *)hci_buf;
+
+	switch (hdr->evt) {
+	case BT_HCI_EVT_LE_META_EVENT: {
+		struct bt_hci_evt_le_meta_event *me = (void *)&hci_buf[2];
+		/* Status is the first parameter of both events. */
+		uint8_t status = hci_buf[3];
+
+		if ((me->subevent == BT_HCI_EVT_LE_CONN_COMPLETE ||
+		     me->subevent == BT_HCI_EVT_LE_ENH_CONN_COMPLETE) &&
+		    !status) {
+			conn_count++;
+		}
+		break;
+	}
+	case BT_HCI_EVT_DISCONN_COMPLETE: {
+		struct bt_hci_evt_disconn_complete *dc = (void *)&hci_buf[2];
+
+		if (!dc->status && conn_count) {
+			conn_count--;
+		}
+		break;
+	}
+	case BT_HCI_EVT_CMD_COMPLETE: {
+		struct bt_hci_evt_cmd_complete *cc = (void *)&hci_buf[2];
+
+		/* Connections are terminated without an event on reset. */
+		if (sys_le16_to_cpu(cc->opcode) == BT_HCI_OP_RESET) {
+			conn_count = 0;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void event_packet_process(uint8_t *hci_buf, bool backlog)
 {
 	bool discardable = event_packet_is_discardable(hci_buf);
 	struct bt_hci_evt_hdr *hdr = (void *)hci_buf;
@@ -256,6 +308,18 @@ static void event_packet_process(uint8_t *hci_buf)
 		BT_DBG("Event (0x%02x) len %u", hdr->evt, hdr->len);
 	}
 
+	if (IS_ENABLED(CONFIG_BT_CONN)) {
+		conn_count_update(hci_buf);
+	}
+
+	if (discardable && backlog) {
+		/* The host is behind the controller, the event is outdated
+		 * by the time it would be processed.
+		 */
+		BT_DBG("Discarding stale event");
+		return;
+	}
+
 	evt_buf = bt_buf_get_evt(hdr->evt, discardable,
 				 discardable ? K_NO_WAIT : K_FOREVER);
 
@@ -273,7 +337,7 @@ static void event_packet_process(uint8_t *hci_buf)
 	bt_recv(evt_buf);
 }
 
-static bool fetch_and_process_hci_evt(uint8_t *p_hci_buffer)
+static bool fetch_and_process_hci_evt(uint8_t *p_hci_buffer, bool backlog)
 {
 	int errcode;
 
@@ -287,25 +351,56 @@ static bool fetch_and_process_hci_evt(uint8_t *p_hci_buffer)
 		return false;
 	}
 
-	event_packet_process(p_hci_buffer);
+	event_packet_process(p_hci_buffer, backlog);
 	return true;
 }
 
 static bool fetch_and_process_acl_data(uint8_t *p_hci_buffer)
 {
+	struct net_buf *data_buf = acl_rx_buf;
+	uint8_t *dst = p_hci_buffer;
 	int errcode;
 
+	if (!conn_count) {
+		/* Not held for the host until the next connection. Packets
+		 * left over from the last one are copied.
+		 */
+		if (data_buf) {
+			net_buf_unref(data_buf);
+			data_buf = NULL;
+		}
+	} else if (!data_buf) {
+		/* Not waiting here, events are retrieved in between. */
+		data_buf = bt_buf_get_rx(BT_BUF_ACL_IN, K_NO_WAIT);
+	}
+
+	if (data_buf && net_buf_tailroom(data_buf) >= ACL_RX_PACKET_MAX_SIZE) {
+		dst = net_buf_tail(data_buf);
+	}
+
 	errcode = MULTITHREADING_LOCK_ACQUIRE();
 	if (!errcode) {
-		errcode = sdc_hci_data_get(p_hci_buffer);
+		errcode = sdc_hci_data_get(dst);
 		MULTITHREADING_LOCK_RELEASE();
 	}
 
 	if (errcode) {
+		/* Kept for the next data packet. */
+		acl_rx_buf = data_buf;
 		return false;
 	}
 
-	data_packet_process(p_hci_buffer);
+	acl_rx_buf = NULL;
+
+	if (!data_buf) {
+		data_buf = bt_buf_get_rx(BT_BUF_ACL_IN, K_FOREVER);
+		if (!data_buf) {
+			BT_ERR("No data buffer available");
+			return true;
+		}
+	}
+
+	data_packet_process(data_buf, dst);
 	return true;
 }
 
@@ -317,21 +412,34 @@ static void recv_thread(void *p1, void *p2, void *p3)
 
 	static uint8_t hci_buffer[CONFIG_BT_RX_BUF_LEN];
 
-	bool received_evt = false;
-	bool received_data = false;
+	bool received = false;
+	bool backlog = false;
 
 	while (true) {
-		if (!received_evt && !received_data) {
+		if (!received) {
 			/* Wait for a signal from the controller. */
 			k_sem_take(&sem_recv, K_FOREVER);
 		}
 
-		received_evt = fetch_and_process_hci_evt(&hci_buffer[0]);
+		for (int i = 0; i < CONFIG_SDC_RX_BATCH_SIZE; i++) {
+			received = fetch_and_process_hci_evt(&hci_buffer[0],
+							     backlog);
+
+			if (IS_ENABLED(CONFIG_BT_CONN) &&
+			    fetch_and_process_acl_data(&hci_buffer[0])) {
+				received = true;
+			}
 
-		if (IS_ENABLED(CONFIG_BT_CONN)) {
-			received_data = fetch_and_process_acl_data(&hci_buffer[0]);
+			if (!received) {
+				break;
+			}
 		}
 
+		/* Packets still pending after a full batch mean that the host
+		 * falls behind the controller.
+		 */
+		backlog = received;
+
 		/* Let other threads of same priority run in between. */
 		k_yield();
 	}
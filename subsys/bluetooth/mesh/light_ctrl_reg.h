@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/**
+ * @file
+ * @brief Light LC illuminance regulator engine
+ *
+ * Floating point and fixed point implementations of the Light LC Server's PI
+ * regulator. Each regulator step is split in two parts: Calculating the
+ * regulator input from the target and ambient illuminance, and integrating
+ * the input with the direction dependent coefficients.
+ *
+ * The fixed point implementation represents illuminance in centi-lux, and
+ * coefficients and the internal sum in Q16.16 format. Both implementations
+ * produce outputs in the full 0 to UINT16_MAX range.
+ */
+
+#ifndef LIGHT_CTRL_REG_H__
+#define LIGHT_CTRL_REG_H__
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+#include <sys/util.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIGHT_CTRL_REG_Q16_SHIFT 16
+#define LIGHT_CTRL_REG_Q16_ONE (1L << LIGHT_CTRL_REG_Q16_SHIFT)
+/** Largest representable internal sum in Q16.16 format. */
+#define LIGHT_CTRL_REG_Q16_SUM_MAX                                             \
+	((int64_t)UINT16_MAX << LIGHT_CTRL_REG_Q16_SHIFT)
+
+/** Get the regulator input from the target and ambient illuminance.
+ *
+ *  @param[in] target   Target illuminance (in lux).
+ *  @param[in] ambient  Ambient illuminance (in lux).
+ *  @param[in] accuracy Regulator accuracy (in percent).
+ *
+ *  @return The error outside of the accuracy dead zone, or 0 if the ambient
+ *          illuminance is within the dead zone.
+ */
+static inline float light_ctrl_reg_input(float target, float ambient,
+					 uint8_t accuracy)
+{
+	float error = target - ambient;
+
+	/* Accuracy should be in percent and both up and down: */
+	float acc = (accuracy * target) / (2 * 100.0f);
+
+	if (error > acc) {
+		return error - acc;
+	}
+
+	if (error < -acc) {
+		return error + acc;
+	}
+
+	return 0.0f;
+}
+
+/** Integrate the regulator input, and get the next output level.
+ *
+ *  @param[in,out] i     Internal integral sum.
+ *  @param[in]     input Regulator input, as returned by
+ *                       @ref light_ctrl_reg_input.
+ *  @param[in]     kp    Proportional coefficient for the input direction.
+ *  @param[in]     ki    Integral coefficient for the input direction.
+ *  @param[in]     dt    Time since the previous step (in milliseconds).
+ *
+ *  @return Linear output level.
+ */
+static inline uint16_t light_ctrl_reg_output(float *i, float input, float kp,
+					     float ki, uint32_t dt)
+{
+	*i += (input * ki) * ((float)dt / (float)MSEC_PER_SEC);
+	*i = MIN(UINT16_MAX, MAX(0, *i));
+
+	float p = input * kp;
+
+	return MIN(UINT16_MAX, MAX(0, (*i + p)));
+}
+
+/** Convert a floating point regulator coefficient to Q16.16 format.
+ *
+ *  @param[in] coeff Floating point coefficient.
+ *
+ *  @return The coefficient in Q16.16 format, clamped to the non-negative
+ *          range.
+ */
+static inline int32_t light_ctrl_reg_coeff_q16(float coeff)
+{
+	if (!(coeff > 0.0f)) {
+		return 0;
+	}
+
+	if (coeff >= (float)(INT32_MAX >> LIGHT_CTRL_REG_Q16_SHIFT)) {
+		return INT32_MAX;
+	}
+
+	return (int32_t)(coeff * LIGHT_CTRL_REG_Q16_ONE + 0.5f);
+}
+
+/** Get the fixed point regulator input.
+ *
+ *  @param[in] target   Target illuminance (in centi-lux).
+ *  @param[in] ambient  Ambient illuminance (in centi-lux).
+ *  @param[in] accuracy Regulator accuracy (in percent).
+ *
+ *  @return The error outside of the accuracy dead zone (in centi-lux), or 0
+ *          if the ambient illuminance is within the dead zone.
+ */
+static inline int32_t light_ctrl_reg_input_q16(int32_t target,
+					       int32_t ambient,
+					       uint8_t accuracy)
+{
+	int32_t error = target - ambient;
+	int32_t acc = ((int64_t)accuracy * target) / (2 * 100);
+
+	if (error > acc) {
+		return error - acc;
+	}
+
+	if (error < -acc) {
+		return error + acc;
+	}
+
+	return 0;
+}
+
+/** Integrate the fixed point regulator input, and get the next output level.
+ *
+ *  @param[in,out] i     Internal integral sum in Q16.16 format.
+ *  @param[in]     input Regulator input, as returned by
+ *                       @ref light_ctrl_reg_input_q16.
+ *  @param[in]     kp    Proportional coefficient for the input direction, in
+ *                       Q16.16 format.
+ *  @param[in]     ki    Integral coefficient for the input direction, in
+ *                       Q16.16 format.
+ *  @param[in]     dt    Time since the previous step (in milliseconds).
+ *
+ *  @return Linear output level.
+ */
+static inline uint16_t light_ctrl_reg_output_q16(uint32_t *i, int32_t input,
+						 int32_t kp, int32_t ki,
+						 uint32_t dt)
+{
+	/* The input is in centi-lux, scale down by 100 before multiplying with
+	 * the time delta to stay within 64 bits:
+	 */
+	int64_t sum = *i + (((int64_t)input * ki) / 100) * dt / MSEC_PER_SEC;
+
+	sum = MIN(LIGHT_CTRL_REG_Q16_SUM_MAX, MAX(0, sum));
+	*i = sum;
+
+	int64_t out = sum + ((int64_t)input * kp) / 100;
+
+	out = MIN(LIGHT_CTRL_REG_Q16_SUM_MAX, MAX(0, out));
+
+	return out >> LIGHT_CTRL_REG_Q16_SHIFT;
+}
+
+/** Get the next adaptive step interval.
+ *
+ *  Backs off exponentially while the regulator is idle, and returns to the
+ *  minimum interval as soon as it needs to make corrections.
+ *
+ *  @param[in] interval Current interval (in milliseconds).
+ *  @param[in] idle     Whether the previous step made no corrections.
+ *  @param[in] min      Minimum interval (in milliseconds).
+ *  @param[in] max      Maximum interval (in milliseconds).
+ *
+ *  @return The next step interval (in milliseconds).
+ */
+static inline uint32_t light_ctrl_reg_interval_next(uint32_t interval,
+						    bool idle, uint32_t min,
+						    uint32_t max)
+{
+	if (!idle) {
+		return min;
+	}
+
+	return MIN(max, MAX(min, interval * 2));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIGHT_CTRL_REG_H__ */
@@ -10,6 +10,7 @@
 #include <bluetooth/mesh/properties.h>
 #include "lightness_internal.h"
 #include "light_ctrl_internal.h"
+#include "light_ctrl_reg.h"
 #include "sensor.h"
 #include "model_utils.h"
 
@@ -18,6 +19,9 @@
 #include "common/log.h"
 
 #define REG_INT CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_INTERVAL
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_ADAPTIVE
+#define REG_INT_MAX CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_INTERVAL_MAX
+#endif
 
 #define FLAGS_CONFIGURATION (BIT(FLAG_OCC_MODE))
 
@@ -54,9 +58,34 @@ static void restart_timer(struct bt_mesh_light_ctrl_srv *srv, uint32_t delay)
 	k_delayed_work_submit(&srv->timer, K_MSEC(delay));
 }
 
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
+static uint32_t reg_interval(struct bt_mesh_light_ctrl_srv *srv)
+{
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_ADAPTIVE
+	return srv->reg.interval;
+#else
+	return REG_INT;
+#endif
+}
+
+static void reg_coeff_update(struct bt_mesh_light_ctrl_srv *srv)
+{
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_FIXED
+	srv->reg.q16.kiu = light_ctrl_reg_coeff_q16(srv->reg.cfg.kiu);
+	srv->reg.q16.kid = light_ctrl_reg_coeff_q16(srv->reg.cfg.kid);
+	srv->reg.q16.kpu = light_ctrl_reg_coeff_q16(srv->reg.cfg.kpu);
+	srv->reg.q16.kpd = light_ctrl_reg_coeff_q16(srv->reg.cfg.kpd);
+#endif
+}
+#endif
+
 static void reg_start(struct bt_mesh_light_ctrl_srv *srv)
 {
 #if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
+	reg_coeff_update(srv);
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_ADAPTIVE
+	srv->reg.interval = REG_INT;
+#endif
 	k_delayed_work_submit(&srv->reg.timer, K_MSEC(REG_INT));
 #endif
 }
@@ -94,6 +123,22 @@ static bool is_enabled(const struct bt_mesh_light_ctrl_srv *srv)
 			       LIGHTNESS_SRV_FLAG_CONTROLLED);
 }
 
+/* Bring an idle adaptive regulator back to its minimum interval when its
+ * inputs change. The next step is a full minimum interval away, so that the
+ * interval the step integrates over matches the time that actually passed.
+ */
+static void reg_wake(struct bt_mesh_light_ctrl_srv *srv)
+{
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_ADAPTIVE
+	if (!is_enabled(srv) || srv->reg.interval == REG_INT) {
+		return;
+	}
+
+	srv->reg.interval = REG_INT;
+	k_delayed_work_submit(&srv->reg.timer, K_MSEC(REG_INT));
+#endif
+}
+
 static int delayed_change(struct bt_mesh_light_ctrl_srv *srv, bool value,
 			  uint32_t delay)
 {
@@ -291,10 +336,12 @@ static uint16_t light_get(struct bt_mesh_light_ctrl_srv *srv)
 
 #if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
 
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_FLOAT
 static float sensor_to_float(struct sensor_value *val)
 {
 	return val->val1 + val->val2 / 1000000.0f;
 }
+#endif
 
 static void lux_get(struct bt_mesh_light_ctrl_srv *srv,
 		    struct sensor_value *lux)
@@ -318,6 +365,26 @@ static void lux_get(struct bt_mesh_light_ctrl_srv *srv,
 	from_centi_lux(centi_lux, lux);
 }
 
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_FIXED
+static int32_t centi_lux_get(struct bt_mesh_light_ctrl_srv *srv)
+{
+	if (!is_enabled(srv)) {
+		return 0;
+	}
+
+	int32_t cfg = to_centi_lux(&srv->reg.cfg.lux[srv->state]);
+
+	if (!atomic_test_bit(&srv->flags, FLAG_TRANSITION) ||
+	    !srv->fade.duration) {
+		return cfg;
+	}
+
+	uint32_t delta = curr_fade_time(srv);
+	int32_t init = to_centi_lux(&srv->fade.initial_lux);
+
+	return init + ((int64_t)(cfg - init) * delta) / srv->fade.duration;
+}
+#else
 static float lux_getf(struct bt_mesh_light_ctrl_srv *srv)
 {
 	if (!is_enabled(srv)) {
@@ -335,6 +402,7 @@ static float lux_getf(struct bt_mesh_light_ctrl_srv *srv)
 
 	return to_centi_lux(&srv->reg.cfg.lux[srv->state]) / 100.0f;
 }
+#endif
 
 #else
 
@@ -358,6 +426,7 @@ static void transition_start(struct bt_mesh_light_ctrl_srv *srv,
 	atomic_set_bit(&srv->flags, FLAG_TRANSITION);
 	light_set(srv, srv->cfg.light[state], fade_time);
 	restart_timer(srv, fade_time);
+	reg_wake(srv);
 }
 
 static int turn_on(struct bt_mesh_light_ctrl_srv *srv,
@@ -482,35 +551,36 @@ static void ctrl_disable(struct bt_mesh_light_ctrl_srv *srv)
 }
 
 #if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG
-static void reg_step(struct k_work *work)
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_FIXED
+static uint16_t reg_output(struct bt_mesh_light_ctrl_srv *srv, uint32_t dt,
+			   bool *idle)
 {
-	struct bt_mesh_light_ctrl_srv *srv = CONTAINER_OF(
-		work, struct bt_mesh_light_ctrl_srv, reg.timer.work);
-
-	if (!is_enabled(srv)) {
-		/* The server might be disabled asynchronously. */
-		return;
-	}
-
-	k_delayed_work_submit(&srv->reg.timer, K_MSEC(REG_INT));
-
-	float target = lux_getf(srv);
-	float ambient = sensor_to_float(&srv->ambient_lux);
-	float error = target - ambient;
-
-	/* Accuracy should be in percent and both up and down: */
-	float accuracy = (srv->reg.cfg.accuracy * target) / (2 * 100.0f);
+	int32_t kp, ki;
+	int32_t input = light_ctrl_reg_input_q16(
+		centi_lux_get(srv), to_centi_lux(&srv->ambient_lux),
+		srv->reg.cfg.accuracy);
 
-	float input;
-	if (error > accuracy) {
-		input = error - accuracy;
-	} else if (error < -accuracy) {
-		input = error + accuracy;
+	if (input >= 0) {
+		kp = srv->reg.q16.kpu;
+		ki = srv->reg.q16.kiu;
 	} else {
-		input = 0.0f;
+		kp = srv->reg.q16.kpd;
+		ki = srv->reg.q16.kid;
 	}
 
+	*idle = (input == 0);
+
+	return light_ctrl_reg_output_q16(&srv->reg.i, input, kp, ki, dt);
+}
+#else
+static uint16_t reg_output(struct bt_mesh_light_ctrl_srv *srv, uint32_t dt,
+			   bool *idle)
+{
 	float kp, ki;
+	float input = light_ctrl_reg_input(lux_getf(srv),
+					   sensor_to_float(&srv->ambient_lux),
+					   srv->reg.cfg.accuracy);
+
 	if (input >= 0) {
 		kp = srv->reg.cfg.kpu;
 		ki = srv->reg.cfg.kiu;
@@ -519,11 +589,31 @@ static void reg_step(struct k_work *work)
 		ki = srv->reg.cfg.kid;
 	}
 
-	srv->reg.i += (input * ki) * ((float)REG_INT / (float)MSEC_PER_SEC);
-	srv->reg.i = MIN(UINT16_MAX, MAX(0, srv->reg.i));
+	*idle = (input == 0.0f);
+
+	return light_ctrl_reg_output(&srv->reg.i, input, kp, ki, dt);
+}
+#endif
 
-	float p = input * kp;
-	uint16_t output = MIN(UINT16_MAX, MAX(0, (srv->reg.i + p)));
+static void reg_step(struct k_work *work)
+{
+	struct bt_mesh_light_ctrl_srv *srv = CONTAINER_OF(
+		work, struct bt_mesh_light_ctrl_srv, reg.timer.work);
+	uint32_t dt = reg_interval(srv);
+	bool idle;
+
+	if (!is_enabled(srv)) {
+		/* The server might be disabled asynchronously. */
+		return;
+	}
+
+	uint16_t output = reg_output(srv, dt, &idle);
+
+#if CONFIG_BT_MESH_LIGHT_CTRL_SRV_REG_ADAPTIVE
+	srv->reg.interval =
+		light_ctrl_reg_interval_next(dt, idle, REG_INT, REG_INT_MAX);
+#endif
+	k_delayed_work_submit(&srv->reg.timer, K_MSEC(reg_interval(srv)));
 
 	/* The regulator output is always in linear format. We'll convert to
 	 * the configured representation again before calling the Lightness
@@ -539,9 +629,9 @@ static void reg_step(struct k_work *work)
 
 		srv->reg.prev = output;
 		atomic_set_bit(&srv->flags, FLAG_REGULATOR);
-		light_set(srv, light_to_repr(output, LINEAR), REG_INT);
+		light_set(srv, light_to_repr(output, LINEAR), dt);
 	} else if (atomic_test_and_clear_bit(&srv->flags, FLAG_REGULATOR)) {
-		light_set(srv, light_to_repr(lvl, LINEAR), REG_INT);
+		light_set(srv, light_to_repr(lvl, LINEAR), dt);
 	}
 }
 #endif
@@ -941,6 +1031,7 @@ static void handle_sensor_status(struct bt_mesh_model *mod,
 
 		if (id == BT_MESH_PROP_ID_PRESENT_AMB_LIGHT_LEVEL) {
 			srv->ambient_lux = value;
+			reg_wake(srv);
 			continue;
 		}
 
@@ -1084,21 +1175,25 @@ static int prop_set(struct net_buf_simple *buf,
 		memcpy(&srv->reg.cfg.kid,
 		       net_buf_simple_pull_mem(buf, sizeof(float)),
 		       sizeof(float));
+		reg_coeff_update(srv);
 		return 0;
 	case BT_MESH_LIGHT_CTRL_COEFF_KIU:
 		memcpy(&srv->reg.cfg.kiu,
 		       net_buf_simple_pull_mem(buf, sizeof(float)),
 		       sizeof(float));
+		reg_coeff_update(srv);
 		return 0;
 	case BT_MESH_LIGHT_CTRL_COEFF_KPD:
 		memcpy(&srv->reg.cfg.kpd,
 		       net_buf_simple_pull_mem(buf, sizeof(float)),
 		       sizeof(float));
+		reg_coeff_update(srv);
 		return 0;
 	case BT_MESH_LIGHT_CTRL_COEFF_KPU:
 		memcpy(&srv->reg.cfg.kpu,
 		       net_buf_simple_pull_mem(buf, sizeof(float)),
 		       sizeof(float));
+		reg_coeff_update(srv);
 		return 0;
 	}
 #endif
@@ -5,6 +5,7 @@
  */
 #include <bluetooth/mesh/models.h>
 #include "model_utils.h"
+#include "pub_sched.h"
 #include "mesh/mesh.h"
 
 #define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_MESH_DEBUG_MODEL)
@@ -105,15 +106,26 @@ int32_t model_delay_decode(uint8_t encoded_delay)
 	return encoded_delay * 5;
 }
 
-int model_send(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
-	       struct net_buf_simple *buf)
+static int send(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
+		struct net_buf_simple *buf, bool defer)
 {
 	if (!ctx && !mod->pub) {
 		return -ENOTSUP;
 	}
 
 	if (ctx) {
-		return bt_mesh_model_send(mod, ctx, buf, NULL, 0);
+		int err = bt_mesh_model_send(mod, ctx, buf, NULL, 0);
+
+		if (IS_ENABLED(CONFIG_BT_MESH_PUB_SCHED) && !err) {
+			pub_sched_sent(ctx, buf->len);
+		}
+
+		return err;
+	}
+
+	if (IS_ENABLED(CONFIG_BT_MESH_PUB_SCHED)) {
+		return defer ? pub_sched_publish(mod, buf) :
+			       pub_sched_publish_now(mod, buf);
 	}
 
 	net_buf_simple_reset(mod->pub->msg);
@@ -122,6 +134,12 @@ int model_send(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 	return bt_mesh_model_publish(mod);
 }
 
+int model_send(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
+	       struct net_buf_simple *buf)
+{
+	return send(mod, ctx, buf, true);
+}
+
 int model_ackd_send(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 		    struct net_buf_simple *buf,
 		    struct bt_mesh_model_ack_ctx *ack, uint32_t rsp_op,
@@ -133,7 +151,10 @@ int model_ackd_send(struct bt_mesh_model *mod, struct bt_mesh_msg_ctx *ctx,
 		return -EALREADY;
 	}
 
-	int retval = model_send(mod, ctx, buf);
+	/* Don't defer acknowledged publications, as the response timeout
+	 * starts immediately:
+	 */
+	int retval = send(mod, ctx, buf, !ack);
 
 	if (ack) {
 		if (retval == 0) {
@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <init.h>
+#include <bluetooth/mesh.h>
+#include "pub_sched.h"
+#include "mesh/foundation.h"
+#include "mesh/access.h"
+
+#define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_MESH_DEBUG_MODEL)
+#define LOG_MODULE_NAME bt_mesh_pub_sched
+#include "common/log.h"
+
+#define SLOT_LEN CONFIG_BT_MESH_PUB_SCHED_SLOT
+#define QUEUE_SIZE CONFIG_BT_MESH_PUB_SCHED_QUEUE_SIZE
+#define MSG_SIZE CONFIG_BT_MESH_PUB_SCHED_MSG_SIZE
+
+/** Longest time between two alignments of the periodic publications (in
+ *  milliseconds).
+ */
+#define ALIGN_INTERVAL_MAX 10000
+
+/* Airtime estimation parameters, assuming the 1M PHY: */
+/** Preamble, access address, header, AdvA, CRC and AD structure header. */
+#define ADV_PDU_OVERHEAD 18
+/** Network header and 32-bit NetMIC. */
+#define NET_PDU_OVERHEAD 13
+#define TRANS_MIC_SIZE 4
+#define UNSEG_HDR_SIZE 1
+#define SEG_HDR_SIZE 4
+#define UNSEG_MAX 15
+#define SEG_MAX 12
+#define ADV_CHANNELS 3
+#define US_PER_BYTE 8
+
+/* Transmit parameter encoding, shared by the network and publish
+ * retransmit states:
+ */
+#define TRANSMIT_COUNT(transmit) ((transmit) & BIT_MASK(3))
+
+/** A deferred publication, with its own copy of the message. */
+struct entry {
+	struct bt_mesh_model *mod;
+	uint16_t len;
+	uint8_t data[MSG_SIZE];
+};
+
+static struct entry pending[QUEUE_SIZE];
+static struct bt_mesh_pub_sched_stats stats;
+static struct k_spinlock lock;
+/* Serializes the writes to the models' publish buffers: */
+static K_MUTEX_DEFINE(pub_lock);
+static struct k_delayed_work slot_work;
+
+static uint32_t pdu_airtime(size_t len)
+{
+	size_t upper = len + TRANS_MIC_SIZE;
+
+	if (upper <= UNSEG_MAX) {
+		return (ADV_PDU_OVERHEAD + NET_PDU_OVERHEAD + UNSEG_HDR_SIZE +
+			upper) * US_PER_BYTE * ADV_CHANNELS;
+	}
+
+	size_t segs = ceiling_fraction(upper, SEG_MAX);
+
+	return (segs * (ADV_PDU_OVERHEAD + NET_PDU_OVERHEAD + SEG_HDR_SIZE) +
+		upper) * US_PER_BYTE * ADV_CHANNELS;
+}
+
+static void account(size_t len, uint32_t transmissions)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	stats.msgs++;
+	stats.airtime_us += (uint64_t)pdu_airtime(len) * transmissions;
+
+	k_spin_unlock(&lock, key);
+}
+
+static uint32_t net_transmissions(void)
+{
+	return TRANSMIT_COUNT(bt_mesh_net_transmit_get()) + 1;
+}
+
+/* Length of the opcode at the start of an access message. */
+static size_t opcode_len(const uint8_t *data, size_t len)
+{
+	if (!len) {
+		return 0;
+	}
+
+	switch (data[0] >> 6) {
+	case 0x02:
+		return MIN(len, 2);
+	case 0x03:
+		return MIN(len, 3);
+	default:
+		return 1;
+	}
+}
+
+static bool same_opcode(const struct entry *entry, const uint8_t *data,
+			size_t len)
+{
+	size_t op_len = opcode_len(data, len);
+
+	return op_len == opcode_len(entry->data, entry->len) &&
+	       !memcmp(entry->data, data, op_len);
+}
+
+static int publish(struct bt_mesh_model *mod, const uint8_t *data, size_t len)
+{
+	int err;
+
+	k_mutex_lock(&pub_lock, K_FOREVER);
+
+	net_buf_simple_reset(mod->pub->msg);
+	net_buf_simple_add_mem(mod->pub->msg, data, len);
+
+	err = bt_mesh_model_publish(mod);
+
+	k_mutex_unlock(&pub_lock);
+
+	if (err) {
+		k_spinlock_key_t key = k_spin_lock(&lock);
+
+		stats.failed++;
+
+		k_spin_unlock(&lock, key);
+
+		return err;
+	}
+
+	account(len, (TRANSMIT_COUNT(mod->pub->retransmit) + 1) *
+			     net_transmissions());
+
+	return 0;
+}
+
+static uint32_t slot_remaining(void)
+{
+	return SLOT_LEN - (k_uptime_get_32() % SLOT_LEN);
+}
+
+struct align_ctx {
+	uint32_t now;
+	uint32_t next;
+};
+
+/* The access layer has no API for moving the next periodic publication, so
+ * the publish timer in struct bt_mesh_model_pub is rescheduled directly. The
+ * access layer submits it with the remaining publish period or retransmit
+ * interval, and publishes periodically when it expires with no
+ * retransmissions left, regardless of when it was submitted.
+ */
+BUILD_ASSERT(__builtin_types_compatible_p(
+		     __typeof__(((struct bt_mesh_model_pub *)0)->timer),
+		     struct k_delayed_work),
+	     "The publish timer is no longer a delayed work item");
+
+/* Move the model's next periodic publication to the nearest slot start, so
+ * that the periodic publications of all models and the deferred
+ * publications go out together.
+ */
+static void align_pub(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
+		      bool vnd, bool primary, void *user_data)
+{
+	struct align_ctx *ctx = user_data;
+	uint32_t slot_end = ctx->now + SLOT_LEN - (ctx->now % SLOT_LEN);
+	uint32_t deadline, offset, remaining;
+
+	/* Leave the publish retransmissions and the publications that are
+	 * being sent alone:
+	 */
+	if (!mod->pub || mod->pub->count ||
+	    bt_mesh_model_pub_period_get(mod) <= 0 ||
+	    !k_delayed_work_pending(&mod->pub->timer)) {
+		return;
+	}
+
+	remaining = k_delayed_work_remaining_get(&mod->pub->timer);
+	deadline = ctx->now + remaining;
+
+	/* Already due in the current slot: */
+	if (deadline < slot_end) {
+		return;
+	}
+
+	offset = deadline % SLOT_LEN;
+	if (offset < SLOT_LEN / 2) {
+		deadline -= offset;
+	} else {
+		deadline += SLOT_LEN - offset;
+	}
+
+	if (deadline - ctx->now != remaining) {
+		BT_DBG("Aligning 0x%04x: %u -> %u", mod->id, remaining,
+		       deadline - ctx->now);
+		k_delayed_work_submit(&mod->pub->timer,
+				      K_MSEC(deadline - ctx->now));
+	}
+
+	ctx->next = MIN(ctx->next, deadline - ctx->now);
+}
+
+static void slot_handler(struct k_work *work)
+{
+	static uint8_t data[MSG_SIZE];
+	struct align_ctx align = {
+		.now = k_uptime_get_32(),
+		.next = ALIGN_INTERVAL_MAX,
+	};
+	struct bt_mesh_model *mod;
+	k_spinlock_key_t key;
+	size_t count = 0;
+	size_t carried = 0;
+	uint16_t len;
+	int err;
+
+	key = k_spin_lock(&lock);
+	stats.slots++;
+	k_spin_unlock(&lock, key);
+
+	/* Take the entries out one by one, so that a model can queue a new
+	 * message while the previous ones are being sent:
+	 */
+	for (size_t i = 0; i < ARRAY_SIZE(pending); i++) {
+		key = k_spin_lock(&lock);
+
+		mod = pending[i].mod;
+
+		/* The access layer retransmits whatever is in the publish
+		 * buffer, so leave the message for a later slot until the
+		 * model's previous publication has been retransmitted:
+		 */
+		if (mod && mod->pub->count) {
+			k_spin_unlock(&lock, key);
+			carried++;
+			continue;
+		}
+
+		len = pending[i].len;
+		memcpy(data, pending[i].data, len);
+		pending[i].mod = NULL;
+
+		k_spin_unlock(&lock, key);
+
+		if (!mod) {
+			continue;
+		}
+
+		err = publish(mod, data, len);
+		if (err) {
+			BT_WARN("Publishing failed for 0x%04x: %d", mod->id,
+				err);
+		}
+
+		count++;
+	}
+
+	BT_DBG("%u publications, %u carried", count, carried);
+
+	if (carried) {
+		align.next = slot_remaining();
+	}
+
+	if (bt_mesh_is_provisioned()) {
+		bt_mesh_model_foreach(align_pub, &align);
+	} else if (!carried) {
+		/* Nothing to align, the next deferred publication restarts
+		 * the slots:
+		 */
+		return;
+	}
+
+	/* Run again with the next periodic publication, unless a deferred
+	 * publication has been scheduled earlier in the meantime:
+	 */
+	if (!k_delayed_work_pending(&slot_work) ||
+	    k_delayed_work_remaining_get(&slot_work) > align.next) {
+		k_delayed_work_submit(&slot_work, K_MSEC(align.next));
+	}
+}
+
+/* Add the message to the pending publications.
+ *
+ * Returns false if the message couldn't be queued.
+ */
+static bool enqueue(struct bt_mesh_model *mod, struct net_buf_simple *buf)
+{
+	struct entry *entry = NULL;
+	k_spinlock_key_t key;
+
+	if (buf->len > MSG_SIZE) {
+		return false;
+	}
+
+	key = k_spin_lock(&lock);
+
+	for (size_t i = 0; i < ARRAY_SIZE(pending); i++) {
+		if (pending[i].mod == mod &&
+		    same_opcode(&pending[i], buf->data, buf->len)) {
+			/* The new message carries the latest state: */
+			entry = &pending[i];
+			stats.superseded++;
+			break;
+		}
+
+		if (!pending[i].mod && !entry) {
+			entry = &pending[i];
+		}
+	}
+
+	if (entry) {
+		if (!entry->mod) {
+			stats.deferred++;
+		}
+
+		entry->mod = mod;
+		entry->len = buf->len;
+		memcpy(entry->data, buf->data, buf->len);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return entry != NULL;
+}
+
+int pub_sched_publish(struct bt_mesh_model *mod, struct net_buf_simple *buf)
+{
+	if (!bt_mesh_is_provisioned()) {
+		return -EAGAIN;
+	}
+
+	if (mod->pub->addr == BT_MESH_ADDR_UNASSIGNED) {
+		return -EADDRNOTAVAIL;
+	}
+
+	if (buf->len > mod->pub->msg->size) {
+		return -EMSGSIZE;
+	}
+
+	if (!enqueue(mod, buf)) {
+		BT_DBG("Can't defer, publishing 0x%04x immediately", mod->id);
+		return publish(mod, buf->data, buf->len);
+	}
+
+	/* Keep the slot timer if it already expires at the next slot start,
+	 * so the publications are aligned to the same slot:
+	 */
+	if (!k_delayed_work_pending(&slot_work) ||
+	    k_delayed_work_remaining_get(&slot_work) > slot_remaining()) {
+		k_delayed_work_submit(&slot_work, K_MSEC(slot_remaining()));
+	}
+
+	return 0;
+}
+
+int pub_sched_publish_now(struct bt_mesh_model *mod,
+			  struct net_buf_simple *buf)
+{
+	return publish(mod, buf->data, buf->len);
+}
+
+void pub_sched_sent(const struct bt_mesh_msg_ctx *ctx, size_t len)
+{
+	ARG_UNUSED(ctx);
+
+	account(len, net_transmissions());
+}
+
+void bt_mesh_pub_sched_stats_get(struct bt_mesh_pub_sched_stats *out)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*out = stats;
+
+	k_spin_unlock(&lock, key);
+}
+
+void bt_mesh_pub_sched_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memset(&stats, 0, sizeof(stats));
+
+	k_spin_unlock(&lock, key);
+}
+
+static int pub_sched_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	/* The slots start with the first deferred publication: */
+	k_delayed_work_init(&slot_work, slot_handler);
+
+	return 0;
+}
+
+SYS_INIT(pub_sched_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/**
+ * @file
+ * @brief Publication scheduler internal API
+ */
+
+#ifndef PUB_SCHED_H__
+#define PUB_SCHED_H__
+
+#include <bluetooth/mesh/pub_sched.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Schedule a publication for the next slot.
+ *
+ *  The message is copied, and replaces a pending message with the same
+ *  opcode from the same model. If the message can't be deferred, it is
+ *  published immediately.
+ *
+ *  @param mod Model to publish on.
+ *  @param buf Message to publish.
+ *
+ *  @retval 0 The publication was scheduled or sent.
+ *  @retval -EADDRNOTAVAIL Publishing is not configured.
+ *  @retval -EAGAIN The device has not been provisioned.
+ *  @retval -EMSGSIZE The message doesn't fit in the publish buffer.
+ *  @return Other negative error codes from @ref bt_mesh_model_publish if
+ *          the message had to be published immediately and failed.
+ */
+int pub_sched_publish(struct bt_mesh_model *mod, struct net_buf_simple *buf);
+
+/** @brief Publish a message immediately.
+ *
+ *  @param mod Model to publish on.
+ *  @param buf Message to publish.
+ *
+ *  @return 0 on success, or (negative) error code from
+ *          @ref bt_mesh_model_publish on failure.
+ */
+int pub_sched_publish_now(struct bt_mesh_model *mod,
+			  struct net_buf_simple *buf);
+
+/** @brief Account for a message sent with an explicit message context.
+ *
+ *  @param ctx Message context the message was sent with.
+ *  @param len Length of the access message.
+ */
+void pub_sched_sent(const struct bt_mesh_msg_ctx *ctx, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUB_SCHED_H__ */
@@ -52,6 +52,244 @@
 
 LOG_MODULE_REGISTER(bt_hids, CONFIG_BT_HIDS_LOG_LEVEL);
 
+/* Positions of the boot reports in the subscription bitmap, following the
+ * Input Reports:
+ */
+#define SUB_BIT_BOOT_MOUSE CONFIG_BT_HIDS_INPUT_REP_MAX
+#define SUB_BIT_BOOT_KB (CONFIG_BT_HIDS_INPUT_REP_MAX + 1)
+
+BUILD_ASSERT(SUB_BIT_BOOT_KB < 16, "Subscription bitmap is too small");
+
+/* Generation of the subscription state. Incremented every time the CCC
+ * state of a connection might have changed without a CCC write from the
+ * peer, for instance when the CCC values of a bonded peer are restored. This
+ * invalidates the subscription bitmaps of all connections. Starts at 1, so
+ * that the bitmap of a new connection context is always refreshed.
+ */
+static atomic_t sub_gen = ATOMIC_INIT(1);
+
+static void sub_refresh(struct bt_hids *hids_obj, struct bt_conn *conn,
+			struct bt_hids_conn_data *conn_data)
+{
+	atomic_val_t gen = atomic_get(&sub_gen);
+	struct bt_gatt_attr *attrs = hids_obj->gp.svc.attrs;
+	uint16_t bitmap = 0;
+
+	if (conn_data->sub_gen == gen) {
+		return;
+	}
+
+	for (size_t i = 0; i < hids_obj->inp_rep_group.cnt; i++) {
+		uint8_t att_ind = hids_obj->inp_rep_group.reports[i].att_ind;
+
+		if (bt_gatt_is_subscribed(conn, &attrs[att_ind],
+					  BT_GATT_CCC_NOTIFY)) {
+			bitmap |= BIT(i);
+		}
+	}
+
+	if (hids_obj->is_mouse &&
+	    bt_gatt_is_subscribed(conn,
+				  &attrs[hids_obj->boot_mouse_inp_rep.att_ind],
+				  BT_GATT_CCC_NOTIFY)) {
+		bitmap |= BIT(SUB_BIT_BOOT_MOUSE);
+	}
+
+	if (hids_obj->is_kb &&
+	    bt_gatt_is_subscribed(conn,
+				  &attrs[hids_obj->boot_kb_inp_rep.att_ind],
+				  BT_GATT_CCC_NOTIFY)) {
+		bitmap |= BIT(SUB_BIT_BOOT_KB);
+	}
+
+	conn_data->sub_bitmap = bitmap;
+	conn_data->sub_gen = gen;
+}
+
+static bool is_subscribed(struct bt_hids *hids_obj, struct bt_conn *conn,
+			  struct bt_hids_conn_data *conn_data, uint8_t sub_bit)
+{
+	sub_refresh(hids_obj, conn, conn_data);
+
+	return (conn_data->sub_bitmap & BIT(sub_bit)) != 0;
+}
+
+static ssize_t sub_write(struct bt_hids *hids_obj, struct bt_conn *conn,
+			 uint8_t sub_bit, uint16_t value)
+{
+	struct bt_hids_conn_data *conn_data =
+		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
+
+	if (conn_data) {
+		/* The CCC value is stored after this callback returns, so
+		 * refresh the other bits before updating this one directly.
+		 */
+		sub_refresh(hids_obj, conn, conn_data);
+		WRITE_BIT(conn_data->sub_bitmap, sub_bit,
+			  (value & BT_GATT_CCC_NOTIFY) != 0);
+		bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+	}
+
+	return sizeof(value);
+}
+
+static void sub_invalidate(void)
+{
+	atomic_inc(&sub_gen);
+}
+
+#if defined(CONFIG_BT_SMP)
+static void security_changed(struct bt_conn *conn, bt_security_t level,
+			     enum bt_security_err err)
+{
+	/* The CCC values of bonded peers are restored on encryption. */
+	sub_invalidate();
+}
+
+static struct bt_conn_cb conn_callbacks = {
+	.security_changed = security_changed,
+};
+#endif
+
+#if CONFIG_BT_HIDS_COALESCE
+/* Forget the notifications queued for a disconnected peer, as they might
+ * never complete, and the report waiting for them if it was for that peer
+ * only. Must be called with the lock held. Returns whether a report for the
+ * other peers is waiting and no longer has notifications to wait for.
+ */
+static bool coalesce_reset_conn(struct bt_hids_coalesce *coalesce,
+				struct bt_conn *conn)
+{
+	uint8_t idx = bt_conn_index(conn);
+
+	coalesce->in_flight -= coalesce->conn_in_flight[idx];
+	coalesce->cb_owed -= coalesce->conn_cb_owed[idx];
+	coalesce->conn_in_flight[idx] = 0;
+	coalesce->conn_cb_owed[idx] = 0;
+
+	if (coalesce->merged && coalesce->conn == conn) {
+		coalesce->merged = 0;
+		coalesce->conn = NULL;
+	}
+
+	return !coalesce->in_flight && coalesce->merged;
+}
+
+static void inp_rep_flush(struct bt_hids *hids_obj,
+			  struct bt_hids_inp_rep *hids_inp_rep);
+static bool boot_mouse_flush(struct bt_hids *hids_obj);
+
+static void coalesce_disconnected(struct bt_hids *hids_obj,
+				  struct bt_conn *conn)
+{
+	struct bt_hids_boot_mouse_inp_rep *mouse =
+		&hids_obj->boot_mouse_inp_rep;
+	k_spinlock_key_t key;
+	bool flush;
+
+	for (size_t i = 0; i < hids_obj->inp_rep_group.cnt; i++) {
+		struct bt_hids_inp_rep *rep =
+			&hids_obj->inp_rep_group.reports[i];
+
+		key = k_spin_lock(&rep->coalesce.lock);
+		flush = coalesce_reset_conn(&rep->coalesce, conn);
+		k_spin_unlock(&rep->coalesce.lock, key);
+
+		if (flush) {
+			inp_rep_flush(hids_obj, rep);
+		}
+	}
+
+	key = k_spin_lock(&mouse->coalesce.lock);
+	if (mouse->coalesce.conn == conn) {
+		mouse->x_delta = 0;
+		mouse->y_delta = 0;
+	}
+
+	flush = coalesce_reset_conn(&mouse->coalesce, conn) ||
+		(!mouse->coalesce.in_flight &&
+		 (mouse->x_delta || mouse->y_delta));
+	k_spin_unlock(&mouse->coalesce.lock, key);
+
+	if (flush) {
+		(void)boot_mouse_flush(hids_obj);
+	}
+}
+
+/* Count a notification before sending it, as it might complete
+ * immediately. Notifications that carry a report from the application owe
+ * it a sent callback.
+ */
+static void coalesce_start(struct bt_hids_coalesce *coalesce,
+			   struct bt_conn *conn, bt_gatt_complete_func_t cb,
+			   bool owed)
+{
+	k_spinlock_key_t key = k_spin_lock(&coalesce->lock);
+	uint8_t idx = bt_conn_index(conn);
+
+	coalesce->in_flight++;
+	coalesce->conn_in_flight[idx]++;
+	if (owed) {
+		coalesce->cb_owed++;
+		coalesce->conn_cb_owed[idx]++;
+		coalesce->cb = cb;
+	}
+
+	k_spin_unlock(&coalesce->lock, key);
+}
+
+static void coalesce_cancel(struct bt_hids_coalesce *coalesce,
+			    struct bt_conn *conn, bool owed)
+{
+	k_spinlock_key_t key = k_spin_lock(&coalesce->lock);
+	uint8_t idx = bt_conn_index(conn);
+
+	coalesce->in_flight--;
+	coalesce->conn_in_flight[idx]--;
+	if (owed) {
+		coalesce->cb_owed--;
+		coalesce->conn_cb_owed[idx]--;
+	}
+
+	k_spin_unlock(&coalesce->lock, key);
+}
+
+/* Account for a completed notification. Must be called with the lock held.
+ * Returns the sent callback to call for it, if any.
+ */
+static bt_gatt_complete_func_t
+coalesce_complete(struct bt_hids_coalesce *coalesce, struct bt_conn *conn)
+{
+	uint8_t idx = bt_conn_index(conn);
+
+	if (coalesce->conn_in_flight[idx] > 0) {
+		coalesce->conn_in_flight[idx]--;
+		coalesce->in_flight--;
+	}
+
+	if (coalesce->conn_cb_owed[idx] > 0) {
+		coalesce->conn_cb_owed[idx]--;
+		coalesce->cb_owed--;
+		return coalesce->cb;
+	}
+
+	return NULL;
+}
+
+/* Complete all merged reports but the last one, which completes when the
+ * merged report is sent.
+ */
+static void coalesce_merged_done(struct bt_conn *conn, uint8_t merged,
+				 bt_gatt_complete_func_t cb)
+{
+	for (size_t i = 1; i < merged; i++) {
+		if (cb) {
+			cb(conn, NULL);
+		}
+	}
+}
+#endif
+
 int bt_hids_connected(struct bt_hids *hids_obj, struct bt_conn *conn)
 {
 	__ASSERT_NO_MSG(conn != NULL);
@@ -102,6 +340,10 @@ int bt_hids_disconnected(struct bt_hids *hids_obj, struct bt_conn *conn)
 
 	int err = bt_conn_ctx_free(hids_obj->conn_ctx, conn);
 
+#if CONFIG_BT_HIDS_COALESCE
+	coalesce_disconnected(hids_obj, conn);
+#endif
+
 	if (err) {
 		LOG_WRN("The memory was not allocated for the context of this "
 			"connection.");
@@ -448,11 +690,29 @@ static ssize_t hids_feat_rep_ref_read(struct bt_conn *conn,
 				 sizeof(report_ref));
 }
 
+static ssize_t hids_input_report_ccc_write(struct bt_conn *conn,
+					   struct bt_gatt_attr const *attr,
+					   uint16_t value)
+{
+	struct bt_hids_inp_rep *inp_rep =
+	    CONTAINER_OF((struct _bt_gatt_ccc *)attr->user_data,
+			 struct bt_hids_inp_rep, ccc);
+	struct bt_hids_inp_rep_group *group =
+	    CONTAINER_OF(inp_rep - inp_rep->idx, struct bt_hids_inp_rep_group,
+			 reports);
+	struct bt_hids *hids = CONTAINER_OF(group, struct bt_hids,
+					    inp_rep_group);
+
+	return sub_write(hids, conn, inp_rep->idx, value);
+}
+
 static void hids_input_report_ccc_changed(struct bt_gatt_attr const *attr,
 					  uint16_t value)
 {
 	LOG_DBG("Input Report CCCD has changed.");
 
+	sub_invalidate();
+
 	struct bt_hids_inp_rep *inp_rep =
 	    CONTAINER_OF((struct _bt_gatt_ccc *)attr->user_data,
 			 struct bt_hids_inp_rep, ccc);
@@ -502,11 +762,26 @@ static ssize_t hids_boot_mouse_inp_report_read(struct bt_conn *conn,
 	return ret_len;
 }
 
+static ssize_t hids_boot_mouse_inp_rep_ccc_write(struct bt_conn *conn,
+						 struct bt_gatt_attr const *attr,
+						 uint16_t value)
+{
+	struct bt_hids_boot_mouse_inp_rep *boot_mouse_rep =
+		CONTAINER_OF((struct _bt_gatt_ccc *)attr->user_data,
+			     struct bt_hids_boot_mouse_inp_rep, ccc);
+	struct bt_hids *hids = CONTAINER_OF(boot_mouse_rep, struct bt_hids,
+					    boot_mouse_inp_rep);
+
+	return sub_write(hids, conn, SUB_BIT_BOOT_MOUSE, value);
+}
+
 static void hids_boot_mouse_inp_rep_ccc_changed(struct bt_gatt_attr const *attr,
 						uint16_t value)
 {
 	LOG_DBG("Boot Mouse Input Report CCCD has changed.");
 
+	sub_invalidate();
+
 	struct bt_hids_boot_mouse_inp_rep *boot_mouse_rep =
 		CONTAINER_OF((struct _bt_gatt_ccc *)attr->user_data,
 			     struct bt_hids_boot_mouse_inp_rep, ccc);
@@ -557,11 +832,26 @@ static ssize_t hids_boot_kb_inp_report_read(struct bt_conn *conn,
 	return ret_len;
 }
 
+static ssize_t hids_boot_kb_inp_rep_ccc_write(struct bt_conn *conn,
+					      struct bt_gatt_attr const *attr,
+					      uint16_t value)
+{
+	struct bt_hids_boot_kb_inp_rep *boot_kb_inp_rep =
+		CONTAINER_OF((struct _bt_gatt_ccc *)attr->user_data,
+			     struct bt_hids_boot_kb_inp_rep, ccc);
+	struct bt_hids *hids = CONTAINER_OF(boot_kb_inp_rep, struct bt_hids,
+					    boot_kb_inp_rep);
+
+	return sub_write(hids, conn, SUB_BIT_BOOT_KB, value);
+}
+
 static void hids_boot_kb_inp_rep_ccc_changed(struct bt_gatt_attr const *attr,
 					     uint16_t value)
 {
 	LOG_DBG("Boot Keyboard Input Report CCCD has changed.");
 
+	sub_invalidate();
+
 	struct bt_hids_boot_kb_inp_rep *boot_kb_inp_rep =
 		CONTAINER_OF((struct _bt_gatt_ccc *)attr->user_data,
 			     struct bt_hids_boot_kb_inp_rep, ccc);
@@ -763,6 +1053,7 @@ hids_input_reports_register(struct bt_hids *hids_obj,
 
 		BT_GATT_POOL_CCC(&hids_obj->gp, hids_inp_rep->ccc,
 				 hids_input_report_ccc_changed,  wperm | rperm);
+		hids_inp_rep->ccc.cfg_write = hids_input_report_ccc_write;
 		BT_GATT_POOL_DESC(&hids_obj->gp, BT_UUID_HIDS_REPORT_REF,
 				  rperm, hids_inp_rep_ref_read,
 				  NULL, &hids_inp_rep->id);
@@ -860,6 +1151,20 @@ int bt_hids_init(struct bt_hids *hids_obj,
 {
 	LOG_DBG("Initializing HIDS.");
 
+#if defined(CONFIG_BT_SMP)
+	static bool conn_cb_registered;
+
+	if (!conn_cb_registered) {
+		bt_conn_cb_register(&conn_callbacks);
+		conn_cb_registered = true;
+	}
+#endif
+
+	/* The attribute layout changes, so all cached subscriptions are
+	 * invalid.
+	 */
+	sub_invalidate();
+
 	hids_obj->pm.evt_handler = init_param->pm_evt_handler;
 	hids_obj->cp.evt_handler = init_param->cp_evt_handler;
 
@@ -916,6 +1221,8 @@ int bt_hids_init(struct bt_hids *hids_obj,
 				 hids_obj->boot_mouse_inp_rep.ccc,
 				 hids_boot_mouse_inp_rep_ccc_changed,
 				 HIDS_GATT_PERM_DEFAULT);
+		hids_obj->boot_mouse_inp_rep.ccc.cfg_write =
+			hids_boot_mouse_inp_rep_ccc_write;
 	}
 
 	/* Register HID Boot Keyboard Input/Output Report characteristic, its
@@ -940,6 +1247,8 @@ int bt_hids_init(struct bt_hids *hids_obj,
 				 hids_obj->boot_kb_inp_rep.ccc,
 				 hids_boot_kb_inp_rep_ccc_changed,
 				 HIDS_GATT_PERM_DEFAULT);
+		hids_obj->boot_kb_inp_rep.ccc.cfg_write =
+			hids_boot_kb_inp_rep_ccc_write;
 
 		BT_GATT_POOL_CHRC(&hids_obj->gp,
 				  BT_UUID_HIDS_BOOT_KB_OUT_REPORT,
@@ -1021,15 +1330,50 @@ static void store_input_report(struct bt_hids_inp_rep *hids_inp_rep,
 	}
 }
 
+#if CONFIG_BT_HIDS_COALESCE
+static void inp_rep_sent(struct bt_conn *conn, void *user_data);
+#endif
+
+static int inp_rep_notify(struct bt_hids_inp_rep *hids_inp_rep,
+			  struct bt_conn *conn,
+			  struct bt_gatt_notify_params *params,
+			  bt_gatt_complete_func_t cb)
+{
+#if CONFIG_BT_HIDS_COALESCE
+	if (hids_inp_rep->merge) {
+		int err;
+
+		params->func = inp_rep_sent;
+		params->user_data = hids_inp_rep;
+
+		coalesce_start(&hids_inp_rep->coalesce, conn, cb, true);
+
+		err = bt_gatt_notify_cb(conn, params);
+		if (err) {
+			coalesce_cancel(&hids_inp_rep->coalesce, conn, true);
+		}
+
+		return err;
+	}
+#endif
+
+	params->func = cb;
+
+	return bt_gatt_notify_cb(conn, params);
+}
+
 static int inp_rep_notify_all(struct bt_hids *hids_obj,
 			      struct bt_hids_inp_rep *hids_inp_rep,
 			      uint8_t const *rep, uint8_t len,
 			      bt_gatt_complete_func_t cb)
 {
-	struct bt_hids_conn_data *conn_data;
-	uint8_t *rep_data = NULL;
-	struct bt_gatt_attr *rep_attr =
-		&hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
+	struct bt_gatt_notify_params params = {0};
+	bool notified = false;
+	int err = 0;
+
+	params.attr = &hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
+	params.data = rep;
+	params.len = hids_inp_rep->size;
 
 	const size_t contexts =
 	    bt_conn_ctx_count(hids_obj->conn_ctx);
@@ -1038,61 +1382,46 @@ static int inp_rep_notify_all(struct bt_hids *hids_obj,
 		const struct bt_conn_ctx *ctx =
 			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
 
-		if (ctx) {
-			bool notification_enabled = bt_gatt_is_subscribed(
-				ctx->conn, rep_attr, BT_GATT_CCC_NOTIFY);
+		if (!ctx) {
+			continue;
+		}
 
-			if (notification_enabled) {
-				conn_data = ctx->data;
-				rep_data = conn_data->inp_rep_ctx +
-					   hids_inp_rep->offset;
+		struct bt_hids_conn_data *conn_data = ctx->data;
 
-				store_input_report(hids_inp_rep, rep_data, rep,
-						   len);
-			}
+		if (is_subscribed(hids_obj, ctx->conn, conn_data,
+				  hids_inp_rep->idx)) {
+			uint8_t *rep_data = conn_data->inp_rep_ctx +
+					    hids_inp_rep->offset;
 
-			bt_conn_ctx_release(hids_obj->conn_ctx,
-					    (void *)ctx->data);
-		}
-	}
+			store_input_report(hids_inp_rep, rep_data, rep, len);
 
-	if (rep_data != NULL) {
-		struct bt_gatt_notify_params params = {0};
+			int ret = inp_rep_notify(hids_inp_rep, ctx->conn,
+						 &params, cb);
 
-		params.attr = rep_attr;
-		params.data = rep;
-		params.len = hids_inp_rep->size;
-		params.func = cb;
+			if (ret) {
+				err = ret;
+			}
 
-		return bt_gatt_notify_cb(NULL, &params);
-	} else {
-		return -ENODATA;
+			notified = true;
+		}
+
+		bt_conn_ctx_release(hids_obj->conn_ctx, (void *)ctx->data);
 	}
+
+	return notified ? err : -ENODATA;
 }
 
-int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
-			 struct bt_conn *conn, uint8_t rep_index,
-			 uint8_t const *rep, uint8_t len,
-			 bt_gatt_complete_func_t cb)
+static int inp_rep_send(struct bt_hids *hids_obj, struct bt_conn *conn,
+			struct bt_hids_inp_rep *hids_inp_rep,
+			uint8_t const *rep, uint8_t len,
+			bt_gatt_complete_func_t cb)
 {
-	struct bt_hids_inp_rep *hids_inp_rep =
-	    &hids_obj->inp_rep_group.reports[rep_index];
-	struct bt_gatt_attr *rep_attr =
-	    &hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
 	uint8_t *rep_data;
 
-	if (hids_inp_rep->size != len) {
-		return -EINVAL;
-	}
-
 	if (!conn) {
 		return inp_rep_notify_all(hids_obj, hids_inp_rep, rep, len, cb);
 	}
 
-	if (!bt_gatt_is_subscribed(conn, rep_attr, BT_GATT_CCC_NOTIFY)) {
-		return -EACCES;
-	}
-
 	struct bt_hids_conn_data *conn_data =
 		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
 
@@ -1101,6 +1430,11 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 		return -EINVAL;
 	}
 
+	if (!is_subscribed(hids_obj, conn, conn_data, hids_inp_rep->idx)) {
+		bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+		return -EACCES;
+	}
+
 	rep_data = conn_data->inp_rep_ctx + hids_inp_rep->offset;
 
 	store_input_report(hids_inp_rep, rep_data, rep, len);
@@ -1110,107 +1444,162 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 	params.attr = &hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
 	params.data = rep;
 	params.len = hids_inp_rep->size;
-	params.func = cb;
 
-	int err = bt_gatt_notify_cb(conn, &params);
+	int err = inp_rep_notify(hids_inp_rep, conn, &params, cb);
 
 	bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
 
 	return err;
 }
 
-static int boot_mouse_inp_report_notify_all(
-	struct bt_hids *hids_obj, const uint8_t *buttons,
-	struct bt_hids_boot_mouse_inp_rep *boot_mouse_inp_rep,
-	int8_t x_delta, int8_t y_delta, bt_gatt_complete_func_t cb)
+#if CONFIG_BT_HIDS_COALESCE
+/* Merge the report into the waiting report if there are notifications
+ * queued. Returns whether the report was merged, and whether a report from
+ * an earlier call is waiting.
+ */
+static bool inp_rep_merge(struct bt_hids_inp_rep *hids_inp_rep,
+			  struct bt_conn *conn, uint8_t const *rep,
+			  uint8_t len, bt_gatt_complete_func_t cb,
+			  bool *waiting)
 {
-	struct bt_hids_conn_data *conn_data;
-	uint8_t rep_ind = hids_obj->boot_mouse_inp_rep.att_ind;
-	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
-	uint8_t *rep_data = NULL;
-	uint8_t rep_buff[BT_HIDS_BOOT_MOUSE_REP_LEN] = {0};
+	struct bt_hids_coalesce *coalesce = &hids_inp_rep->coalesce;
+	k_spinlock_key_t key = k_spin_lock(&coalesce->lock);
+	bool merge = (coalesce->in_flight > 0) &&
+		     (coalesce->merged < UINT8_MAX) &&
+		     (!coalesce->merged || coalesce->conn == conn);
+
+	*waiting = (coalesce->merged > 0);
+
+	if (merge && !coalesce->merged) {
+		memcpy(hids_inp_rep->pending, rep, len);
+	} else if (merge) {
+		merge = hids_inp_rep->merge(hids_inp_rep->pending, rep, len);
+	}
 
-	rep_buff[1] = (uint8_t)x_delta;
-	rep_buff[2] = (uint8_t)y_delta;
+	if (merge) {
+		coalesce->conn = conn;
+		coalesce->cb = cb;
+		coalesce->merged++;
+	}
 
-	const size_t contexts = bt_conn_ctx_count(hids_obj->conn_ctx);
+	k_spin_unlock(&coalesce->lock, key);
 
-	for (size_t i = 0; i < contexts; i++) {
-		const struct bt_conn_ctx *ctx =
-			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
+	return merge;
+}
 
-		if (ctx) {
-			bool notification_enabled = bt_gatt_is_subscribed(
-				ctx->conn, rep_attr, BT_GATT_CCC_NOTIFY);
+static void inp_rep_flush(struct bt_hids *hids_obj,
+			  struct bt_hids_inp_rep *hids_inp_rep)
+{
+	struct bt_hids_coalesce *coalesce = &hids_inp_rep->coalesce;
+	uint8_t rep[CONFIG_BT_HIDS_COALESCE_REP_LEN];
+	bt_gatt_complete_func_t cb;
+	struct bt_conn *conn;
+	k_spinlock_key_t key;
+	uint8_t merged;
 
-			if (notification_enabled) {
-				conn_data = ctx->data;
-				rep_data =
-				    conn_data->hids_boot_mouse_inp_rep_ctx;
+	key = k_spin_lock(&coalesce->lock);
 
-				if (buttons) {
-					/* If buttons data is not given
-					 * use old values.
-					 */
-					rep_data[0] = *buttons;
-				}
+	merged = coalesce->merged;
+	conn = coalesce->conn;
+	cb = coalesce->cb;
+	memcpy(rep, hids_inp_rep->pending, hids_inp_rep->size);
+	coalesce->merged = 0;
 
-				rep_buff[0] = rep_data[0];
-			}
+	k_spin_unlock(&coalesce->lock, key);
 
-			bt_conn_ctx_release(hids_obj->conn_ctx,
-					    (void *)ctx->data);
-		}
+	if (!merged) {
+		return;
 	}
 
-	if (rep_data != NULL) {
-		struct bt_gatt_notify_params params = {0};
+	coalesce_merged_done(conn, merged, cb);
 
-		params.attr = rep_attr;
-		params.data = rep_buff;
-		params.len = sizeof(conn_data->hids_boot_mouse_inp_rep_ctx);
-		params.func = cb;
+	int err = inp_rep_send(hids_obj, conn, hids_inp_rep, rep,
+			       hids_inp_rep->size, cb);
 
-		return bt_gatt_notify_cb(NULL, &params);
-	} else {
-		return -ENODATA;
+	if (err) {
+		LOG_WRN("Failed to send merged Input Report: %d", err);
+		if (cb) {
+			cb(conn, NULL);
+		}
 	}
 }
 
-int bt_hids_boot_mouse_inp_rep_send(struct bt_hids *hids_obj,
-				    struct bt_conn *conn,
-				    const uint8_t *buttons,
-				    int8_t x_delta, int8_t y_delta,
-				    bt_gatt_complete_func_t cb)
+static void inp_rep_sent(struct bt_conn *conn, void *user_data)
 {
-	uint8_t rep_ind = hids_obj->boot_mouse_inp_rep.att_ind;
-	struct bt_hids_boot_mouse_inp_rep *boot_mouse_inp_rep =
-	    &hids_obj->boot_mouse_inp_rep;
-	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
-	uint8_t *rep_data;
+	struct bt_hids_inp_rep *hids_inp_rep = user_data;
+	struct bt_hids_inp_rep_group *group =
+	    CONTAINER_OF(hids_inp_rep - hids_inp_rep->idx,
+			 struct bt_hids_inp_rep_group, reports);
+	struct bt_hids *hids_obj = CONTAINER_OF(group, struct bt_hids,
+						inp_rep_group);
+	bt_gatt_complete_func_t cb;
+	k_spinlock_key_t key;
+	bool flush;
+
+	key = k_spin_lock(&hids_inp_rep->coalesce.lock);
+	cb = coalesce_complete(&hids_inp_rep->coalesce, conn);
+	flush = !hids_inp_rep->coalesce.in_flight;
+	k_spin_unlock(&hids_inp_rep->coalesce.lock, key);
+
+	if (cb) {
+		cb(conn, NULL);
+	}
 
-	if (!conn) {
-		return boot_mouse_inp_report_notify_all(hids_obj, buttons,
-							boot_mouse_inp_rep,
-							x_delta, y_delta, cb);
+	if (flush) {
+		inp_rep_flush(hids_obj, hids_inp_rep);
 	}
+}
+#endif
 
-	if (!bt_gatt_is_subscribed(conn, rep_attr, BT_GATT_CCC_NOTIFY)) {
-		return -EACCES;
+int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
+			 struct bt_conn *conn, uint8_t rep_index,
+			 uint8_t const *rep, uint8_t len,
+			 bt_gatt_complete_func_t cb)
+{
+	struct bt_hids_inp_rep *hids_inp_rep =
+	    &hids_obj->inp_rep_group.reports[rep_index];
+
+	if (hids_inp_rep->size != len) {
+		return -EINVAL;
 	}
 
-	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
+#if CONFIG_BT_HIDS_COALESCE
+	if (hids_inp_rep->merge && len <= sizeof(hids_inp_rep->pending)) {
+		bool waiting;
 
-	BUILD_ASSERT(sizeof(conn_data->hids_boot_mouse_inp_rep_ctx) >= 3,
-			 "buffer is too short");
+		if (inp_rep_merge(hids_inp_rep, conn, rep, len, cb,
+				  &waiting)) {
+			return 0;
+		}
 
-	if (!conn_data) {
-		LOG_WRN("The context was not found");
-		return -EINVAL;
+		/* Keep the reports in order: */
+		if (waiting) {
+			inp_rep_flush(hids_obj, hids_inp_rep);
+		}
 	}
+#endif
 
-	rep_data = conn_data->hids_boot_mouse_inp_rep_ctx;
+	return inp_rep_send(hids_obj, conn, hids_inp_rep, rep, len, cb);
+}
+
+#if CONFIG_BT_HIDS_COALESCE
+static void boot_mouse_sent(struct bt_conn *conn, void *user_data);
+#endif
+
+static int boot_mouse_notify(struct bt_hids *hids_obj, struct bt_conn *conn,
+			     struct bt_hids_conn_data *conn_data,
+			     const uint8_t *buttons, int8_t x_delta,
+			     int8_t y_delta, bt_gatt_complete_func_t cb,
+			     bool owed)
+{
+	struct bt_hids_boot_mouse_inp_rep *boot_mouse_inp_rep =
+		&hids_obj->boot_mouse_inp_rep;
+	uint8_t *rep_data = conn_data->hids_boot_mouse_inp_rep_ctx;
+	struct bt_gatt_notify_params params = {0};
+	int err;
+
+	BUILD_ASSERT(sizeof(conn_data->hids_boot_mouse_inp_rep_ctx) >= 3,
+			 "buffer is too short");
 
 	if (buttons) {
 		/* If buttons data is not given use old values. */
@@ -1219,33 +1608,259 @@ int bt_hids_boot_mouse_inp_rep_send(struct bt_hids *hids_obj,
 	rep_data[1] = (uint8_t)x_delta;
 	rep_data[2] = (uint8_t)y_delta;
 
-	struct bt_gatt_notify_params params = {0};
-
-	params.attr = &hids_obj->gp.svc.attrs[rep_ind];
+	params.attr = &hids_obj->gp.svc.attrs[boot_mouse_inp_rep->att_ind];
 	params.data = rep_data;
 	params.len = sizeof(conn_data->hids_boot_mouse_inp_rep_ctx);
+
+#if CONFIG_BT_HIDS_COALESCE
+	params.func = boot_mouse_sent;
+	params.user_data = hids_obj;
+
+	coalesce_start(&boot_mouse_inp_rep->coalesce, conn, cb, owed);
+#else
 	params.func = cb;
+#endif
 
-	int err = bt_gatt_notify_cb(conn, &params);
+	err = bt_gatt_notify_cb(conn, &params);
+
+#if CONFIG_BT_HIDS_COALESCE
+	if (err) {
+		coalesce_cancel(&boot_mouse_inp_rep->coalesce, conn, owed);
+	}
+#endif
 
 	rep_data[1] = 0;
 	rep_data[2] = 0;
 
+	return err;
+}
+
+static int boot_mouse_inp_report_notify_all(
+	struct bt_hids *hids_obj, const uint8_t *buttons,
+	int8_t x_delta, int8_t y_delta, bt_gatt_complete_func_t cb, bool owed)
+{
+	bool notified = false;
+	int err = 0;
+
+	const size_t contexts = bt_conn_ctx_count(hids_obj->conn_ctx);
+
+	for (size_t i = 0; i < contexts; i++) {
+		const struct bt_conn_ctx *ctx =
+			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
+
+		if (!ctx) {
+			continue;
+		}
+
+		if (is_subscribed(hids_obj, ctx->conn, ctx->data,
+				  SUB_BIT_BOOT_MOUSE)) {
+			int ret = boot_mouse_notify(hids_obj, ctx->conn,
+						    ctx->data, buttons,
+						    x_delta, y_delta, cb, owed);
+
+			if (ret) {
+				err = ret;
+			}
+
+			notified = true;
+		}
+
+		bt_conn_ctx_release(hids_obj->conn_ctx, (void *)ctx->data);
+	}
+
+	return notified ? err : -ENODATA;
+}
+
+/* Send a Boot Mouse report. Reports sent by the application owe it a sent
+ * callback for each notification.
+ */
+static int boot_mouse_send(struct bt_hids *hids_obj, struct bt_conn *conn,
+			   const uint8_t *buttons, int8_t x_delta,
+			   int8_t y_delta, bt_gatt_complete_func_t cb,
+			   bool owed)
+{
+	if (!conn) {
+		return boot_mouse_inp_report_notify_all(hids_obj, buttons,
+							x_delta, y_delta, cb,
+							owed);
+	}
+
+	struct bt_hids_conn_data *conn_data =
+		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
+
+	if (!conn_data) {
+		LOG_WRN("The context was not found");
+		return -EINVAL;
+	}
+
+	int err;
+
+	if (is_subscribed(hids_obj, conn, conn_data, SUB_BIT_BOOT_MOUSE)) {
+		err = boot_mouse_notify(hids_obj, conn, conn_data, buttons,
+					x_delta, y_delta, cb, owed);
+	} else {
+		err = -EACCES;
+	}
+
 	bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
 
 	return err;
 }
 
+#if CONFIG_BT_HIDS_COALESCE
+static bool boot_mouse_waiting(struct bt_hids_boot_mouse_inp_rep *rep)
+{
+	return rep->coalesce.merged || rep->x_delta || rep->y_delta;
+}
+
+/* Merge the movement into the waiting movement if there are notifications
+ * queued. Returns whether the movement was merged, and whether movement
+ * from an earlier call is waiting.
+ */
+static bool boot_mouse_merge(struct bt_hids_boot_mouse_inp_rep *rep,
+			     struct bt_conn *conn, const uint8_t *buttons,
+			     int8_t x_delta, int8_t y_delta,
+			     bt_gatt_complete_func_t cb, bool *waiting)
+{
+	k_spinlock_key_t key = k_spin_lock(&rep->coalesce.lock);
+	bool merge;
+
+	*waiting = boot_mouse_waiting(rep);
+
+	/* Button changes are never merged, as the host must see every
+	 * transition.
+	 */
+	merge = !buttons && (rep->coalesce.in_flight > 0) &&
+		(rep->coalesce.merged < UINT8_MAX) &&
+		(!*waiting || rep->coalesce.conn == conn);
+
+	if (merge) {
+		rep->x_delta = MIN(MAX(rep->x_delta + x_delta, INT16_MIN),
+				   INT16_MAX);
+		rep->y_delta = MIN(MAX(rep->y_delta + y_delta, INT16_MIN),
+				   INT16_MAX);
+		rep->coalesce.conn = conn;
+		rep->coalesce.cb = cb;
+		rep->coalesce.merged++;
+	}
+
+	k_spin_unlock(&rep->coalesce.lock, key);
+
+	return merge;
+}
+
+/* Send the waiting movement. Movement that doesn't fit in a report is kept
+ * for the next report. Returns whether movement is still waiting.
+ */
+static bool boot_mouse_flush(struct bt_hids *hids_obj)
+{
+	struct bt_hids_boot_mouse_inp_rep *rep = &hids_obj->boot_mouse_inp_rep;
+	bt_gatt_complete_func_t cb;
+	int8_t x_delta, y_delta;
+	struct bt_conn *conn;
+	k_spinlock_key_t key;
+	bool waiting, remaining;
+	uint8_t merged;
+
+	key = k_spin_lock(&rep->coalesce.lock);
+
+	waiting = boot_mouse_waiting(rep);
+	merged = rep->coalesce.merged;
+	conn = rep->coalesce.conn;
+	cb = rep->coalesce.cb;
+	x_delta = MIN(MAX(rep->x_delta, INT8_MIN), INT8_MAX);
+	y_delta = MIN(MAX(rep->y_delta, INT8_MIN), INT8_MAX);
+
+	rep->coalesce.merged = 0;
+	rep->x_delta -= x_delta;
+	rep->y_delta -= y_delta;
+	remaining = rep->x_delta || rep->y_delta;
+
+	k_spin_unlock(&rep->coalesce.lock, key);
+
+	if (!waiting) {
+		return false;
+	}
+
+	coalesce_merged_done(conn, merged, cb);
+
+	/* A report that only carries the remaining movement doesn't complete
+	 * any report from the application:
+	 */
+	int err = boot_mouse_send(hids_obj, conn, NULL, x_delta, y_delta, cb,
+				  merged > 0);
+
+	if (err) {
+		LOG_WRN("Failed to send merged Boot Mouse report: %d", err);
+		if (merged && cb) {
+			cb(conn, NULL);
+		}
+
+		return false;
+	}
+
+	return remaining;
+}
+
+static void boot_mouse_sent(struct bt_conn *conn, void *user_data)
+{
+	struct bt_hids *hids_obj = user_data;
+	struct bt_hids_boot_mouse_inp_rep *rep = &hids_obj->boot_mouse_inp_rep;
+	bt_gatt_complete_func_t cb;
+	k_spinlock_key_t key;
+	bool flush;
+
+	key = k_spin_lock(&rep->coalesce.lock);
+	cb = coalesce_complete(&rep->coalesce, conn);
+	flush = !rep->coalesce.in_flight;
+	k_spin_unlock(&rep->coalesce.lock, key);
+
+	if (cb) {
+		cb(conn, NULL);
+	}
+
+	if (flush) {
+		(void)boot_mouse_flush(hids_obj);
+	}
+}
+#endif
+
+int bt_hids_boot_mouse_inp_rep_send(struct bt_hids *hids_obj,
+				    struct bt_conn *conn,
+				    const uint8_t *buttons,
+				    int8_t x_delta, int8_t y_delta,
+				    bt_gatt_complete_func_t cb)
+{
+#if CONFIG_BT_HIDS_COALESCE
+	bool waiting;
+
+	if (boot_mouse_merge(&hids_obj->boot_mouse_inp_rep, conn, buttons,
+			     x_delta, y_delta, cb, &waiting)) {
+		return 0;
+	}
+
+	/* Keep the reports in order: */
+	while (waiting) {
+		waiting = boot_mouse_flush(hids_obj);
+	}
+#endif
+
+	return boot_mouse_send(hids_obj, conn, buttons, x_delta, y_delta, cb,
+			       true);
+}
+
 static int
 boot_kb_inp_notify_all(struct bt_hids *hids_obj, uint8_t const *rep,
-		       uint16_t len,
-		       struct bt_hids_boot_kb_inp_rep *boot_kb_inp_rep,
-		       bt_gatt_complete_func_t cb)
+		       uint16_t len, bt_gatt_complete_func_t cb)
 {
-	struct bt_hids_conn_data *conn_data;
+	struct bt_gatt_notify_params params = {0};
 	uint8_t rep_ind = hids_obj->boot_kb_inp_rep.att_ind;
-	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
-	uint8_t *rep_data = NULL;
+	bool notified = false;
+	int err = 0;
+
+	params.attr = &hids_obj->gp.svc.attrs[rep_ind];
+	params.len = BT_HIDS_BOOT_KB_INPUT_REP_LEN;
+	params.func = cb;
 
 	const size_t contexts = bt_conn_ctx_count(hids_obj->conn_ctx);
 
@@ -1253,36 +1868,35 @@ boot_kb_inp_notify_all(struct bt_hids *hids_obj, uint8_t const *rep,
 		const struct bt_conn_ctx *ctx =
 		    bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
 
-		if (ctx) {
-			bool notification_enabled = bt_gatt_is_subscribed(
-				ctx->conn, rep_attr, BT_GATT_CCC_NOTIFY);
+		if (!ctx) {
+			continue;
+		}
 
-			if (notification_enabled) {
-				conn_data = ctx->data;
-				rep_data = conn_data->hids_boot_kb_inp_rep_ctx;
+		struct bt_hids_conn_data *conn_data = ctx->data;
 
-				memcpy(rep_data, rep, len);
-				memset(&rep_data[len], 0,
-				       (BT_HIDS_BOOT_KB_INPUT_REP_LEN - len));
-			}
+		if (is_subscribed(hids_obj, ctx->conn, conn_data,
+				  SUB_BIT_BOOT_KB)) {
+			uint8_t *rep_data = conn_data->hids_boot_kb_inp_rep_ctx;
 
-			bt_conn_ctx_release(hids_obj->conn_ctx,
-					    (void *)ctx->data);
-		}
-	}
+			memcpy(rep_data, rep, len);
+			memset(&rep_data[len], 0,
+			       (BT_HIDS_BOOT_KB_INPUT_REP_LEN - len));
 
-	if (rep_data != NULL) {
-		struct bt_gatt_notify_params params = {0};
+			params.data = rep_data;
 
-		params.attr = rep_attr;
-		params.data = rep_data;
-		params.len = sizeof(conn_data->hids_boot_kb_inp_rep_ctx);
-		params.func = cb;
+			int ret = bt_gatt_notify_cb(ctx->conn, &params);
 
-		return bt_gatt_notify_cb(NULL, &params);
-	} else {
-		return -ENODATA;
+			if (ret) {
+				err = ret;
+			}
+
+			notified = true;
+		}
+
+		bt_conn_ctx_release(hids_obj->conn_ctx, (void *)ctx->data);
 	}
+
+	return notified ? err : -ENODATA;
 }
 
 int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj,
@@ -1290,32 +1904,30 @@ int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj,
 				      uint16_t len, bt_gatt_complete_func_t cb)
 {
 	uint8_t rep_ind = hids_obj->boot_kb_inp_rep.att_ind;
-	struct bt_hids_boot_kb_inp_rep *boot_kb_input_report =
-		&hids_obj->boot_kb_inp_rep;
 	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
 	uint8_t *rep_data = NULL;
 
-	if (!conn) {
-		return boot_kb_inp_notify_all(hids_obj, rep, len,
-					      boot_kb_input_report, cb);
+	if (len > BT_HIDS_BOOT_KB_INPUT_REP_LEN) {
+		return -EINVAL;
 	}
 
-	if (!bt_gatt_is_subscribed(conn, rep_attr, BT_GATT_CCC_NOTIFY)) {
-		return -EACCES;
+	if (!conn) {
+		return boot_kb_inp_notify_all(hids_obj, rep, len, cb);
 	}
 
 	struct bt_hids_conn_data *conn_data =
 		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
 
-	if (len > sizeof(conn_data->hids_boot_kb_inp_rep_ctx)) {
-		return -EINVAL;
-	}
-
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
 		return -EINVAL;
 	}
 
+	if (!is_subscribed(hids_obj, conn, conn_data, SUB_BIT_BOOT_KB)) {
+		bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+		return -EACCES;
+	}
+
 	rep_data = conn_data->hids_boot_kb_inp_rep_ctx;
 
 	memcpy(rep_data, rep, len);
@@ -239,6 +239,226 @@ static uint16_t chrc_value_handle_by_uuid(struct bt_gatt_dm *dm,
 	return gatt_desc->handle;
 }
 
+#if defined(CONFIG_BT_HOGP_CACHE)
+/* Information read from a bonded HID server. The entry is only valid for a
+ * peer with the same attribute handles.
+ */
+struct hogp_cache_entry {
+	bt_addr_le_t addr;
+	uint8_t id;
+	uint32_t used;
+	struct bt_hogp_handlers handlers;
+	struct bt_hids_info info_val;
+	uint8_t rep_count;
+	uint16_t rep_handles[CONFIG_BT_HOGP_REPORTS_MAX];
+	uint8_t rep_ids[CONFIG_BT_HOGP_REPORTS_MAX];
+	bool valid;
+	bool map_complete;
+	uint16_t map_len;
+	uint8_t map[CONFIG_BT_HOGP_CACHE_MAP_SIZE];
+};
+
+static struct hogp_cache_entry hogp_cache[CONFIG_BT_HOGP_CACHE_ENTRIES];
+static uint32_t hogp_cache_used;
+
+/**
+ * @brief Check if the cache entry matches the HIDS client
+ *
+ * @param entry Cache entry.
+ * @param hogp  HOGP object with assigned handles.
+ *
+ * @return true if the entry has been stored for the same peer and the
+ *         same attribute handles.
+ */
+static bool cache_entry_match(const struct hogp_cache_entry *entry,
+			      const struct bt_hogp *hogp)
+{
+	if (!entry->valid ||
+	    bt_addr_le_cmp(&entry->addr, bt_conn_get_dst(hogp->conn)) ||
+	    memcmp(&entry->handlers, &hogp->handlers,
+		   sizeof(entry->handlers)) ||
+	    entry->rep_count != hogp->rep_count) {
+		return false;
+	}
+
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		if (entry->rep_handles[i] != hogp->rep_info[i]->handlers.val) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Find the cache entry of the HIDS client
+ *
+ * @param hogp HOGP object with assigned handles.
+ *
+ * @return Pointer to the cache entry or NULL if the peer is not cached.
+ */
+static struct hogp_cache_entry *cache_find(const struct bt_hogp *hogp)
+{
+	if (!hogp->conn) {
+		return NULL;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(hogp_cache); i++) {
+		if (cache_entry_match(&hogp_cache[i], hogp)) {
+			return &hogp_cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Restore the HIDS client information from the cache
+ *
+ * @param hogp HOGP object with assigned handles.
+ *
+ * @return true if the information has been restored.
+ */
+static bool cache_restore(struct bt_hogp *hogp)
+{
+	struct hogp_cache_entry *entry = cache_find(hogp);
+	struct bt_conn_info info;
+
+	if (!entry) {
+		return false;
+	}
+
+	/* The bond might have been removed without the cache being told: */
+	if (bt_conn_get_info(hogp->conn, &info) || info.id != entry->id ||
+	    !bt_addr_le_is_bonded(info.id, &entry->addr)) {
+		LOG_DBG("Peer is no longer bonded, dropping cache entry");
+		entry->valid = false;
+		return false;
+	}
+
+	hogp->info_val = entry->info_val;
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		hogp->rep_info[i]->ref.id = entry->rep_ids[i];
+	}
+
+	/* Protocol Mode is reset to Report Protocol Mode on every connection
+	 * establishment.
+	 */
+	hogp->pm = BT_HIDS_PM_REPORT;
+	entry->used = ++hogp_cache_used;
+
+	LOG_DBG("Information restored from cache");
+	return true;
+}
+
+/**
+ * @brief Store the HIDS client information in the cache
+ *
+ * Only the information of bonded peers is stored. When the cache is full,
+ * the least recently used entry is replaced.
+ *
+ * @param hogp HOGP object.
+ */
+static void cache_store(struct bt_hogp *hogp)
+{
+	const bt_addr_le_t *addr = bt_conn_get_dst(hogp->conn);
+	struct bt_conn_info info;
+	struct hogp_cache_entry *entry;
+
+	if (hogp->rep_count > CONFIG_BT_HOGP_REPORTS_MAX ||
+	    bt_conn_get_info(hogp->conn, &info) ||
+	    !bt_addr_le_is_bonded(info.id, addr)) {
+		return;
+	}
+
+	entry = cache_find(hogp);
+	if (!entry) {
+		entry = &hogp_cache[0];
+		for (size_t i = 0; i < ARRAY_SIZE(hogp_cache); i++) {
+			if (!hogp_cache[i].valid) {
+				entry = &hogp_cache[i];
+				break;
+			}
+			if (hogp_cache[i].used < entry->used) {
+				entry = &hogp_cache[i];
+			}
+		}
+
+		memset(entry, 0, sizeof(*entry));
+		bt_addr_le_copy(&entry->addr, addr);
+		entry->id = info.id;
+		entry->handlers = hogp->handlers;
+		entry->rep_count = hogp->rep_count;
+		for (size_t i = 0; i < hogp->rep_count; i++) {
+			entry->rep_handles[i] = hogp->rep_info[i]->handlers.val;
+		}
+		entry->valid = true;
+	}
+
+	entry->info_val = hogp->info_val;
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		entry->rep_ids[i] = hogp->rep_info[i]->ref.id;
+	}
+	entry->used = ++hogp_cache_used;
+}
+
+void bt_hogp_cache_bond_deleted(uint8_t id, const bt_addr_le_t *peer)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(hogp_cache); i++) {
+		struct hogp_cache_entry *entry = &hogp_cache[i];
+
+		if (entry->id == id &&
+		    (!bt_addr_le_cmp(peer, BT_ADDR_LE_ANY) ||
+		     !bt_addr_le_cmp(&entry->addr, peer))) {
+			entry->valid = false;
+		}
+	}
+}
+
+/**
+ * @brief Store a Report Map chunk in the cache
+ *
+ * Chunks are only stored in order. The map is complete when a chunk
+ * shorter than the maximum read response is received.
+ *
+ * @param hogp   HOGP object.
+ * @param data   Report Map chunk.
+ * @param length The size of the chunk.
+ * @param offset The offset of the chunk.
+ */
+static void cache_map_store(struct bt_hogp *hogp, const uint8_t *data,
+			    uint16_t length, size_t offset)
+{
+	struct hogp_cache_entry *entry = cache_find(hogp);
+
+	if (!entry || entry->map_complete) {
+		return;
+	}
+
+	if (offset == 0) {
+		/* Reading restarted, drop any partially stored map */
+		entry->map_len = 0;
+	} else if (offset != entry->map_len) {
+		return;
+	}
+
+	if (length > sizeof(entry->map) - entry->map_len) {
+		/* Too large to be cached */
+		entry->map_len = 0;
+		return;
+	}
+
+	memcpy(&entry->map[entry->map_len], data, length);
+	entry->map_len += length;
+
+	if (length < bt_gatt_get_mtu(hogp->conn) - 1) {
+		entry->map_complete = true;
+	}
+}
+
+static void map_cache_work_handler(struct k_work *work);
+#endif /* CONFIG_BT_HOGP_CACHE */
+
 /**
  * @brief Mark hids ready to work
  *
@@ -249,6 +469,9 @@ static uint16_t chrc_value_handle_by_uuid(struct bt_gatt_dm *dm,
  */
 static void hids_mark_ready(struct bt_hogp *hogp)
 {
+#if defined(CONFIG_BT_HOGP_CACHE)
+	cache_store(hogp);
+#endif
 	k_sem_give(&hogp->read_params_sem);
 	hogp->ready = true;
 	if (hogp->ready_cb) {
@@ -327,11 +550,33 @@ static int pm_read_start(struct bt_hogp *hogp)
 	return 0;
 }
 
+/**
+ * @brief Parse protocol mode value
+ *
+ * @param hogp   HOGP object.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the received data.
+ *
+ * @return 0 or negative error value.
+ */
+static int pm_parse(struct bt_hogp *hogp, const void *data, uint16_t length)
+{
+	if (length != 1 || !data) {
+		LOG_ERR("Unexpected PM size");
+		return -ENOTSUP;
+	}
+
+	hogp->pm = (enum bt_hids_pm)((uint8_t *)data)[0];
+	LOG_DBG("Read PM success: %d", (int)hogp->pm);
+	return 0;
+}
+
 static uint8_t pm_read_process(struct bt_conn *conn, uint8_t err,
 			    struct bt_gatt_read_params *params,
 			    const void *data, uint16_t length)
 {
 	struct bt_hogp *hogp;
+	int ret;
 
 	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
 
@@ -340,14 +585,12 @@ static uint8_t pm_read_process(struct bt_conn *conn, uint8_t err,
 		hids_prep_error(hogp, err);
 		return BT_GATT_ITER_STOP;
 	}
-	if (length != 1 || !data) {
-		LOG_ERR("Unexpected PM size");
-		hids_prep_error(hogp, -ENOTSUP);
+	ret = pm_parse(hogp, data, length);
+	if (ret) {
+		hids_prep_error(hogp, ret);
 		return BT_GATT_ITER_STOP;
 	}
 
-	hogp->pm = (enum bt_hids_pm)((uint8_t *)data)[0];
-	LOG_DBG("Read PM success: %d", (int)hogp->pm);
 	hids_mark_ready(hogp);
 	return BT_GATT_ITER_STOP;
 }
@@ -410,15 +653,48 @@ static int repref_read_start(struct bt_hogp *hogp, size_t rep_idx)
 	return 0;
 }
 
+/**
+ * @brief Parse report reference value
+ *
+ * @param hogp    HOGP object.
+ * @param rep_idx Index in the report array.
+ * @param data    Pointer to the data buffer.
+ * @param length  The size of the received data.
+ *
+ * @return 0 or negative error value.
+ */
+static int repref_parse(struct bt_hogp *hogp, size_t rep_idx,
+			const void *data, uint16_t length)
+{
+	struct bt_hogp_rep_info *rep;
+	const uint8_t *bdata = data;
+
+	if (length != 2 || !data) {
+		LOG_ERR("Report (idx: %u) reference unexpected size (%u)",
+			rep_idx, length);
+		return -ENOTSUP;
+	}
+
+	rep = hogp->rep_info[rep_idx];
+	if ((uint8_t)rep->ref.type != bdata[1]) {
+		LOG_ERR("Unexpected report type (%u while expecting %u)",
+			bdata[1], rep->ref.type);
+		return -EINVAL;
+	}
+	rep->ref.id = bdata[0];
+	LOG_DBG("Report reference read (idx: %u, id: %u)",
+		rep_idx, rep->ref.id);
+
+	return 0;
+}
+
 static uint8_t repref_read_process(struct bt_conn *conn, uint8_t err,
 				struct bt_gatt_read_params *params,
 				const void *data, uint16_t length)
 {
 	int ret;
 	struct bt_hogp *hogp;
-	struct bt_hogp_rep_info *rep;
 	size_t rep_idx;
-	const uint8_t *bdata = data;
 
 	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
 
@@ -431,24 +707,12 @@ static uint8_t repref_read_process(struct bt_conn *conn, uint8_t err,
 		hids_prep_error(hogp, err);
 		return BT_GATT_ITER_STOP;
 	}
-	if (length != 2 || !data) {
-		LOG_ERR("Report (idx: %u) reference unexpected size (%u)",
-			rep_idx, length);
-		hids_prep_error(hogp, -ENOTSUP);
-		return BT_GATT_ITER_STOP;
-	}
 
-	rep = hogp->rep_info[rep_idx];
-	if ((uint8_t)rep->ref.type != bdata[1]) {
-		LOG_ERR("Unexpected report type (%u while expecting %u)",
-			bdata[1], rep->ref.type);
-		hids_prep_error(hogp, -EINVAL);
+	ret = repref_parse(hogp, rep_idx, data, length);
+	if (ret) {
+		hids_prep_error(hogp, ret);
 		return BT_GATT_ITER_STOP;
 	}
-	rep->ref.id = bdata[0];
-	LOG_DBG("Report reference read (idx: %u, id: %u)",
-		rep_idx, rep->ref.id);
-
 
 	/* Next */
 	ret = repref_read_start(hogp, rep_idx + 1);
@@ -479,6 +743,37 @@ static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
 				   struct bt_gatt_read_params *params,
 				   const void *data, uint16_t length);
 
+/**
+ * @brief Parse HID information value
+ *
+ * @param hogp   HOGP object.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the received data.
+ *
+ * @return 0 or negative error value.
+ */
+static int hid_info_parse(struct bt_hogp *hogp, const void *data,
+			  uint16_t length)
+{
+	const uint8_t *bdata = data;
+
+	if (length != 4 || !data) {
+		LOG_ERR("Unexpected HID information size: %u", length);
+		return -ENOTSUP;
+	}
+
+	hogp->info_val.bcd_hid = sys_get_le16(&bdata[0]);
+	hogp->info_val.b_country_code = bdata[2];
+	hogp->info_val.flags = bdata[3];
+
+	LOG_DBG("HID information success:");
+	LOG_DBG("  bcdHID: %x", hogp->info_val.bcd_hid);
+	LOG_DBG("  bCountryCode: 0x%x", hogp->info_val.b_country_code);
+	LOG_DBG("  Flags: 0x%x", hogp->info_val.flags);
+
+	return 0;
+}
+
 static int hid_info_read_start(struct bt_hogp *hogp)
 {
 	int err;
@@ -506,7 +801,7 @@ static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
 				   const void *data, uint16_t length)
 {
 	struct bt_hogp *hogp;
-	const uint8_t *bdata = data;
+	int ret;
 
 	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
 
@@ -515,28 +810,254 @@ static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
 		hids_prep_error(hogp, err);
 		return BT_GATT_ITER_STOP;
 	}
-	if (length != 4 || !data) {
-		LOG_ERR("Unexpected HID information size: %u", length);
-		hids_prep_error(hogp, -ENOTSUP);
+
+	ret = hid_info_parse(hogp, data, length);
+	if (ret) {
+		hids_prep_error(hogp, ret);
 		return BT_GATT_ITER_STOP;
 	}
 
-	hogp->info_val.bcd_hid = sys_get_le16(&bdata[0]);
-	hogp->info_val.b_country_code = bdata[2];
-	hogp->info_val.flags = bdata[3];
+	ret = repref_read_start(hogp, 0);
+	if (ret) {
+		hids_prep_error(hogp, ret);
+	}
 
-	LOG_DBG("HID information success:");
-	LOG_DBG("  bcdHID: %x", hogp->info_val.bcd_hid);
-	LOG_DBG("  bCountryCode: 0x%x", hogp->info_val.b_country_code);
-	LOG_DBG("  Flags: 0x%x", hogp->info_val.flags);
+	return BT_GATT_ITER_STOP;
+}
+
+#if defined(CONFIG_BT_HOGP_READ_MULTIPLE)
+/*
+ * Values read during the preparation, in order: HID Information, all
+ * Report References and Protocol Mode. All of them have fixed sizes, so they
+ * can be read with Read Multiple requests and split by their known sizes.
+ */
+#define PREP_ITEM_INFO_LEN   4
+#define PREP_ITEM_REPREF_LEN 2
+#define PREP_ITEM_PM_LEN     1
+
+/**
+ * @brief Get the number of values read during the preparation
+ *
+ * @param hogp HOGP object.
+ *
+ * @return Number of values.
+ */
+static size_t prep_item_count(const struct bt_hogp *hogp)
+{
+	return 1 + hogp->rep_count + (hogp->handlers.pm ? 1 : 0);
+}
+
+/**
+ * @brief Get the handle and the size of a preparation value
+ *
+ * @param hogp   HOGP object.
+ * @param item   Value index.
+ * @param handle Pointer to the handle to set.
+ *
+ * @return The size of the value.
+ */
+static uint16_t prep_item_get(const struct bt_hogp *hogp, size_t item,
+			      uint16_t *handle)
+{
+	if (item == 0) {
+		*handle = hogp->handlers.info;
+		return PREP_ITEM_INFO_LEN;
+	}
+
+	if (item <= hogp->rep_count) {
+		*handle = hogp->rep_info[item - 1]->handlers.ref;
+		return PREP_ITEM_REPREF_LEN;
+	}
+
+	*handle = hogp->handlers.pm;
+	return PREP_ITEM_PM_LEN;
+}
+
+/**
+ * @brief Parse a preparation value
+ *
+ * @param hogp   HOGP object.
+ * @param item   Value index.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the value.
+ *
+ * @return 0 or negative error value.
+ */
+static int prep_item_parse(struct bt_hogp *hogp, size_t item,
+			   const uint8_t *data, uint16_t length)
+{
+	if (item == 0) {
+		return hid_info_parse(hogp, data, length);
+	}
+
+	if (item <= hogp->rep_count) {
+		return repref_parse(hogp, item - 1, data, length);
+	}
+
+	return pm_parse(hogp, data, length);
+}
+
+/**
+ * @brief Process preparation values read
+ *
+ * Read Multiple responses contain the values of all requested handles
+ * concatenated. Zephyr calls the function once with the response, and once
+ * without data when the request is completed.
+ *
+ * @param conn   Connection handler.
+ * @param err    Read ATT error code.
+ * @param params Notification parameters structure - the pointer
+ *               to the structure provided to read function.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the received data.
+ *
+ * @retval BT_GATT_ITER_STOP     Stop notification
+ * @retval BT_GATT_ITER_CONTINUE Continue notification
+ */
+static uint8_t prep_read_process(struct bt_conn *conn, uint8_t err,
+				 struct bt_gatt_read_params *params,
+				 const void *data, uint16_t length);
+
+/**
+ * @brief Start preparation values read
+ *
+ * Reads as many of the remaining preparation values as fit into a single
+ * response. The device is marked ready when all values are read.
+ *
+ * @param hogp See @ref bt_hogp_handles_assign.
+ * @param item Index of the first value to read.
+ *
+ * @return 0 or negative error value.
+ */
+static int prep_read_start(struct bt_hogp *hogp, size_t item)
+{
+	size_t items = prep_item_count(hogp);
+	uint16_t space = bt_gatt_get_mtu(hogp->conn) - 1;
+	uint8_t count = 0;
+	int err;
+
+	if (item >= items) {
+		hids_mark_ready(hogp);
+		return 0;
+	}
+
+	while ((item + count < items) &&
+	       (count < ARRAY_SIZE(hogp->init_repref.handles))) {
+		uint16_t handle;
+		uint16_t len = prep_item_get(hogp, item + count, &handle);
+
+		if (len > space) {
+			break;
+		}
+
+		hogp->init_repref.handles[count++] = handle;
+		space -= len;
+	}
+
+	LOG_DBG("Reading %u values starting at %u", count, item);
+	hogp->init_repref.item = item;
+	hogp->init_repref.count = count;
+	hogp->read_params.func = prep_read_process;
+	hogp->read_params.handle_count = count;
+	if (count == 1) {
+		hogp->read_params.single.handle = hogp->init_repref.handles[0];
+		hogp->read_params.single.offset = 0;
+	} else {
+		/* The value sizes are known, so the plain Read Multiple
+		 * request can be used with any server.
+		 */
+		hogp->read_params.multiple.handles = hogp->init_repref.handles;
+		hogp->read_params.multiple.variable = false;
+	}
+
+	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
+	if (err) {
+		LOG_ERR("Preparation read error (err: %d)", err);
+		hogp->init_repref.count = 0;
+		return err;
+	}
+	return 0;
+}
+
+static uint8_t prep_read_process(struct bt_conn *conn, uint8_t err,
+				 struct bt_gatt_read_params *params,
+				 const void *data, uint16_t length)
+{
+	struct bt_hogp *hogp;
+	const uint8_t *bdata = data;
+	size_t item;
+	int ret;
+
+	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
+
+	if (!hogp->init_repref.count) {
+		/* Completion of a failed request */
+		return BT_GATT_ITER_STOP;
+	}
+
+	if (err == BT_ATT_ERR_NOT_SUPPORTED) {
+		/* Read Multiple is optional for the server */
+		LOG_DBG("Read Multiple not supported, reading one by one");
+		hogp->init_repref.count = 0;
+		ret = hid_info_read_start(hogp);
+		if (ret) {
+			hids_prep_error(hogp, ret);
+		}
+		return BT_GATT_ITER_STOP;
+	}
 
-	err = repref_read_start(hogp, 0);
 	if (err) {
+		LOG_ERR("Preparation read error (err: %d)", err);
+		hogp->init_repref.count = 0;
 		hids_prep_error(hogp, err);
+		return BT_GATT_ITER_STOP;
+	}
+
+	item = hogp->init_repref.item;
+
+	/* Single reads report an empty value without data */
+	if (data || (params->handle_count == 1)) {
+		for (size_t i = 0; i < hogp->init_repref.count; i++) {
+			uint16_t handle;
+			uint16_t len = prep_item_get(hogp, item + i, &handle);
+
+			ret = prep_item_parse(hogp, item + i, bdata,
+					      MIN(len, length));
+			if (!ret && (len > length)) {
+				ret = -ENOTSUP;
+			}
+			if (ret) {
+				hogp->init_repref.count = 0;
+				hids_prep_error(hogp, ret);
+				return BT_GATT_ITER_STOP;
+			}
+
+			bdata += len;
+			length -= len;
+		}
+
+		if (length) {
+			LOG_ERR("Unexpected preparation response size");
+			hogp->init_repref.count = 0;
+			hids_prep_error(hogp, -ENOTSUP);
+			return BT_GATT_ITER_STOP;
+		}
+
+		if (params->handle_count > 1) {
+			/* Continue when the request is completed */
+			return BT_GATT_ITER_CONTINUE;
+		}
+	}
+
+	/* Next */
+	ret = prep_read_start(hogp, item + hogp->init_repref.count);
+	if (ret) {
+		hids_prep_error(hogp, ret);
 	}
 
 	return BT_GATT_ITER_STOP;
 }
+#endif /* CONFIG_BT_HOGP_READ_MULTIPLE */
 
 /**
  * @brief Start anything that should be started after discovery
@@ -559,7 +1080,18 @@ static int post_discovery_start(struct bt_hogp *hogp)
 		return err;
 	}
 
+#if defined(CONFIG_BT_HOGP_CACHE)
+	if (cache_restore(hogp)) {
+		hids_mark_ready(hogp);
+		return 0;
+	}
+#endif
+
+#if defined(CONFIG_BT_HOGP_READ_MULTIPLE)
+	err = prep_read_start(hogp, 0);
+#else
 	err = hid_info_read_start(hogp);
+#endif
 	if (err) {
 		k_sem_give(&hogp->read_params_sem);
 		return err;
@@ -762,6 +1294,9 @@ void bt_hogp_init(struct bt_hogp *hogp,
 	hogp->prep_error_cb = params->prep_error_cb;
 	hogp->pm_update_cb  = params->pm_update_cb;
 	k_sem_init(&hogp->read_params_sem, 1, 1);
+#if defined(CONFIG_BT_HOGP_CACHE)
+	k_work_init(&hogp->map_work, map_cache_work_handler);
+#endif
 }
 
 int bt_hogp_handles_assign(struct bt_gatt_dm *dm,
@@ -1108,11 +1643,59 @@ static uint8_t map_read_process(struct bt_conn *conn, uint8_t err,
 	}
 
 	offset = hogp->read_params.single.offset;
+#if defined(CONFIG_BT_HOGP_CACHE)
+	if (!err && data) {
+		cache_map_store(hogp, data, length, offset);
+	}
+#endif
 	k_sem_give(&hogp->read_params_sem);
 	hogp->map_cb(hogp, err, data, length, offset);
 	return BT_GATT_ITER_STOP;
 }
 
+#if defined(CONFIG_BT_HOGP_CACHE)
+/**
+ * @brief Return Report Map chunk from the cache
+ *
+ * The chunk is returned from the work queue, so the map callback is never
+ * called from the context of @ref bt_hogp_map_read. The chunks have the
+ * same size as the read responses would have.
+ *
+ * @param work Work item.
+ */
+static void map_cache_work_handler(struct k_work *work)
+{
+	struct bt_hogp *hogp = CONTAINER_OF(work, struct bt_hogp, map_work);
+	size_t offset = hogp->read_params.single.offset;
+	struct hogp_cache_entry *entry = cache_find(hogp);
+	bt_hogp_map_cb map_cb = hogp->map_cb;
+
+	if (!entry || !entry->map_complete) {
+		/* Entry replaced in the meantime */
+		int err = bt_gatt_read(hogp->conn, &(hogp->read_params));
+
+		if (!err) {
+			return;
+		}
+
+		k_sem_give(&hogp->read_params_sem);
+		map_cb(hogp, BT_ATT_ERR_UNLIKELY, NULL, 0, offset);
+		return;
+	}
+
+	k_sem_give(&hogp->read_params_sem);
+
+	if (offset > entry->map_len) {
+		map_cb(hogp, BT_ATT_ERR_INVALID_OFFSET, NULL, 0, offset);
+		return;
+	}
+
+	map_cb(hogp, 0, &entry->map[offset],
+	       MIN(entry->map_len - offset, bt_gatt_get_mtu(hogp->conn) - 1),
+	       offset);
+}
+#endif /* CONFIG_BT_HOGP_CACHE */
+
 int bt_hogp_map_read(struct bt_hogp *hogp,
 		     bt_hogp_map_cb func,
 		     size_t offset,
@@ -1133,6 +1716,16 @@ int bt_hogp_map_read(struct bt_hogp *hogp,
 	hogp->read_params.handle_count  = 1;
 	hogp->read_params.single.handle = hogp->handlers.rep_map;
 	hogp->read_params.single.offset = offset;
+
+#if defined(CONFIG_BT_HOGP_CACHE)
+	struct hogp_cache_entry *entry = cache_find(hogp);
+
+	if (entry && entry->map_complete) {
+		k_work_submit(&hogp->map_work);
+		return 0;
+	}
+#endif
+
 	err = bt_gatt_read(hogp->conn, &(hogp->read_params));
 	if (err) {
 		hogp->map_cb = NULL;
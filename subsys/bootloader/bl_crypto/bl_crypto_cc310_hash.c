@@ -14,10 +14,18 @@
 #include <bl_crypto.h>
 #include "bl_crypto_cc310_common.h"
 
-#define MAX_CHUNK_LEN 0x8000 /* Must be 4 byte aligned. */
-#define CHUNK_LEN_STACK 0x200
+#define MAX_CHUNK_LEN CONFIG_SB_CRYPTO_CC310_HASH_CHUNK_LEN
+#define CHUNK_LEN_STACK CONFIG_SB_CRYPTO_CC310_HASH_EXT_CHUNK_LEN
 #define RAM_BUFFER_LEN_WORDS ((MAX_CHUNK_LEN) / 4)
-#define STACK_BUFFER_LEN_WORDS ((CHUNK_LEN_STACK) / 4)
+#define SHA256_BLOCK_LEN 64
+
+/* Chunks must be whole SHA-256 blocks so that data is never buffered inside
+ * the CryptoCell context between chunks.
+ */
+BUILD_ASSERT((MAX_CHUNK_LEN % SHA256_BLOCK_LEN) == 0,
+		"CONFIG_SB_CRYPTO_CC310_HASH_CHUNK_LEN must be a multiple of 64.");
+BUILD_ASSERT((CHUNK_LEN_STACK % SHA256_BLOCK_LEN) == 0,
+		"CONFIG_SB_CRYPTO_CC310_HASH_EXT_CHUNK_LEN must be a multiple of 64.");
 
 /*! Illegal context pointer. */
 #define CRYS_HASH_INVALID_USER_CONTEXT_POINTER_ERROR \
@@ -66,18 +74,27 @@ int bl_sha256_init(nrf_cc310_bl_hash_context_sha256_t * const ctx)
 	return retval;
 }
 
+static inline bool in_ram(const uint8_t *data)
+{
+	return (uint32_t)data >= CONFIG_SRAM_BASE_ADDRESS;
+}
+
+/* Hash the data one chunk at a time. Chunks in flash are copied to @p buffer
+ * first, chunks already in RAM are hashed in place. Since CryptoCell can only
+ * reach RAM, only the parts of @p data that are in flash need copying.
+ */
 static int hash_blocks(nrf_cc310_bl_hash_context_sha256_t *const ctx,
 		const uint8_t *data, uint32_t data_len, const uint32_t max_chunk_len,
 		uint32_t *buffer)
 {
-	uint32_t remaining_copy_len = data_len;
-	uint32_t chunk_len = MIN(data_len, max_chunk_len);
 	CRYSError_t retval = CRYS_OK;
 
 	cc310_bl_backend_enable();
 	for (uint32_t i = 0; i < data_len; i += max_chunk_len) {
+		uint32_t chunk_len = MIN(data_len - i, max_chunk_len);
 		uint8_t const *source = &data[i];
-		if (buffer) {
+
+		if (!in_ram(source)) {
 			memcpy32(buffer, source, chunk_len);
 			source = (uint8_t *)buffer;
 		}
@@ -87,9 +104,6 @@ static int hash_blocks(nrf_cc310_bl_hash_context_sha256_t *const ctx,
 		if (retval != CRYS_OK) {
 			break;
 		}
-
-		remaining_copy_len -= chunk_len;
-		chunk_len = MIN(remaining_copy_len, max_chunk_len);
 	}
 	cc310_bl_backend_disable();
 
@@ -110,16 +124,14 @@ static int sha256_update(nrf_cc310_bl_hash_context_sha256_t *const ctx,
 {
 	CRYSError_t retval;
 
-	if ((uint32_t)data < CONFIG_SRAM_BASE_ADDRESS) {
+	if (in_ram(data)) {
+		retval = hash_blocks(ctx, data, data_len, MAX_CHUNK_LEN, NULL);
+	} else if (external) {
 		/* Copy to RAM buffer, then hash. */
 		/* Cryptocell has DMA access to RAM only */
-		if (external) {
-			retval = hash_blocks_stack(ctx, data, data_len, CHUNK_LEN_STACK);
-		} else {
-			retval = hash_blocks(ctx, data, data_len, MAX_CHUNK_LEN, ram_buffer);
-		}
+		retval = hash_blocks_stack(ctx, data, data_len, CHUNK_LEN_STACK);
 	} else {
-		retval = hash_blocks(ctx, data, data_len, MAX_CHUNK_LEN, NULL);
+		retval = hash_blocks(ctx, data, data_len, MAX_CHUNK_LEN, ram_buffer);
 	}
 	switch (retval) {
 	case CRYS_HASH_INVALID_USER_CONTEXT_POINTER_ERROR:
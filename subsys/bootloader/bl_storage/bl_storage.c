@@ -53,6 +53,23 @@ struct counter_collection {
 
 #define TYPE_COUNTERS 1 /* Type referring to counter collection. */
 #define COUNTER_DESC_VERSION 1 /* Counter description value for firmware version. */
+#define COUNTER_DESC_VALIDATION_CACHE 2 /* Counter description value for validation cache. */
+
+/** An entry in the validation cache. The entry is stored in the slots of the
+ *  validation cache counter, and each member is written separately. The
+ *  'written' token is written last, so an entry which was interrupted while
+ *  being written is never used.
+ */
+struct validation_cache_entry {
+	uint16_t hash[VALIDATION_CACHE_HASH_LEN / 2];
+	uint16_t version;
+	uint16_t key_idx;
+	uint16_t written;
+};
+
+#define VALIDATION_CACHE_ENTRY_SLOTS \
+	(sizeof(struct validation_cache_entry) / sizeof(uint16_t))
+#define VALIDATION_CACHE_WRITTEN_VAL 0xA5A5 /* Written when entry is complete. */
 
 static const struct bl_storage_data *p_bl_storage_data =
 	(struct bl_storage_data *)PM_PROVISION_ADDRESS;
@@ -308,3 +325,112 @@ int set_monotonic_counter(uint16_t new_counter)
 	write_halfword(next_counter_addr, ~new_counter);
 	return 0;
 }
+
+
+uint16_t num_validation_cache_entries(void)
+{
+	const struct monotonic_counter *counter
+			= get_counter_struct(COUNTER_DESC_VALIDATION_CACHE);
+	uint16_t num_slots = 0;
+
+	if (counter != NULL) {
+		num_slots = read_halfword(&counter->num_counter_slots);
+	}
+	return num_slots != 0xFFFF ? num_slots / VALIDATION_CACHE_ENTRY_SLOTS : 0;
+}
+
+
+static const struct validation_cache_entry *validation_cache_get(void)
+{
+	const struct monotonic_counter *counter
+			= get_counter_struct(COUNTER_DESC_VALIDATION_CACHE);
+
+	return counter != NULL ? (const struct validation_cache_entry *)
+					counter->counter_slots : NULL;
+}
+
+
+static bool validation_cache_entry_match(
+		const struct validation_cache_entry *entry,
+		const uint8_t *hash, uint16_t version)
+{
+	if ((read_halfword(&entry->written) != VALIDATION_CACHE_WRITTEN_VAL)
+		|| (read_halfword(&entry->version) != version)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < (VALIDATION_CACHE_HASH_LEN / 2); i++) {
+		uint16_t expected = hash[2 * i] | (hash[2 * i + 1] << 8);
+
+		if (read_halfword(&entry->hash[i]) != expected) {
+			return false;
+		}
+	}
+
+	/* Entries created with a key that has since been invalidated are no
+	 * longer valid.
+	 */
+	uint16_t key_idx = read_halfword(&entry->key_idx);
+
+	return (key_idx < num_public_keys_read()) && key_is_valid(key_idx);
+}
+
+
+static bool validation_cache_entry_free(
+		const struct validation_cache_entry *entry)
+{
+	const uint16_t *slots = (const uint16_t *)entry;
+
+	for (uint32_t i = 0; i < VALIDATION_CACHE_ENTRY_SLOTS; i++) {
+		if (read_halfword(&slots[i]) != 0xFFFF) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool validation_cache_check(const uint8_t *hash, uint16_t version)
+{
+	const struct validation_cache_entry *entries = validation_cache_get();
+	uint16_t num_entries = num_validation_cache_entries();
+
+	for (uint32_t i = 0; i < num_entries; i++) {
+		if (validation_cache_entry_match(&entries[i], hash, version)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+int validation_cache_store(const uint8_t *hash, uint16_t version,
+			   uint16_t key_idx)
+{
+	const struct validation_cache_entry *entries = validation_cache_get();
+	uint16_t num_entries = num_validation_cache_entries();
+
+	if (version == 0xFFFF) {
+		return -EINVAL;
+	}
+
+	for (uint32_t i = 0; i < num_entries; i++) {
+		const struct validation_cache_entry *entry = &entries[i];
+
+		if (!validation_cache_entry_free(entry)) {
+			continue;
+		}
+
+		for (uint32_t j = 0; j < (VALIDATION_CACHE_HASH_LEN / 2); j++) {
+			write_halfword(&entry->hash[j],
+				hash[2 * j] | (hash[2 * j + 1] << 8));
+		}
+		write_halfword(&entry->version, version);
+		write_halfword(&entry->key_idx, key_idx);
+		write_halfword(&entry->written, VALIDATION_CACHE_WRITTEN_VAL);
+		return 0;
+	}
+
+	/* No more room. */
+	return -ENOMEM;
+}
@@ -128,14 +128,18 @@ static bool validation_info_check(const struct fw_validation_info *vinfo)
 }
 
 
-/* Find the validation_info at the end of the firmware. */
+/* Find the validation_info at the end of the firmware. The validation_info is
+ * always placed on a word boundary, so only word aligned addresses are checked.
+ */
 static const struct fw_validation_info *
 validation_info_find(uint32_t start_address, uint32_t search_distance)
 {
 	const struct fw_validation_info *vinfo;
+	uint32_t end_address = start_address + search_distance;
 
-	for (int i = 0; i <= search_distance; i++) {
-		vinfo = (const struct fw_validation_info *)(start_address + i);
+	for (uint32_t addr = ROUND_UP(start_address, 4); addr <= end_address;
+			addr += 4) {
+		vinfo = (const struct fw_validation_info *)addr;
 		if (validation_info_check(vinfo)) {
 			return vinfo;
 		}
@@ -143,10 +147,35 @@ validation_info_find(uint32_t start_address, uint32_t search_distance)
 	return NULL;
 }
 
+
+/* Locate the validation_info of the firmware, first at the location given by
+ * CONFIG_SB_VALIDATION_METADATA_OFFSET (if set), then directly after the
+ * firmware.
+ */
+static const struct fw_validation_info *
+validation_info_locate(uint32_t fw_src_address, const struct fw_info *fwinfo)
+{
+	if (CONFIG_SB_VALIDATION_METADATA_OFFSET != 0) {
+		uint32_t offset = CONFIG_SB_VALIDATION_METADATA_OFFSET
+				- fwinfo->address;
+
+		if ((CONFIG_SB_VALIDATION_METADATA_OFFSET >= fwinfo->address)
+			&& (offset >= fwinfo->size)
+			&& validation_info_check(
+			   (const struct fw_validation_info *)
+			   (fw_src_address + offset))) {
+			return (const struct fw_validation_info *)
+						(fw_src_address + offset);
+		}
+	}
+
+	return validation_info_find(fw_src_address + fwinfo->size, 4);
+}
+
 #ifdef CONFIG_SB_VALIDATE_FW_SIGNATURE
 static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_size,
 			       const struct fw_validation_info *fw_val_info,
-			       bool external)
+			       bool external, uint32_t *key_idx_out)
 {
 	int init_retval = bl_crypto_init();
 
@@ -204,6 +233,9 @@ static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_
 				invalidate_public_key(i);
 			}
 			PRINT("Firmware signature verified.\n\r");
+			if (key_idx_out != NULL) {
+				*key_idx_out = key_data_idx;
+			}
 			return true;
 		} else if (retval == -EHASHINV) {
 			PRINT("Public key didn't match, try next.\n\r");
@@ -220,6 +252,57 @@ static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_
 }
 
 
+#ifdef CONFIG_SB_VALIDATION_CACHE
+/* Validate the signature, unless the image is found in the validation cache.
+ * Only used for local validation, i.e. by the bootloader itself, since the
+ * cache is written when an image passes validation.
+ */
+static bool validate_signature_cached(const uint32_t fw_src_address,
+				const struct fw_info *fwinfo,
+				const struct fw_validation_info *fw_val_info)
+{
+	const bool external = false;
+	bl_sha256_ctx_t ctx;
+	uint8_t hash[CONFIG_SB_HASH_LEN];
+	uint32_t key_idx;
+	int retval = bl_crypto_init();
+
+	if (retval == 0) {
+		retval = bl_sha256_init(&ctx);
+	}
+	if (retval == 0) {
+		retval = bl_sha256_update(&ctx,
+				(const uint8_t *)fw_src_address, fwinfo->size);
+	}
+	if (retval == 0) {
+		retval = bl_sha256_finalize(&ctx, hash);
+	}
+	if (retval != 0) {
+		PRINT("Hashing for validation cache failed: %d.\n\r", retval);
+		return validate_signature(fw_src_address, fwinfo->size,
+					fw_val_info, external, NULL);
+	}
+
+	if (validation_cache_check(hash, fwinfo->version)) {
+		PRINT("Firmware found in validation cache.\n\r");
+		return true;
+	}
+
+	if (!validate_signature(fw_src_address, fwinfo->size, fw_val_info,
+				external, &key_idx)) {
+		return false;
+	}
+
+	retval = validation_cache_store(hash, fwinfo->version, key_idx);
+	if (retval != 0) {
+		PRINT("Firmware not added to validation cache: %d.\n\r",
+			retval);
+	}
+	return true;
+}
+#endif
+
+
 #elif defined(CONFIG_SB_VALIDATE_FW_HASH)
 static bool validate_hash(const uint32_t fw_src_address, const uint32_t fw_size,
 			  const struct fw_validation_info *fw_val_info,
@@ -321,7 +404,7 @@ static bool validate_firmware(uint32_t fw_dst_address, uint32_t fw_src_address,
 		return false;
 	}
 
-	fw_val_info = validation_info_find(fw_src_address + fwinfo->size, 4);
+	fw_val_info = validation_info_locate(fw_src_address, fwinfo);
 
 	if (!fw_val_info) {
 		PRINT("Could not find valid firmware validation info.\n\r");
@@ -334,8 +417,14 @@ static bool validate_firmware(uint32_t fw_dst_address, uint32_t fw_src_address,
 	}
 
 #ifdef CONFIG_SB_VALIDATE_FW_SIGNATURE
+#ifdef CONFIG_SB_VALIDATION_CACHE
+	if (!external) {
+		return validate_signature_cached(fw_src_address, fwinfo,
+						fw_val_info);
+	}
+#endif
 	return validate_signature(fw_src_address, fwinfo->size, fw_val_info,
-				external);
+				external, NULL);
 #elif defined(CONFIG_SB_VALIDATE_FW_HASH)
 	return validate_hash(fw_src_address, fwinfo->size, fw_val_info,
 				external);
@@ -5,6 +5,7 @@
  */
 #include <errno.h>
 #include <irq.h>
+#include <kernel.h>
 #include <sys/byteorder.h>
 #include <nrf.h>
 #include <esb.h>
@@ -45,8 +46,24 @@
  /* The maximum value for PID. */
 #define PID_MAX 3
 
+/* Number of TX FIFOs. */
+#if defined(CONFIG_ESB_TX_QUEUE_PER_PIPE)
+#define TX_FIFO_NUM CONFIG_ESB_PIPE_COUNT
+#else
+#define TX_FIFO_NUM 1
+#endif
+
+/* Highest radio channel number. */
+#define RF_CHANNEL_MAX 100
+
+/* Time from starting the radio until it starts transmitting. */
+#define TX_RAMP_UP_TIME_US 130
+
 #define BIT_MASK_UINT_8(x) (0xFF >> (8 - (x)))
 
+/* Length of the S0 (or length) and S1 fields in front of the payload. */
+#define PDU_HEADER_LEN 2
+
 #define RADIO_SHORTS_COMMON                                                    \
 	(RADIO_SHORTS_READY_START_Msk | RADIO_SHORTS_END_DISABLE_Msk |         \
 	 RADIO_SHORTS_ADDRESS_RSSISTART_Msk |                                  \
@@ -119,24 +136,49 @@ struct pipe_info {
 	bool ack_payload; /* State of the transmission of ACK payloads. */
 };
 
+/* Payload to be transmitted. The radio transmits directly from the packet
+ * buffer, which holds the S0 (or length) and S1 fields in front of the
+ * payload data.
+ */
+struct tx_slot {
+	uint8_t pdu[PDU_HEADER_LEN + CONFIG_ESB_MAX_PAYLOAD_LENGTH];
+	uint8_t length;	/* Length of the payload data. */
+	uint8_t pipe;	/* Pipe used for the payload. */
+	uint8_t pid;	/* PID assigned to the payload. */
+	bool noack;	/* The payload does not need to be acknowledged. */
+};
+
+/* Received payload. The radio receives directly into the packet buffer. */
+struct rx_slot {
+	uint8_t pdu[PDU_HEADER_LEN + CONFIG_ESB_MAX_PAYLOAD_LENGTH];
+	uint8_t length;	/* Length of the payload data. */
+	uint8_t pipe;	/* Pipe the payload was received on. */
+	uint8_t pid;	/* PID of the payload. */
+	int8_t rssi;	/* RSSI of the received packet. */
+	bool noack;	/* The payload was not acknowledged. */
+};
+
+/* Single-producer, single-consumer queues. The application is the producer
+ * of the TX queue and the consumer of the RX queue, and the radio interrupt
+ * is the other end. Each index is only written by its own end, so no locking
+ * is needed. The indexes run from 0 to twice the queue size, which makes it
+ * possible to tell a full queue from an empty one without a shared counter.
+ */
+
 /* First-in, first-out queue of payloads to be transmitted. */
 struct payload_tx_fifo {
-	 /* Payload queue */
-	struct esb_payload *payload[CONFIG_ESB_TX_FIFO_SIZE];
+	struct tx_slot slot[CONFIG_ESB_TX_FIFO_SIZE];
 
-	uint32_t back;	/* Back of the queue (last in). */
-	uint32_t front;	/* Front of queue (first out). */
-	uint32_t count;	/* Number of elements in the queue. */
+	volatile uint32_t back;	/* Back of the queue (last in). */
+	volatile uint32_t front;	/* Front of queue (first out). */
 };
 
 /* First-in, first-out queue of received payloads. */
 struct payload_rx_fifo {
-	 /* Payload queue */
-	struct esb_payload *payload[CONFIG_ESB_RX_FIFO_SIZE];
+	struct rx_slot slot[CONFIG_ESB_RX_FIFO_SIZE];
 
-	uint32_t back;	/* Back of the queue (last in). */
-	uint32_t front;	/* Front of queue (first out). */
-	uint32_t count;	/* Number of elements in the queue. */
+	volatile uint32_t back;	/* Back of the queue (last in). */
+	volatile uint32_t front;	/* Front of queue (first out). */
 };
 
 /* Enhanced ShockBurst address.
@@ -176,13 +218,24 @@ static struct esb_address esb_addr = {
 };
 
 static esb_event_handler event_handler;
-static struct esb_payload *current_payload;
+static struct tx_slot *current_payload;
+/* TX FIFO of the current (or last) transmission. */
+static struct payload_tx_fifo *current_fifo;
+/* The payload the radio is transmitting has been flushed, and is removed
+ * from its FIFO when the transmission ends.
+ */
+static volatile bool tx_discard;
 
 /* FIFOs and buffers */
-static struct payload_tx_fifo tx_fifo;
+static struct payload_tx_fifo tx_fifos[TX_FIFO_NUM];
 static struct payload_rx_fifo rx_fifo;
-static uint8_t tx_payload_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
-static uint8_t rx_payload_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
+/* Packet buffer for acknowledgments without payload. */
+static uint8_t ack_buffer[PDU_HEADER_LEN];
+/* Packet buffer for packets received when the RX FIFO is full. */
+static uint8_t
+	rx_discard_buffer[PDU_HEADER_LEN + CONFIG_ESB_MAX_PAYLOAD_LENGTH];
+/* Packet buffer the radio receives into. */
+static uint8_t *rx_pdu = rx_discard_buffer;
 
 /* Run time variables */
 static uint8_t pids[CONFIG_ESB_PIPE_COUNT];
@@ -190,6 +243,10 @@ static struct pipe_info rx_pipe_info[CONFIG_ESB_PIPE_COUNT];
 static volatile uint32_t interrupt_flags;
 static volatile uint32_t retransmits_remaining;
 static volatile uint32_t last_tx_attempts;
+/* Retransmit parameters of the current transmission. */
+static uint32_t retransmit_count;
+static uint32_t retransmit_delay;
+static uint32_t tx_start_cycles;
 static volatile uint32_t wait_for_ack_timeout_us;
 
 static uint32_t radio_shorts_common = RADIO_SHORTS_COMMON;
@@ -207,6 +264,7 @@ static void on_radio_disabled_tx(void);
 static void on_radio_disabled_tx_wait_for_ack(void);
 static void on_radio_disabled_rx(void);
 static void on_radio_disabled_rx_ack(void);
+static void clear_events_restart_rx(void);
 
 /*  Function to do bytewise bit-swap on an unsigned 32-bit value */
 static uint32_t bytewise_bit_swap(const uint8_t *input)
@@ -447,54 +505,171 @@ static bool update_radio_parameters(void)
 	return params_valid;
 }
 
-static void reset_fifos(void)
+static uint32_t fifo_count(uint32_t back, uint32_t front, uint32_t size)
 {
-	tx_fifo.back = 0;
-	tx_fifo.front = 0;
-	tx_fifo.count = 0;
+	return (back >= front) ? (back - front) : (back + 2 * size - front);
+}
 
-	rx_fifo.back = 0;
-	rx_fifo.front = 0;
-	rx_fifo.count = 0;
+static uint32_t fifo_next(uint32_t index, uint32_t size)
+{
+	return (index + 1 >= 2 * size) ? 0 : (index + 1);
 }
 
-static void initialize_fifos(void)
+static uint32_t fifo_slot(uint32_t index, uint32_t size)
 {
-	static struct esb_payload rx_payload[CONFIG_ESB_RX_FIFO_SIZE];
-	static struct esb_payload tx_payload[CONFIG_ESB_TX_FIFO_SIZE];
+	return (index >= size) ? (index - size) : index;
+}
 
-	reset_fifos();
+static uint32_t tx_fifo_count(const struct payload_tx_fifo *fifo)
+{
+	return fifo_count(fifo->back, fifo->front, CONFIG_ESB_TX_FIFO_SIZE);
+}
+
+static uint32_t rx_fifo_count(void)
+{
+	return fifo_count(rx_fifo.back, rx_fifo.front,
+			  CONFIG_ESB_RX_FIFO_SIZE);
+}
+
+static struct tx_slot *tx_fifo_front(struct payload_tx_fifo *fifo)
+{
+	return &fifo->slot[fifo_slot(fifo->front, CONFIG_ESB_TX_FIFO_SIZE)];
+}
 
-	for (size_t i = 0; i < CONFIG_ESB_TX_FIFO_SIZE; i++) {
-		tx_fifo.payload[i] = &tx_payload[i];
+static struct tx_slot *tx_fifo_back(struct payload_tx_fifo *fifo)
+{
+	return &fifo->slot[fifo_slot(fifo->back, CONFIG_ESB_TX_FIFO_SIZE)];
+}
+
+/* Get the TX FIFO that payloads for the given pipe are queued in. */
+static struct payload_tx_fifo *tx_fifo_get(uint8_t pipe)
+{
+#if defined(CONFIG_ESB_TX_QUEUE_PER_PIPE)
+	return &tx_fifos[pipe];
+#else
+	return &tx_fifos[0];
+#endif
+}
+
+/* Get the number of payloads queued in all TX FIFOs. */
+static uint32_t tx_fifos_count(void)
+{
+	uint32_t count = 0;
+
+	for (size_t i = 0; i < TX_FIFO_NUM; i++) {
+		count += tx_fifo_count(&tx_fifos[i]);
+	}
+
+	return count;
+}
+
+/*  Get the TX FIFO to transmit the next payload from.
+ *
+ *  With the round robin scheduler, the FIFOs are serviced in turn, starting
+ *  after the FIFO of the last transmission, so that a pipe that does not get
+ *  acknowledgments cannot block the other pipes. With the priority
+ *  scheduler, the FIFO of the lowest pipe number is always serviced first.
+ *
+ *  @return TX FIFO to transmit from, or NULL if all FIFOs are empty.
+ */
+static struct payload_tx_fifo *tx_fifo_next(void)
+{
+	size_t start = 0;
+
+	if (IS_ENABLED(CONFIG_ESB_TX_SCHEDULER_ROUND_ROBIN) && current_fifo) {
+		start = (current_fifo - tx_fifos) + 1;
+	}
+
+	for (size_t i = 0; i < TX_FIFO_NUM; i++) {
+		struct payload_tx_fifo *fifo =
+			&tx_fifos[(start + i) % TX_FIFO_NUM];
+
+		if (tx_fifo_count(fifo) > 0) {
+			return fifo;
+		}
 	}
 
-	for (size_t i = 0; i < CONFIG_ESB_RX_FIFO_SIZE; i++) {
-		rx_fifo.payload[i] = &rx_payload[i];
+	return NULL;
+}
+
+static struct rx_slot *rx_fifo_front(void)
+{
+	return &rx_fifo.slot[fifo_slot(rx_fifo.front,
+				       CONFIG_ESB_RX_FIFO_SIZE)];
+}
+
+static struct rx_slot *rx_fifo_back(void)
+{
+	return &rx_fifo.slot[fifo_slot(rx_fifo.back, CONFIG_ESB_RX_FIFO_SIZE)];
+}
+
+static void reset_fifos(void)
+{
+	for (size_t i = 0; i < TX_FIFO_NUM; i++) {
+		tx_fifos[i].back = 0;
+		tx_fifos[i].front = 0;
 	}
+
+	current_fifo = NULL;
+	tx_discard = false;
+
+	rx_fifo.back = 0;
+	rx_fifo.front = 0;
+
+	rx_pdu = rx_discard_buffer;
 }
 
-static void tx_fifo_remove_last(void)
+static void tx_fifo_remove_last(struct payload_tx_fifo *fifo)
 {
-	if (tx_fifo.count == 0) {
+	if (tx_fifo_count(fifo) == 0) {
 		return;
 	}
 
-	uint32_t key = irq_lock();
+	fifo->front = fifo_next(fifo->front, CONFIG_ESB_TX_FIFO_SIZE);
+}
 
-	tx_fifo.count--;
-	if (++tx_fifo.front >= CONFIG_ESB_TX_FIFO_SIZE) {
-		tx_fifo.front = 0;
+/*  Check if the radio is transmitting from the front of the TX FIFO of the
+ *  current transmission. The slot must not be released until the radio is
+ *  done with it.
+ */
+static bool tx_in_flight(void)
+{
+	switch (esb_state) {
+	case ESB_STATE_PTX_TX:
+	case ESB_STATE_PTX_TX_ACK:
+	case ESB_STATE_PTX_RX_ACK:
+		return true;
+	case ESB_STATE_PRX_SEND_ACK:
+		return current_payload &&
+		       NRF_RADIO->PACKETPTR == (uint32_t)current_payload->pdu;
+	default:
+		return false;
 	}
+}
 
-	irq_unlock(key);
+/*  Get the packet buffer to receive the next packet into.
+ *
+ *  Packets are received directly into the back of the RX FIFO. When the RX
+ *  FIFO is full, packets are received into a discard buffer instead.
+ *
+ *  @return Packet buffer to set in NRF_RADIO->PACKETPTR.
+ */
+static uint8_t *rx_pdu_update(void)
+{
+	if (rx_fifo_count() < CONFIG_ESB_RX_FIFO_SIZE) {
+		rx_pdu = rx_fifo_back()->pdu;
+	} else {
+		rx_pdu = rx_discard_buffer;
+	}
+
+	return rx_pdu;
 }
 
-/*  Function to push the content of the rx_buffer to the RX FIFO.
+/*  Function to push the received packet to the RX FIFO.
  *
- *  The module will point the register NRF_RADIO->PACKETPTR to a buffer for
- *  receiving packets. After receiving a packet the module will call this
- *  function to copy the received data to the RX FIFO.
+ *  The module will point the register NRF_RADIO->PACKETPTR to the back of
+ *  the RX FIFO for receiving packets. After receiving a packet the module
+ *  will call this function to make the packet available to the application.
  *
  *  @param  pipe Pipe number to set for the packet.
  *  @param  pid  Packet ID.
@@ -504,38 +679,480 @@ static void tx_fifo_remove_last(void)
  */
 static bool rx_fifo_push_rfbuf(uint8_t pipe, uint8_t pid)
 {
-	if (rx_fifo.count >= CONFIG_ESB_RX_FIFO_SIZE) {
+	struct rx_slot *slot = rx_fifo_back();
+
+	if (rx_fifo_count() >= CONFIG_ESB_RX_FIFO_SIZE ||
+	    rx_pdu != slot->pdu) {
 		return false;
 	}
 
 	if (esb_cfg.protocol == ESB_PROTOCOL_ESB_DPL) {
-		if (rx_payload_buffer[0] > CONFIG_ESB_MAX_PAYLOAD_LENGTH) {
+		if (rx_pdu[0] > CONFIG_ESB_MAX_PAYLOAD_LENGTH) {
 			return false;
 		}
-		rx_fifo.payload[rx_fifo.back]->length = rx_payload_buffer[0];
+		slot->length = rx_pdu[0];
 	} else if (esb_cfg.mode == ESB_MODE_PTX) {
 		/* Received packet is an acknowledgment */
-		rx_fifo.payload[rx_fifo.back]->length = 0;
+		slot->length = 0;
 	} else {
-		rx_fifo.payload[rx_fifo.back]->length = esb_cfg.payload_length;
+		slot->length = esb_cfg.payload_length;
 	}
 
-	memcpy(rx_fifo.payload[rx_fifo.back]->data, &rx_payload_buffer[2],
-	       rx_fifo.payload[rx_fifo.back]->length);
+	slot->pipe = pipe;
+	slot->rssi = NRF_RADIO->RSSISAMPLE;
+	slot->pid = pid;
+	slot->noack = !(rx_pdu[1] & 0x01);
 
-	rx_fifo.payload[rx_fifo.back]->pipe = pipe;
-	rx_fifo.payload[rx_fifo.back]->rssi = NRF_RADIO->RSSISAMPLE;
-	rx_fifo.payload[rx_fifo.back]->pid = pid;
-	rx_fifo.payload[rx_fifo.back]->noack = !(rx_payload_buffer[1] & 0x01);
+	/* The slot must be complete before it is made available. */
+	__DMB();
+	rx_fifo.back = fifo_next(rx_fifo.back, CONFIG_ESB_RX_FIFO_SIZE);
+
+	return true;
+}
 
-	if (++rx_fifo.back >= CONFIG_ESB_RX_FIFO_SIZE) {
-		rx_fifo.back = 0;
+#if defined(CONFIG_ESB_PIPE_STATS)
+static struct esb_pipe_stats pipe_stats[CONFIG_ESB_PIPE_COUNT];
+
+static void stats_rssi_add(uint8_t pipe, uint32_t rssi)
+{
+	uint32_t bin = MIN(rssi / ESB_PIPE_STATS_RSSI_BIN_WIDTH,
+			   ESB_PIPE_STATS_RSSI_BINS - 1);
+
+	pipe_stats[pipe].rssi_hist[bin]++;
+}
+
+static void stats_rx_add(uint8_t pipe, bool retransmit)
+{
+	if (retransmit) {
+		pipe_stats[pipe].rx_retransmits++;
+	} else {
+		pipe_stats[pipe].rx_packets++;
+	}
+}
+
+static void stats_tx_attempts_add(uint8_t pipe, uint32_t attempts)
+{
+	pipe_stats[pipe].tx_attempts += attempts;
+}
+
+static void stats_tx_add(uint8_t pipe, bool success, uint32_t attempts)
+{
+	struct esb_pipe_stats *stats = &pipe_stats[pipe];
+
+	stats_tx_attempts_add(pipe, attempts);
+
+	if (success) {
+		stats->tx_success++;
+	} else {
+		stats->tx_failed++;
+	}
+}
+
+static void stats_ack_latency_add(uint8_t pipe)
+{
+	struct esb_pipe_stats *stats = &pipe_stats[pipe];
+	uint32_t latency =
+		k_cyc_to_us_floor32(k_cycle_get_32() - tx_start_cycles);
+
+	/* Exponential moving average, with each new sample weighted 1/8. */
+	if (stats->ack_latency_avg_us == 0) {
+		stats->ack_latency_avg_us = latency;
+	} else {
+		stats->ack_latency_avg_us =
+			(7 * stats->ack_latency_avg_us + latency) / 8;
 	}
-	rx_fifo.count++;
 
+	stats->ack_latency_max_us = MAX(stats->ack_latency_max_us, latency);
+}
+#else
+static inline void stats_rssi_add(uint8_t pipe, uint32_t rssi) {}
+static inline void stats_rx_add(uint8_t pipe, bool retransmit) {}
+static inline void stats_tx_attempts_add(uint8_t pipe, uint32_t attempts) {}
+static inline void stats_tx_add(uint8_t pipe, bool success,
+				uint32_t attempts) {}
+static inline void stats_ack_latency_add(uint8_t pipe) {}
+#endif /* defined(CONFIG_ESB_PIPE_STATS) */
+
+/* Longest retransmit delay used with the configured retransmit delay. */
+static uint32_t retransmit_delay_max(uint16_t delay)
+{
+#if defined(CONFIG_ESB_ADAPTIVE_RETRANSMIT)
+	return MAX(delay, CONFIG_ESB_ADAPTIVE_RETRANSMIT_DELAY_MAX);
+#else
+	return delay;
+#endif
+}
+
+#if defined(CONFIG_ESB_ADAPTIVE_RETRANSMIT)
+/* Retransmit parameters, adapted to the link quality of each pipe. */
+struct retransmit_params {
+	uint16_t delay;
+	uint16_t count;
+};
+
+static struct retransmit_params pipe_retransmit[CONFIG_ESB_PIPE_COUNT];
+
+static void retransmit_params_reset(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(pipe_retransmit); i++) {
+		pipe_retransmit[i].delay = esb_cfg.retransmit_delay;
+		pipe_retransmit[i].count = esb_cfg.retransmit_count;
+	}
+}
+
+/*  Adapt the retransmit parameters of a pipe to the outcome of a
+ *  transmission.
+ *
+ *  A pipe that fails gets half the retransmits and twice the retransmit
+ *  delay for its next transmission, so that a peer that is out of range uses
+ *  less air time. A pipe that needs retransmits to succeed spreads them out
+ *  further, as losses are likely caused by bursts of interference. A pipe
+ *  that succeeds on the first attempt gradually returns to the configured
+ *  parameters.
+ *
+ *  @param pipe     Pipe of the transmission.
+ *  @param success  Whether the transmission was acknowledged.
+ *  @param attempts Number of transmission attempts.
+ */
+static void retransmit_params_update(uint8_t pipe, bool success,
+				     uint32_t attempts)
+{
+	struct retransmit_params *params = &pipe_retransmit[pipe];
+	uint32_t delay_max = retransmit_delay_max(esb_cfg.retransmit_delay);
+	uint32_t delay;
+
+	if (!success) {
+		delay = 2 * params->delay;
+		params->count = MAX(params->count / 2, 1);
+	} else if (attempts > 1) {
+		delay = params->delay + params->delay / 4;
+		params->count = esb_cfg.retransmit_count;
+	} else {
+		delay = (params->delay + esb_cfg.retransmit_delay) / 2;
+		params->count = esb_cfg.retransmit_count;
+	}
+
+	params->delay = MIN(delay, delay_max);
+}
+
+static void retransmit_params_get(uint8_t pipe)
+{
+	retransmit_delay = pipe_retransmit[pipe].delay;
+	retransmit_count = MIN(pipe_retransmit[pipe].count,
+			       esb_cfg.retransmit_count);
+}
+#else
+static inline void retransmit_params_reset(void) {}
+static inline void retransmit_params_update(uint8_t pipe, bool success,
+					    uint32_t attempts) {}
+
+static void retransmit_params_get(uint8_t pipe)
+{
+	retransmit_delay = esb_cfg.retransmit_delay;
+	retransmit_count = esb_cfg.retransmit_count;
+}
+#endif /* defined(CONFIG_ESB_ADAPTIVE_RETRANSMIT) */
+
+/* Update the statistics and retransmit parameters at the end of a
+ * transmission. Must be called before the payload is removed from its FIFO.
+ */
+static void tx_complete(bool success)
+{
+	uint8_t pipe = current_payload->pipe;
+
+	stats_tx_add(pipe, success, last_tx_attempts);
+	retransmit_params_update(pipe, success, last_tx_attempts);
+}
+
+#if defined(CONFIG_ESB_CHANNEL_HOPPING)
+/* Channel in the hop table, with the failure statistics used to blacklist
+ * it.
+ */
+struct hop_channel {
+	uint8_t channel;
+	uint8_t blacklist; /* Number of hops the channel is skipped for. */
+	uint16_t attempts; /* Transmission attempts in the current window. */
+	uint16_t failures; /* Failed attempts in the current window. */
+};
+
+#define HOP_FAILURE_THRESHOLD CONFIG_ESB_CHANNEL_HOPPING_FAILURE_THRESHOLD
+#define HOP_PRX_DWELL_TIME CONFIG_ESB_CHANNEL_HOPPING_PRX_DWELL_TIME
+
+static struct hop_channel hop_table[CONFIG_ESB_CHANNEL_HOPPING_TABLE_SIZE];
+static uint8_t hop_count;
+static uint8_t hop_index;
+/* Number of hops since the last successful transmission. */
+static uint8_t hop_sweep;
+/* The PRX is looking for the PTX on the other channels. */
+static bool hop_searching;
+/* The PRX dwell time has passed without hearing the PTX. */
+static volatile bool hop_search_due;
+static struct k_timer hop_timer;
+
+static void hop_table_set(const uint8_t *channels, uint8_t count)
+{
+	memset(hop_table, 0, sizeof(hop_table));
+
+	for (size_t i = 0; i < count; i++) {
+		hop_table[i].channel = channels[i];
+	}
+
+	hop_count = count;
+	hop_index = 0;
+	hop_sweep = 0;
+
+	if (count > 0) {
+		esb_addr.rf_channel = hop_table[0].channel;
+	}
+}
+
+/*  Move to the next channel in the hop table.
+ *
+ *  The channels that are blacklisted are skipped, unless all of them are.
+ */
+static void hop_next(void)
+{
+	uint8_t index = hop_index;
+
+	for (size_t i = 0; i < hop_count; i++) {
+		if (hop_table[i].blacklist > 0) {
+			hop_table[i].blacklist--;
+		}
+	}
+
+	for (size_t i = 0; i < hop_count; i++) {
+		index = (index + 1) % hop_count;
+
+		if (hop_table[index].blacklist == 0) {
+			break;
+		}
+	}
+
+	hop_index = index;
+	esb_addr.rf_channel = hop_table[index].channel;
+}
+
+/*  Update the failure statistics of the current channel.
+ *
+ *  @param attempts Number of transmission attempts.
+ *  @param failures Number of failed attempts.
+ *
+ *  @return true if the channel has been blacklisted.
+ */
+static bool hop_channel_update(uint32_t attempts, uint32_t failures)
+{
+	struct hop_channel *ch = &hop_table[hop_index];
+	bool bad;
+
+	ch->attempts += attempts;
+	ch->failures += failures;
+
+	if (ch->attempts < CONFIG_ESB_CHANNEL_HOPPING_WINDOW) {
+		return false;
+	}
+
+	bad = (ch->failures * 100 >= ch->attempts * HOP_FAILURE_THRESHOLD);
+	ch->attempts = 0;
+	ch->failures = 0;
+
+	if (bad) {
+		ch->blacklist = CONFIG_ESB_CHANNEL_HOPPING_BLACKLIST_HOPS;
+	}
+
+	return bad;
+}
+
+/*  Update the failure statistics of the current channel at the end of a PTX
+ *  transmission, and hop to the next channel if the channel is blacklisted.
+ *
+ *  @param success  Whether the transmission was acknowledged.
+ *  @param attempts Number of transmission attempts.
+ *
+ *  @return true if the transmission should be retried on the next channel.
+ */
+static bool hop_tx_complete(bool success, uint32_t attempts)
+{
+	bool bad;
+
+	if (hop_count == 0) {
+		return false;
+	}
+
+	bad = hop_channel_update(attempts, success ? (attempts - 1) : attempts);
+
+	if (success) {
+		hop_sweep = 0;
+
+		if (bad) {
+			hop_next();
+		}
+
+		return false;
+	}
+
+	/* Sweep the hop table looking for the PRX before reporting the
+	 * failure.
+	 */
+	hop_next();
+
+	if (++hop_sweep < hop_count) {
+		return true;
+	}
+
+	hop_sweep = 0;
+	return false;
+}
+
+static void hop_search_start(void)
+{
+	if (!hop_searching) {
+		hop_searching = true;
+		k_timer_start(&hop_timer, K_MSEC(HOP_PRX_DWELL_TIME),
+			      K_MSEC(HOP_PRX_DWELL_TIME));
+	}
+}
+
+static void hop_search_stop(void)
+{
+	if (hop_searching) {
+		hop_searching = false;
+		k_timer_stop(&hop_timer);
+	}
+
+	hop_search_due = false;
+}
+
+/*  Update the failure statistics of the current channel when the PRX
+ *  receives a packet.
+ *
+ *  Retransmitted packets and packets with CRC errors count as failures,
+ *  which gives the PRX about the same view of the channel as the PTX. When
+ *  the channel is blacklisted, the PRX moves to the next channel like the
+ *  PTX does, and looks for the PTX in case the PTX has not moved.
+ *
+ *  The PRX only looks for the PTX on the other channels after a sign that
+ *  the link is lost, so it stays on its channel when the PTX is idle.
+ *
+ *  @param crc_ok     Whether the packet was received with a valid CRC.
+ *  @param retransmit Whether the packet is a retransmission.
+ */
+static void hop_rx_update(bool crc_ok, bool retransmit)
+{
+	if (hop_count == 0) {
+		return;
+	}
+
+	if (crc_ok) {
+		hop_search_stop();
+	} else {
+		hop_search_start();
+	}
+
+	if (hop_channel_update(1, (crc_ok && !retransmit) ? 0 : 1)) {
+		hop_next();
+		hop_search_start();
+	}
+}
+
+/*  Restart the PRX on the channel selected by the hop logic. Called from the
+ *  radio interrupt, so that the PRX does not leave the channel while it
+ *  receives a packet or sends an ACK.
+ *
+ *  The channel is only changed while the radio waits for a packet. If the
+ *  address of a packet has been received, or an ACK is being sent, the
+ *  change is left to the interrupt that ends the packet or the ACK.
+ */
+static void hop_rx_apply(void)
+{
+	if (esb_state != ESB_STATE_PRX || NRF_RADIO->EVENTS_ADDRESS) {
+		return;
+	}
+
+	if (hop_search_due) {
+		hop_search_due = false;
+		hop_next();
+	}
+
+	if (NRF_RADIO->FREQUENCY != esb_addr.rf_channel) {
+		clear_events_restart_rx();
+	}
+}
+
+/* The PRX has not heard the PTX during the dwell time, and moves to the next
+ * channel to find it. The PRX dwells on each channel for longer than it
+ * takes the PTX to sweep the hop table, so they meet within one PRX hop.
+ * The hop is left to the radio interrupt.
+ */
+static void hop_timer_handler(struct k_timer *timer)
+{
+	hop_search_due = true;
+	NVIC_SetPendingIRQ(RADIO_IRQn);
+}
+
+/* Longest time it takes the PTX to sweep a hop table, in milliseconds,
+ * assuming the longest delay the adaptive retransmit might use.
+ */
+static uint32_t hop_sweep_time(uint8_t count, uint16_t retransmit_delay,
+			       uint16_t retransmit_count)
+{
+	return ceiling_fraction(count * (retransmit_count + 1) *
+				retransmit_delay_max(retransmit_delay), 1000);
+}
+
+/* The PRX must dwell on each channel for longer than a PTX sweep. */
+static bool hop_params_valid(uint8_t count, uint16_t retransmit_delay,
+			     uint16_t retransmit_count)
+{
+	return hop_sweep_time(count, retransmit_delay, retransmit_count) <
+	       HOP_PRX_DWELL_TIME;
+}
+
+/* Whether the retransmit parameters fit the current hop table. */
+static bool hop_retransmit_valid(uint16_t retransmit_delay,
+				 uint16_t retransmit_count)
+{
+	return hop_params_valid(hop_count, retransmit_delay, retransmit_count);
+}
+
+static void hop_init(void)
+{
+	k_timer_init(&hop_timer, hop_timer_handler, NULL);
+	hop_searching = false;
+	hop_search_due = false;
+	hop_sweep = 0;
+
+	for (size_t i = 0; i < hop_count; i++) {
+		hop_table[i].blacklist = 0;
+		hop_table[i].attempts = 0;
+		hop_table[i].failures = 0;
+	}
+}
+
+static void hop_stop(void)
+{
+	hop_search_stop();
+}
+#else
+static inline void hop_table_set(const uint8_t *channels, uint8_t count) {}
+
+static inline bool hop_tx_complete(bool success, uint32_t attempts)
+{
+	return false;
+}
+
+static inline void hop_rx_update(bool crc_ok, bool retransmit) {}
+
+static inline bool hop_retransmit_valid(uint16_t retransmit_delay,
+					uint16_t retransmit_count)
+{
 	return true;
 }
 
+static inline void hop_rx_apply(void) {}
+static inline void hop_init(void) {}
+static inline void hop_stop(void) {}
+#endif /* defined(CONFIG_ESB_CHANNEL_HOPPING) */
+
 static void sys_timer_init(void)
 {
 	/* Configure the system timer with a 1 MHz base frequency */
@@ -568,21 +1185,16 @@ static void ppi_init(void)
 		(uint32_t)&NRF_RADIO->TASKS_TXEN;
 }
 
-static void start_tx_transaction(void)
+/* Transmit the current payload. */
+static void start_tx_payload(void)
 {
 	bool ack;
 
-	last_tx_attempts = 1;
-	/* Prepare the payload */
-	current_payload = tx_fifo.payload[tx_fifo.front];
-
 	switch (esb_cfg.protocol) {
 	case ESB_PROTOCOL_ESB:
 		update_rf_payload_format(current_payload->length);
-		tx_payload_buffer[0] = current_payload->pid;
-		tx_payload_buffer[1] = 0;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
+		current_payload->pdu[0] = current_payload->pid;
+		current_payload->pdu[1] = 0;
 
 		NRF_RADIO->SHORTS = radio_shorts_common |
 				    RADIO_SHORTS_DISABLED_RXEN_Msk;
@@ -590,18 +1202,16 @@ static void start_tx_transaction(void)
 				      RADIO_INTENSET_READY_Msk;
 
 		/* Configure the retransmit counter */
-		retransmits_remaining = esb_cfg.retransmit_count;
+		retransmits_remaining = retransmit_count;
 		on_radio_disabled = on_radio_disabled_tx;
 		esb_state = ESB_STATE_PTX_TX_ACK;
 		break;
 
 	case ESB_PROTOCOL_ESB_DPL:
 		ack = !current_payload->noack || !esb_cfg.selective_auto_ack;
-		tx_payload_buffer[0] = current_payload->length;
-		tx_payload_buffer[1] = current_payload->pid << 1;
-		tx_payload_buffer[1] |= current_payload->noack ? 0x00 : 0x01;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
+		current_payload->pdu[0] = current_payload->length;
+		current_payload->pdu[1] = current_payload->pid << 1;
+		current_payload->pdu[1] |= current_payload->noack ? 0x00 : 0x01;
 
 		/* Handling ack if noack is set to false or if
 		 * selective auto ack is turned off
@@ -613,7 +1223,7 @@ static void start_tx_transaction(void)
 					      RADIO_INTENSET_READY_Msk;
 
 			/* Configure the retransmit counter */
-			retransmits_remaining = esb_cfg.retransmit_count;
+			retransmits_remaining = retransmit_count;
 			on_radio_disabled = on_radio_disabled_tx;
 			esb_state = ESB_STATE_PTX_TX_ACK;
 		} else {
@@ -633,7 +1243,7 @@ static void start_tx_transaction(void)
 	NRF_RADIO->RXADDRESSES = 1 << current_payload->pipe;
 	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
 
-	NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)current_payload->pdu;
 
 	NVIC_ClearPendingIRQ(RADIO_IRQn);
 	irq_enable(RADIO_IRQn);
@@ -645,12 +1255,26 @@ static void start_tx_transaction(void)
 	NRF_RADIO->TASKS_TXEN = 1;
 }
 
+static void start_tx_transaction(void)
+{
+	last_tx_attempts = 1;
+	/* Prepare the payload */
+	current_fifo = tx_fifo_next();
+	current_payload = tx_fifo_front(current_fifo);
+	retransmit_params_get(current_payload->pipe);
+	tx_start_cycles = k_cycle_get_32();
+
+	start_tx_payload();
+}
+
 static void on_radio_disabled_tx_noack(void)
 {
 	interrupt_flags |= INT_TX_SUCCESS_MSK;
-	tx_fifo_remove_last();
+	tx_complete(true);
+	tx_fifo_remove_last(current_fifo);
+	tx_discard = false;
 
-	if (tx_fifo.count == 0) {
+	if (tx_fifos_count() == 0) {
 		esb_state = ESB_STATE_IDLE;
 		NVIC_SetPendingIRQ(ESB_EVT_IRQ);
 	} else {
@@ -671,7 +1295,7 @@ static void on_radio_disabled_tx(void)
 	 * received by the time defined in wait_for_ack_timeout_us
 	 */
 	ESB_SYS_TIMER->CC[0] = wait_for_ack_timeout_us;
-	ESB_SYS_TIMER->CC[1] = esb_cfg.retransmit_delay - 130;
+	ESB_SYS_TIMER->CC[1] = retransmit_delay - TX_RAMP_UP_TIME_US;
 	ESB_SYS_TIMER->TASKS_CLEAR = 1;
 	ESB_SYS_TIMER->EVENTS_COMPARE[0] = 0;
 	ESB_SYS_TIMER->EVENTS_COMPARE[1] = 0;
@@ -688,7 +1312,7 @@ static void on_radio_disabled_tx(void)
 		update_rf_payload_format(0);
 	}
 
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_pdu_update();
 	on_radio_disabled = on_radio_disabled_tx_wait_for_ack;
 	esb_state = ESB_STATE_PTX_RX_ACK;
 }
@@ -709,21 +1333,25 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 		ESB_SYS_TIMER->TASKS_SHUTDOWN = 1;
 		NRF_PPI->CHENCLR = (1 << CONFIG_ESB_PPI_TX_START);
 		interrupt_flags |= INT_TX_SUCCESS_MSK;
-		last_tx_attempts = esb_cfg.retransmit_count -
-				   retransmits_remaining + 1;
+		last_tx_attempts = retransmit_count - retransmits_remaining + 1;
 
-		tx_fifo_remove_last();
+		stats_rssi_add(current_payload->pipe, NRF_RADIO->RSSISAMPLE);
+		stats_ack_latency_add(current_payload->pipe);
+		tx_complete(true);
+		hop_tx_complete(true, last_tx_attempts);
+		tx_fifo_remove_last(current_fifo);
+		tx_discard = false;
 
-		if (esb_cfg.protocol != ESB_PROTOCOL_ESB &&
-		    rx_payload_buffer[0] > 0) {
+		if (esb_cfg.protocol != ESB_PROTOCOL_ESB && rx_pdu[0] > 0) {
+			stats_rx_add(NRF_RADIO->TXADDRESS, false);
 			if (rx_fifo_push_rfbuf((uint8_t)NRF_RADIO->TXADDRESS,
-					       rx_payload_buffer[1] >> 1)) {
+					       rx_pdu[1] >> 1)) {
 				interrupt_flags |=
 					INT_RX_DATA_RECEIVED_MSK;
 			}
 		}
 
-		if ((tx_fifo.count == 0) ||
+		if ((tx_fifos_count() == 0) ||
 		    (esb_cfg.tx_mode == ESB_TXMODE_MANUAL)) {
 			esb_state = ESB_STATE_IDLE;
 			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
@@ -735,11 +1363,29 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 		if (retransmits_remaining-- == 0) {
 			ESB_SYS_TIMER->TASKS_SHUTDOWN = 1;
 			NRF_PPI->CHENCLR = (1 << CONFIG_ESB_PPI_TX_START);
+			last_tx_attempts = retransmit_count + 1;
+
+			if (hop_tx_complete(false, last_tx_attempts) &&
+			    !tx_discard) {
+				/* Retry the same payload on the next channel
+				 * in the hop table.
+				 */
+				stats_tx_attempts_add(current_payload->pipe,
+						      last_tx_attempts);
+				start_tx_payload();
+				return;
+			}
+
 			/* All retransmits are expended, and the TX operation is
 			 * suspended
 			 */
-			last_tx_attempts = esb_cfg.retransmit_count + 1;
 			interrupt_flags |= INT_TX_FAILED_MSK;
+			tx_complete(false);
+
+			if (tx_discard) {
+				tx_fifo_remove_last(current_fifo);
+				tx_discard = false;
+			}
 
 			esb_state = ESB_STATE_IDLE;
 			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
@@ -751,7 +1397,7 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 			NRF_RADIO->SHORTS = radio_shorts_common |
 					    RADIO_SHORTS_DISABLED_RXEN_Msk;
 			update_rf_payload_format(current_payload->length);
-			NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+			NRF_RADIO->PACKETPTR = (uint32_t)current_payload->pdu;
 			on_radio_disabled = on_radio_disabled_tx;
 			esb_state = ESB_STATE_PTX_TX_ACK;
 			ESB_SYS_TIMER->TASKS_START = 1;
@@ -767,7 +1413,7 @@ static void clear_events_restart_rx(void)
 {
 	NRF_RADIO->SHORTS = radio_shorts_common;
 	update_rf_payload_format(esb_cfg.payload_length);
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_pdu_update();
 	NRF_RADIO->EVENTS_DISABLED = 0;
 	NRF_RADIO->TASKS_DISABLE = 1;
 
@@ -775,6 +1421,8 @@ static void clear_events_restart_rx(void)
 		/* wait for register to settle */
 	}
 
+	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
+	NRF_RADIO->EVENTS_ADDRESS = 0;
 	NRF_RADIO->EVENTS_DISABLED = 0;
 	NRF_RADIO->SHORTS = radio_shorts_common |
 			    RADIO_SHORTS_DISABLED_TXEN_Msk;
@@ -782,20 +1430,19 @@ static void clear_events_restart_rx(void)
 	NRF_RADIO->TASKS_RXEN = 1;
 }
 
-static void on_radio_disabled_rx_dpl(bool retransmit_payload,
-				     struct pipe_info *pipe_info)
+static uint8_t *on_radio_disabled_rx_dpl(bool retransmit_payload,
+					 struct pipe_info *pipe_info)
 {
-	if (tx_fifo.count > 0 &&
-	    (tx_fifo.payload[tx_fifo.front]->pipe == NRF_RADIO->RXMATCH)) {
+	struct payload_tx_fifo *fifo = tx_fifo_get(NRF_RADIO->RXMATCH);
+	uint8_t *ack_pdu;
+
+	if (tx_fifo_count(fifo) > 0 &&
+	    (tx_fifo_front(fifo)->pipe == NRF_RADIO->RXMATCH)) {
 		/* Pipe stays in ACK with payload until TX FIFO is empty */
 		/* Do not report TX success on first ack payload or retransmit
 		 */
 		if (pipe_info->ack_payload && !retransmit_payload) {
-			if (++tx_fifo.front >= CONFIG_ESB_TX_FIFO_SIZE) {
-				tx_fifo.front = 0;
-			}
-
-			tx_fifo.count--;
+			tx_fifo_remove_last(fifo);
 
 			/* ACK payloads also require TX_DS */
 			/* (page 40 of the
@@ -805,20 +1452,26 @@ static void on_radio_disabled_rx_dpl(bool retransmit_payload,
 		}
 
 		pipe_info->ack_payload = true;
+	}
 
-		current_payload = tx_fifo.payload[tx_fifo.front];
+	if (tx_fifo_count(fifo) > 0 &&
+	    (tx_fifo_front(fifo)->pipe == NRF_RADIO->RXMATCH)) {
+		current_fifo = fifo;
+		current_payload = tx_fifo_front(fifo);
 
 		update_rf_payload_format(current_payload->length);
-		tx_payload_buffer[0] = current_payload->length;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
+		ack_pdu = current_payload->pdu;
+		ack_pdu[0] = current_payload->length;
 	} else {
 		pipe_info->ack_payload = false;
 		update_rf_payload_format(0);
-		tx_payload_buffer[0] = 0;
+		ack_pdu = ack_buffer;
+		ack_pdu[0] = 0;
 	}
 
-	tx_payload_buffer[1] = rx_payload_buffer[1];
+	ack_pdu[1] = rx_pdu[1];
+
+	return ack_pdu;
 }
 
 static void on_radio_disabled_rx(void)
@@ -826,75 +1479,97 @@ static void on_radio_disabled_rx(void)
 	bool retransmit_payload = false;
 	bool send_rx_event = true;
 	struct pipe_info *pipe_info;
+	uint8_t *ack_pdu;
 
 	if (NRF_RADIO->CRCSTATUS == 0) {
+		hop_rx_update(false, false);
 		clear_events_restart_rx();
 		return;
 	}
 
-	if (rx_fifo.count >= CONFIG_ESB_RX_FIFO_SIZE) {
+	if (rx_pdu == rx_discard_buffer) {
+		/* The RX FIFO was full when the packet was received */
+		hop_rx_update(true, false);
 		clear_events_restart_rx();
 		return;
 	}
 
 	pipe_info = &rx_pipe_info[NRF_RADIO->RXMATCH];
 	if (NRF_RADIO->RXCRC == pipe_info->crc &&
-	    (rx_payload_buffer[1] >> 1) == pipe_info->pid) {
+	    (rx_pdu[1] >> 1) == pipe_info->pid) {
 		retransmit_payload = true;
 		send_rx_event = false;
 	}
 
-	pipe_info->pid = rx_payload_buffer[1] >> 1;
+	pipe_info->pid = rx_pdu[1] >> 1;
 	pipe_info->crc = NRF_RADIO->RXCRC;
 
+	stats_rssi_add(NRF_RADIO->RXMATCH, NRF_RADIO->RSSISAMPLE);
+	stats_rx_add(NRF_RADIO->RXMATCH, retransmit_payload);
+	hop_rx_update(true, retransmit_payload);
+
+	if (send_rx_event) {
+		/* Push the new packet to the RX buffer and trigger a received
+		 * event if the operation was successful. This must be done
+		 * before the packet pointer is moved to the next RX slot.
+		 */
+		if (rx_fifo_push_rfbuf(NRF_RADIO->RXMATCH, pipe_info->pid)) {
+			interrupt_flags |= INT_RX_DATA_RECEIVED_MSK;
+			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
+		}
+	}
+
 	/* Check if an ack should be sent */
 	if ((esb_cfg.selective_auto_ack == false) ||
-	    ((rx_payload_buffer[1] & 0x01) == 1)) {
+	    ((rx_pdu[1] & 0x01) == 1)) {
 		NRF_RADIO->SHORTS = radio_shorts_common |
 				    RADIO_SHORTS_DISABLED_RXEN_Msk;
 
 		switch (esb_cfg.protocol) {
 		case ESB_PROTOCOL_ESB_DPL:
-			on_radio_disabled_rx_dpl(retransmit_payload, pipe_info);
+			ack_pdu = on_radio_disabled_rx_dpl(retransmit_payload,
+							   pipe_info);
 			break;
 
 		case ESB_PROTOCOL_ESB:
+		default:
 			update_rf_payload_format(0);
-			tx_payload_buffer[0] = rx_payload_buffer[0];
-			tx_payload_buffer[1] = 0;
+			ack_buffer[0] = rx_pdu[0];
+			ack_buffer[1] = 0;
+			ack_pdu = ack_buffer;
 			break;
 		}
 
 		esb_state = ESB_STATE_PRX_SEND_ACK;
 		NRF_RADIO->TXADDRESS = NRF_RADIO->RXMATCH;
 
-		NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+		NRF_RADIO->PACKETPTR = (uint32_t)ack_pdu;
 		on_radio_disabled = on_radio_disabled_rx_ack;
 	} else {
 		clear_events_restart_rx();
 	}
-
-	if (send_rx_event) {
-		/* Push the new packet to the RX buffer and trigger a received
-		 * event if the operation was
-		 * successful.
-		 */
-		if (rx_fifo_push_rfbuf(NRF_RADIO->RXMATCH, pipe_info->pid)) {
-			interrupt_flags |= INT_RX_DATA_RECEIVED_MSK;
-			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
-		}
-	}
 }
 
 static void on_radio_disabled_rx_ack(void)
 {
+	if (tx_discard) {
+		/* The ACK payload was flushed while it was being sent. */
+		tx_fifo_remove_last(current_fifo);
+		rx_pipe_info[current_payload->pipe].ack_payload = false;
+		tx_discard = false;
+	}
+
 	NRF_RADIO->SHORTS = radio_shorts_common |
 			    RADIO_SHORTS_DISABLED_TXEN_Msk;
 	update_rf_payload_format(esb_cfg.payload_length);
 
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_pdu_update();
 	on_radio_disabled = on_radio_disabled_rx;
 
+	/* The radio is back in RX, waiting for the address of the next
+	 * packet.
+	 */
+	NRF_RADIO->EVENTS_ADDRESS = 0;
 	esb_state = ESB_STATE_PRX;
 }
 
@@ -943,6 +1618,8 @@ static void RADIO_IRQHandler(void)
 			on_radio_disabled();
 		}
 	}
+
+	hop_rx_apply();
 }
 
 static void ESB_EVT_IRQHandler(void)
@@ -995,6 +1672,10 @@ int esb_init(const struct esb_config *config)
 	if (config == NULL) {
 		return -EINVAL;
 	}
+	if (!hop_retransmit_valid(config->retransmit_delay,
+				  config->retransmit_count)) {
+		return -EINVAL;
+	}
 
 	if (esb_initialized) {
 		esb_disable();
@@ -1010,6 +1691,8 @@ int esb_init(const struct esb_config *config)
 	memset(pids, 0, sizeof(pids));
 
 	update_radio_parameters();
+	retransmit_params_reset();
+	hop_init();
 
 	/* Configure radio address registers according to ESB default values */
 	NRF_RADIO->BASE0 = 0xE7E7E7E7;
@@ -1017,7 +1700,7 @@ int esb_init(const struct esb_config *config)
 	NRF_RADIO->PREFIX0 = 0x23C343E7;
 	NRF_RADIO->PREFIX1 = 0x13E363A3;
 
-	initialize_fifos();
+	reset_fifos();
 	sys_timer_init();
 	ppi_init();
 
@@ -1122,6 +1805,7 @@ void esb_disable(void)
 	esb_state = ESB_STATE_IDLE;
 	esb_initialized = false;
 
+	hop_stop();
 	reset_fifos();
 
 	memset(rx_pipe_info, 0, sizeof(rx_pipe_info));
@@ -1140,42 +1824,72 @@ bool esb_is_idle(void)
 	return (esb_state == ESB_STATE_IDLE);
 }
 
-int esb_write_payload(const struct esb_payload *payload)
+static int tx_payload_check(uint8_t pipe, uint8_t length)
+{
+	if (length == 0 || length > CONFIG_ESB_MAX_PAYLOAD_LENGTH ||
+	    (esb_cfg.protocol == ESB_PROTOCOL_ESB &&
+	     length > esb_cfg.payload_length)) {
+		return -EMSGSIZE;
+	}
+	if (pipe >= CONFIG_ESB_PIPE_COUNT) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int esb_tx_claim(uint8_t pipe, uint8_t **data)
 {
+	struct payload_tx_fifo *fifo;
+
 	if (!esb_initialized) {
 		return -EACCES;
 	}
-	if (payload == NULL) {
+	if (data == NULL || pipe >= CONFIG_ESB_PIPE_COUNT) {
 		return -EINVAL;
 	}
-	if (payload->length == 0 ||
-	    payload->length > CONFIG_ESB_MAX_PAYLOAD_LENGTH ||
-	    (esb_cfg.protocol == ESB_PROTOCOL_ESB &&
-	     payload->length > esb_cfg.payload_length)) {
-		return -EMSGSIZE;
-	}
-	if (tx_fifo.count >= CONFIG_ESB_TX_FIFO_SIZE) {
+
+	fifo = tx_fifo_get(pipe);
+	if (tx_fifo_count(fifo) >= CONFIG_ESB_TX_FIFO_SIZE) {
 		return -ENOMEM;
 	}
-	if (payload->pipe >= CONFIG_ESB_PIPE_COUNT) {
-		return -EINVAL;
-	}
 
-	uint32_t key = irq_lock();
+	*data = &tx_fifo_back(fifo)->pdu[PDU_HEADER_LEN];
 
-	memcpy(tx_fifo.payload[tx_fifo.back], payload,
-	       sizeof(struct esb_payload));
+	return 0;
+}
 
-	pids[payload->pipe] = (pids[payload->pipe] + 1) % (PID_MAX + 1);
-	tx_fifo.payload[tx_fifo.back]->pid = pids[payload->pipe];
+int esb_tx_commit(uint8_t pipe, uint8_t length, bool noack)
+{
+	struct payload_tx_fifo *fifo;
+	struct tx_slot *slot;
+	int err;
 
-	if (++tx_fifo.back >= CONFIG_ESB_TX_FIFO_SIZE) {
-		tx_fifo.back = 0;
+	if (!esb_initialized) {
+		return -EACCES;
 	}
 
-	tx_fifo.count++;
+	err = tx_payload_check(pipe, length);
+	if (err) {
+		return err;
+	}
 
-	irq_unlock(key);
+	fifo = tx_fifo_get(pipe);
+	if (tx_fifo_count(fifo) >= CONFIG_ESB_TX_FIFO_SIZE) {
+		return -ENOMEM;
+	}
+
+	slot = tx_fifo_back(fifo);
+	slot->length = length;
+	slot->pipe = pipe;
+	slot->noack = noack;
+
+	pids[pipe] = (pids[pipe] + 1) % (PID_MAX + 1);
+	slot->pid = pids[pipe];
+
+	/* The slot must be complete before it is made available. */
+	__DMB();
+	fifo->back = fifo_next(fifo->back, CONFIG_ESB_TX_FIFO_SIZE);
 
 	if (esb_cfg.mode == ESB_MODE_PTX &&
 	    esb_cfg.tx_mode == ESB_TXMODE_AUTO &&
@@ -1186,8 +1900,11 @@ int esb_write_payload(const struct esb_payload *payload)
 	return 0;
 }
 
-int esb_read_rx_payload(struct esb_payload *payload)
+int esb_write_payload(const struct esb_payload *payload)
 {
+	uint8_t *data;
+	int err;
+
 	if (!esb_initialized) {
 		return -EACCES;
 	}
@@ -1195,38 +1912,94 @@ int esb_read_rx_payload(struct esb_payload *payload)
 		return -EINVAL;
 	}
 
-	if (rx_fifo.count == 0) {
-		return -ENODATA;
+	err = tx_payload_check(payload->pipe, payload->length);
+	if (err) {
+		return err;
 	}
 
-	uint32_t key = irq_lock();
+	err = esb_tx_claim(payload->pipe, &data);
+	if (err) {
+		return err;
+	}
+
+	memcpy(data, payload->data, payload->length);
 
-	payload->length = rx_fifo.payload[rx_fifo.front]->length;
-	payload->pipe = rx_fifo.payload[rx_fifo.front]->pipe;
-	payload->rssi = rx_fifo.payload[rx_fifo.front]->rssi;
-	payload->pid = rx_fifo.payload[rx_fifo.front]->pid;
-	payload->noack = rx_fifo.payload[rx_fifo.front]->noack;
-	memcpy(payload->data, rx_fifo.payload[rx_fifo.front]->data,
-	       payload->length);
+	return esb_tx_commit(payload->pipe, payload->length, payload->noack);
+}
+
+int esb_rx_claim(struct esb_payload_ref *payload)
+{
+	struct rx_slot *slot;
 
-	if (++rx_fifo.front >= CONFIG_ESB_RX_FIFO_SIZE) {
-		rx_fifo.front = 0;
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+	if (payload == NULL) {
+		return -EINVAL;
+	}
+	if (rx_fifo_count() == 0) {
+		return -ENODATA;
 	}
 
-	rx_fifo.count--;
+	/* Do not read the slot before it has been made available. */
+	__DMB();
+	slot = rx_fifo_front();
 
-	irq_unlock(key);
+	payload->data = &slot->pdu[PDU_HEADER_LEN];
+	payload->length = slot->length;
+	payload->pipe = slot->pipe;
+	payload->rssi = slot->rssi;
+	payload->pid = slot->pid;
+	payload->noack = slot->noack;
+
+	return 0;
+}
+
+int esb_rx_commit(void)
+{
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+	if (rx_fifo_count() == 0) {
+		return -ENODATA;
+	}
+
+	rx_fifo.front = fifo_next(rx_fifo.front, CONFIG_ESB_RX_FIFO_SIZE);
 
 	return 0;
 }
 
+int esb_read_rx_payload(struct esb_payload *payload)
+{
+	struct esb_payload_ref ref;
+	int err;
+
+	if (payload == NULL) {
+		return -EINVAL;
+	}
+
+	err = esb_rx_claim(&ref);
+	if (err) {
+		return err;
+	}
+
+	payload->length = ref.length;
+	payload->pipe = ref.pipe;
+	payload->rssi = ref.rssi;
+	payload->pid = ref.pid;
+	payload->noack = ref.noack;
+	memcpy(payload->data, ref.data, ref.length);
+
+	return esb_rx_commit();
+}
+
 int esb_start_tx(void)
 {
 	if (esb_state != ESB_STATE_IDLE) {
 		return -EBUSY;
 	}
 
-	if (tx_fifo.count == 0) {
+	if (tx_fifos_count() == 0) {
 		return -ENODATA;
 	}
 
@@ -1252,7 +2025,7 @@ int esb_start_rx(void)
 
 	NRF_RADIO->RXADDRESSES = esb_addr.rx_pipes_enabled;
 	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_pdu_update();
 
 	NVIC_ClearPendingIRQ(RADIO_IRQn);
 	irq_enable(RADIO_IRQn);
@@ -1272,6 +2045,8 @@ int esb_stop_rx(void)
 		return -EINVAL;
 	}
 
+	hop_stop();
+
 	NRF_RADIO->SHORTS = 0;
 	NRF_RADIO->INTENCLR = 0xFFFFFFFF;
 	on_radio_disabled = NULL;
@@ -1294,9 +2069,20 @@ int esb_flush_tx(void)
 
 	uint32_t key = irq_lock();
 
-	tx_fifo.count = 0;
-	tx_fifo.back = 0;
-	tx_fifo.front = 0;
+	for (size_t i = 0; i < TX_FIFO_NUM; i++) {
+		struct payload_tx_fifo *fifo = &tx_fifos[i];
+
+		if (fifo == current_fifo && tx_in_flight()) {
+			/* Keep the slot the radio transmits from until the
+			 * transmission ends.
+			 */
+			fifo->back = fifo_next(fifo->front,
+					       CONFIG_ESB_TX_FIFO_SIZE);
+			tx_discard = true;
+		} else {
+			fifo->front = fifo->back;
+		}
+	}
 
 	irq_unlock(key);
 
@@ -1308,16 +2094,29 @@ int esb_pop_tx(void)
 	if (!esb_initialized) {
 		return -EACCES;
 	}
-	if (tx_fifo.count == 0) {
-		return -ENODATA;
-	}
 
+	struct payload_tx_fifo *fifo;
 	uint32_t key = irq_lock();
 
-	if (++tx_fifo.back >= CONFIG_ESB_TX_FIFO_SIZE) {
-		tx_fifo.back = 0;
+	if (tx_in_flight()) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
+
+	/* Pop from the FIFO of the last transmission, which holds the payload
+	 * that failed, or else from the FIFO that is to be transmitted next.
+	 */
+	fifo = current_fifo;
+	if (!fifo || tx_fifo_count(fifo) == 0) {
+		fifo = tx_fifo_next();
+	}
+
+	if (!fifo) {
+		irq_unlock(key);
+		return -ENODATA;
 	}
-	tx_fifo.count--;
+
+	tx_fifo_remove_last(fifo);
 
 	irq_unlock(key);
 
@@ -1332,9 +2131,10 @@ int esb_flush_rx(void)
 
 	uint32_t key = irq_lock();
 
-	rx_fifo.count = 0;
-	rx_fifo.back = 0;
-	rx_fifo.front = 0;
+	/* Only the consumer index is moved, the radio may be receiving into
+	 * the back of the FIFO.
+	 */
+	rx_fifo.front = rx_fifo.back;
 
 	memset(rx_pipe_info, 0, sizeof(rx_pipe_info));
 
@@ -1671,14 +2471,43 @@ int esb_set_rf_channel(uint32_t channel)
 	if (esb_state != ESB_STATE_IDLE) {
 		return -EBUSY;
 	}
-	if (channel > 100) {
+	if (channel > RF_CHANNEL_MAX) {
 		return -EINVAL;
 	}
 
 	esb_addr.rf_channel = channel;
+	hop_table_set(NULL, 0);
+
+	return 0;
+}
+
+#if defined(CONFIG_ESB_CHANNEL_HOPPING)
+int esb_set_hopping_channels(const uint8_t *channels, uint8_t count)
+{
+	if (esb_state != ESB_STATE_IDLE) {
+		return -EBUSY;
+	}
+	if ((channels == NULL && count > 0) ||
+	    count > CONFIG_ESB_CHANNEL_HOPPING_TABLE_SIZE) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (channels[i] > RF_CHANNEL_MAX) {
+			return -EINVAL;
+		}
+	}
+
+	if (!hop_params_valid(count, esb_cfg.retransmit_delay,
+			      esb_cfg.retransmit_count)) {
+		return -EINVAL;
+	}
+
+	hop_table_set(channels, count);
 
 	return 0;
 }
+#endif /* defined(CONFIG_ESB_CHANNEL_HOPPING) */
 
 int esb_get_rf_channel(uint32_t *channel)
 {
@@ -1713,8 +2542,12 @@ int esb_set_retransmit_delay(uint16_t delay)
 	if (delay < RETRANSMIT_DELAY_MIN) {
 		return -EINVAL;
 	}
+	if (!hop_retransmit_valid(delay, esb_cfg.retransmit_count)) {
+		return -EINVAL;
+	}
 
 	esb_cfg.retransmit_delay = delay;
+	retransmit_params_reset();
 
 	return 0;
 }
@@ -1724,8 +2557,12 @@ int esb_set_retransmit_count(uint16_t count)
 	if (esb_state != ESB_STATE_IDLE) {
 		return -EBUSY;
 	}
+	if (!hop_retransmit_valid(esb_cfg.retransmit_delay, count)) {
+		return -EINVAL;
+	}
 
 	esb_cfg.retransmit_count = count;
+	retransmit_params_reset();
 
 	return 0;
 }
@@ -1754,3 +2591,29 @@ int esb_reuse_pid(uint8_t pipe)
 
 	return 0;
 }
+
+#if defined(CONFIG_ESB_PIPE_STATS)
+int esb_pipe_stats_get(uint8_t pipe, struct esb_pipe_stats *stats)
+{
+	if (stats == NULL || pipe >= CONFIG_ESB_PIPE_COUNT) {
+		return -EINVAL;
+	}
+
+	uint32_t key = irq_lock();
+
+	memcpy(stats, &pipe_stats[pipe], sizeof(*stats));
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+void esb_pipe_stats_reset(void)
+{
+	uint32_t key = irq_lock();
+
+	memset(pipe_stats, 0, sizeof(pipe_stats));
+
+	irq_unlock(key);
+}
+#endif /* defined(CONFIG_ESB_PIPE_STATS) */
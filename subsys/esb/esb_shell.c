@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdlib.h>
+#include <shell/shell.h>
+#include <esb.h>
+
+static void stats_print(const struct shell *shell, uint8_t pipe)
+{
+	struct esb_pipe_stats stats;
+	int err;
+
+	err = esb_pipe_stats_get(pipe, &stats);
+	if (err) {
+		shell_error(shell, "Failed to get stats (err:%d)", err);
+		return;
+	}
+
+	shell_print(shell, "Pipe %u:", pipe);
+	shell_print(shell, "  TX success:%u failed:%u attempts:%u",
+		    stats.tx_success, stats.tx_failed, stats.tx_attempts);
+	shell_print(shell, "  RX packets:%u retransmits:%u",
+		    stats.rx_packets, stats.rx_retransmits);
+	shell_print(shell, "  ACK latency avg:%u us max:%u us",
+		    stats.ack_latency_avg_us, stats.ack_latency_max_us);
+
+	for (size_t i = 0; i < ESB_PIPE_STATS_RSSI_BINS; i++) {
+		if (stats.rssi_hist[i] == 0) {
+			continue;
+		}
+
+		shell_print(shell, "  RSSI -%u dBm:%u",
+			    (unsigned int)(i * ESB_PIPE_STATS_RSSI_BIN_WIDTH),
+			    stats.rssi_hist[i]);
+	}
+}
+
+static int cmd_esb_stats(const struct shell *shell, size_t argc, char **argv)
+{
+	if (argc > 1) {
+		unsigned long pipe = strtoul(argv[1], NULL, 0);
+
+		if (pipe >= CONFIG_ESB_PIPE_COUNT) {
+			shell_error(shell, "Invalid pipe: %s", argv[1]);
+			return -EINVAL;
+		}
+
+		stats_print(shell, pipe);
+		return 0;
+	}
+
+	for (uint8_t pipe = 0; pipe < CONFIG_ESB_PIPE_COUNT; pipe++) {
+		stats_print(shell, pipe);
+	}
+
+	return 0;
+}
+
+static int cmd_esb_stats_reset(const struct shell *shell, size_t argc,
+			       char **argv)
+{
+	esb_pipe_stats_reset();
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_cmd_esb,
+	SHELL_CMD_ARG(stats, NULL, "Print link statistics [pipe]",
+		      cmd_esb_stats, 1, 1),
+	SHELL_CMD_ARG(stats_reset, NULL, "Reset link statistics",
+		      cmd_esb_stats_reset, 1, 0),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(esb, &sub_cmd_esb, "Enhanced ShockBurst commands", NULL);
@@ -5,7 +5,10 @@
  */
 #include <logging/log.h>
 #include <zephyr.h>
+#include <ctype.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <net/socket.h>
 #include <net/tls_credentials.h>
@@ -20,8 +23,9 @@ LOG_MODULE_REGISTER(ftp_client, CONFIG_FTP_CLIENT_LOG_LEVEL);
 #define FTP_MAX_HOSTNAME	64
 #define FTP_MAX_USERNAME	32
 #define FTP_MAX_PASSWORD	32
+#define FTP_MAX_CMD_LEN		256
 
-#define FTP_CODE_ANY		0
+#define FTP_PIPELINE_DEPTH	CONFIG_FTP_CLIENT_PIPELINE_DEPTH
 
 #define FTP_STACK_SIZE		KB(2)
 #define FTP_PRIORITY		K_LOWEST_APPLICATION_THREAD_PRIO
@@ -37,65 +41,98 @@ static struct ftp_client {
 } client;
 
 static struct k_work_q ftp_work_q;
-static char ctrl_buf[NET_IPV4_MTU];
-static K_SEM_DEFINE(tx_done, 0, 1);
 
-enum data_task_type {
-	TASK_SEND,
-	TASK_RECEIVE
+/* Which replies to a command are posted to the control callback */
+enum ctrl_post {
+	POST_NONE,
+	POST_FINAL,
+	POST_ALL
 };
 
-static struct data_task {
-	struct k_work work;
-	enum data_task_type task;
-	char *ctrl_msg;		/* PSAV resposne */
-	uint8_t *data;		/* TX data */
-	uint16_t length;	/* TX length */
-} data_task_param;
+/* Replies are matched to commands in the order the commands were sent, so
+ * a command can be sent before the replies to earlier ones are received,
+ * for instance while a data transfer is in progress.
+ */
+static struct {
+	uint32_t sent;	/* Commands sent */
+	uint32_t done;	/* Final replies received */
+	enum ctrl_post post[FTP_PIPELINE_DEPTH];
+	int code[FTP_PIPELINE_DEPTH];
+	size_t value[FTP_PIPELINE_DEPTH]; /* Port of 227, size of 213 */
+} pipeline;
+
+static K_MUTEX_DEFINE(ctrl_tx_lock);
+static K_MUTEX_DEFINE(ctrl_rx_lock);
+
+/* Control channel input, reassembled into complete replies */
+static struct {
+	char buf[NET_IPV4_MTU];
+	size_t len;	/* Octets in the buffer */
+	size_t pos;	/* End of the lines already parsed */
+	int code;	/* Code of a multi-line reply in progress */
+} ctrl_rx;
+static char ctrl_buf[NET_IPV4_MTU + 1];
+
+/* One data transfer at a time */
+static K_MUTEX_DEFINE(data_lock);
+static uint8_t data_buf[CONFIG_FTP_CLIENT_DATA_BUF_SIZE];
+
+static uint16_t parse_pasv_port(const char *msg)
+{
+	unsigned long val[6];
+	const char *ptr = msg + 3;
+	char *end;
+
+	/* Parse Server port from passive message
+	 * e.g. "227 Entering Passive Mode (90,130,70,73,86,111)"
+	 */
+	while (*ptr != '\0' && !isdigit((unsigned char)*ptr)) {
+		ptr++;
+	}
+	for (int i = 0; i < ARRAY_SIZE(val); i++) {
+		val[i] = strtoul(ptr, &end, 10);
+		if (end == ptr || val[i] > UINT8_MAX) {
+			LOG_ERR("Invalid PASV reply");
+			return 0;
+		}
+		ptr = end + 1;
+	}
+
+	return (val[4] << 8) | val[5];
+}
 
-static int parse_return_code(const uint8_t *message, int success_code)
+static int reply_code(const char *line, size_t len)
 {
-	char code_str[6]; /* max 1xxxx*/
-	int ret = FTP_CODE_500;
+	if (len < 4 ||
+	    !isdigit((unsigned char)line[0]) ||
+	    !isdigit((unsigned char)line[1]) ||
+	    !isdigit((unsigned char)line[2])) {
+		return 0;
+	}
 
-	sprintf(code_str, "%d ", success_code);
-	if (strstr(message, code_str)) {
-		ret = success_code;
+	return (line[0] - '0') * 100 + (line[1] - '0') * 10 + (line[2] - '0');
+}
+
+static size_t reply_value(int code)
+{
+	if (code == FTP_CODE_227) {
+		return parse_pasv_port(ctrl_buf);
+	} else if (code == FTP_CODE_213) {
+		return strtoul(ctrl_buf + 4, NULL, 10);
 	}
 
-	return ret;
+	return 0;
 }
 
-static int establish_data_channel(const char *pasv_msg)
+static int establish_data_channel(uint16_t data_port)
 {
 	int ret;
-	char tmp[16];
-	char *tmp1, *tmp2;
-	uint16_t data_port;
 	int data_sock;
+	struct sockaddr_in remote = client.remote;
 
-	/* Parse Server port from passive message
-	 * e.g. "227 Entering Passive Mode (90,130,70,73,86,111)"
-	 */
-	tmp1 = strstr(pasv_msg, "(");
-	tmp1++;
-	tmp2 = strstr(tmp1, ",");
-	tmp2++;
-	tmp1 = strstr(tmp2, ",");
-	tmp1++;
-	tmp2 = strstr(tmp1, ",");
-	tmp2++;
-	tmp1 = strstr(tmp2, ",");
-	tmp1++;
-	tmp2 = strstr(tmp1, ",");
-	memset(tmp, 0x00, 16);
-	strncpy(tmp, (const char *)tmp1, (size_t)(tmp2 - tmp1));
-	data_port = atoi(tmp) << 8;
-	tmp2++;
-	tmp1 = strstr(tmp2, ")");
-	memset(tmp, 0x00, 16);
-	strncpy(tmp, (const char *)tmp2, (size_t)(tmp1 - tmp2));
-	data_port += atoi(tmp);
+	if (data_port == 0) {
+		return -EBADMSG;
+	}
 
 	/* Establish the second connect for data */
 	if (client.sec_tag <= 0) {
@@ -105,7 +142,7 @@ static int establish_data_channel(const char *pasv_msg)
 	}
 	if (data_sock < 0) {
 		LOG_ERR("socket(data) failed: %d", -errno);
-		ret = -errno;
+		return -errno;
 	}
 
 	if (client.sec_tag > 0) {
@@ -120,8 +157,8 @@ static int establish_data_channel(const char *pasv_msg)
 		}
 
 	}
-	client.remote.sin_port = htons(data_port);
-	ret = connect(data_sock, (struct sockaddr *)&client.remote,
+	remote.sin_port = htons(data_port);
+	ret = connect(data_sock, (struct sockaddr *)&remote,
 		 sizeof(struct sockaddr_in));
 	if (ret < 0) {
 		LOG_ERR("connect(data) failed: %d", -errno);
@@ -136,7 +173,7 @@ static int establish_data_channel(const char *pasv_msg)
  */
 static int do_ftp_send_ctrl(const uint8_t *message, int length)
 {
-	int ret;
+	int ret = 0;
 	uint32_t offset = 0;
 
 	LOG_HEXDUMP_DBG(message, length, "TXC");
@@ -156,92 +193,293 @@ static int do_ftp_send_ctrl(const uint8_t *message, int length)
 	return ret;
 }
 
-/**@brief Send FTP data via socket
+/**@brief Receive more of the FTP control channel from socket
  */
-static int do_ftp_send_data(const char *pasv_msg, uint8_t *message, uint16_t length)
+static int do_ftp_recv_ctrl(void)
 {
-	int data_sock;
 	int ret;
-	uint32_t offset = 0;
+	struct pollfd fds[1];
 
-	/* Establish data channel */
-	ret = establish_data_channel(pasv_msg);
+	fds[0].fd = client.sock;
+	fds[0].events = POLLIN;
+	ret = poll(fds, 1, MSEC_PER_SEC * CONFIG_FTP_CLIENT_LISTEN_TIME);
+	if (ret <= 0) {
+		LOG_ERR("poll(ctrl) failed: (%d)", -errno);
+		return -ETIMEDOUT;
+	}
+	ret = recv(client.sock, ctrl_rx.buf + ctrl_rx.len,
+		   sizeof(ctrl_rx.buf) - ctrl_rx.len, 0);
 	if (ret < 0) {
-		return ret;
+		LOG_ERR("recv(ctrl) failed: (%d)", -errno);
+		return -errno;
+	}
+	if (ret == 0) {
+		/* Server close connection */
+		return -ECONNRESET;
 	}
 
-	LOG_HEXDUMP_DBG(message, length, "TXD");
+	LOG_HEXDUMP_DBG(ctrl_rx.buf + ctrl_rx.len, ret, "RXC");
+	ctrl_rx.len += ret;
 
-	data_sock = ret;
-	while (offset < length) {
-		ret = send(data_sock, message + offset, length - offset, 0);
-		if (ret < 0) {
-			LOG_ERR("send(data) failed: %d", -errno);
-			ret = -errno;
+	return 0;
+}
+
+/**@brief Remove parsed input, passing it on to the control callback
+ */
+static void ctrl_take(enum ctrl_post post, int code, size_t len)
+{
+	memcpy(ctrl_buf, ctrl_rx.buf, len);
+	ctrl_buf[len] = '\0';
+
+	ctrl_rx.len -= len;
+	memmove(ctrl_rx.buf, ctrl_rx.buf + len, ctrl_rx.len);
+	ctrl_rx.pos = 0;
+
+	if (post == POST_ALL ||
+	    (post == POST_FINAL && !FTP_PRELIMINARY_POS(code))) {
+		client.ctrl_callback(ctrl_buf, len);
+	}
+}
+
+/**@brief Find the end of the first reply in the control channel input
+ *
+ * @retval Code of the reply, or 0 if the reply is not complete.
+ */
+static int ctrl_parse(void)
+{
+	while (ctrl_rx.pos < ctrl_rx.len) {
+		char *line = ctrl_rx.buf + ctrl_rx.pos;
+		char *end = memchr(line, '\n', ctrl_rx.len - ctrl_rx.pos);
+		size_t len;
+		int code;
+
+		if (end == NULL) {
 			break;
 		}
-		offset += ret;
-		ret = 0;
+		len = end - line + 1;
+		code = reply_code(line, len);
+		ctrl_rx.pos += len;
+
+		if (ctrl_rx.code == 0) {
+			if (code == 0) {
+				LOG_WRN("Unexpected reply line dropped");
+				ctrl_take(POST_NONE, 0, ctrl_rx.pos);
+			} else if (line[3] == '-') {
+				/* First line of a multi-line reply */
+				ctrl_rx.code = code;
+			} else {
+				return code;
+			}
+		} else if (code == ctrl_rx.code && line[3] != '-') {
+			/* Last line of a multi-line reply */
+			ctrl_rx.code = 0;
+			return code;
+		}
 	}
 
-	LOG_DBG("DATA sent");
-	close(data_sock);
-	return ret;
+	return 0;
 }
 
-/**@brief Receive FTP message from socket
+/**@brief Receive one complete reply
+ *
+ * Replies may be split across segments, and several replies may arrive in
+ * one segment.
  */
-static int do_ftp_recv_ctrl(bool post_result, int success_code)
+static int ctrl_read(enum ctrl_post post)
 {
 	int ret;
-	struct pollfd fds[1];
 
-	/* Receive FTP control message */
-	fds[0].fd = client.sock;
-	fds[0].events = POLLIN;
-	ret = poll(fds, 1, MSEC_PER_SEC * CONFIG_FTP_CLIENT_LISTEN_TIME);
-	if (ret <= 0) {
-		LOG_ERR("poll(ctrl) failed: (%d)", -errno);
-		return -ETIMEDOUT;
+	while (true) {
+		ret = ctrl_parse();
+		if (ret > 0) {
+			ctrl_take(post, ret, ctrl_rx.pos);
+			break;
+		}
+
+		if (ctrl_rx.len == sizeof(ctrl_rx.buf)) {
+			if (ctrl_rx.pos > 0) {
+				/* Pass on the lines of a long reply so far */
+				ctrl_take(post, ctrl_rx.code, ctrl_rx.pos);
+			} else {
+				LOG_WRN("Reply line too long, dropped");
+				ctrl_rx.len = 0;
+			}
+		}
+
+		ret = do_ftp_recv_ctrl();
+		if (ret) {
+			break;
+		}
 	}
-	ret = recv(client.sock, ctrl_buf, sizeof(ctrl_buf), 0);
-	if (ret < 0) {
-		LOG_ERR("recv(ctrl) failed: (%d)", -errno);
-		return -errno;
+
+	return ret;
+}
+
+static int ctrl_vsend(enum ctrl_post post, uint32_t *ticket,
+		      const char *fmt, va_list args)
+{
+	char cmd[FTP_MAX_CMD_LEN];
+	int len;
+	int ret;
+
+	len = vsnprintf(cmd, sizeof(cmd), fmt, args);
+	if (len < 0 || len >= sizeof(cmd)) {
+		return -EINVAL;
 	}
-	if (ret == 0) {
-		/* Server close connection */
-		return -ECONNRESET;
+
+	k_mutex_lock(&ctrl_tx_lock, K_FOREVER);
+
+	if (pipeline.sent - pipeline.done >= FTP_PIPELINE_DEPTH) {
+		LOG_ERR("Too many commands in progress");
+		ret = -EBUSY;
+	} else {
+		pipeline.post[pipeline.sent % FTP_PIPELINE_DEPTH] = post;
+		ret = do_ftp_send_ctrl(cmd, len);
+		if (ret == 0) {
+			*ticket = pipeline.sent++;
+		}
 	}
 
-	ctrl_buf[ret] = 0x00;
-	LOG_HEXDUMP_DBG(ctrl_buf, ret, "RXC");
+	k_mutex_unlock(&ctrl_tx_lock);
+
+	return ret;
+}
+
+/**@brief Send a command without waiting for the reply
+ *
+ * @param post Replies to post to the control callback
+ * @param ticket Ticket for @ref ctrl_reply
+ * @param fmt Command format, followed by the arguments
+ */
+static int ctrl_send(enum ctrl_post post, uint32_t *ticket,
+		     const char *fmt, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, fmt);
+	ret = ctrl_vsend(post, ticket, fmt, args);
+	va_end(args);
+
+	return ret;
+}
 
-	if (post_result) {
-		client.ctrl_callback(ctrl_buf, ret);
+/**@brief Wait for the final reply to a command
+ *
+ * Replies to the commands sent before are received first, whichever
+ * thread is waiting for them.
+ *
+ * @param ticket Ticket from @ref ctrl_send
+ * @param value Value carried by the reply, can be NULL
+ *
+ * @retval ftp_return_code or negative if error
+ */
+static int ctrl_reply(uint32_t ticket, size_t *value)
+{
+	uint32_t slot;
+	int ret = 0;
+
+	k_mutex_lock(&ctrl_rx_lock, K_FOREVER);
+
+	while ((int32_t)(ticket - pipeline.done) >= 0) {
+		slot = pipeline.done % FTP_PIPELINE_DEPTH;
+		ret = ctrl_read(pipeline.post[slot]);
+		if (ret < 0) {
+			goto out;
+		}
+		if (FTP_PRELIMINARY_POS(ret)) {
+			continue;
+		}
+		pipeline.code[slot] = ret;
+		pipeline.value[slot] = reply_value(ret);
+		pipeline.done++;
 	}
 
-	LOG_DBG("CTRL received");
-	return parse_return_code(ctrl_buf, success_code);
+	slot = ticket % FTP_PIPELINE_DEPTH;
+	ret = pipeline.code[slot];
+	if (value) {
+		*value = pipeline.value[slot];
+	}
+
+out:
+	k_mutex_unlock(&ctrl_rx_lock);
+
+	return ret;
 }
 
-/**@brief Receive FTP data from socket
+/**@brief Send a command and wait for the final reply
  */
-static void do_ftp_recv_data(const char *pasv_msg)
+static int ctrl_cmd(const char *fmt, ...)
 {
+	uint32_t ticket;
+	va_list args;
 	int ret;
-	int data_sock;
-	struct pollfd fds[1];
-	char data_buf[NET_IPV4_MTU];
 
-	/* Establish data channel */
-	ret = establish_data_channel(pasv_msg);
+	va_start(args, fmt);
+	ret = ctrl_vsend(POST_ALL, &ticket, fmt, args);
+	va_end(args);
+	if (ret) {
+		return ret;
+	}
+
+	return ctrl_reply(ticket, NULL);
+}
+
+/**@brief Reset the control channel for a new connection
+ *
+ * The server greeting is handled as the reply to command 0.
+ */
+static void ctrl_reset(void)
+{
+	k_mutex_lock(&ctrl_tx_lock, K_FOREVER);
+	k_mutex_lock(&ctrl_rx_lock, K_FOREVER);
+
+	ctrl_rx.len = 0;
+	ctrl_rx.pos = 0;
+	ctrl_rx.code = 0;
+	pipeline.done = 0;
+	pipeline.post[0] = POST_ALL;
+	pipeline.sent = 1;
+
+	k_mutex_unlock(&ctrl_rx_lock);
+	k_mutex_unlock(&ctrl_tx_lock);
+}
+
+/**@brief Open a passive mode data connection
+ */
+static int data_open(int *data_sock)
+{
+	uint32_t ticket;
+	size_t port;
+	int ret;
+
+	/* Always set Passive mode to act as TCP client */
+	ret = ctrl_send(POST_ALL, &ticket, CMD_PASV);
+	if (ret) {
+		return -EIO;
+	}
+	ret = ctrl_reply(ticket, &port);
+	if (ret != FTP_CODE_227) {
+		return ret;
+	}
+
+	ret = establish_data_channel(port);
 	if (ret < 0) {
-		return;
+		return ret;
 	}
+	*data_sock = ret;
+
+	return 0;
+}
+
+/**@brief Receive FTP data from socket
+ */
+static int do_ftp_recv_data(int data_sock, size_t *offset,
+			    ftp_client_consumer_t consumer, void *user_data)
+{
+	int ret;
+	struct pollfd fds[1];
 
-	/* Receive FTP data message */
-	data_sock = ret;
 	fds[0].fd = data_sock;
 	fds[0].events = POLLIN;
 	do {
@@ -249,7 +487,7 @@ static void do_ftp_recv_data(const char *pasv_msg)
 			MSEC_PER_SEC * CONFIG_FTP_CLIENT_LISTEN_TIME);
 		if (ret <= 0) {
 			LOG_ERR("poll(data) failed: (%d)", -errno);
-			break;
+			return -ETIMEDOUT;
 		}
 		if ((fds[0].revents & POLLIN) != POLLIN) {
 			LOG_INF("No more data");
@@ -258,7 +496,7 @@ static void do_ftp_recv_data(const char *pasv_msg)
 		ret = recv(data_sock, data_buf, sizeof(data_buf), 0);
 		if (ret < 0) {
 			LOG_ERR("recv(data) failed: (%d)", -errno);
-			break;
+			return -errno;
 		}
 		if (ret == 0) {
 			/* Server close connection */
@@ -266,36 +504,160 @@ static void do_ftp_recv_data(const char *pasv_msg)
 		}
 
 		LOG_HEXDUMP_DBG(data_buf, ret, "RXD");
-		client.data_callback(data_buf, ret);
+		*offset += ret;
+		ret = consumer(*offset - ret, data_buf, ret, user_data);
+		if (ret < 0) {
+			return ret;
+		}
 	} while (true);
 
-	close(data_sock);
 	LOG_DBG("DATA received");
+	return 0;
+}
+
+/**@brief Send FTP data via socket
+ */
+static int do_ftp_send_data(int data_sock, size_t *offset,
+			    ftp_client_producer_t producer, void *user_data)
+{
+	int ret;
+	int length;
+	int sent;
+
+	do {
+		length = producer(*offset, data_buf, sizeof(data_buf),
+				  user_data);
+		if (length <= 0) {
+			break;
+		}
+		length = MIN(length, (int)sizeof(data_buf));
+
+		LOG_HEXDUMP_DBG(data_buf, length, "TXD");
+
+		for (sent = 0; sent < length; sent += ret) {
+			ret = send(data_sock, data_buf + sent, length - sent, 0);
+			if (ret < 0) {
+				LOG_ERR("send(data) failed: %d", -errno);
+				return -errno;
+			}
+		}
+		*offset += length;
+	} while (true);
+
+	LOG_DBG("DATA sent");
+	return length;
 }
 
-static void data_task(struct k_work *item)
+/**@brief Receive the result of a data command, see @ref ftp_get_stream
+ */
+static int data_get(enum ctrl_post post, size_t *offset,
+		    ftp_client_consumer_t consumer, void *user_data,
+		    const char *fmt, ...)
 {
-	struct data_task *task_param =
-		CONTAINER_OF(item, struct data_task, work);
+	uint32_t rest;
+	uint32_t ticket;
+	va_list args;
+	int data_sock;
+	int ret;
+	int err;
+
+	k_mutex_lock(&data_lock, K_FOREVER);
+
+	ret = data_open(&data_sock);
+	if (ret) {
+		goto unlock;
+	}
+
+	/* REST only affects the next command, so the transfer command is
+	 * sent right after it. If REST is refused, the server would send
+	 * from the beginning: the data connection is closed unread and the
+	 * REST reply is returned.
+	 */
+	if (*offset > 0) {
+		ret = ctrl_send(POST_ALL, &rest, CMD_REST,
+				(unsigned int)*offset);
+		if (ret) {
+			goto close;
+		}
+	}
+	va_start(args, fmt);
+	ret = ctrl_vsend(post, &ticket, fmt, args);
+	va_end(args);
+	if (ret) {
+		goto close;
+	}
+	if (*offset > 0) {
+		ret = ctrl_reply(rest, NULL);
+		if (ret != FTP_CODE_350) {
+			close(data_sock);
+			(void)ctrl_reply(ticket, NULL);
+			goto unlock;
+		}
+	}
+
+	err = do_ftp_recv_data(data_sock, offset, consumer, user_data);
+	close(data_sock);
 
-	if (task_param->task == TASK_RECEIVE) {
-		do_ftp_recv_data(task_param->ctrl_msg);
-	} else if (task_param->task == TASK_SEND) {
-		do_ftp_send_data(task_param->ctrl_msg,
-				task_param->data,
-				task_param->length);
-		k_sem_give(&tx_done);
+	/* The final reply follows the end of the data */
+	ret = ctrl_reply(ticket, NULL);
+	if (err) {
+		ret = err;
 	}
+	goto unlock;
+
+close:
+	close(data_sock);
+unlock:
+	k_mutex_unlock(&data_lock);
+
+	return ret;
+}
+
+static int data_callback_consumer(size_t offset, const uint8_t *data,
+				  size_t len, void *user_data)
+{
+	ARG_UNUSED(offset);
+	ARG_UNUSED(user_data);
+
+	client.data_callback(data, len);
+
+	return 0;
+}
+
+struct put_buf {
+	const uint8_t *data;
+	size_t length;
+};
+
+static int put_buf_producer(size_t offset, uint8_t *buf, size_t size,
+			    void *user_data)
+{
+	const struct put_buf *put = user_data;
+	size_t len = MIN(size, put->length - offset);
+
+	if (len > 0) {
+		memcpy(buf, put->data + offset, len);
+	}
+
+	return len;
 }
 
 static void keepalive_handler(struct k_work *work)
 {
+	uint32_t ticket;
 	int ret;
 
-	ret = do_ftp_send_ctrl(CMD_NOOP, sizeof(CMD_NOOP) - 1);
+	/* A data transfer keeps the connection alive */
+	if (k_mutex_lock(&data_lock, K_NO_WAIT)) {
+		return;
+	}
+
+	ret = ctrl_send(POST_NONE, &ticket, CMD_NOOP);
 	if (ret == 0) {
-		(void)do_ftp_recv_ctrl(false, FTP_CODE_200);
+		(void)ctrl_reply(ticket, NULL);
 	}
+
+	k_mutex_unlock(&data_lock);
 }
 
 K_WORK_DEFINE(keepalive_work, keepalive_handler);
@@ -329,7 +691,7 @@ int ftp_open(const char *hostname, uint16_t port, int sec_tag)
 	}
 	if (client.sock < 0) {
 		LOG_ERR("socket(ctrl) failed: %d", -errno);
-		ret = -errno;
+		return -errno;
 	}
 
 	if (sec_tag > 0) {
@@ -368,20 +730,15 @@ int ftp_open(const char *hostname, uint16_t port, int sec_tag)
 	freeaddrinfo(result);
 
 	/* Receive server greeting */
-	ret = do_ftp_recv_ctrl(true, FTP_CODE_220);
+	ctrl_reset();
+	ret = ctrl_reply(0, NULL);
 	if (ret != FTP_CODE_220) {
 		close(client.sock);
 		return ret;
 	}
 
 	/* Send UTF8 option */
-	sprintf(ctrl_buf, CMD_OPTS, "UTF8 ON");
-	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-	if (ret) {
-		close(client.sock);
-		return ret;
-	}
-	ret = do_ftp_recv_ctrl(true, FTP_CODE_200);
+	ret = ctrl_cmd(CMD_OPTS, "UTF8 ON");
 	if (ret != FTP_CODE_200) {
 		close(client.sock);
 		return ret;
@@ -397,20 +754,10 @@ int ftp_login(const char *username, const char *password)
 	int keepalive_time = CONFIG_FTP_CLIENT_KEEPALIVE_TIME;
 
 	/* send username */
-	sprintf(ctrl_buf, CMD_USER, username);
-	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-	if (ret) {
-		return ret;
-	}
-	ret = do_ftp_recv_ctrl(true, FTP_CODE_331);
+	ret = ctrl_cmd(CMD_USER, username);
 	if (ret == FTP_CODE_331) {
 		/* send password if requested */
-		sprintf(ctrl_buf, CMD_PASS, password);
-		ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-		if (ret) {
-			return ret;
-		}
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_230);
+		ret = ctrl_cmd(CMD_PASS, password);
 	}
 	if (ret != FTP_CODE_230) {
 		return ret;
@@ -431,14 +778,12 @@ int ftp_close(void)
 	int ret = 0;
 
 	if (client.connected) {
-		ret = do_ftp_send_ctrl(CMD_QUIT, sizeof(CMD_QUIT) - 1);
-		if (ret == 0) {
-			ret = do_ftp_recv_ctrl(true, FTP_CODE_221);
-			k_timer_stop(&keepalive_timer);
-		}
+		k_timer_stop(&keepalive_timer);
+		ret = ctrl_cmd(CMD_QUIT);
 	}
 
 	close(client.sock);
+	client.sock = INVALID_SOCKET;
 	client.connected = false;
 	client.sec_tag = INVALID_SEC_TAG;
 	return ret;
@@ -446,269 +791,196 @@ int ftp_close(void)
 
 int ftp_status(void)
 {
+	uint32_t syst;
+	uint32_t stat;
 	int ret;
 
 	/* get server system type */
-	ret = do_ftp_send_ctrl(CMD_SYST, sizeof(CMD_SYST) - 1);
-	if (ret == 0) {
-		do_ftp_recv_ctrl(true, FTP_CODE_215);
+	ret = ctrl_send(POST_ALL, &syst, CMD_SYST);
+	if (ret) {
+		return ret;
 	}
 
 	/* get server and connection status */
-	ret = do_ftp_send_ctrl(CMD_STAT, sizeof(CMD_STAT) - 1);
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_211);
-		if (ret != FTP_CODE_211) {
-			do {
-				ret = do_ftp_recv_ctrl(true, FTP_CODE_211);
-				if (ret == -ETIMEDOUT || ret == FTP_CODE_211) {
-					break;
-				}
-			} while (1);
-		}
+	ret = ctrl_send(POST_ALL, &stat, CMD_STAT);
+	if (ret) {
+		return ret;
 	}
 
-	return ret;
+	(void)ctrl_reply(syst, NULL);
+	return ctrl_reply(stat, NULL);
 }
 
 int ftp_type(enum ftp_trasfer_type type)
 {
-	int ret;
-
 	if (type == FTP_TYPE_ASCII) {
-		ret = do_ftp_send_ctrl(CMD_TYPE_A, sizeof(CMD_TYPE_A) - 1);
+		return ctrl_cmd(CMD_TYPE_A);
 	} else if (type == FTP_TYPE_BINARY) {
-		ret = do_ftp_send_ctrl(CMD_TYPE_I, sizeof(CMD_TYPE_I) - 1);
-	} else {
-		return -EINVAL;
-	}
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_200);
+		return ctrl_cmd(CMD_TYPE_I);
 	}
 
-	return ret;
+	return -EINVAL;
 }
 
 int ftp_pwd(void)
 {
-	int ret;
-
-	ret = do_ftp_send_ctrl(CMD_PWD, sizeof(CMD_PWD) - 1);
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_257);
-	}
-
-	return ret;
+	return ctrl_cmd(CMD_PWD);
 }
 
 int ftp_list(const char *options, const char *target)
 {
-	int ret;
-	char list_cmd[128];
-
-	/* Always set Passive mode to act as TCP client */
-	ret = do_ftp_send_ctrl(CMD_PASV, sizeof(CMD_PASV) - 1);
-	if (ret) {
-		return -EIO;
-	}
-	ret = do_ftp_recv_ctrl(true, FTP_CODE_227);
-	if (ret != FTP_CODE_227) {
-		return ret;
-	}
-	data_task_param.ctrl_msg = ctrl_buf;
-	data_task_param.task = TASK_RECEIVE;
+	size_t offset = 0;
 
 	/* Send LIST/NLST command in control channel */
 	if (strlen(options) != 0) {
 		if (strlen(target) != 0) {
-			sprintf(list_cmd, CMD_LIST_OPT_FILE, options, target);
-		} else {
-			sprintf(list_cmd, CMD_LIST_OPT, options);
-		}
-	} else {
-		if (strlen(target) != 0) {
-			sprintf(list_cmd, CMD_LIST_FILE, target);
-		} else {
-			memcpy(list_cmd, CMD_NLST, sizeof(CMD_NLST) - 1);
+			return data_get(POST_ALL, &offset,
+					data_callback_consumer, NULL,
+					CMD_LIST_OPT_FILE, options, target);
 		}
+		return data_get(POST_ALL, &offset, data_callback_consumer,
+				NULL, CMD_LIST_OPT, options);
 	}
-	ret = do_ftp_send_ctrl(list_cmd, strlen(list_cmd));
-
-	/* Set up data connection */
-	k_work_submit_to_queue(&ftp_work_q, &data_task_param.work);
-
-	if (ret == 0) {
-		do {
-			ret = do_ftp_recv_ctrl(true, FTP_CODE_226);
-			if (ret == -ETIMEDOUT || ret == FTP_CODE_226) {
-				break;
-			}
-		} while (1);
+	if (strlen(target) != 0) {
+		return data_get(POST_ALL, &offset, data_callback_consumer,
+				NULL, CMD_LIST_FILE, target);
 	}
-
-	return ret;
+	return data_get(POST_ALL, &offset, data_callback_consumer, NULL,
+			CMD_NLST);
 }
 
 int ftp_cwd(const char *folder)
 {
-	int ret;
-
 	if (strcmp(folder, "..") == 0) {
-		ret = do_ftp_send_ctrl(CMD_CDUP, sizeof(CMD_CDUP) - 1);
-	} else {
-		sprintf(ctrl_buf, CMD_CWD, folder);
-		ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-	}
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_250);
+		return ctrl_cmd(CMD_CDUP);
 	}
 
-	return ret;
+	return ctrl_cmd(CMD_CWD, folder);
 }
 
 int ftp_mkd(const char *folder)
 {
-	int ret;
-
-	sprintf(ctrl_buf, CMD_MKD, folder);
-	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_257);
-	}
-
-	return ret;
+	return ctrl_cmd(CMD_MKD, folder);
 }
 
 int ftp_rmd(const char *folder)
 {
-	int ret;
-
-	sprintf(ctrl_buf, CMD_RMD, folder);
-	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_250);
-	}
-
-	return ret;
+	return ctrl_cmd(CMD_RMD, folder);
 }
 
 int ftp_rename(const char *old_name, const char *new_name)
 {
 	int ret;
 
-	sprintf(ctrl_buf, CMD_RNFR, old_name);
-	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_350);
-	}
+	ret = ctrl_cmd(CMD_RNFR, old_name);
 	if (ret != FTP_CODE_350) {
 		return ret;
 	}
 
-	sprintf(ctrl_buf, CMD_RNTO, new_name);
-	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_250);
-	}
-
-	return ret;
+	return ctrl_cmd(CMD_RNTO, new_name);
 }
 
 int ftp_delete(const char *file)
 {
-	int ret;
-
-	sprintf(ctrl_buf, CMD_DELE, file);
-	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
-	if (ret == 0) {
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_250);
-	}
-
-	return ret;
+	return ctrl_cmd(CMD_DELE, file);
 }
 
-int ftp_get(const char *file)
+int ftp_size(const char *file, size_t *size)
 {
+	uint32_t ticket;
 	int ret;
-	char get_cmd[128];
 
-	/* Always set Passive mode to act as TCP client */
-	ret = do_ftp_send_ctrl(CMD_PASV, sizeof(CMD_PASV) - 1);
-	if (ret) {
-		return -EIO;
-	}
-	ret = do_ftp_recv_ctrl(true, FTP_CODE_227);
-	if (ret != FTP_CODE_227) {
-		return ret;
+	if (size == NULL) {
+		return -EINVAL;
 	}
-	data_task_param.ctrl_msg = ctrl_buf;
-	data_task_param.task = TASK_RECEIVE;
 
-	/* Send RETR command in control channel */
-	sprintf(get_cmd, CMD_RETR, file);
-	ret = do_ftp_send_ctrl(get_cmd, strlen(get_cmd));
+	ret = ctrl_send(POST_ALL, &ticket, CMD_SIZE, file);
 	if (ret) {
-		return -EIO;
+		return ret;
 	}
 
-	/* Set up data connection */
-	k_work_submit_to_queue(&ftp_work_q, &data_task_param.work);
+	return ctrl_reply(ticket, size);
+}
 
-	/* Receive control */
-	do {
-		ret = do_ftp_recv_ctrl(false, FTP_CODE_226);
-		if (ret == -ETIMEDOUT || ret == FTP_CODE_226) {
-			break;
-		}
-	} while (1);
+int ftp_get(const char *file)
+{
+	size_t offset = 0;
+
+	return ftp_get_stream(file, &offset, data_callback_consumer, NULL);
+}
 
-	if (ret == FTP_CODE_226) {
-		client.ctrl_callback(ctrl_buf, strlen(ctrl_buf));
+int ftp_get_stream(const char *file, size_t *offset,
+		   ftp_client_consumer_t consumer, void *user_data)
+{
+	if (file == NULL || offset == NULL || consumer == NULL) {
+		return -EINVAL;
 	}
 
-	return ret;
+	/* Only the final reply is posted, after the data */
+	return data_get(POST_FINAL, offset, consumer, user_data,
+			CMD_RETR, file);
 }
 
-int ftp_put(const char *file, const uint8_t *data, uint16_t length)
+int ftp_put(const char *file, const uint8_t *data, size_t length)
 {
+	size_t offset = 0;
+	struct put_buf put = {
+		.data = data,
+		.length = data ? length : 0
+	};
+
+	return ftp_put_stream(file, &offset, put_buf_producer, &put);
+}
+
+int ftp_put_stream(const char *file, size_t *offset,
+		   ftp_client_producer_t producer, void *user_data)
+{
+	uint32_t ticket;
+	int data_sock;
 	int ret;
-	char put_cmd[128];
+	int err;
 
-	if (data && length) {
-		/* Always set Passive mode to act as TCP client */
-		ret = do_ftp_send_ctrl(CMD_PASV, sizeof(CMD_PASV) - 1);
-		if (ret) {
-			return -EIO;
-		}
-		ret = do_ftp_recv_ctrl(true, FTP_CODE_227);
-		if (ret != FTP_CODE_227) {
-			return ret;
+	if (file == NULL || offset == NULL || producer == NULL) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&data_lock, K_FOREVER);
+
+	ret = data_open(&data_sock);
+	if (ret) {
+		goto unlock;
+	}
+
+	/* Unlike for downloads, STOR must wait for REST to be accepted,
+	 * or the server would truncate the file.
+	 */
+	if (*offset > 0) {
+		ret = ctrl_cmd(CMD_REST, (unsigned int)*offset);
+		if (ret != FTP_CODE_350) {
+			close(data_sock);
+			goto unlock;
 		}
-		data_task_param.ctrl_msg = ctrl_buf;
-		data_task_param.task = TASK_SEND;
-		data_task_param.data = (uint8_t *)data;
-		data_task_param.length = length;
 	}
 
 	/* Send STOR command in control channel */
-	sprintf(put_cmd, CMD_STOR, file);
-	ret = do_ftp_send_ctrl(put_cmd, strlen(put_cmd));
-
-	/* Now send data */
-	if (data && length) {
-		k_work_submit_to_queue(&ftp_work_q, &data_task_param.work);
-		k_sem_take(&tx_done, K_FOREVER);
+	ret = ctrl_send(POST_ALL, &ticket, CMD_STOR, file);
+	if (ret) {
+		close(data_sock);
+		goto unlock;
 	}
 
-	if (ret == 0) {
-		do {
-			ret = do_ftp_recv_ctrl(true, FTP_CODE_226);
-			if (ret == -ETIMEDOUT || ret == FTP_CODE_226) {
-				break;
-			}
-		} while (1);
+	/* Now send data, closing the connection marks the end of file */
+	err = do_ftp_send_data(data_sock, offset, producer, user_data);
+	close(data_sock);
+
+	ret = ctrl_reply(ticket, NULL);
+	if (err < 0) {
+		ret = err;
 	}
 
+unlock:
+	k_mutex_unlock(&data_lock);
+
 	return ret;
 }
 
@@ -726,7 +998,6 @@ int ftp_init(ftp_client_callback_t ctrl_callback,
 
 	k_work_q_start(&ftp_work_q, ftp_stack_area,
 		K_THREAD_STACK_SIZEOF(ftp_stack_area), FTP_PRIORITY);
-	k_work_init(&data_task_param.work, data_task);
 
 	return 0;
 }
@@ -4,7 +4,9 @@
  * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
  */
 
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 #include <strings.h>
 #include <zephyr.h>
 #include <zephyr/types.h>
@@ -14,402 +16,326 @@
 
 LOG_MODULE_REGISTER(icalendar_parser, CONFIG_ICAL_PARSER_LOG_LEVEL);
 
-static size_t unfold_contentline(const char *buf, char *prop_buf)
+/* Content line parser states.
+ * Reference: RFC 5545 3.1 Content Lines
+ */
+enum ical_state {
+	/* Property name, up to ";" or ":" */
+	ICAL_STATE_NAME,
+	/* Property parameters, up to ":" outside quoted values */
+	ICAL_STATE_PARAMS,
+	/* Property value, passed on in slices */
+	ICAL_STATE_VALUE,
+	/* BEGIN or END value, ended by the line break */
+	ICAL_STATE_TOKEN,
+};
+
+/* Calendar components and their events */
+static const struct {
+	const char *name;
+	enum ical_parser_evt_id id;
+} components[] = {
+	{ "VEVENT", ICAL_EVT_VEVENT },
+	{ "VTODO", ICAL_EVT_VTODO },
+	{ "VJOURNAL", ICAL_EVT_VJOURNAL },
+	{ "VFREEBUSY", ICAL_EVT_VFREEBUSY },
+	{ "VTIMEZONE", ICAL_EVT_VTIMEZONE },
+};
+
+/* VEVENT properties stored in the component */
+struct ical_field {
+	const char *name;
+	size_t offset;
+	size_t size;
+	enum ical_parser_error_id error;
+};
+
+static const struct ical_field vevent_fields[] = {
+	{ "SUMMARY", offsetof(struct ical_component, summary),
+	  CONFIG_ICAL_PARSER_SUMMARY_SIZE, ICAL_ERROR_SUMMARY },
+	{ "LOCATION", offsetof(struct ical_component, location),
+	  CONFIG_ICAL_PARSER_LOCATION_SIZE, ICAL_ERROR_LOCATION },
+	{ "DESCRIPTION", offsetof(struct ical_component, description),
+	  CONFIG_ICAL_PARSER_DESCRIPTION_SIZE, ICAL_ERROR_DESCRIPTION },
+	{ "DTSTART", offsetof(struct ical_component, dtstart),
+	  CONFIG_ICAL_PARSER_DTSTART_SIZE, ICAL_ERROR_DTSTART },
+	{ "DTEND", offsetof(struct ical_component, dtend),
+	  CONFIG_ICAL_PARSER_DTEND_SIZE, ICAL_ERROR_DTEND },
+};
+
+static void component_begin(struct icalendar_parser *ical)
 {
-	size_t unfold_size = 0;
-	const char *sol = buf;
-	char *eol;
-	uint16_t total_line_len = 0, single_line_len = 0;
-
-	while (1) {
-		eol = strstr(sol, "\r\n");
-		if (!eol) {
-			return 0;
-		}
-		single_line_len = eol - sol;
-		if ((total_line_len + single_line_len)
-		    <= CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE) {
-			memcpy(prop_buf +
-			       total_line_len, sol, single_line_len);
-			total_line_len += single_line_len;
-		} else {
-			LOG_DBG("Property value overflow."
-				"Increase CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE.");
-			return 0;
-		}
-		if (!strncmp(eol, "\r\n ", strlen("\r\n "))) {
-			/* Long content line is split into multiple lines.
-			 * Copy the folded part to unfolded buffer.
-			 */
-			sol = eol + strlen("\r\n ");
-		} else {
-			/* Content line is delimited. Count parsed bytes */
-			unfold_size = eol - buf;
-			break;
-		}
+	if (!strcasecmp(ical->token, "VCALENDAR")) {
+		LOG_DBG("Found a calendar stream");
+		ical->icalobject_begin = true;
+		ical->depth = 0;
+		ical->in_component = false;
+		return;
 	}
-	prop_buf[unfold_size] = '\0';
 
-	return unfold_size;
-}
-
-static bool parse_desc_props(const char *buf,
-			     const char *name,
-			     size_t name_size,
-			     char *value,
-			     size_t max_value_len)
-{
-	bool ret;
-	size_t unfold_size;
-	char ical_prop_buf[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
-
-	unfold_size = unfold_contentline(buf, ical_prop_buf);
-	if (unfold_size <= 0) {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s no value/param.", name);
-		return false;
+	if (!ical->icalobject_begin || ical->depth++ > 0) {
+		/* Outside the calendar, or nested such as VALARM */
+		return;
 	}
 
-	if (ical_prop_buf[name_size] == ':') {
-		size_t value_len = unfold_size - name_size - 1;
-
-		if (value_len <= max_value_len) {
-			memcpy(value,
-				ical_prop_buf + name_size + 1,
-				value_len);
-			value[value_len] = '\0';
-			ret = true;
-		} else {
-			/* Property value overflow. */
-			LOG_ERR("%s value overflow.", name);
-			ret = false;
-		}
-	} else if (ical_prop_buf[name_size] == ';') {
-		/* Does not support property parameter. */
-		LOG_ERR("%s param not supported.", name);
-		ret = false;
-	} else {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s wrong format.", name);
-		ret = false;
-	}
-
-	return ret;
-}
-
-static bool parse_datetime_props(const char *buf,
-				 const char *name,
-				 size_t name_size,
-				 char *value,
-				 size_t max_value_len)
-{
-	bool ret;
-	size_t unfold_size;
-	char ical_prop_buf[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
-
-	unfold_size = unfold_contentline(buf, ical_prop_buf);
-	if (unfold_size <= 0) {
-		/* Property wrong format - fail to unfold property. */
-		LOG_ERR("%s wrong format. Fail to unfold property", name);
-		return false;
-	}
-
-	if (ical_prop_buf[name_size] == ':') {
-		size_t value_len = unfold_size - name_size - 1;
-
-		if (value_len <= max_value_len) {
-			memcpy(value,
-				ical_prop_buf + name_size + 1,
-				value_len);
-			value[value_len] = '\0';
-			ret = true;
-		} else {
-			/* Property value overflow. */
-			LOG_ERR("%s value overflow.", name);
-			ret = false;
-		}
-	} else if (ical_prop_buf[name_size] == ';') {
-		char *dtvalue;
-
-		dtvalue = strchr(ical_prop_buf, ':');
-		if (dtvalue) {
-			dtvalue = dtvalue + 1;
-			size_t value_len;
-
-			value_len = unfold_size -
-					(dtvalue - ical_prop_buf);
-			if (value_len <= max_value_len) {
-				memcpy(value, dtvalue, value_len);
-				value[value_len] = '\0';
-				ret = true;
-			} else {
-				/* Property value overflow. */
-				LOG_ERR("%s value overflow.", name);
-				ret = false;
+	for (size_t i = 0; i < ARRAY_SIZE(components); i++) {
+		if (!strcasecmp(ical->token, components[i].name)) {
+			memset(&ical->evt, 0, sizeof(ical->evt));
+			ical->evt.id = components[i].id;
+			ical->evt.error = ICAL_ERROR_COM_NOT_SUPPORTED;
+			if (components[i].id == ICAL_EVT_VEVENT) {
+				ical->evt.error = ICAL_ERROR_NONE;
 			}
-		} else {
-			/* Property wrong format - no value. */
-			LOG_ERR("%s wrong format - no value.", name);
-			ret = false;
+			ical->in_component = true;
+			break;
 		}
-	} else {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s wrong format.", name);
-		ret = false;
 	}
-
-	return ret;
 }
 
-static size_t parse_calprops(const char *buf)
+static int component_end(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *end = NULL;
-	char prop_value[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
-
-	parsed = strstr(parsed, "BEGIN:VCALENDAR\r\n");
-	if (parsed == NULL) {
+	if (!strcasecmp(ical->token, "VCALENDAR")) {
+		ical->icalobject_begin = false;
 		return 0;
 	}
-	parsed += strlen("BEGIN:VCALENDAR\r\n");
 
-	end = strstr(parsed, "\r\nBEGIN:");
-	if (end == NULL) {
+	if (!ical->icalobject_begin || ical->depth == 0 ||
+	    --ical->depth > 0 || !ical->in_component) {
 		return 0;
 	}
-	end += strlen("\r\n");
-
-	while (parsed < end) {
-		memset(prop_value, 0, sizeof(prop_value));
-		if (!strncmp(parsed, "PRODID", 6)) {
-			if (!parse_desc_props(parsed, "PRODID", 6,
-					prop_value, sizeof(prop_value))) {
-				LOG_ERR("Wrong PRODID");
-			}
-		} else if (!strncmp(parsed, "VERSION", 7)) {
-			if (!parse_desc_props(parsed, "VERSION", 7,
-					prop_value, sizeof(prop_value))) {
-				LOG_ERR("Wrong VERSION");
-			}
-		}
-		parsed = strstr(parsed, "\r\n");
-		parsed += strlen("\r\n");
-	}
 
-	return (parsed - buf);
+	ical->in_component = false;
+	return ical->callback(&ical->evt);
 }
 
-static size_t parse_eventprop(const char *buf,
-			      struct ical_parser_evt *evt)
+static void value_begin(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	if (strncmp(buf, "BEGIN:VEVENT\r\n", strlen("BEGIN:VEVENT\r\n"))) {
-		return 0;
+	ical->value_len = 0;
+	ical->field = NULL;
+
+	if (!strcasecmp(ical->name, "BEGIN") ||
+	    !strcasecmp(ical->name, "END")) {
+		ical->token[0] = '\0';
+		ical->state = ICAL_STATE_TOKEN;
+		return;
 	}
 
-	com_end = strstr(buf, "END:VEVENT\r\n");
-	if (com_end == NULL) {
-		return 0;
+	ical->state = ICAL_STATE_VALUE;
+	if (!ical->in_component || ical->depth != 1 ||
+	    ical->evt.id != ICAL_EVT_VEVENT) {
+		return;
 	}
 
-	evt->id = ICAL_EVT_VEVENT;
-	evt->error = ICAL_ERROR_NONE;
-	com_end += strlen("END:VEVENT\r\n");
-	while (parsed < com_end) {
-		if (!strncasecmp(parsed, "SUMMARY", 7)) {
-			if (!parse_desc_props(
-				parsed, "SUMMARY", 7,
-				evt->ical_com.summary,
-				CONFIG_ICAL_PARSER_SUMMARY_SIZE)) {
-				evt->error = ICAL_ERROR_SUMMARY;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "LOCATION", 8)) {
-			if (!parse_desc_props(
-				parsed, "LOCATION", 8,
-				evt->ical_com.location,
-				CONFIG_ICAL_PARSER_LOCATION_SIZE)) {
-				evt->error = ICAL_ERROR_LOCATION;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "DESCRIPTION", 11)) {
-			if (!parse_desc_props(
-				parsed, "DESCRIPTION", 11,
-				evt->ical_com.description,
-				CONFIG_ICAL_PARSER_DESCRIPTION_SIZE)) {
-				evt->error = ICAL_ERROR_DESCRIPTION;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "DTSTART", 7)) {
-			if (!parse_datetime_props(
-				parsed, "DTSTART", 7,
-				evt->ical_com.dtstart,
-				CONFIG_ICAL_PARSER_DTSTART_SIZE)) {
-				evt->error = ICAL_ERROR_DTSTART;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed,
-					"DTEND", 5)) {
-			if (!parse_datetime_props(
-				parsed, "DTEND", 5,
-				evt->ical_com.dtend,
-				CONFIG_ICAL_PARSER_DTEND_SIZE)) {
-				evt->error = ICAL_ERROR_DTEND;
-				parsed = com_end;
-			}
+	for (size_t i = 0; i < ARRAY_SIZE(vevent_fields); i++) {
+		if (!strcasecmp(ical->name, vevent_fields[i].name)) {
+			ical->field = &vevent_fields[i];
+			break;
 		}
-
-		/* Move parsed pointer to end of line break */
-		parsed = strstr(parsed, "\r\n") + 2;
 	}
-
-	return parsed - buf;
 }
 
-static size_t parse_todoprop(const char *buf,
-				struct ical_parser_evt *evt)
+/* Store a slice of the value in the component or BEGIN/END token */
+static void value_store(struct icalendar_parser *ical,
+			const struct ical_property *prop)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	com_end = strstr(buf, "END:VTODO\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VTODO\r\n");
+	const struct ical_field *field = ical->field;
+	char *dst;
+	size_t size;
+	size_t len;
+
+	if (ical->state == ICAL_STATE_TOKEN) {
+		dst = ical->token;
+		size = sizeof(ical->token) - 1;
+	} else if (field != NULL) {
+		dst = (char *)&ical->evt.ical_com + field->offset;
+		size = field->size;
+	} else {
+		return;
 	}
-	evt->id = ICAL_EVT_VTODO;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
-
-	return parsed - buf;
-}
 
-static size_t parse_jourprop(const char *buf,
-				struct ical_parser_evt *evt)
-{
-	const char *parsed = buf;
-	char *com_end;
-
-	com_end = strstr(buf, "END:VJOURNAL\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VJOURNAL\r\n");
+	if (prop->offset >= size) {
+		len = 0;
+	} else {
+		len = MIN(prop->len, size - prop->offset);
+		memcpy(dst + prop->offset, prop->value, len);
+		dst[prop->offset + len] = '\0';
 	}
-	evt->id = ICAL_EVT_VJOURNAL;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
+	if (len < prop->len && field != NULL &&
+	    ical->evt.error == ICAL_ERROR_NONE) {
+		/* Property value overflow. */
+		LOG_ERR("%s value overflow.", field->name);
+		ical->evt.error = field->error;
+	}
 }
 
-static size_t parse_fbprop(const char *buf, struct ical_parser_evt *evt)
+static int value_slice(struct icalendar_parser *ical, const char *value,
+		       size_t len, bool last)
 {
-	const char *parsed = buf;
-	char *com_end;
+	struct ical_property prop = {
+		.name = ical->name,
+		.params = ical->params,
+		.value = value,
+		.len = len,
+		.offset = ical->value_len,
+		.last = last
+	};
+	int ret = 0;
+
+	ical->value_len += len;
+	value_store(ical, &prop);
+
+	if (ical->prop_callback) {
+		ret = ical->prop_callback(&prop);
+	}
 
-	com_end = strstr(buf, "END:VFREEBUSY\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VFREEBUSY\r\n");
+	if (last && ical->state == ICAL_STATE_TOKEN) {
+		if (!strcasecmp(ical->name, "BEGIN")) {
+			component_begin(ical);
+		} else if (component_end(ical)) {
+			ret = -ECANCELED;
+		}
 	}
-	evt->id = ICAL_EVT_VFREEBUSY;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
+	return ret;
 }
 
-static size_t parse_tzprop(const char *buf, struct ical_parser_evt *evt)
+/* End of an unfolded content line */
+static int line_end(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	com_end = strstr(buf, "END:VTIMEZONE\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VTIMEZONE\r\n");
+	int ret = 0;
+
+	if (ical->state == ICAL_STATE_VALUE ||
+	    ical->state == ICAL_STATE_TOKEN) {
+		ret = value_slice(ical, NULL, 0, true);
+	} else if (ical->name_len > 0) {
+		/* Property wrong format - no value. */
+		LOG_ERR("%s wrong format.", ical->name);
 	}
-	evt->id = ICAL_EVT_VTIMEZONE;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
+	ical->state = ICAL_STATE_NAME;
+	ical->quoted = false;
+	ical->name_len = 0;
+	ical->name[0] = '\0';
+	ical->params_len = 0;
+	ical->params[0] = '\0';
+
+	return ret;
 }
 
-static size_t parse_component(char *buf, struct ical_parser_evt *evt)
+static void append(char *buf, size_t *len, size_t size, char c)
 {
-	char *com_begin = buf;
-	size_t ret = 0;
-
-	/* Search begin of component */
-	if (!strncmp(com_begin, "BEGIN:VEVENT\r\n", 14)) {
-		ret += parse_eventprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VTODO\r\n", 13)) {
-		ret += parse_todoprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VJOURNAL\r\n", 16)) {
-		ret += parse_jourprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VFREEBUSY\r\n", 17)) {
-		ret += parse_fbprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VTIMEZONE\r\n", 17)) {
-		ret += parse_tzprop(com_begin, evt);
+	if (*len < size) {
+		buf[(*len)++] = c;
+		buf[*len] = '\0';
+	} else if (*len == size) {
+		LOG_WRN("%s truncated.", buf);
+		(*len)++;
 	}
-
-	return ret;
 }
 
-static size_t parse_icalbody(char *buf,
-				icalendar_parser_callback_t callback)
+size_t ical_parser_parse(struct icalendar_parser *ical,
+			const char *data, size_t len)
 {
-	size_t parsed_bytes = 0, parsed_offset = 0;
+	const char *slice = NULL;
+	size_t i;
+
+	ical->stopped = false;
 
-	do {
-		struct ical_parser_evt evt;
+	for (i = 0; i < len; i++) {
+		char c = data[i];
 
-		parsed_bytes = parse_component(buf + parsed_offset, &evt);
-		parsed_offset += parsed_bytes;
-		if (parsed_bytes > 0) {
-			callback(&evt);
+		if (ical->eol) {
+			ical->eol = false;
+			if (c == ' ' || c == '\t') {
+				/* Long content line is split into multiple
+				 * lines. Drop the line break and whitespace.
+				 */
+				continue;
+			}
+			if (line_end(ical)) {
+				ical->stopped = true;
+				return i;
+			}
 		}
-	} while (parsed_bytes > 0);
 
-	return parsed_offset;
-}
+		if (c == '\r' || c == '\n') {
+			if (slice != NULL) {
+				const char *value = slice;
 
-size_t ical_parser_parse(struct icalendar_parser *ical,
-			const char *data, size_t len)
-{
-	size_t parsed_offset = 0;
+				slice = NULL;
+				if (value_slice(ical, value, data + i - value,
+						false)) {
+					ical->stopped = true;
+					return i;
+				}
+			}
+			if (c == '\n') {
+				/* BEGIN and END lines are not folded, end
+				 * them now so that components are reported
+				 * as soon as they are complete.
+				 */
+				if (ical->state != ICAL_STATE_TOKEN) {
+					ical->eol = true;
+				} else if (line_end(ical)) {
+					ical->stopped = true;
+					return i + 1;
+				}
+			}
+			continue;
+		}
 
-	if (CONFIG_ICAL_PARSER_BUFFER_SIZE < (ical->offset + len)) {
-		return -ENOBUFS;
+		switch (ical->state) {
+		case ICAL_STATE_NAME:
+			if (c == ';') {
+				ical->state = ICAL_STATE_PARAMS;
+			} else if (c == ':') {
+				value_begin(ical);
+			} else {
+				append(ical->name, &ical->name_len,
+				       CONFIG_ICAL_PARSER_NAME_SIZE, c);
+			}
+			break;
+		case ICAL_STATE_PARAMS:
+			if (c == '"') {
+				ical->quoted = !ical->quoted;
+			} else if (c == ':' && !ical->quoted) {
+				value_begin(ical);
+				break;
+			}
+			append(ical->params, &ical->params_len,
+			       CONFIG_ICAL_PARSER_PARAMS_SIZE, c);
+			break;
+		default:
+			if (slice == NULL) {
+				slice = data + i;
+			}
+			break;
+		}
 	}
 
-	memcpy(ical->buf + ical->offset, data, len);
-	ical->buf[ical->offset + len] = '\0';
-
-	/* Check begin of iCalendar object delimiter
-	 * Reference: RFC 5545 3.4 iCalendar Object
-	 */
-	if (!ical->icalobject_begin) {
-		/* The body of the iCalendar object consists of
-		 * a sequence of calendar properties and
-		 * one or more calendar components.
-		 *
-		 * Reference: RFC 5545 3.6 Calendar Components
+	if (slice != NULL) {
+		/* The rest of the value follows in the next data. All of the
+		 * data is parsed even if the callback stops here.
 		 */
-		parsed_offset += parse_calprops(ical->buf);
-		if (parsed_offset > 0) {
-			LOG_DBG("Found a calendar stream");
-			ical->icalobject_begin = true;
+		if (value_slice(ical, slice, data + len - slice, false)) {
+			ical->stopped = true;
 		}
 	}
 
-	/* If we got a calendar property, start parsing calendar body. */
-	if (ical->icalobject_begin) {
-		parsed_offset += parse_icalbody(ical->buf + parsed_offset,
-						ical->callback);
-	}
+	return i;
+}
 
-	if (parsed_offset) {
-		ical->offset = ical->offset + len - parsed_offset;
-		memcpy(ical->buf, ical->buf + parsed_offset, ical->offset);
+int ical_parser_property_callback_set(struct icalendar_parser *ical,
+				      icalendar_property_callback_t callback)
+{
+	if (ical == NULL) {
+		return -EINVAL;
 	}
 
-	return parsed_offset;
+	ical->prop_callback = callback;
+
+	return 0;
 }
 
 int ical_parser_init(struct icalendar_parser *ical,
@@ -419,9 +345,9 @@ int ical_parser_init(struct icalendar_parser *ical,
 		return -EINVAL;
 	}
 
+	memset(ical, 0, sizeof(*ical));
 	ical->callback = callback;
-	ical->icalobject_begin = false;
-	ical->offset = 0;
+	ical->state = ICAL_STATE_NAME;
 
 	return 0;
 }
@@ -19,6 +19,7 @@ LOG_MODULE_REGISTER(nfc_t4t_apdu, CONFIG_NFC_T4T_APDU_LOG_LEVEL);
 #define LC_LONG_FORMAT_SIZE 3U
 #define LE_SHORT_FORMAT_SIZE 1U
 #define LE_LONG_FORMAT_SIZE 2U
+#define LE_LONG_FORMAT_TOKEN_SIZE 1U
 
 /** @brief Values used to encode Lc field in C-APDU.
  */
@@ -34,12 +35,26 @@ LOG_MODULE_REGISTER(nfc_t4t_apdu, CONFIG_NFC_T4T_APDU_LOG_LEVEL);
 /* Size of Status field contained in R-APDU. */
 #define STATUS_SIZE 2U
 
+/** @brief Check if C-APDU requires extended length fields.
+ *
+ *  According to ISO/IEC 7816-4, Lc and Le fields use the same format, so
+ *  both of them are encoded in extended format when either one does not fit
+ *  in the short format.
+ */
+static bool nfc_t4t_apdu_comm_extended(const struct nfc_t4t_apdu_comm *cmd_apdu)
+{
+	return ((cmd_apdu->data.buff) &&
+		(cmd_apdu->data.len > LC_LONG_FORMAT_THR)) ||
+	       (cmd_apdu->resp_len > LE_LONG_FORMAT_THR);
+}
+
 static uint16_t nfc_t4t_apdu_comm_size_calc(const struct nfc_t4t_apdu_comm *cmd_apdu)
 {
 	uint16_t res = CLASS_TYPE_SIZE + INSTRUCTION_TYPE_SIZE + PARAMETER_SIZE;
+	bool extended = nfc_t4t_apdu_comm_extended(cmd_apdu);
 
 	if (cmd_apdu->data.buff) {
-		if (cmd_apdu->data.len > LC_LONG_FORMAT_THR) {
+		if (extended) {
 			res += LC_LONG_FORMAT_SIZE;
 		} else {
 			res += LC_SHORT_FORMAT_SIZE;
@@ -49,8 +64,15 @@ static uint16_t nfc_t4t_apdu_comm_size_calc(const struct nfc_t4t_apdu_comm *cmd_
 	res += cmd_apdu->data.len;
 
 	if (cmd_apdu->resp_len != LE_FIELD_ABSENT) {
-		if (cmd_apdu->resp_len > LE_LONG_FORMAT_THR) {
+		if (extended) {
 			res += LE_LONG_FORMAT_SIZE;
+
+			/* Extended Le field without Lc field starts with
+			 * a zero byte.
+			 */
+			if (!cmd_apdu->data.buff) {
+				res += LE_LONG_FORMAT_TOKEN_SIZE;
+			}
 		} else {
 			res += LE_SHORT_FORMAT_SIZE;
 		}
@@ -77,6 +99,7 @@ int nfc_t4t_apdu_comm_encode(const struct nfc_t4t_apdu_comm *cmd_apdu,
 			     uint8_t *raw_data, uint16_t *len)
 {
 	int err;
+	bool extended;
 
 	/*  Validate passed arguments. */
 	err = nfc_t4t_apdu_comm_args_validate(cmd_apdu, raw_data, len);
@@ -84,6 +107,8 @@ int nfc_t4t_apdu_comm_encode(const struct nfc_t4t_apdu_comm *cmd_apdu,
 		return err;
 	}
 
+	extended = nfc_t4t_apdu_comm_extended(cmd_apdu);
+
 	/* Check if there is enough memory in the provided buffer to store
 	 * described C-APDU.
 	 */
@@ -105,7 +130,7 @@ int nfc_t4t_apdu_comm_encode(const struct nfc_t4t_apdu_comm *cmd_apdu,
 	/* Check if optional data field should be included. */
 	if (cmd_apdu->data.buff) {
 		/* Use long data length encoding. */
-		if (cmd_apdu->data.len > LC_LONG_FORMAT_THR) {
+		if (extended) {
 			*raw_data++ = LC_LONG_FORMAT_TOKEN;
 
 			sys_put_be16(cmd_apdu->data.len, raw_data);
@@ -124,7 +149,11 @@ int nfc_t4t_apdu_comm_encode(const struct nfc_t4t_apdu_comm *cmd_apdu,
 	 */
 	if (cmd_apdu->resp_len != LE_FIELD_ABSENT) {
 		/* Use long response length encoding. */
-		if (cmd_apdu->resp_len > LE_LONG_FORMAT_THR) {
+		if (extended) {
+			if (!cmd_apdu->data.buff) {
+				*raw_data++ = LC_LONG_FORMAT_TOKEN;
+			}
+
 			sys_put_be16(cmd_apdu->resp_len, raw_data);
 			raw_data += sizeof(uint16_t);
 		} else {
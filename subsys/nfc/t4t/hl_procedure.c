@@ -27,6 +27,41 @@ LOG_MODULE_REGISTER(nfc_t4t_hl_procedure,
 #define APDU_LE_MAP_2_MAX_VALUE 0xFF
 #define NFC_T4T_APDU_RSP_ALL 256
 
+#if defined(CONFIG_NFC_T4T_HL_PROCEDURE_EXTENDED_APDU)
+#define APDU_CHUNK_MAX_SIZE UINT16_MAX
+#else
+#define APDU_CHUNK_MAX_SIZE APDU_LE_MAP_2_MAX_VALUE
+#endif
+
+#define APDU_BUF_SIZE CONFIG_NFC_T4T_HL_PROCEDURE_APDU_BUF_SIZE
+
+/* C-APDU header of the NDEF Update command: CLA, INS, P1, P2 and the Lc
+ * field, which is one byte long in the short form and three bytes long in
+ * the extended form.
+ */
+#define APDU_UPDATE_HEADER_SIZE 5
+#define APDU_UPDATE_EXT_HEADER_SIZE 7
+
+BUILD_ASSERT(APDU_BUF_SIZE > APDU_UPDATE_HEADER_SIZE,
+	     "The APDU buffer is too small for the NDEF Update command");
+
+/* Largest NDEF Update data chunk that fits in the APDU buffer. Chunks
+ * longer than a short APDU can carry are sent in the extended form, which
+ * has a longer header.
+ */
+#if defined(CONFIG_NFC_T4T_HL_PROCEDURE_EXTENDED_APDU)
+#define APDU_UPDATE_CHUNK_MAX_SIZE                                       \
+	((APDU_BUF_SIZE - APDU_UPDATE_EXT_HEADER_SIZE >                  \
+	  APDU_LE_MAP_2_MAX_VALUE) ?                                     \
+		 MIN(APDU_CHUNK_MAX_SIZE,                                \
+		     APDU_BUF_SIZE - APDU_UPDATE_EXT_HEADER_SIZE) :      \
+		 MIN(APDU_LE_MAP_2_MAX_VALUE,                            \
+		     APDU_BUF_SIZE - APDU_UPDATE_HEADER_SIZE))
+#else
+#define APDU_UPDATE_CHUNK_MAX_SIZE                                       \
+	MIN(APDU_LE_MAP_2_MAX_VALUE, APDU_BUF_SIZE - APDU_UPDATE_HEADER_SIZE)
+#endif
+
 enum nfc_t4t_hl_transaction_type {
 	NFC_T4T_HL_SELECT,
 	NFC_T4T_HL_CC_READ,
@@ -57,7 +92,7 @@ struct t4t_hl_procedure {
 	enum nfc_t4t_hl_transaction_type transaction_type;
 	enum nfc_t4t_hl_procedure_select select_type;
 	uint16_t file_offset;
-	uint8_t apdu_buff[CONFIG_NFC_T4T_HL_PROCEDURE_APDU_BUF_SIZE];
+	uint8_t apdu_buff[APDU_BUF_SIZE];
 };
 
 static struct t4t_hl_procedure t4t_hl;
@@ -180,7 +215,7 @@ static int ndef_file_chunk_read(const struct nfc_t4t_apdu_resp *resp)
 		apdu_comm.instruction = NFC_T4T_APDU_COMM_INS_READ;
 		apdu_comm.parameter = t4t_hl.file_offset;
 		apdu_comm.resp_len = MIN(t4t_hl.ndef.nlen - (t4t_hl.file_offset - NDEF_FILE_NLEN_SIZE),
-				MIN(APDU_LE_MAP_2_MAX_VALUE, t4t_hl.ndef.cc->max_rapdu_size));
+				MIN(APDU_CHUNK_MAX_SIZE, t4t_hl.ndef.cc->max_rapdu_size));
 
 		t4t_hl.transaction_type = NFC_T4T_HL_NDEF_READ;
 
@@ -215,7 +250,7 @@ static int ndef_file_chunk_update(void)
 		apdu_comm.parameter = t4t_hl.file_offset;
 		apdu_comm.data.buff = t4t_hl.ndef.buff + t4t_hl.file_offset;
 		apdu_comm.data.len = MIN(t4t_hl.ndef.buff_size - t4t_hl.file_offset,
-				MIN(APDU_LE_MAP_2_MAX_VALUE, t4t_hl.ndef.cc->max_capdu_size));
+				MIN(APDU_UPDATE_CHUNK_MAX_SIZE, t4t_hl.ndef.cc->max_capdu_size));
 
 		t4t_hl.file_offset += apdu_comm.data.len;
 		t4t_hl.transaction_type = NFC_T4T_HL_NDEF_UPDATE;
@@ -39,6 +39,16 @@ LOG_MODULE_REGISTER(nfc_t4t_isodep, CONFIG_NFC_T4T_ISODEP_LOG_LEVEL);
 
 #define T4T_FSD_MIN 16
 
+/* Largest FSDI/FSCI value in use. FSDI values above 8 are defined by
+ * ISO/IEC 14443-4:2016, the NFC Forum Digital Specification 2.0 treats
+ * them as RFU.
+ */
+#if defined(CONFIG_NFC_T4T_ISODEP_EXTENDED_FSD)
+#define T4T_FSDI_MAX NFC_T4T_ISODEP_FSD_4096
+#else
+#define T4T_FSDI_MAX NFC_T4T_ISODEP_FSD_256
+#endif
+
 #define T4T_RATS_CMD 0xE0
 #define T4T_RATS_DID_MASK 0x0F
 #define T4T_RATS_FSDI_MASK 0xF0
@@ -107,6 +117,13 @@ struct nfc_t4t_buf {
 	size_t buf_size;
 };
 
+struct isodep_chunk {
+	uint8_t *frame;
+	size_t len;
+	size_t data_len;
+	bool chaining;
+};
+
 struct nfc_t4t_err {
 	enum isodep_frame last_frame;
 	uint8_t frame_retry_cnt;
@@ -119,6 +136,8 @@ struct nfc_t4t_isodep {
 	struct nfc_t4t_buf tx_data;
 	struct nfc_t4t_buf rx_data;
 	struct nfc_t4t_err err_status;
+	struct isodep_chunk chunk;
+	struct isodep_chunk next_chunk;
 	uint16_t fsd;
 	uint8_t block_num;
 	uint8_t retransmit_cnt;
@@ -131,8 +150,11 @@ struct nfc_t4t_isodep {
 	bool first_transfer;
 };
 
-/* Map FSD value in terms of FSDI according to NFC Forum Digital Specification 2.0 14.16.1 */
-static const uint16_t fsd_value_map[] = {16, 24, 32, 40, 48, 64, 96, 128, 256};
+/* Map FSD value in terms of FSDI according to NFC Forum Digital Specification 2.0 14.16.1
+ * and ISO/IEC 14443-4:2016 5.2.2.
+ */
+static const uint16_t fsd_value_map[] = {16, 24, 32, 40, 48, 64, 96, 128, 256,
+					 512, 1024, 2048, 4096};
 
 static struct nfc_t4t_isodep t4t_isodep;
 static const struct nfc_t4t_isodep_cb *t4t_isodep_cb;
@@ -145,6 +167,8 @@ static void isodep_transmission_clear(void)
 	t4t_isodep.transmitted_len            = 0;
 	t4t_isodep.transmit_len               = 0;
 	t4t_isodep.chaining                   = false;
+	t4t_isodep.chunk.len                  = 0;
+	t4t_isodep.next_chunk.len             = 0;
 	t4t_isodep.retransmit_cnt             = 0;
 	t4t_isodep.err_status.frame_retry_cnt = 0;
 	t4t_isodep.err_status.last_frame      = ISODEP_FRAME_NONE;
@@ -163,6 +187,19 @@ static size_t did_include(uint8_t *data, size_t pos)
 	return pos;
 }
 
+static uint8_t *ctrl_frame_get(void)
+{
+	/* Control frames are built at the beginning of the Tx buffer.
+	 * Drop the chained I-block prepared there in advance, it is
+	 * built again when needed.
+	 */
+	if (t4t_isodep.next_chunk.frame == t4t_isodep.tx_data.data) {
+		t4t_isodep.next_chunk.len = 0;
+	}
+
+	return t4t_isodep.tx_data.data;
+}
+
 static void err_notify(int err)
 {
 	isodep_transmission_clear();
@@ -203,6 +240,11 @@ static int ats_parse(const uint8_t *data, size_t len)
 
 	fsci = t0 & T4T_ATS_T0_FSCI_MASK;
 
+	/* RFU FSCI values are interpreted as the largest supported one. */
+	if (fsci > T4T_FSDI_MAX) {
+		fsci = T4T_FSDI_MAX;
+	}
+
 	/* FSC is mapped from FSCI in the same way like FSD.
 	 * NFC Forum Digital Specification 2.0 14.6.2.
 	 */
@@ -285,50 +327,96 @@ static int ats_parse(const uint8_t *data, size_t len)
 	return 0;
 }
 
-static void isodep_chunk_send(void)
+static bool chunk_pipeline_enabled(void)
+{
+	/* Two I-blocks must fit in the Tx buffer at the same time. */
+	return IS_ENABLED(CONFIG_NFC_T4T_ISODEP_CHAINING_PIPELINE) &&
+	       (t4t_isodep.tx_data.buf_size >= (2 * t4t_isodep.tag.fsc));
+}
+
+static uint8_t *chunk_slot_other(const uint8_t *frame)
+{
+	uint8_t *slot = t4t_isodep.tx_data.data;
+
+	return (frame == slot) ? (slot + t4t_isodep.tag.fsc) : slot;
+}
+
+static void isodep_chunk_prepare(struct isodep_chunk *chunk, uint8_t *frame,
+				 uint8_t block_num, size_t offset)
 {
-	size_t data_len;
-	uint32_t fdt;
 	size_t index = 0;
-	const uint8_t *data = t4t_isodep.transmit_data;
-	uint8_t *tx_data = t4t_isodep.tx_data.data;
+	size_t remaining = t4t_isodep.transmit_len - offset;
 
-	__ASSERT_NO_MSG(data);
-	__ASSERT_NO_MSG(tx_data);
+	__ASSERT_NO_MSG(t4t_isodep.transmit_data);
+	__ASSERT_NO_MSG(frame);
 
-	/* Prepare first chunk. */
-	tx_data[index] = ISODEP_I_BLOCK | (t4t_isodep.block_num & 1);
+	frame[index] = ISODEP_I_BLOCK | (block_num & 1);
 
 	/* Check if DID field should be included. */
-	index = did_include(tx_data, index);
+	index = did_include(frame, index);
 
 	/* Use chaining when data is to long. */
-	if ((t4t_isodep.tag.fsc - index) <
-	    (t4t_isodep.transmit_len - t4t_isodep.transmitted_len)) {
-		tx_data[0] |= I_BLOCK_CHAINING_BIT;
-		data_len = t4t_isodep.tag.fsc - index;
-		t4t_isodep.chaining = true;
+	if ((t4t_isodep.tag.fsc - index) < remaining) {
+		frame[0] |= I_BLOCK_CHAINING_BIT;
+		chunk->data_len = t4t_isodep.tag.fsc - index;
+		chunk->chaining = true;
+	} else {
+		chunk->data_len = remaining;
+		chunk->chaining = false;
+	}
+
+	memcpy(&frame[index], &t4t_isodep.transmit_data[offset],
+	       chunk->data_len);
+
+	chunk->frame = frame;
+	chunk->len = index + chunk->data_len;
+}
+
+static void isodep_chunk_send(void)
+{
+	uint32_t fdt;
+	size_t transmitted_len;
+	struct isodep_chunk *chunk = &t4t_isodep.chunk;
+
+	if (t4t_isodep.next_chunk.len) {
+		/* Chunk was prepared while the previous one was in flight. */
+		*chunk = t4t_isodep.next_chunk;
+		t4t_isodep.next_chunk.len = 0;
 	} else {
-		data_len = t4t_isodep.transmit_len - t4t_isodep.transmitted_len;
-		t4t_isodep.chaining = false;
+		isodep_chunk_prepare(chunk, t4t_isodep.tx_data.data,
+				     t4t_isodep.block_num,
+				     t4t_isodep.transmitted_len);
 	}
 
+	t4t_isodep.chaining = chunk->chaining;
+
 	/* Restore last frame type in case nfc_t4t_isodep_transmit() was called
 	 * as it clears the transmission status.
 	 */
 	t4t_isodep.err_status.last_frame = ISODEP_FRAME_I;
 
-	memcpy(&tx_data[index], &data[t4t_isodep.transmitted_len], data_len);
-
-	index += data_len;
-	t4t_isodep.tx_data.len = index;
-	t4t_isodep.transmitted_len += data_len;
+	t4t_isodep.tx_data.len = chunk->len;
+	t4t_isodep.transmitted_len += chunk->data_len;
+	transmitted_len = t4t_isodep.transmitted_len;
 
 	fdt = t4t_isodep.tag.fwt + T4T_FWT_DELTA + NFCA_T4T_FWT_T_FC;
 
 	if (t4t_isodep_cb->ready_to_send) {
-		t4t_isodep_cb->ready_to_send(t4t_isodep.tx_data.data,
-					     t4t_isodep.tx_data.len, fdt);
+		t4t_isodep_cb->ready_to_send(chunk->frame, chunk->len, fdt);
+	}
+
+	/* Prepare the next chained I-block in the other half of the Tx buffer
+	 * while this one is in flight, so that it can be sent as soon as the
+	 * R(ACK) is received. Skip it if the transfer state changed in the
+	 * meantime.
+	 */
+	if (t4t_isodep.chaining && chunk_pipeline_enabled() &&
+	    (t4t_isodep.transmitted_len == transmitted_len) &&
+	    (t4t_isodep.next_chunk.len == 0)) {
+		isodep_chunk_prepare(&t4t_isodep.next_chunk,
+				     chunk_slot_other(chunk->frame),
+				     ISODEP_BLOC_NUM_TOOGLE(t4t_isodep.block_num),
+				     transmitted_len);
 	}
 }
 
@@ -341,7 +429,7 @@ static void isodep_r_frame_send(bool ack)
 {
 	size_t index = 0;
 	uint32_t fdt;
-	uint8_t *tx_data = t4t_isodep.tx_data.data;
+	uint8_t *tx_data = ctrl_frame_get();
 
 	tx_data[index] = ISODEP_R_BLOCK | (t4t_isodep.block_num & 1);
 
@@ -419,7 +507,7 @@ static int isodep_s_frame_handle(const uint8_t *data, size_t len)
 
 	/* Prepare S(WTX) response. */
 	index = 0;
-	tx_data = t4t_isodep.tx_data.data;
+	tx_data = ctrl_frame_get();
 
 	tx_data[index] = ISODEP_S_BLOCK | S_BLOCK_WTX_MASK;
 
@@ -493,8 +581,8 @@ static int isodep_r_frame_handle(const uint8_t *data, size_t len)
 		fdt = t4t_isodep.tag.fwt + T4T_FWT_DELTA + NFCA_T4T_FWT_T_FC;
 
 		if (t4t_isodep_cb->ready_to_send) {
-			t4t_isodep_cb->ready_to_send(t4t_isodep.tx_data.data,
-						     t4t_isodep.tx_data.len, fdt);
+			t4t_isodep_cb->ready_to_send(t4t_isodep.chunk.frame,
+						     t4t_isodep.chunk.len, fdt);
 
 			t4t_isodep.retransmit_cnt++;
 		}
@@ -709,6 +797,12 @@ int nfc_t4t_isodep_rats_send(enum nfc_t4t_isodep_fsd fsd, uint8_t did)
 {
 	uint8_t param;
 
+	if (fsd > T4T_FSDI_MAX) {
+		LOG_ERR("Unsupported FSD value.");
+
+		return -EINVAL;
+	}
+
 	if (atomic_cas(&t4t_isodep.state, ISODEP_STATE_INITIALIZED,
 		       ISODEP_STATE_TRANSFER)) {
 	} else if (atomic_cas(&t4t_isodep.state, ISODEP_STATE_SELECTED,
@@ -768,7 +862,7 @@ int nfc_t4t_isodep_tag_deselect(void)
 		return -EACCES;
 	}
 
-	tx_data = t4t_isodep.tx_data.data;
+	tx_data = ctrl_frame_get();
 
 	tx_data[index] = ISODEP_S_BLOCK;
 
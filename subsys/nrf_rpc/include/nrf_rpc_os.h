@@ -82,6 +82,13 @@ void nrf_rpc_os_remote_count(int count);
 static inline void nrf_rpc_os_remote_reserve(void)
 {
 	extern struct k_sem _nrf_rpc_os_remote_counter;
+	extern k_tid_t _nrf_rpc_os_remote_reserved;
+
+	/* Take the remote thread reserved by the transport, if any. */
+	if (_nrf_rpc_os_remote_reserved == k_current_get()) {
+		_nrf_rpc_os_remote_reserved = NULL;
+		return;
+	}
 
 	k_sem_take(&_nrf_rpc_os_remote_counter, K_FOREVER);
 }
@@ -93,6 +100,20 @@ static inline void nrf_rpc_os_remote_release(void)
 	k_sem_give(&_nrf_rpc_os_remote_counter);
 }
 
+/* Not in the nRF RPC OS API. The transport reserves a remote thread for a
+ * packet it holds back, in case the packet is an event, so that no other
+ * thread can take the last one before the event is sent. The next
+ * nrf_rpc_os_remote_reserve() call from the same thread takes the reserved
+ * remote thread without waiting.
+ */
+bool nrf_rpc_os_remote_try_reserve(void);
+
+/* Not in the nRF RPC OS API. Release the remote thread reserved with
+ * nrf_rpc_os_remote_try_reserve() by the current thread, if it has not been
+ * taken by nrf_rpc_os_remote_reserve().
+ */
+void nrf_rpc_os_remote_unreserve(void);
+
 #ifdef __cplusplus
 }
 #endif
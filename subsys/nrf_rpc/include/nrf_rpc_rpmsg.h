@@ -28,6 +28,15 @@ extern "C" {
 #define NRF_RPC_TR_MAX_HEADER_SIZE 0
 #define NRF_RPC_TR_AUTO_FREE_RX_BUF 1
 
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_BATCH)
+/* Frame type added by the transport after each packet. It is not
+ * negotiated: both cores must enable CONFIG_NRF_RPC_TR_RPMSG_BATCH.
+ */
+#define NRF_RPC_RPMSG_TRAILER_SIZE 1
+#else
+#define NRF_RPC_RPMSG_TRAILER_SIZE 0
+#endif
+
 typedef void (*nrf_rpc_tr_receive_handler_t)(const uint8_t *packet, size_t len);
 
 int nrf_rpc_tr_init(nrf_rpc_tr_receive_handler_t callback);
@@ -36,15 +45,56 @@ static inline void nrf_rpc_tr_free_rx_buf(const uint8_t *buf)
 {
 }
 
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_BATCH)
+uint8_t *nrf_rpc_rpmsg_tx_buf_alloc(uint8_t *stack_buf, size_t len);
+
+void nrf_rpc_rpmsg_tx_buf_free(uint8_t *buf);
+
+/* Packets are allocated in the shared memory, so that they are not copied
+ * when sent. The buffer on the stack is used only if the packet does not fit
+ * in the shared memory buffers.
+ */
+#define nrf_rpc_tr_alloc_tx_buf(buf, len)				       \
+	uint32_t _nrf_rpc_tr_buf_vla[(sizeof(uint32_t) - 1 + (len) +	       \
+				      NRF_RPC_RPMSG_TRAILER_SIZE) /	       \
+				     sizeof(uint32_t)];			       \
+	*(buf) = nrf_rpc_rpmsg_tx_buf_alloc(				       \
+		(uint8_t *)(&_nrf_rpc_tr_buf_vla), (len))
+
+#define nrf_rpc_tr_free_tx_buf(buf) nrf_rpc_rpmsg_tx_buf_free(buf)
+#else
 #define nrf_rpc_tr_alloc_tx_buf(buf, len)				       \
 	uint32_t _nrf_rpc_tr_buf_vla[(sizeof(uint32_t) - 1 + (len)) /	       \
 				     sizeof(uint32_t)];			       \
 	*(buf) = (uint8_t *)(&_nrf_rpc_tr_buf_vla)
 
 #define nrf_rpc_tr_free_tx_buf(buf)
+#endif
 
+/* The buffer must come from nrf_rpc_tr_alloc_tx_buf(). */
 int nrf_rpc_tr_send(uint8_t *buf, size_t len);
 
+/**@brief Start coalescing packets sent from the current thread.
+ *
+ * Packets sent by the current thread until @ref nrf_rpc_rpmsg_batch_end are
+ * sent to the other core in as few frames as possible, instead of one frame
+ * for each packet. Other threads that start a batch wait until the batch
+ * ends. Batches can be nested. Without CONFIG_NRF_RPC_TR_RPMSG_BATCH, each
+ * packet is still sent in its own frame.
+ *
+ * Only send events in a batch. A command waits for its response, but the
+ * command is not sent until the batch ends. The batch is sent earlier if the
+ * next event would wait for a thread on the other core.
+ */
+void nrf_rpc_rpmsg_batch_begin(void);
+
+/**@brief Send the packets coalesced since @ref nrf_rpc_rpmsg_batch_begin.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int nrf_rpc_rpmsg_batch_end(void);
+
 #ifdef __cplusplus
 }
 #endif
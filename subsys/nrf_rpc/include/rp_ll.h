@@ -8,10 +8,12 @@
 #define RP_LL_API_H_
 
 #include <zephyr.h>
+#if !defined(CONFIG_NRF_RPC_TR_LOOPBACK)
 #include <metal/sys.h>
 #include <metal/device.h>
 #include <metal/alloc.h>
 #include <openamp/open_amp.h>
+#endif
 
 /**
  * @file
@@ -48,7 +50,9 @@ typedef void (*rp_ll_event_handler)(struct rp_ll_endpoint *endpoint,
  * Content is not important for user of the API.
  */
 struct rp_ll_endpoint {
+#if !defined(CONFIG_NRF_RPC_TR_LOOPBACK)
 	struct rpmsg_endpoint rpmsg_ep;
+#endif
 	rp_ll_event_handler callback;
 	uint32_t flags;
 };
@@ -88,6 +92,56 @@ void rp_ll_endpoint_uninit(struct rp_ll_endpoint *endpoint);
 int rp_ll_send(struct rp_ll_endpoint *endpoint, const uint8_t *buf,
 	       size_t buf_len);
 
+/** @brief Gets a buffer in shared memory to send a packet in.
+ *
+ * The buffer must be sent with @ref rp_ll_send_nocopy, it cannot be
+ * returned otherwise. Waits until a buffer is available.
+ *
+ * @param endpoint endpoint to use
+ * @param size     size of the buffer
+ *
+ * @return buffer or NULL if no buffer is available
+ */
+uint8_t *rp_ll_tx_buf_get(struct rp_ll_endpoint *endpoint, size_t *size);
+
+/** @brief Sends a packet from a buffer in shared memory without copying it.
+ *
+ * @param endpoint endpoint to use
+ * @param buf      buffer from @ref rp_ll_tx_buf_get
+ * @param buf_len  length of the packet in @a buf
+ */
+int rp_ll_send_nocopy(struct rp_ll_endpoint *endpoint, uint8_t *buf,
+		      size_t buf_len);
+
+/** @brief Checks if a buffer is in shared memory.
+ *
+ * @param buf buffer to check
+ *
+ * @return true if @a buf is from @ref rp_ll_tx_buf_get
+ */
+bool rp_ll_buf_is_shared(const uint8_t *buf);
+
+#if defined(CONFIG_NRF_RPC_TR_LOOPBACK)
+/** @brief Loopback statistics */
+struct rp_ll_loopback_stats {
+	/** Packets received */
+	uint32_t packets;
+	/** Bytes received */
+	uint32_t bytes;
+	/** Packets that were copied into shared memory */
+	uint32_t copies;
+};
+
+/** @brief Gets the loopback statistics.
+ *
+ * @param stats statistics
+ */
+void rp_ll_loopback_stats_get(struct rp_ll_loopback_stats *stats);
+
+/** @brief Resets the loopback statistics. */
+void rp_ll_loopback_stats_reset(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,9 @@ static uint32_t remote_thread_total;
 
 struct k_sem _nrf_rpc_os_remote_counter;
 
+/* Thread that holds a remote thread reserved by the transport. */
+k_tid_t _nrf_rpc_os_remote_reserved;
+
 static K_THREAD_STACK_ARRAY_DEFINE(pool_stacks,
 	CONFIG_NRF_RPC_THREAD_POOL_SIZE,
 	CONFIG_NRF_RPC_THREAD_STACK_SIZE);
@@ -79,6 +82,7 @@ int nrf_rpc_os_init(nrf_rpc_os_work_t callback)
 		return err;
 	}
 	remote_thread_total = 0;
+	_nrf_rpc_os_remote_reserved = NULL;
 
 	atomic_set(&context_mask, CONTEXT_MASK_INIT_VALUE);
 
@@ -168,3 +172,24 @@ void nrf_rpc_os_remote_count(int count)
 		remote_thread_total--;
 	}
 }
+
+bool nrf_rpc_os_remote_try_reserve(void)
+{
+	__ASSERT_NO_MSG(_nrf_rpc_os_remote_reserved == NULL);
+
+	if (k_sem_take(&_nrf_rpc_os_remote_counter, K_NO_WAIT) != 0) {
+		return false;
+	}
+
+	_nrf_rpc_os_remote_reserved = k_current_get();
+
+	return true;
+}
+
+void nrf_rpc_os_remote_unreserve(void)
+{
+	if (_nrf_rpc_os_remote_reserved == k_current_get()) {
+		_nrf_rpc_os_remote_reserved = NULL;
+		k_sem_give(&_nrf_rpc_os_remote_counter);
+	}
+}
@@ -9,13 +9,11 @@
 
 #include <zephyr.h>
 #include <errno.h>
-#include <metal/sys.h>
-#include <metal/device.h>
-#include <metal/alloc.h>
-#include <openamp/open_amp.h>
+#include <sys/byteorder.h>
 
 #include "rp_ll.h"
 #include "nrf_rpc.h"
+#include "nrf_rpc_os.h"
 #include "nrf_rpc_rpmsg.h"
 
 /* Utility macro for dumping content of the packets with limit of 32 bytes
@@ -29,6 +27,39 @@
 	}								       \
 } while (0)
 
+#define FRAME_TRAILER_SIZE NRF_RPC_RPMSG_TRAILER_SIZE
+
+/* Frame types, stored in the last byte of each frame. */
+enum frame_type {
+	FRAME_PACKET,	/* One nRF RPC packet */
+	FRAME_BATCH,	/* Packets, each one following a batch entry header */
+	FRAME_EMPTY,	/* Unused buffer given back to the other core */
+};
+
+/* Batch entry header, followed by the packet padded to a word boundary */
+struct batch_entry {
+	uint16_t len;
+	uint16_t reserved;
+};
+
+#define BATCH_ENTRY_SIZE(len) \
+	ROUND_UP(sizeof(struct batch_entry) + (len), sizeof(uint32_t))
+
+/* Frame that the packets sent in a batch are coalesced into */
+static struct {
+	struct k_mutex lock;
+	k_tid_t owner;
+	uint32_t depth;
+	uint8_t *frame;
+	size_t size;
+	size_t len;
+	/* Packet allocated in the frame, but not sent yet */
+	uint8_t *packet;
+} batch;
+
+/* Size of the buffers in shared memory, known after the first one. */
+static size_t shared_buf_size;
+
 /* Semaphore used to do initial handshake */
 K_SEM_DEFINE(handshake_sem, 0, 1);
 
@@ -42,6 +73,12 @@ static struct rp_ll_endpoint ll_endpoint;
 static int translate_error(int rpmsg_err)
 {
 	switch (rpmsg_err) {
+#if defined(CONFIG_NRF_RPC_TR_LOOPBACK)
+	case -ENOMEM:
+		return -NRF_ENOMEM;
+	case -EINVAL:
+		return -NRF_EINVAL;
+#else
 	case RPMSG_ERR_BUFF_SIZE:
 	case RPMSG_ERR_NO_MEM:
 	case RPMSG_ERR_NO_BUFF:
@@ -52,6 +89,7 @@ static int translate_error(int rpmsg_err)
 	case RPMSG_ERR_INIT:
 	case RPMSG_ERR_ADDR:
 		return -NRF_EIO;
+#endif
 	default:
 		if (rpmsg_err < 0) {
 			return -NRF_EIO;
@@ -82,7 +120,150 @@ static void ll_event_handler(struct rp_ll_endpoint *endpoint,
 
 	DUMP_LIMITED_DBG(buf, length, "Received data");
 
-	receive_callback(buf, length);
+	if (!IS_ENABLED(CONFIG_NRF_RPC_TR_RPMSG_BATCH)) {
+		receive_callback(buf, length);
+		return;
+	}
+
+	if (length < FRAME_TRAILER_SIZE) {
+		NRF_RPC_ERR("Empty frame");
+		return;
+	}
+
+	length -= FRAME_TRAILER_SIZE;
+
+	switch (buf[length]) {
+	case FRAME_PACKET:
+		receive_callback(buf, length);
+		break;
+
+	case FRAME_BATCH:
+		while (length >= sizeof(struct batch_entry)) {
+			size_t len = sys_get_le16(buf);
+
+			if (BATCH_ENTRY_SIZE(len) > length) {
+				NRF_RPC_ERR("Truncated batch");
+				break;
+			}
+
+			receive_callback(&buf[sizeof(struct batch_entry)], len);
+
+			buf += BATCH_ENTRY_SIZE(len);
+			length -= BATCH_ENTRY_SIZE(len);
+		}
+		break;
+
+	case FRAME_EMPTY:
+		break;
+
+	default:
+		NRF_RPC_ERR("Unknown frame type %u", buf[length]);
+		break;
+	}
+}
+
+static int frame_send(uint8_t *buf, size_t len, enum frame_type type)
+{
+	int err;
+
+	if (IS_ENABLED(CONFIG_NRF_RPC_TR_RPMSG_BATCH)) {
+		buf[len] = type;
+		len += FRAME_TRAILER_SIZE;
+	}
+
+	DUMP_LIMITED_DBG(buf, len, "Send data");
+
+	if (rp_ll_buf_is_shared(buf)) {
+		err = rp_ll_send_nocopy(&ll_endpoint, buf, len);
+	} else {
+		err = rp_ll_send(&ll_endpoint, buf, len);
+	}
+
+	return translate_error(err);
+}
+
+static uint8_t *shared_buf_get(size_t *size)
+{
+	uint8_t *buf = rp_ll_tx_buf_get(&ll_endpoint, size);
+
+	if (buf) {
+		shared_buf_size = *size;
+	}
+
+	return buf;
+}
+
+static int batch_flush(void)
+{
+	int err;
+
+	if (!batch.frame) {
+		return 0;
+	}
+
+	NRF_RPC_ASSERT(batch.packet == NULL);
+
+	err = frame_send(batch.frame, batch.len,
+			 batch.len ? FRAME_BATCH : FRAME_EMPTY);
+
+	batch.frame = NULL;
+	batch.len = 0;
+
+	return err;
+}
+
+static bool batch_owned(void)
+{
+	return batch.depth > 0 && batch.owner == k_current_get();
+}
+
+static uint8_t *batch_alloc(size_t len)
+{
+	size_t needed = BATCH_ENTRY_SIZE(len) + FRAME_TRAILER_SIZE;
+	bool remote_free;
+
+	if (shared_buf_size && needed > shared_buf_size) {
+		/* Does not fit in any frame. */
+		return NULL;
+	}
+
+	/* Each event in the batch holds a remote thread until the other core
+	 * handles it. Reserve one for the packet in case it is an event, and
+	 * send the batch if there is none left, so that the event does not
+	 * wait for the events held back in the batch.
+	 */
+	remote_free = nrf_rpc_os_remote_try_reserve();
+
+	if (batch.frame && (batch.len + needed > batch.size ||
+			    (batch.len && !remote_free))) {
+		(void)batch_flush();
+	}
+
+	if (!batch.frame) {
+		batch.frame = shared_buf_get(&batch.size);
+		if (!batch.frame) {
+			nrf_rpc_os_remote_unreserve();
+			return NULL;
+		}
+	}
+
+	if (batch.len + needed > batch.size) {
+		nrf_rpc_os_remote_unreserve();
+		return NULL;
+	}
+
+	batch.packet = &batch.frame[batch.len + sizeof(struct batch_entry)];
+
+	return batch.packet;
+}
+
+static void batch_commit(size_t len)
+{
+	sys_put_le16(len, &batch.frame[batch.len]);
+	sys_put_le16(0, &batch.frame[batch.len + sizeof(uint16_t)]);
+
+	batch.len += BATCH_ENTRY_SIZE(len);
+	batch.packet = NULL;
 }
 
 int nrf_rpc_tr_init(nrf_rpc_tr_receive_handler_t callback)
@@ -93,6 +274,8 @@ int nrf_rpc_tr_init(nrf_rpc_tr_receive_handler_t callback)
 
 	receive_callback = callback;
 
+	k_mutex_init(&batch.lock);
+
 	err = rp_ll_init();
 	if (err != 0) {
 		goto error_exit;
@@ -115,15 +298,103 @@ error_exit:
 	return translate_error(err);
 }
 
-int nrf_rpc_tr_send(uint8_t *buf, size_t len)
+uint8_t *nrf_rpc_rpmsg_tx_buf_alloc(uint8_t *stack_buf, size_t len)
 {
-	int err;
+	uint8_t *buf;
+	size_t size;
+
+	if (batch_owned()) {
+		NRF_RPC_ASSERT(batch.packet == NULL);
+
+		buf = batch_alloc(len);
+		if (buf) {
+			return buf;
+		}
+
+		/* Waiting for a buffer while the batch holds one could take
+		 * forever.
+		 */
+		(void)batch_flush();
+	}
+
+	if (shared_buf_size && len + FRAME_TRAILER_SIZE > shared_buf_size) {
+		return stack_buf;
+	}
+
+	buf = shared_buf_get(&size);
+	if (!buf) {
+		return stack_buf;
+	}
+
+	if (len + FRAME_TRAILER_SIZE > size) {
+		(void)frame_send(buf, 0, FRAME_EMPTY);
+		return stack_buf;
+	}
+
+	return buf;
+}
 
+void nrf_rpc_rpmsg_tx_buf_free(uint8_t *buf)
+{
+	if (batch_owned() && buf == batch.packet) {
+		batch.packet = NULL;
+		nrf_rpc_os_remote_unreserve();
+		return;
+	}
+
+	if (rp_ll_buf_is_shared(buf)) {
+		/* Shared memory buffers only go back through the other core. */
+		(void)frame_send(buf, 0, FRAME_EMPTY);
+	}
+}
+
+int nrf_rpc_tr_send(uint8_t *buf, size_t len)
+{
 	NRF_RPC_ASSERT(buf != NULL);
 
-	DUMP_LIMITED_DBG(buf, len, "Send data");
+	if (batch_owned()) {
+		if (buf == batch.packet) {
+			batch_commit(len);
+			/* Only an event takes the reserved remote thread. */
+			nrf_rpc_os_remote_unreserve();
+			return 0;
+		}
+
+		/* Keep the order of the packets. */
+		(void)batch_flush();
+	}
 
-	err = rp_ll_send(&ll_endpoint, buf, len);
+	return frame_send(buf, len, FRAME_PACKET);
+}
 
-	return translate_error(err);
+void nrf_rpc_rpmsg_batch_begin(void)
+{
+	if (!IS_ENABLED(CONFIG_NRF_RPC_TR_RPMSG_BATCH)) {
+		return;
+	}
+
+	k_mutex_lock(&batch.lock, K_FOREVER);
+
+	batch.owner = k_current_get();
+	batch.depth++;
+}
+
+int nrf_rpc_rpmsg_batch_end(void)
+{
+	int err = 0;
+
+	if (!IS_ENABLED(CONFIG_NRF_RPC_TR_RPMSG_BATCH)) {
+		return 0;
+	}
+
+	NRF_RPC_ASSERT(batch_owned());
+
+	if (--batch.depth == 0) {
+		err = batch_flush();
+		batch.owner = NULL;
+	}
+
+	k_mutex_unlock(&batch.lock);
+
+	return err;
 }
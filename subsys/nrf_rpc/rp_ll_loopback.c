@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ *
+ */
+#include <zephyr.h>
+#include <errno.h>
+#include <string.h>
+
+#include "rp_ll.h"
+
+#include <logging/log.h>
+
+LOG_MODULE_REGISTER(rp_ll_loopback);
+
+/* Packets sent through an endpoint are received by the same endpoint, in
+ * the receive thread, as if they were sent by the other core.
+ */
+
+#define BUF_SIZE  CONFIG_NRF_RPC_TR_LOOPBACK_BUF_SIZE
+#define BUF_COUNT CONFIG_NRF_RPC_TR_LOOPBACK_BUF_COUNT
+
+/* Packet in flight */
+struct loopback_packet {
+	struct rp_ll_endpoint *endpoint;
+	uint8_t *buf;
+	size_t len;
+};
+
+static struct k_work_q my_work_q;
+static struct k_work work_item;
+
+static uint8_t __aligned(4) bufs[BUF_COUNT][BUF_SIZE];
+static struct k_mem_slab buf_slab;
+
+K_MSGQ_DEFINE(packet_queue, sizeof(struct loopback_packet), BUF_COUNT + 1, 4);
+
+static struct rp_ll_loopback_stats stats;
+
+/* Thread properties */
+static K_THREAD_STACK_DEFINE(rx_thread_stack,
+	CONFIG_NRF_RPC_TR_PRMSG_RX_STACK_SIZE);
+
+static void work_callback(struct k_work *item)
+{
+	struct loopback_packet packet;
+
+	ARG_UNUSED(item);
+
+	while (k_msgq_get(&packet_queue, &packet, K_NO_WAIT) == 0) {
+		struct rp_ll_endpoint *ep = packet.endpoint;
+
+		if (packet.buf == NULL) {
+			LOG_INF("Handshake done");
+			ep->callback(ep, RP_LL_EVENT_CONNECTED, NULL, 0);
+			continue;
+		}
+
+		stats.packets++;
+		stats.bytes += packet.len;
+
+		ep->callback(ep, RP_LL_EVENT_DATA, packet.buf, packet.len);
+		k_mem_slab_free(&buf_slab, (void **)&packet.buf);
+	}
+}
+
+static void packet_put(struct rp_ll_endpoint *endpoint, uint8_t *buf,
+		       size_t len)
+{
+	struct loopback_packet packet = {
+		.endpoint = endpoint,
+		.buf = buf,
+		.len = len
+	};
+
+	/* The queue has room for every buffer and the handshake. */
+	(void)k_msgq_put(&packet_queue, &packet, K_NO_WAIT);
+	k_work_submit_to_queue(&my_work_q, &work_item);
+}
+
+uint8_t *rp_ll_tx_buf_get(struct rp_ll_endpoint *endpoint, size_t *size)
+{
+	void *buf;
+
+	ARG_UNUSED(endpoint);
+
+	if (k_mem_slab_alloc(&buf_slab, &buf, K_FOREVER) != 0) {
+		return NULL;
+	}
+
+	*size = BUF_SIZE;
+
+	return buf;
+}
+
+int rp_ll_send_nocopy(struct rp_ll_endpoint *endpoint, uint8_t *buf,
+		      size_t buf_len)
+{
+	if (!rp_ll_buf_is_shared(buf) || buf_len > BUF_SIZE) {
+		return -EINVAL;
+	}
+
+	packet_put(endpoint, buf, buf_len);
+
+	return 0;
+}
+
+bool rp_ll_buf_is_shared(const uint8_t *buf)
+{
+	return (buf >= &bufs[0][0]) && (buf < &bufs[BUF_COUNT][0]);
+}
+
+int rp_ll_send(struct rp_ll_endpoint *endpoint, const uint8_t *buf,
+	size_t buf_len)
+{
+	uint8_t *tx_buf;
+	size_t size;
+
+	if (buf_len > BUF_SIZE) {
+		return -ENOMEM;
+	}
+
+	tx_buf = rp_ll_tx_buf_get(endpoint, &size);
+	if (!tx_buf) {
+		return -ENOMEM;
+	}
+
+	memcpy(tx_buf, buf, buf_len);
+	stats.copies++;
+
+	packet_put(endpoint, tx_buf, buf_len);
+
+	return 0;
+}
+
+void rp_ll_loopback_stats_get(struct rp_ll_loopback_stats *out)
+{
+	*out = stats;
+}
+
+void rp_ll_loopback_stats_reset(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+int rp_ll_init(void)
+{
+	int err;
+
+	err = k_mem_slab_init(&buf_slab, bufs, BUF_SIZE, BUF_COUNT);
+	if (err) {
+		LOG_ERR("Buffer initialization failed: %d", err);
+		return err;
+	}
+
+	k_work_q_start(&my_work_q, rx_thread_stack,
+		K_THREAD_STACK_SIZEOF(rx_thread_stack),
+		CONFIG_NRF_RPC_TR_PRMSG_RX_PRIORITY);
+	k_work_init(&work_item, work_callback);
+
+	LOG_DBG("initializing %s: SUCCESS", __func__);
+
+	return 0;
+}
+
+int rp_ll_endpoint_init(struct rp_ll_endpoint *endpoint,
+	int endpoint_number, rp_ll_event_handler callback, void *user_data)
+{
+	ARG_UNUSED(endpoint_number);
+	ARG_UNUSED(user_data);
+
+	endpoint->callback = callback;
+
+	/* The endpoint is its own counterpart. */
+	packet_put(endpoint, NULL, 0);
+
+	return 0;
+}
+
+void rp_ll_endpoint_uninit(struct rp_ll_endpoint *endpoint)
+{
+	ARG_UNUSED(endpoint);
+}
+
+void rp_ll_uninit(void)
+{
+	LOG_INF("Loopback uninitialized");
+}
@@ -9,10 +9,11 @@
 #include <sys/printk.h>
 #include <sys/util.h>
 #include <sys/byteorder.h>
+#include <sys/atomic.h>
 #include <zephyr.h>
-#include <SEGGER_RTT.h>
 #include <profiler.h>
 #include <string.h>
+#include "profiler_nordic_backend.h"
 
 
 /* By default, when there is no shell, all events are profiled. */
@@ -22,6 +23,7 @@ uint32_t profiler_enabled_events = 0xffffffff;
 
 
 static K_SEM_DEFINE(profiler_sem, 0, 1);
+static K_SEM_DEFINE(profiler_nordic_sem, 0, 1);
 static bool protocol_running;
 static bool sending_events;
 
@@ -31,6 +33,70 @@ enum nordic_command {
 	NORDIC_COMMAND_INFO	= 3
 };
 
+/* Compact trace record reporting the number of dropped events */
+#define RECORD_ID_DROPPED	0xFF
+
+/* Line preceding the event descriptions in compact trace format */
+#define INFO_FORMAT_COMPACT	"!format,compact\n"
+
+/* Time after which sending the event descriptions is abandoned */
+#define INFO_TIMEOUT_MS		10000
+
+/* Staged records start with a header word holding their length. The
+ * header is set last to let the profiler thread skip records that are
+ * still being written.
+ */
+#define RECORD_HDR_SIZE		sizeof(atomic_t)
+#define RECORD_COMMITTED	BIT(16)
+#define RECORD_LEN_MASK		BIT_MASK(16)
+
+/* Event type ID and timestamp come before the data of an event. */
+#define RECORD_DATA_OFFSET	(sizeof(uint8_t) + sizeof(uint32_t))
+#define RECORD_MAX_ARGS		((CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN - \
+				  RECORD_DATA_OFFSET) / sizeof(uint32_t))
+#define VARINT_MAX_LEN		5
+#define RECORD_ENCODED_MAX	(sizeof(uint8_t) + \
+				 VARINT_MAX_LEN * (1 + RECORD_MAX_ARGS))
+
+/* Encoded records are sent to the host in chunks up to this size. */
+#define CHUNK_SIZE		MAX(128, RECORD_ENCODED_MAX)
+
+#define STAGING_SIZE		CONFIG_PROFILER_NORDIC_STAGING_BUFFER_SIZE
+#define STAGING_MASK		(STAGING_SIZE - 1)
+
+BUILD_ASSERT((STAGING_SIZE & STAGING_MASK) == 0,
+	     "Staging buffer size must be a power of two");
+BUILD_ASSERT(RECORD_HDR_SIZE + CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN <=
+	     STAGING_SIZE / 2, "Staging buffer too small");
+BUILD_ASSERT(CHUNK_SIZE < CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE,
+	     "Data buffer too small");
+BUILD_ASSERT(CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS < RECORD_ID_DROPPED,
+	     "Event type ID reserved for the trace format");
+
+/* Staging buffer filled by events submitted on one CPU. Threads and
+ * interrupts reserve space with a compare-and-swap on the head, only the
+ * profiler thread moves the tail.
+ */
+struct staging_buf {
+	atomic_t head;
+	atomic_t tail;
+	atomic_t dropped;
+	atomic_t data[STAGING_SIZE / sizeof(atomic_t)];
+};
+
+static struct staging_buf staging[CONFIG_MP_NUM_CPUS];
+
+/* Values the compact trace format deltas refer to */
+static struct {
+	uint32_t timestamp;
+	uint32_t args[RECORD_MAX_ARGS];
+} last;
+
+static struct {
+	uint8_t buf[CHUNK_SIZE];
+	size_t len;
+} chunk;
+
 char descr[CONFIG_MAX_NUMBER_OF_CUSTOM_EVENTS]
 	  [CONFIG_MAX_LENGTH_OF_CUSTOM_EVENTS_DESCRIPTIONS];
 static char *arg_types_encodings[] = {
@@ -46,42 +112,244 @@ static char *arg_types_encodings[] = {
 
 uint8_t profiler_num_events;
 
-static uint8_t buffer_data[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
-static uint8_t buffer_info[CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE];
-static uint8_t buffer_commands[CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE];
-
 static k_tid_t protocol_thread_id;
 
 static K_THREAD_STACK_DEFINE(profiler_nordic_stack,
 			     CONFIG_PROFILER_NORDIC_STACK_SIZE);
 static struct k_thread profiler_nordic_thread;
 
-static int send_info_data(const char *data, size_t data_len)
+static struct staging_buf *staging_local(void)
+{
+#if CONFIG_MP_NUM_CPUS > 1
+	return &staging[arch_curr_cpu()->id];
+#else
+	return &staging[0];
+#endif
+}
+
+static void staging_copy_in(struct staging_buf *sb, uint32_t pos,
+			    const uint8_t *data, size_t len)
 {
-	uint8_t retry_cnt = 0;
-	static const uint8_t retry_cnt_max = 100;
+	uint8_t *dst = (uint8_t *)sb->data;
+	size_t off = pos & STAGING_MASK;
+	size_t part = MIN(len, STAGING_SIZE - off);
 
-	size_t num_bytes_send;
+	memcpy(dst + off, data, part);
+	memcpy(dst, data + part, len - part);
+}
 
-	num_bytes_send = SEGGER_RTT_WriteNoLock(
-				  CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-				  data, data_len);
+static void staging_copy_out(struct staging_buf *sb, uint32_t pos,
+			     uint8_t *buf, size_t len)
+{
+	const uint8_t *src = (const uint8_t *)sb->data;
+	size_t off = pos & STAGING_MASK;
+	size_t part = MIN(len, STAGING_SIZE - off);
 
-	while (num_bytes_send == 0) {
-		/* Give host time to read the data and free some space
-		 * in the buffer. */
-		k_sleep(K_MSEC(100));
-		num_bytes_send = SEGGER_RTT_WriteNoLock(
-				  CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-				  data, data_len);
+	memcpy(buf, src + off, part);
+	memcpy(buf + part, src, len - part);
+}
+
+static void staging_clear(struct staging_buf *sb, uint32_t pos, size_t len)
+{
+	uint8_t *dst = (uint8_t *)sb->data;
+	size_t off = pos & STAGING_MASK;
+	size_t part = MIN(len, STAGING_SIZE - off);
+
+	memset(dst + off, 0, part);
+	memset(dst, 0, len - part);
+}
+
+static void staging_put(const uint8_t *data, size_t len)
+{
+	struct staging_buf *sb = staging_local();
+	uint32_t size = ROUND_UP(RECORD_HDR_SIZE + len, sizeof(atomic_t));
+	uint32_t head;
+	uint32_t used;
+
+	do {
+		head = (uint32_t)atomic_get(&sb->head);
+		used = head - (uint32_t)atomic_get(&sb->tail);
+
+		if (size > STAGING_SIZE - used) {
+			atomic_inc(&sb->dropped);
+			return;
+		}
+	} while (!atomic_cas(&sb->head, (atomic_val_t)head,
+			     (atomic_val_t)(head + size)));
+
+	staging_copy_in(sb, head + RECORD_HDR_SIZE, data, len);
+	(void)atomic_set(&sb->data[(head & STAGING_MASK) / sizeof(atomic_t)],
+			 RECORD_COMMITTED | len);
+
+	if ((used < STAGING_SIZE / 2) && (used + size >= STAGING_SIZE / 2)) {
+		profiler_nordic_notify();
+	}
+}
+
+static size_t staging_take(struct staging_buf *sb, uint8_t *buf)
+{
+	uint32_t tail = (uint32_t)atomic_get(&sb->tail);
+	atomic_val_t hdr;
+	size_t len;
+	size_t size;
+
+	if (tail == (uint32_t)atomic_get(&sb->head)) {
+		return 0;
+	}
+
+	hdr = atomic_get(&sb->data[(tail & STAGING_MASK) / sizeof(atomic_t)]);
+	if (!(hdr & RECORD_COMMITTED)) {
+		/* Interrupted while being written, taken on the next flush. */
+		return 0;
+	}
+
+	len = hdr & RECORD_LEN_MASK;
+	size = ROUND_UP(RECORD_HDR_SIZE + len, sizeof(atomic_t));
+
+	staging_copy_out(sb, tail + RECORD_HDR_SIZE, buf, len);
+	/* Free space must not contain committed record headers. */
+	staging_clear(sb, tail, size);
+	(void)atomic_set(&sb->tail, (atomic_val_t)(tail + size));
+
+	return len;
+}
+
+static size_t varint_encode(uint8_t *buf, uint32_t value)
+{
+	size_t len = 0;
+
+	while (value >= 0x80) {
+		buf[len++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	buf[len++] = value;
+
+	return len;
+}
+
+static size_t delta_encode(uint8_t *buf, uint32_t *prev, uint32_t value)
+{
+	int32_t delta = (int32_t)(value - *prev);
+
+	*prev = value;
+
+	/* Zigzag encoding keeps small negative deltas short. */
+	return varint_encode(buf, ((uint32_t)delta << 1) ^
+				  (uint32_t)(delta >> 31));
+}
+
+static size_t record_encode(uint8_t *buf, const uint8_t *record, size_t len)
+{
+	size_t pos = 0;
+
+	if (!IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT)) {
+		memcpy(buf, record, len);
+		return len;
+	}
+
+	buf[pos++] = record[0];
+	pos += delta_encode(&buf[pos], &last.timestamp,
+			    sys_get_le32(&record[sizeof(uint8_t)]));
+
+	for (size_t i = 0; RECORD_DATA_OFFSET + i * sizeof(uint32_t) < len;
+	     i++) {
+		pos += delta_encode(&buf[pos], &last.args[i],
+			sys_get_le32(&record[RECORD_DATA_OFFSET +
+					     i * sizeof(uint32_t)]));
+	}
 
+	return pos;
+}
+
+static bool chunk_send(void)
+{
+	if ((chunk.len > 0) &&
+	    !profiler_nordic_backend_data_write(chunk.buf, chunk.len)) {
+		return false;
+	}
+
+	chunk.len = 0;
+	return true;
+}
+
+/* The legacy trace format has no record for dropped events, so they are
+ * reported on the console instead.
+ */
+static bool dropped_report(struct staging_buf *sb)
+{
+	if (!IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT)) {
+		printk("Profiler: %u events dropped\n",
+		       (uint32_t)atomic_set(&sb->dropped, 0));
+		return true;
+	}
+
+	if ((chunk.len + 1 + VARINT_MAX_LEN > CHUNK_SIZE) && !chunk_send()) {
+		return false;
+	}
+
+	chunk.buf[chunk.len++] = RECORD_ID_DROPPED;
+	chunk.len += varint_encode(&chunk.buf[chunk.len],
+				   (uint32_t)atomic_set(&sb->dropped, 0));
+
+	return true;
+}
+
+static void staging_flush(void)
+{
+	uint8_t record[CONFIG_PROFILER_CUSTOM_EVENT_BUF_LEN];
+	size_t len;
+
+	/* Events wait in the staging buffers until the host makes room for
+	 * the data that was not accepted before.
+	 */
+	if (!chunk_send()) {
+		return;
+	}
+
+	for (size_t cpu = 0; cpu < ARRAY_SIZE(staging); cpu++) {
+		struct staging_buf *sb = &staging[cpu];
+
+		if (atomic_get(&sb->dropped) && !dropped_report(sb)) {
+			return;
+		}
+
+		while (true) {
+			if ((chunk.len + RECORD_ENCODED_MAX > CHUNK_SIZE) &&
+			    !chunk_send()) {
+				return;
+			}
+
+			len = staging_take(sb, record);
+			if (len == 0) {
+				break;
+			}
+
+			chunk.len += record_encode(&chunk.buf[chunk.len],
+						   record, len);
+		}
+	}
+
+	(void)chunk_send();
+}
+
+static int send_info_data(const char *data, size_t data_len)
+{
+	int64_t timeout = k_uptime_get() + INFO_TIMEOUT_MS;
+
+	while (!profiler_nordic_backend_info_write(data, data_len)) {
 		/* Avoid being blocked in while loop if host does not read
-		 * the RTT data.
+		 * the data.
 		 */
-		retry_cnt++;
-		if (retry_cnt > retry_cnt_max) {
+		if (k_uptime_get() > timeout) {
 			return -ENOBUFS;
 		}
+
+		/* Give host time to read the data and free some space
+		 * in the buffer. Keep passing on events meanwhile.
+		 */
+		(void)k_sem_take(&profiler_nordic_sem,
+			K_MSEC(CONFIG_PROFILER_NORDIC_FLUSH_PERIOD_MS));
+		staging_flush();
 	}
 
 	return 0;
@@ -94,10 +362,15 @@ static void send_system_description(void)
 	 */
 	uint8_t ne = profiler_num_events;
 
-	__DMB();
+	__sync_synchronize();
 	char end_line = '\n';
 	int err = 0;
 
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT)) {
+		err = send_info_data(INFO_FORMAT_COMPACT,
+				     strlen(INFO_FORMAT_COMPACT));
+	}
+
 	for (size_t t = 0; ((t < ne) && !err); t++) {
 		err = send_info_data(descr[t], strlen(descr[t]));
 		if (!err) {
@@ -110,36 +383,49 @@ static void send_system_description(void)
 	}
 }
 
+static void handle_command(enum nordic_command command)
+{
+	switch (command) {
+	case NORDIC_COMMAND_START:
+		/* Host decodes deltas from the start of the trace. */
+		memset(&last, 0, sizeof(last));
+		chunk.len = 0;
+		sending_events = true;
+		break;
+	case NORDIC_COMMAND_STOP:
+		sending_events = false;
+		break;
+	case NORDIC_COMMAND_INFO:
+		send_system_description();
+		break;
+	default:
+		__ASSERT_NO_MSG(false);
+		break;
+	}
+}
+
 static void profiler_nordic_thread_fn(void)
 {
 	while (protocol_running) {
-		uint8_t read_data;
-		enum nordic_command command;
-
-		if (SEGGER_RTT_Read(
-		     CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
-		     &read_data, sizeof(read_data))) {
-			command = (enum nordic_command)read_data;
-			switch (command) {
-			case NORDIC_COMMAND_START:
-				sending_events = true;
-				break;
-			case NORDIC_COMMAND_STOP:
-				sending_events = false;
-				break;
-			case NORDIC_COMMAND_INFO:
-				send_system_description();
-				break;
-			default:
-				__ASSERT_NO_MSG(false);
-				break;
-			}
+		uint8_t command;
+
+		(void)k_sem_take(&profiler_nordic_sem,
+			K_MSEC(CONFIG_PROFILER_NORDIC_FLUSH_PERIOD_MS));
+
+		while (profiler_nordic_backend_command_read(&command)) {
+			handle_command((enum nordic_command)command);
 		}
-		k_sleep(K_MSEC(500));
+
+		staging_flush();
 	}
 	k_sem_give(&profiler_sem);
 }
 
+void profiler_nordic_notify(void)
+{
+	k_sem_give(&profiler_nordic_sem);
+}
+
 int profiler_init(void)
 {
 	protocol_running = true;
@@ -148,29 +434,10 @@ int profiler_init(void)
 	}
 	int ret;
 
-	ret = SEGGER_RTT_ConfigUpBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
-		"Nordic profiler data",
-		buffer_data,
-		CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
-
-	ret = SEGGER_RTT_ConfigUpBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
-		"Nordic profiler info",
-		buffer_info,
-		CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
-
-	ret = SEGGER_RTT_ConfigDownBuffer(
-		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
-		"Nordic profiler command",
-		buffer_commands,
-		CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE,
-		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
-	__ASSERT_NO_MSG(ret >= 0);
+	ret = profiler_nordic_backend_init();
+	if (ret) {
+		return ret;
+	}
 
 	protocol_thread_id =  k_thread_create(&profiler_nordic_thread,
 			profiler_nordic_stack,
@@ -185,7 +452,7 @@ void profiler_term(void)
 {
 	sending_events = false;
 	protocol_running = false;
-	k_wakeup(protocol_thread_id);
+	profiler_nordic_notify();
 	k_sem_take(&profiler_sem, K_FOREVER);
 }
 
@@ -233,7 +500,7 @@ uint16_t profiler_register_event_type(const char *name, const char **args,
 	/* Memory barrier to make sure that data is visible
 	 * before being accessed
 	 */
-	__DMB();
+	__sync_synchronize();
 	profiler_num_events++;
 	k_sched_unlock();
 
@@ -259,7 +526,7 @@ void profiler_log_encode_u32(struct log_event_buf *buf, uint32_t data)
 void profiler_log_add_mem_address(struct log_event_buf *buf,
 				  const void *mem_address)
 {
-	profiler_log_encode_u32(buf, (uint32_t)mem_address);
+	profiler_log_encode_u32(buf, (uint32_t)(uintptr_t)mem_address);
 }
 
 void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
@@ -269,14 +536,7 @@ void profiler_log_send(struct log_event_buf *buf, uint16_t event_type_id)
 		uint8_t type_id = event_type_id & UCHAR_MAX;
 
 		buf->payload_start[0] = type_id;
-		int key = irq_lock();
-
-		uint8_t num_bytes_send = SEGGER_RTT_WriteNoLock(
-				CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
-				buf->payload_start,
-				buf->payload - buf->payload_start);
-		ARG_UNUSED(num_bytes_send);
-		irq_unlock(key);
-		__ASSERT_NO_MSG(num_bytes_send > 0);
+		staging_put(buf->payload_start,
+			    buf->payload - buf->payload_start);
 	}
 }
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _PROFILER_NORDIC_BACKEND_H_
+#define _PROFILER_NORDIC_BACKEND_H_
+
+#include <zephyr/types.h>
+
+/** @brief Initialize the transport used to communicate with the host.
+ *
+ * @retval 0 If the operation was successful.
+ */
+int profiler_nordic_backend_init(void);
+
+/** @brief Send trace data to the host.
+ *
+ * Data is either sent as a whole or not at all.
+ *
+ * @param data Data to send.
+ * @param len Length of the data.
+ *
+ * @return Number of bytes sent.
+ */
+size_t profiler_nordic_backend_data_write(const void *data, size_t len);
+
+/** @brief Send event descriptions to the host.
+ *
+ * Data is either sent as a whole or not at all.
+ *
+ * @param data Data to send.
+ * @param len Length of the data.
+ *
+ * @return Number of bytes sent.
+ */
+size_t profiler_nordic_backend_info_write(const void *data, size_t len);
+
+/** @brief Read a command received from the host.
+ *
+ * @param command Pointer to the command.
+ *
+ * @retval true If a command was read.
+ */
+bool profiler_nordic_backend_command_read(uint8_t *command);
+
+/** @brief Wake up the profiler thread.
+ *
+ * Backends call this function when a command is received.
+ */
+void profiler_nordic_notify(void);
+
+#endif /* _PROFILER_NORDIC_BACKEND_H_ */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <errno.h>
+#include <zephyr.h>
+#include <spinlock.h>
+#include <sys/ring_buffer.h>
+#include <profiler.h>
+#include "profiler_nordic_backend.h"
+
+
+RING_BUF_DECLARE(buffer_data, CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE);
+RING_BUF_DECLARE(buffer_info, CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE);
+RING_BUF_DECLARE(buffer_commands, CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE);
+
+static struct k_spinlock lock;
+
+static size_t buffer_write(struct ring_buf *rb, const void *data,
+			   size_t len)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (ring_buf_space_get(rb) < len) {
+		len = 0;
+	} else {
+		len = ring_buf_put(rb, data, len);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return len;
+}
+
+static size_t buffer_read(struct ring_buf *rb, uint8_t *buf, size_t size)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	size = ring_buf_get(rb, buf, size);
+
+	k_spin_unlock(&lock, key);
+
+	return size;
+}
+
+int profiler_nordic_backend_init(void)
+{
+	ring_buf_reset(&buffer_data);
+	ring_buf_reset(&buffer_info);
+	ring_buf_reset(&buffer_commands);
+
+	return 0;
+}
+
+size_t profiler_nordic_backend_data_write(const void *data, size_t len)
+{
+	return buffer_write(&buffer_data, data, len);
+}
+
+size_t profiler_nordic_backend_info_write(const void *data, size_t len)
+{
+	return buffer_write(&buffer_info, data, len);
+}
+
+bool profiler_nordic_backend_command_read(uint8_t *command)
+{
+	return buffer_read(&buffer_commands, command, sizeof(*command)) > 0;
+}
+
+size_t profiler_nordic_mem_data_read(uint8_t *buf, size_t size)
+{
+	return buffer_read(&buffer_data, buf, size);
+}
+
+size_t profiler_nordic_mem_info_read(uint8_t *buf, size_t size)
+{
+	return buffer_read(&buffer_info, buf, size);
+}
+
+int profiler_nordic_mem_command_write(uint8_t command)
+{
+	if (!buffer_write(&buffer_commands, &command, sizeof(command))) {
+		return -ENOBUFS;
+	}
+
+	profiler_nordic_notify();
+
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <SEGGER_RTT.h>
+#include "profiler_nordic_backend.h"
+
+
+static uint8_t buffer_data[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
+static uint8_t buffer_info[CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE];
+static uint8_t buffer_commands[CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE];
+
+int profiler_nordic_backend_init(void)
+{
+	int ret;
+
+	ret = SEGGER_RTT_ConfigUpBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+		"Nordic profiler data",
+		buffer_data,
+		CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE,
+		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	ret = SEGGER_RTT_ConfigUpBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
+		"Nordic profiler info",
+		buffer_info,
+		CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE,
+		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	ret = SEGGER_RTT_ConfigDownBuffer(
+		CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
+		"Nordic profiler command",
+		buffer_commands,
+		CONFIG_PROFILER_NORDIC_COMMAND_BUFFER_SIZE,
+		SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	__ASSERT_NO_MSG(ret >= 0);
+
+	return 0;
+}
+
+size_t profiler_nordic_backend_data_write(const void *data, size_t len)
+{
+	/* Only the profiler thread writes to the channel. */
+	return SEGGER_RTT_WriteNoLock(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_DATA,
+				      data, len);
+}
+
+size_t profiler_nordic_backend_info_write(const void *data, size_t len)
+{
+	return SEGGER_RTT_WriteNoLock(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_INFO,
+				      data, len);
+}
+
+bool profiler_nordic_backend_command_read(uint8_t *command)
+{
+	/* The host cannot signal written data, the profiler thread checks
+	 * for commands every time it flushes the staging buffers.
+	 */
+	if (!SEGGER_RTT_HasData(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS)) {
+		return false;
+	}
+
+	return SEGGER_RTT_Read(CONFIG_PROFILER_NORDIC_RTT_CHANNEL_COMMANDS,
+			       command, sizeof(*command)) > 0;
+}
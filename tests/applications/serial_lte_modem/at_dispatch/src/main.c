@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include "slm_util.h"
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+#include <time.h>
+#endif
+
+/* Number of dispatches timed per command. */
+#define ITERATIONS 10000
+
+struct test_cmd {
+	const char *name;
+};
+
+/* Full SLM command set, from the list the table in slm_at_host.c is built
+ * from. All the optional modules are enabled in CMakeLists.txt.
+ */
+static const struct test_cmd sorted_cmds[] = {
+#define SLM_AT_CMD(_name, _handler) {_name},
+#include "slm_at_cmds.h"
+#undef SLM_AT_CMD
+};
+
+/* The same commands in the order the module parsers used to be tried in,
+ * which is the baseline for the benchmark.
+ */
+static const char * const chain_cmds[] = {
+	"AT#XSLMVER", "AT#XSLMUART", "AT#XRESET", "AT#XCLAC", "AT#XSLEEP",
+	"AT#XTCPSVR", "AT#XTCPCLI", "AT#XTCPSEND", "AT#XTCPRECV",
+	"AT#XUDPSVR", "AT#XUDPCLI", "AT#XUDPSEND",
+	"AT#XSOCKET", "AT#XSOCKETOPT", "AT#XBIND", "AT#XCONNECT",
+	"AT#XLISTEN", "AT#XACCEPT", "AT#XSEND", "AT#XRECV", "AT#XSENDTO",
+	"AT#XRECVFROM", "AT#XGETADDRINFO",
+	"AT%CMNG",
+	"AT#XPING",
+	"AT#XFOTA",
+	"AT#XGPS",
+	"AT#XFTP",
+	"AT#XMQTTCON", "AT#XMQTTPUB", "AT#XMQTTSUB", "AT#XMQTTUNSUB",
+	"AT#XHTTPCCON", "AT#XHTTPCREQ",
+	"AT+CMUX",
+};
+
+/* Commands that are not SLM commands, and go to the modem. */
+static const char * const modem_cmds[] = {
+	"AT+CFUN?",
+	"AT+CEREG=5",
+	"AT%XSYSTEMMODE=1,0,0,0",
+};
+
+/* Keeps the compiler from optimizing out the timed lookups. */
+static const char * volatile sink;
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+/* Simulated time does not advance while the CPU is busy, use the host clock
+ * instead.
+ */
+static uint64_t timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static uint64_t elapsed_ns(uint64_t start)
+{
+	return timestamp() - start;
+}
+#else
+static uint64_t timestamp(void)
+{
+	return k_cycle_get_32();
+}
+
+static uint64_t elapsed_ns(uint64_t start)
+{
+	return k_cyc_to_ns_floor64(k_cycle_get_32() - (uint32_t)start);
+}
+#endif
+
+static const char *chain_find(const char *cmd)
+{
+	for (int i = 0; i < ARRAY_SIZE(chain_cmds); i++) {
+		if (slm_util_cmd_casecmp(cmd, chain_cmds[i])) {
+			return chain_cmds[i];
+		}
+	}
+
+	return NULL;
+}
+
+static const char *table_find(const char *cmd)
+{
+	const struct test_cmd *entry;
+
+	entry = slm_util_at_cmd_find(cmd, sorted_cmds, ARRAY_SIZE(sorted_cmds),
+				     sizeof(sorted_cmds[0]));
+
+	return entry ? entry->name : NULL;
+}
+
+static void test_table_sorted(void)
+{
+	zassert_equal(ARRAY_SIZE(sorted_cmds), ARRAY_SIZE(chain_cmds), NULL);
+
+	for (int i = 1; i < ARRAY_SIZE(sorted_cmds); i++) {
+		zassert_true(strcmp(sorted_cmds[i - 1].name,
+				    sorted_cmds[i].name) < 0,
+			     "Not sorted at %s", sorted_cmds[i].name);
+	}
+}
+
+static void test_find(void)
+{
+	for (int i = 0; i < ARRAY_SIZE(chain_cmds); i++) {
+		zassert_equal(table_find(chain_cmds[i]), chain_find(chain_cmds[i]),
+			      "Mismatch for %s", chain_cmds[i]);
+	}
+
+	zassert_equal(strcmp(table_find("AT#XSOCKET=1,1,0"), "AT#XSOCKET"), 0,
+		      NULL);
+	zassert_equal(strcmp(table_find("at#xsocket?"), "AT#XSOCKET"), 0, NULL);
+	zassert_equal(strcmp(table_find("AT#XSocketOpt=?"), "AT#XSOCKETOPT"), 0,
+		      NULL);
+	zassert_equal(strcmp(table_find("AT#XSEND=\"x\""), "AT#XSEND"), 0,
+		      NULL);
+	zassert_equal(strcmp(table_find("AT#XSENDTO=\"x\""), "AT#XSENDTO"), 0,
+		      NULL);
+	zassert_equal(strcmp(table_find("AT#XSLMVER\r\n"), "AT#XSLMVER"), 0,
+		      NULL);
+	zassert_equal(strcmp(table_find("AT%CMNG=1"), "AT%CMNG"), 0, NULL);
+
+	zassert_is_null(table_find(""), NULL);
+	zassert_is_null(table_find("AT#X"), NULL);
+	zassert_is_null(table_find("AT#XSOCKETS=1"), NULL);
+	zassert_is_null(table_find("AT#XGETADDRINFOXXXXXXXXXXXXXXXXX"), NULL);
+	zassert_is_null(table_find("some data in data mode"), NULL);
+
+	for (int i = 0; i < ARRAY_SIZE(modem_cmds); i++) {
+		zassert_is_null(table_find(modem_cmds[i]), NULL);
+		zassert_is_null(chain_find(modem_cmds[i]), NULL);
+	}
+}
+
+static void benchmark(const char *cmd, uint64_t *chain_total,
+		      uint64_t *table_total)
+{
+	uint64_t chain_ns;
+	uint64_t table_ns;
+	uint64_t start;
+
+	start = timestamp();
+	for (int i = 0; i < ITERATIONS; i++) {
+		sink = chain_find(cmd);
+	}
+	chain_ns = elapsed_ns(start);
+
+	start = timestamp();
+	for (int i = 0; i < ITERATIONS; i++) {
+		sink = table_find(cmd);
+	}
+	table_ns = elapsed_ns(start);
+
+	TC_PRINT("%-28s %6u ns %6u ns\n", cmd,
+		 (uint32_t)(chain_ns / ITERATIONS),
+		 (uint32_t)(table_ns / ITERATIONS));
+
+	*chain_total += chain_ns;
+	*table_total += table_ns;
+}
+
+static void test_dispatch_benchmark(void)
+{
+	char cmd[SLM_AT_CMD_NAME_MAX_LEN + 8];
+	uint64_t chain_total = 0;
+	uint64_t table_total = 0;
+	int count = 0;
+
+	TC_PRINT("%-28s %9s %9s\n", "Command", "Linear", "Table");
+
+	for (int i = 0; i < ARRAY_SIZE(chain_cmds); i++, count++) {
+		snprintf(cmd, sizeof(cmd), "%s=1,2", chain_cmds[i]);
+		benchmark(cmd, &chain_total, &table_total);
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(modem_cmds); i++, count++) {
+		benchmark(modem_cmds[i], &chain_total, &table_total);
+	}
+
+	TC_PRINT("%-28s %6u ns %6u ns\n", "Average",
+		 (uint32_t)(chain_total / (count * ITERATIONS)),
+		 (uint32_t)(table_total / (count * ITERATIONS)));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(at_dispatch_test,
+			 ztest_unit_test(test_table_sorted),
+			 ztest_unit_test(test_find),
+			 ztest_unit_test(test_dispatch_benchmark)
+			 );
+
+	ztest_run_test_suite(at_dispatch_test);
+}
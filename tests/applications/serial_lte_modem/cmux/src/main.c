@@ -0,0 +1,682 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <sys/atomic.h>
+#include "slm_cmux.h"
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+#include <time.h>
+#endif
+
+/* The test plays the host side of the link. Frames written by the
+ * multiplexer are decoded here, and frames from the host are passed to
+ * slm_cmux_input(), in place of the UART.
+ */
+
+#define N1		CONFIG_SLM_CMUX_N1_MAX
+#define THROUGHPUT_LEN	(64 * 1024)
+#define FRAME_QUEUE_LEN	16
+#define FRAME_DATA_LEN	32
+
+#define EA		0x01
+#define CR		0x02
+#define MSG_PN		0x80
+#define MSG_TEST	0x20
+#define MSG_MSC		0xE0
+#define MSG_NSC		0x10
+
+#define SENDER_STACK_SIZE	2048
+#define SENDER_PRIORITY		K_PRIO_PREEMPT(5)
+
+struct peer_frame {
+	uint8_t dlci;
+	uint8_t type;
+	bool cr;
+	bool pf;
+	uint8_t data[FRAME_DATA_LEN];
+	uint16_t len;
+};
+
+static struct {
+	struct slm_cmux_decoder dec;
+	uint8_t dec_buf[SLM_CMUX_DECODER_BUF_SIZE(N1)];
+	/* Frames the host may send on the data channel */
+	int tx_credits;
+	/* Frames received on the data channel, not yet credited back */
+	atomic_t consumed;
+	size_t data_len;
+	bool data_error;
+	struct peer_frame frames[FRAME_QUEUE_LEN];
+	int head;
+	int tail;
+	int rx_ready[SLM_CMUX_DLCI_COUNT];
+	bool open[SLM_CMUX_DLCI_COUNT];
+} peer;
+
+static K_MUTEX_DEFINE(peer_lock);
+static K_SEM_DEFINE(peer_sem, 0, 1);
+
+static K_THREAD_STACK_DEFINE(sender_stack, SENDER_STACK_SIZE);
+static struct k_thread sender_thread;
+static uint8_t pattern[1024];
+static int sender_result;
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+/* Simulated time does not advance while the CPU is busy, use the host clock
+ * instead.
+ */
+static uint64_t timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static uint64_t elapsed_ns(uint64_t start)
+{
+	return timestamp() - start;
+}
+#else
+static uint64_t timestamp(void)
+{
+	return k_cycle_get_32();
+}
+
+static uint64_t elapsed_ns(uint64_t start)
+{
+	return k_cyc_to_ns_floor64(k_cycle_get_32() - (uint32_t)start);
+}
+#endif
+
+static void peer_data_handle(const uint8_t *data, uint16_t len)
+{
+	for (int i = 0; i < len; i++) {
+		if (data[i] != (uint8_t)(peer.data_len + i)) {
+			peer.data_error = true;
+		}
+	}
+	peer.data_len += len;
+	atomic_inc(&peer.consumed);
+	k_sem_give(&peer_sem);
+}
+
+static void peer_frame_handle(const struct slm_cmux_frame *frame)
+{
+	const uint8_t *data = frame->data;
+	uint16_t len = frame->len;
+	struct peer_frame *entry;
+
+	if (frame->has_credits) {
+		peer.tx_credits += frame->credits;
+	}
+	if (frame->type == SLM_CMUX_UIH && frame->dlci == SLM_CMUX_DLCI_DATA) {
+		if (len > 0) {
+			peer_data_handle(data, len);
+		}
+		return;
+	}
+
+	/* Everything else is checked by the test cases */
+	entry = &peer.frames[peer.head % FRAME_QUEUE_LEN];
+	entry->dlci = frame->dlci;
+	entry->type = frame->type;
+	entry->cr = frame->cr;
+	entry->pf = frame->pf;
+	entry->len = MIN(len, FRAME_DATA_LEN);
+	memcpy(entry->data, data, entry->len);
+	peer.head++;
+}
+
+static int loop_write(const uint8_t *data, size_t len)
+{
+	struct slm_cmux_frame frame;
+
+	k_mutex_lock(&peer_lock, K_FOREVER);
+	for (size_t i = 0; i < len; i++) {
+		if (slm_cmux_decode(&peer.dec, data[i], &frame) == 1) {
+			peer_frame_handle(&frame);
+		}
+	}
+	k_mutex_unlock(&peer_lock);
+
+	return 0;
+}
+
+static void loop_rx_ready(uint8_t dlci)
+{
+	peer.rx_ready[dlci]++;
+}
+
+static void loop_state_changed(uint8_t dlci, bool open)
+{
+	peer.open[dlci] = open;
+}
+
+static void loop_start(enum slm_cmux_mode mode, uint16_t n1)
+{
+	struct slm_cmux_config cfg = {
+		.mode = mode,
+		.n1 = n1,
+		.write = loop_write,
+		.rx_ready = loop_rx_ready,
+		.state_changed = loop_state_changed,
+	};
+
+	memset(&peer, 0, sizeof(peer));
+	slm_cmux_decoder_init(&peer.dec, mode, peer.dec_buf,
+			      sizeof(peer.dec_buf));
+	k_sem_reset(&peer_sem);
+	zassert_equal(slm_cmux_start(&cfg), 0, NULL);
+}
+
+static void peer_frame_send(const struct slm_cmux_frame *frame)
+{
+	static uint8_t buf[SLM_CMUX_FRAME_SIZE(N1)];
+	int ret;
+
+	ret = slm_cmux_frame_encode(peer.dec.mode, frame, buf, sizeof(buf));
+	zassert_true(ret > 0, "Encoding failed: %d", ret);
+	slm_cmux_input(buf, ret);
+}
+
+static void peer_send(uint8_t dlci, uint8_t type, bool pf,
+		      const uint8_t *data, uint16_t len)
+{
+	struct slm_cmux_frame frame = {
+		.dlci = dlci,
+		.type = type,
+		.cr = true,
+		.pf = pf,
+		.data = data,
+		.len = len,
+	};
+
+	peer_frame_send(&frame);
+}
+
+static void peer_credits_send(uint8_t dlci, uint8_t credits)
+{
+	struct slm_cmux_frame frame = {
+		.dlci = dlci,
+		.type = SLM_CMUX_UIH,
+		.cr = true,
+		.pf = true,
+		.has_credits = true,
+		.credits = credits,
+	};
+
+	peer_frame_send(&frame);
+}
+
+static void peer_msg_send(uint8_t type, const uint8_t *value, uint8_t len)
+{
+	uint8_t msg[FRAME_DATA_LEN];
+
+	msg[0] = type | CR | EA;
+	msg[1] = (len << 1) | EA;
+	memcpy(&msg[2], value, len);
+	peer_send(SLM_CMUX_DLCI_CTRL, SLM_CMUX_UIH, false, msg, len + 2);
+}
+
+static struct peer_frame *peer_frame_get(void)
+{
+	zassert_true(peer.tail < peer.head, "No frame received");
+	return &peer.frames[peer.tail++ % FRAME_QUEUE_LEN];
+}
+
+static void expect_frame(uint8_t dlci, uint8_t type)
+{
+	struct peer_frame *frame = peer_frame_get();
+
+	zassert_equal(frame->dlci, dlci, "DLCI %d", frame->dlci);
+	zassert_equal(frame->type, type, "Type 0x%02x", frame->type);
+}
+
+static struct peer_frame *expect_msg(uint8_t type)
+{
+	struct peer_frame *frame = peer_frame_get();
+
+	zassert_equal(frame->dlci, SLM_CMUX_DLCI_CTRL, NULL);
+	zassert_equal(frame->type, SLM_CMUX_UIH, NULL);
+	zassert_true(frame->len >= 2, NULL);
+	zassert_equal(frame->data[0] & ~(CR | EA), type,
+		      "Message 0x%02x", frame->data[0]);
+
+	return frame;
+}
+
+/* Opens the control channel and the data channel, with credit based flow
+ * control on the data channel.
+ */
+static void loop_open(enum slm_cmux_mode mode, uint16_t n1)
+{
+	uint8_t pn[8] = {
+		SLM_CMUX_DLCI_DATA, 0xF0, 0, 0, n1 & 0xFF, n1 >> 8, 0, 7
+	};
+	struct peer_frame *frame;
+
+	loop_start(mode, n1);
+	peer_send(SLM_CMUX_DLCI_CTRL, SLM_CMUX_SABM, true, NULL, 0);
+	expect_frame(SLM_CMUX_DLCI_CTRL, SLM_CMUX_UA);
+
+	peer_msg_send(MSG_PN, pn, sizeof(pn));
+	frame = expect_msg(MSG_PN);
+	zassert_equal(frame->data[1], (8 << 1) | EA, NULL);
+	zassert_equal(frame->data[2 + 1], 0xE0, "No credit flow control");
+	zassert_equal(frame->data[2 + 4] | (frame->data[2 + 5] << 8), n1, NULL);
+	peer.tx_credits = frame->data[2 + 7];
+	slm_cmux_decoder_credits_set(&peer.dec, SLM_CMUX_DLCI_DATA, true);
+
+	peer_send(SLM_CMUX_DLCI_DATA, SLM_CMUX_SABM, true, NULL, 0);
+	expect_frame(SLM_CMUX_DLCI_DATA, SLM_CMUX_UA);
+	expect_msg(MSG_MSC);
+	zassert_true(peer.open[SLM_CMUX_DLCI_DATA], NULL);
+	zassert_true(peer.tx_credits > 0, NULL);
+	peer.tail = peer.head;
+}
+
+static void test_fcs_vector(void)
+{
+	const uint8_t expected[] = { 0xF9, 0x03, 0x3F, 0x01, 0x1C, 0xF9 };
+	struct slm_cmux_frame frame = {
+		.dlci = 0,
+		.type = SLM_CMUX_SABM,
+		.cr = true,
+		.pf = true,
+	};
+	uint8_t buf[SLM_CMUX_FRAME_SIZE(0)];
+	int ret;
+
+	ret = slm_cmux_frame_encode(SLM_CMUX_MODE_BASIC, &frame, buf,
+				    sizeof(buf));
+	zassert_equal(ret, sizeof(expected), NULL);
+	zassert_mem_equal(buf, expected, sizeof(expected), NULL);
+}
+
+static void test_credit_octet(void)
+{
+	/* The credit octet follows the length field, which does not count
+	 * it, and is not covered by the FCS of the UIH frame.
+	 */
+	const uint8_t data[] = { 0x41 };
+	struct slm_cmux_frame frame = {
+		.dlci = SLM_CMUX_DLCI_DATA,
+		.type = SLM_CMUX_UIH,
+		.pf = true,
+		.has_credits = true,
+		.credits = 3,
+		.data = data,
+		.len = sizeof(data),
+	};
+	struct slm_cmux_frame plain = frame;
+	uint8_t buf[SLM_CMUX_FRAME_SIZE(sizeof(data))];
+	uint8_t ref[SLM_CMUX_FRAME_SIZE(sizeof(data))];
+	int ret, ref_len;
+
+	plain.has_credits = false;
+	ref_len = slm_cmux_frame_encode(SLM_CMUX_MODE_BASIC, &plain, ref,
+					sizeof(ref));
+	ret = slm_cmux_frame_encode(SLM_CMUX_MODE_BASIC, &frame, buf,
+				    sizeof(buf));
+	zassert_equal(ret, ref_len + 1, NULL);
+	zassert_mem_equal(buf, ref, 4, "Header changed");
+	zassert_equal(buf[3], (sizeof(data) << 1) | EA, "Credits counted");
+	zassert_equal(buf[4], frame.credits, NULL);
+	zassert_mem_equal(&buf[5], &ref[4], ref_len - 4, NULL);
+
+	/* Only with P/F in UIH frames */
+	frame.pf = false;
+	zassert_equal(slm_cmux_frame_encode(SLM_CMUX_MODE_BASIC, &frame, buf,
+					    sizeof(buf)), -EINVAL, NULL);
+}
+
+static void roundtrip(enum slm_cmux_mode mode, uint8_t type,
+		      const uint8_t *data, uint16_t len, bool has_credits)
+{
+	static uint8_t buf[SLM_CMUX_FRAME_SIZE(N1)];
+	static uint8_t dec_buf[SLM_CMUX_DECODER_BUF_SIZE(N1)];
+	struct slm_cmux_decoder dec;
+	struct slm_cmux_frame in = {
+		.dlci = SLM_CMUX_DLCI_AT,
+		.type = type,
+		.cr = false,
+		.pf = true,
+		.has_credits = has_credits,
+		.credits = 0x5A,
+		.data = data,
+		.len = len,
+	};
+	struct slm_cmux_frame out;
+	int frames = 0;
+	int ret;
+
+	ret = slm_cmux_frame_encode(mode, &in, buf, sizeof(buf));
+	zassert_true(ret > 0, "Encoding failed: %d", ret);
+
+	if (mode == SLM_CMUX_MODE_ADVANCED) {
+		for (int i = 1; i < ret - 1; i++) {
+			zassert_not_equal(buf[i], 0x7E, "Flag not escaped");
+		}
+	}
+
+	slm_cmux_decoder_init(&dec, mode, dec_buf, sizeof(dec_buf));
+	slm_cmux_decoder_credits_set(&dec, in.dlci, has_credits);
+	for (int i = 0; i < ret; i++) {
+		int err = slm_cmux_decode(&dec, buf[i], &out);
+
+		zassert_true(err >= 0, "Decoding failed: %d", err);
+		frames += err;
+	}
+	zassert_equal(frames, 1, "Frame not decoded");
+	zassert_equal(out.dlci, in.dlci, NULL);
+	zassert_equal(out.type, in.type, NULL);
+	zassert_equal(out.cr, in.cr, NULL);
+	zassert_equal(out.pf, in.pf, NULL);
+	zassert_equal(out.has_credits, in.has_credits, NULL);
+	zassert_equal(out.credits, has_credits ? in.credits : 0, NULL);
+	zassert_equal(out.len, in.len, NULL);
+	zassert_mem_equal(out.data, data, len, NULL);
+}
+
+static void test_roundtrip_basic(void)
+{
+	static uint8_t data[N1];
+
+	for (int i = 0; i < sizeof(data); i++) {
+		data[i] = 0xF9 - i;
+	}
+	/* One and two octet length fields */
+	roundtrip(SLM_CMUX_MODE_BASIC, SLM_CMUX_UIH, data, 10, false);
+	roundtrip(SLM_CMUX_MODE_BASIC, SLM_CMUX_UIH, data, sizeof(data),
+		  false);
+	roundtrip(SLM_CMUX_MODE_BASIC, SLM_CMUX_UI, data, 20, false);
+	roundtrip(SLM_CMUX_MODE_BASIC, SLM_CMUX_SABM, NULL, 0, false);
+	/* Credits with and without data */
+	roundtrip(SLM_CMUX_MODE_BASIC, SLM_CMUX_UIH, data, sizeof(data),
+		  true);
+	roundtrip(SLM_CMUX_MODE_BASIC, SLM_CMUX_UIH, NULL, 0, true);
+}
+
+static void test_roundtrip_advanced(void)
+{
+	static uint8_t data[N1];
+
+	for (int i = 0; i < sizeof(data); i++) {
+		data[i] = (i % 2) ? 0x7E : 0x7D;
+	}
+	roundtrip(SLM_CMUX_MODE_ADVANCED, SLM_CMUX_UIH, data, 10, false);
+	roundtrip(SLM_CMUX_MODE_ADVANCED, SLM_CMUX_UIH, data, sizeof(data),
+		  false);
+	roundtrip(SLM_CMUX_MODE_ADVANCED, SLM_CMUX_UI, data, 20, false);
+	roundtrip(SLM_CMUX_MODE_ADVANCED, SLM_CMUX_SABM, NULL, 0, false);
+	/* Credits with and without data */
+	roundtrip(SLM_CMUX_MODE_ADVANCED, SLM_CMUX_UIH, data, sizeof(data),
+		  true);
+	roundtrip(SLM_CMUX_MODE_ADVANCED, SLM_CMUX_UIH, NULL, 0, true);
+}
+
+static void test_bad_fcs(void)
+{
+	const uint8_t data[] = "AT+CFUN?\r\n";
+	enum slm_cmux_mode modes[] = {
+		SLM_CMUX_MODE_BASIC, SLM_CMUX_MODE_ADVANCED
+	};
+	struct slm_cmux_frame frame = {
+		.dlci = SLM_CMUX_DLCI_AT,
+		.type = SLM_CMUX_UIH,
+		.data = data,
+		.len = sizeof(data) - 1,
+	};
+	uint8_t buf[SLM_CMUX_FRAME_SIZE(sizeof(data))];
+	uint8_t dec_buf[SLM_CMUX_DECODER_BUF_SIZE(sizeof(data))];
+	struct slm_cmux_decoder dec;
+	struct slm_cmux_frame out;
+	int errors, frames;
+	int len, ret;
+
+	for (int m = 0; m < ARRAY_SIZE(modes); m++) {
+		len = slm_cmux_frame_encode(modes[m], &frame, buf, sizeof(buf));
+		zassert_true(len > 0, NULL);
+		slm_cmux_decoder_init(&dec, modes[m], dec_buf, sizeof(dec_buf));
+
+		/* Corrupted header, then the same frame intact */
+		buf[1] ^= 0x04;
+		errors = frames = 0;
+		for (int i = 0; i < len; i++) {
+			ret = slm_cmux_decode(&dec, buf[i], &out);
+			errors += (ret < 0);
+			frames += (ret == 1);
+		}
+		buf[1] ^= 0x04;
+		for (int i = 0; i < len; i++) {
+			ret = slm_cmux_decode(&dec, buf[i], &out);
+			errors += (ret < 0);
+			frames += (ret == 1);
+		}
+		zassert_equal(errors, 1, "Mode %d", modes[m]);
+		zassert_equal(frames, 1, "Mode %d", modes[m]);
+		zassert_equal(out.len, frame.len, NULL);
+	}
+}
+
+static void test_open_close(void)
+{
+	const uint8_t cmd[] = "AT+CGMR\r\n";
+	const uint8_t ok[] = "OK\r\n";
+	const uint8_t test_value[] = { 0x12, 0x34 };
+	uint8_t buf[sizeof(cmd)];
+	struct peer_frame *frame;
+
+	loop_start(SLM_CMUX_MODE_BASIC, SLM_CMUX_N1_BASIC);
+
+	/* No channels before the control channel */
+	peer_send(SLM_CMUX_DLCI_AT, SLM_CMUX_SABM, true, NULL, 0);
+	expect_frame(SLM_CMUX_DLCI_AT, SLM_CMUX_DM);
+
+	peer_send(SLM_CMUX_DLCI_CTRL, SLM_CMUX_SABM, true, NULL, 0);
+	frame = peer_frame_get();
+	zassert_equal(frame->type, SLM_CMUX_UA, NULL);
+	zassert_true(frame->cr, "Response without C/R");
+	zassert_true(frame->pf, "Final bit not set");
+	zassert_true(slm_cmux_is_open(SLM_CMUX_DLCI_CTRL), NULL);
+
+	peer_send(SLM_CMUX_DLCI_COUNT, SLM_CMUX_SABM, true, NULL, 0);
+	expect_frame(SLM_CMUX_DLCI_COUNT, SLM_CMUX_DM);
+
+	peer_send(SLM_CMUX_DLCI_AT, SLM_CMUX_SABM, true, NULL, 0);
+	expect_frame(SLM_CMUX_DLCI_AT, SLM_CMUX_UA);
+	frame = expect_msg(MSG_MSC);
+	zassert_equal(frame->data[2] >> 2, SLM_CMUX_DLCI_AT, NULL);
+	zassert_true(peer.open[SLM_CMUX_DLCI_AT], NULL);
+
+	/* Data on the AT channel, without credits */
+	peer_send(SLM_CMUX_DLCI_AT, SLM_CMUX_UIH, false, cmd, sizeof(cmd) - 1);
+	zassert_equal(peer.rx_ready[SLM_CMUX_DLCI_AT], 1, NULL);
+	zassert_equal(slm_cmux_recv(SLM_CMUX_DLCI_AT, buf, sizeof(buf)),
+		      sizeof(cmd) - 1, NULL);
+	zassert_mem_equal(buf, cmd, sizeof(cmd) - 1, NULL);
+
+	zassert_equal(slm_cmux_send(SLM_CMUX_DLCI_AT, ok, 4), 0, NULL);
+	frame = peer_frame_get();
+	zassert_equal(frame->type, SLM_CMUX_UIH, NULL);
+	zassert_false(frame->cr, "Command from the responder");
+	zassert_equal(frame->len, 4, NULL);
+	zassert_mem_equal(frame->data, ok, 4, NULL);
+
+	/* The data channel is not open */
+	zassert_equal(slm_cmux_send(SLM_CMUX_DLCI_DATA, ok, 1), -ENOTCONN,
+		      NULL);
+
+	peer_msg_send(MSG_TEST, test_value, sizeof(test_value));
+	frame = expect_msg(MSG_TEST);
+	zassert_false(frame->data[0] & CR, "Response expected");
+	zassert_mem_equal(&frame->data[2], test_value, sizeof(test_value),
+			  NULL);
+
+	/* Unsupported message */
+	peer_msg_send(0x44, NULL, 0);
+	frame = expect_msg(MSG_NSC);
+	zassert_equal(frame->data[2], 0x44 | CR | EA, NULL);
+
+	peer_send(SLM_CMUX_DLCI_AT, SLM_CMUX_DISC, true, NULL, 0);
+	expect_frame(SLM_CMUX_DLCI_AT, SLM_CMUX_UA);
+	zassert_false(slm_cmux_is_open(SLM_CMUX_DLCI_AT), NULL);
+	zassert_false(peer.open[SLM_CMUX_DLCI_AT], NULL);
+
+	peer_send(SLM_CMUX_DLCI_CTRL, SLM_CMUX_DISC, true, NULL, 0);
+	expect_frame(SLM_CMUX_DLCI_CTRL, SLM_CMUX_UA);
+	zassert_false(slm_cmux_is_open(SLM_CMUX_DLCI_CTRL), NULL);
+	zassert_equal(slm_cmux_send(SLM_CMUX_DLCI_AT, ok, 1), -ENOTCONN,
+		      NULL);
+	slm_cmux_stop();
+}
+
+static void test_credits(void)
+{
+	static uint8_t data[4 * N1];
+	int credits;
+
+	loop_open(SLM_CMUX_MODE_BASIC, N1);
+
+	/* The host stops when it runs out of credits */
+	credits = peer.tx_credits;
+	for (int i = 0; i < credits; i++) {
+		peer_send(SLM_CMUX_DLCI_DATA, SLM_CMUX_UIH, false, pattern, N1);
+		peer.tx_credits--;
+	}
+	zassert_equal(peer.tx_credits, 0, NULL);
+
+	/* Reading gives the credits back */
+	while (slm_cmux_recv(SLM_CMUX_DLCI_DATA, data, sizeof(data)) > 0) {
+	}
+	zassert_true(peer.tx_credits > 0, "No credits given");
+
+	/* The initial credits from the host, then the multiplexer waits */
+	zassert_equal(slm_cmux_send(SLM_CMUX_DLCI_DATA, pattern, N1 * 7), 0,
+		      NULL);
+	zassert_equal(peer.data_len, N1 * 7, NULL);
+	zassert_equal(slm_cmux_send(SLM_CMUX_DLCI_DATA, pattern, 1), -EAGAIN,
+		      NULL);
+	zassert_equal(peer.data_len, N1 * 7, NULL);
+	slm_cmux_stop();
+}
+
+static void sender(void *p1, void *p2, void *p3)
+{
+	size_t remaining = THROUGHPUT_LEN;
+	size_t len;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	/* Multiples of 256 keep the pattern continuous */
+	while (remaining > 0) {
+		len = MIN(remaining, sizeof(pattern));
+		sender_result = slm_cmux_send(SLM_CMUX_DLCI_DATA, pattern, len);
+		if (sender_result) {
+			return;
+		}
+		remaining -= len;
+	}
+}
+
+static void throughput(enum slm_cmux_mode mode, uint16_t n1)
+{
+	static uint8_t data[1024];
+	size_t sent = 0;
+	size_t received = 0;
+	uint64_t start, up_ns, down_ns;
+	atomic_val_t credits;
+	int ret;
+
+	loop_open(mode, n1);
+
+	/* Host to modem, the host waits for credits */
+	start = timestamp();
+	while (received < THROUGHPUT_LEN) {
+		while (peer.tx_credits > 0 && sent < THROUGHPUT_LEN) {
+			size_t len = MIN(n1, THROUGHPUT_LEN - sent);
+
+			for (int i = 0; i < len; i++) {
+				data[i] = (uint8_t)(sent + i);
+			}
+			peer_send(SLM_CMUX_DLCI_DATA, SLM_CMUX_UIH, false,
+				  data, len);
+			peer.tx_credits--;
+			sent += len;
+		}
+		ret = slm_cmux_recv(SLM_CMUX_DLCI_DATA, data, sizeof(data));
+		zassert_true(ret > 0, "Stalled at %d", received);
+		for (int i = 0; i < ret; i++) {
+			zassert_equal(data[i], (uint8_t)(received + i),
+				      "Corrupted at %d", received + i);
+		}
+		received += ret;
+	}
+	up_ns = elapsed_ns(start);
+
+	/* Modem to host, the sender waits for credits */
+	start = timestamp();
+	k_thread_create(&sender_thread, sender_stack,
+			K_THREAD_STACK_SIZEOF(sender_stack), sender,
+			NULL, NULL, NULL, SENDER_PRIORITY, 0, K_NO_WAIT);
+	while (peer.data_len < THROUGHPUT_LEN) {
+		if (k_sem_take(&peer_sem, K_SECONDS(1)) != 0) {
+			break;
+		}
+		credits = atomic_set(&peer.consumed, 0);
+		if (credits > 0) {
+			peer_credits_send(SLM_CMUX_DLCI_DATA, credits);
+		}
+	}
+	down_ns = elapsed_ns(start);
+	k_thread_join(&sender_thread, K_SECONDS(1));
+
+	zassert_equal(sender_result, 0, "Send failed: %d", sender_result);
+	zassert_equal(peer.data_len, THROUGHPUT_LEN, NULL);
+	zassert_false(peer.data_error, "Data corrupted");
+
+	TC_PRINT("%s N1 %d: up %u kB/s, down %u kB/s\n",
+		 mode == SLM_CMUX_MODE_BASIC ? "Basic" : "Advanced", n1,
+		 (uint32_t)((uint64_t)THROUGHPUT_LEN * NSEC_PER_SEC /
+			    1024 / MAX(up_ns, 1)),
+		 (uint32_t)((uint64_t)THROUGHPUT_LEN * NSEC_PER_SEC /
+			    1024 / MAX(down_ns, 1)));
+
+	slm_cmux_stop();
+}
+
+static void test_throughput(void)
+{
+	throughput(SLM_CMUX_MODE_BASIC, SLM_CMUX_N1_BASIC);
+	throughput(SLM_CMUX_MODE_BASIC, N1);
+	throughput(SLM_CMUX_MODE_ADVANCED, SLM_CMUX_N1_ADVANCED);
+	throughput(SLM_CMUX_MODE_ADVANCED, N1);
+}
+
+void test_main(void)
+{
+	for (int i = 0; i < sizeof(pattern); i++) {
+		pattern[i] = (uint8_t)i;
+	}
+
+	ztest_test_suite(cmux_test,
+			 ztest_unit_test(test_fcs_vector),
+			 ztest_unit_test(test_credit_octet),
+			 ztest_unit_test(test_roundtrip_basic),
+			 ztest_unit_test(test_roundtrip_advanced),
+			 ztest_unit_test(test_bad_fcs),
+			 ztest_unit_test(test_open_close),
+			 ztest_unit_test(test_credits),
+			 ztest_unit_test(test_throughput)
+			 );
+
+	ztest_run_test_suite(cmux_test);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include "slm_util.h"
+
+#define PATTERN "+++"
+#define GUARD 1000
+
+static struct slm_util_term term;
+
+static void input(const char *data, uint32_t now,
+		  enum slm_util_term_result expected, size_t released)
+{
+	enum slm_util_term_result result;
+	size_t out;
+
+	result = slm_util_term_input(&term, (const uint8_t *)data,
+				     strlen(data), now, &out);
+	zassert_equal(result, expected, "Wrong result for \"%s\" at %u",
+		      data, now);
+	zassert_equal(out, released, "Wrong release for \"%s\" at %u", data,
+		      now);
+}
+
+static void test_alone(void)
+{
+	slm_util_term_init(&term, PATTERN, GUARD, 0);
+
+	input(PATTERN, GUARD, SLM_UTIL_TERM_COMPLETE, 0);
+
+	/* Only confirmed after the guard time without input: */
+	zassert_false(slm_util_term_check(&term, 2 * GUARD - 1), NULL);
+	zassert_true(slm_util_term_check(&term, 2 * GUARD), NULL);
+	zassert_false(slm_util_term_check(&term, 2 * GUARD), "Not reset");
+}
+
+static void test_split(void)
+{
+	slm_util_term_init(&term, PATTERN, GUARD, 0);
+
+	/* Split over several UART RX chunks, with short pauses: */
+	input("+", GUARD, SLM_UTIL_TERM_PARTIAL, 0);
+	input("+", GUARD + 100, SLM_UTIL_TERM_PARTIAL, 0);
+	input("+", GUARD + 200, SLM_UTIL_TERM_COMPLETE, 0);
+	zassert_true(slm_util_term_check(&term, 2 * GUARD + 200), NULL);
+
+	slm_util_term_init(&term, PATTERN, GUARD, 0);
+
+	input("++", GUARD, SLM_UTIL_TERM_PARTIAL, 0);
+	input("+", GUARD + 1, SLM_UTIL_TERM_COMPLETE, 0);
+	zassert_true(slm_util_term_check(&term, 2 * GUARD + 1), NULL);
+}
+
+static void test_no_guard_before(void)
+{
+	slm_util_term_init(&term, PATTERN, GUARD, 0);
+
+	input(PATTERN, GUARD - 1, SLM_UTIL_TERM_DATA, 0);
+	zassert_false(slm_util_term_check(&term, 3 * GUARD), NULL);
+
+	/* Data resets the pause: */
+	input("data", 2 * GUARD, SLM_UTIL_TERM_DATA, 0);
+	input(PATTERN, 3 * GUARD - 1, SLM_UTIL_TERM_DATA, 0);
+	input(PATTERN, 4 * GUARD - 1, SLM_UTIL_TERM_COMPLETE, 0);
+}
+
+static void test_in_data(void)
+{
+	slm_util_term_init(&term, PATTERN, GUARD, 0);
+
+	input("data" PATTERN, GUARD, SLM_UTIL_TERM_DATA, 0);
+	input(PATTERN "data", 2 * GUARD, SLM_UTIL_TERM_DATA, 0);
+	input(PATTERN "+", 3 * GUARD, SLM_UTIL_TERM_DATA, 0);
+	input("+-+", 4 * GUARD, SLM_UTIL_TERM_DATA, 0);
+}
+
+static void test_released(void)
+{
+	slm_util_term_init(&term, PATTERN, GUARD, 0);
+
+	/* Data after the pattern, within the guard time: */
+	input(PATTERN, GUARD, SLM_UTIL_TERM_COMPLETE, 0);
+	input("x", GUARD + 500, SLM_UTIL_TERM_DATA, 3);
+	zassert_false(slm_util_term_check(&term, 3 * GUARD), NULL);
+
+	/* Data completing a partial pattern: */
+	input("++", 3 * GUARD, SLM_UTIL_TERM_PARTIAL, 0);
+	input("+x", 3 * GUARD + 10, SLM_UTIL_TERM_DATA, 2);
+
+	/* A pause within the pattern, which starts again: */
+	input("+", 5 * GUARD, SLM_UTIL_TERM_PARTIAL, 0);
+	input("++", 6 * GUARD, SLM_UTIL_TERM_PARTIAL, 1);
+	input("+", 6 * GUARD + 10, SLM_UTIL_TERM_COMPLETE, 0);
+	zassert_true(slm_util_term_check(&term, 7 * GUARD + 10), NULL);
+}
+
+static void test_wrap(void)
+{
+	/* The millisecond uptime counter wraps around: */
+	slm_util_term_init(&term, PATTERN, GUARD, UINT32_MAX - 10);
+
+	input(PATTERN, GUARD - 12, SLM_UTIL_TERM_DATA, 0);
+	input(PATTERN, 2 * GUARD, SLM_UTIL_TERM_COMPLETE, 0);
+	zassert_true(slm_util_term_check(&term, 3 * GUARD), NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(datamode_test,
+			 ztest_unit_test(test_alone),
+			 ztest_unit_test(test_split),
+			 ztest_unit_test(test_no_guard_before),
+			 ztest_unit_test(test_in_data),
+			 ztest_unit_test(test_released),
+			 ztest_unit_test(test_wrap)
+			 );
+
+	ztest_run_test_suite(datamode_test);
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <irq_offload.h>
+#include <drivers/entropy_cc3xx.h>
+#include "entropy_cc3xx_pool.h"
+
+#define POOL_SIZE	CONFIG_ENTROPY_CC3XX_POOL_SIZE
+#define REFILL_WAIT	K_MSEC(100)
+
+static struct {
+	uint32_t calls;
+	int error;
+	uint8_t next;
+} trng;
+
+static struct {
+	uint8_t buf[POOL_SIZE + 16];
+	size_t len;
+	int ret;
+} isr_request;
+
+static int trng_mock_get(uint8_t *buf, size_t len)
+{
+	trng.calls++;
+
+	if (trng.error) {
+		return trng.error;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = trng.next++;
+	}
+
+	return 0;
+}
+
+static struct entropy_cc3xx_pool_stats stats_get(void)
+{
+	struct entropy_cc3xx_pool_stats stats;
+
+	zassert_equal(entropy_cc3xx_pool_stats_get(&stats), 0,
+		      "No statistics");
+
+	return stats;
+}
+
+static void isr_get(const void *param)
+{
+	ARG_UNUSED(param);
+
+	isr_request.ret = entropy_cc3xx_pool_get_isr(isr_request.buf,
+						     isr_request.len);
+}
+
+static int pool_get_in_isr(size_t len)
+{
+	isr_request.len = len;
+	irq_offload(isr_get, NULL);
+
+	return isr_request.ret;
+}
+
+static void test_init(void)
+{
+	struct entropy_cc3xx_pool_stats stats;
+
+	zassert_equal(entropy_cc3xx_pool_init(NULL), -EINVAL,
+		      "Initialized without source");
+	zassert_equal(entropy_cc3xx_pool_stats_get(NULL), -EINVAL,
+		      "Statistics without buffer");
+
+	zassert_equal(entropy_cc3xx_pool_init(trng_mock_get), 0,
+		      "Pool not initialized");
+
+	k_sleep(REFILL_WAIT);
+
+	stats = stats_get();
+	zassert_equal(stats.size, POOL_SIZE, "Wrong size");
+	zassert_equal(stats.fill, POOL_SIZE, "Pool not filled");
+	zassert_equal(stats.refills, 1, "Wrong refill count");
+	zassert_equal(stats.reseeds, 1, "DRBG not seeded once");
+	zassert_equal(stats.errors, 0, "Errors reported");
+	zassert_equal(trng.calls, 1, "TRNG not used once");
+}
+
+static void test_get(void)
+{
+	uint8_t first[32];
+	uint8_t second[32];
+	uint8_t zero[32] = {0};
+	struct entropy_cc3xx_pool_stats before = stats_get();
+	struct entropy_cc3xx_pool_stats after;
+
+	zassert_equal(entropy_cc3xx_pool_get(first, sizeof(first)), 0,
+		      "No entropy");
+	zassert_equal(entropy_cc3xx_pool_get(second, sizeof(second)), 0,
+		      "No entropy");
+
+	zassert_true(memcmp(first, zero, sizeof(first)), "Empty entropy");
+	zassert_true(memcmp(first, second, sizeof(first)), "Same entropy");
+
+	after = stats_get();
+	zassert_equal(after.hits, before.hits + 2, "Not served from pool");
+	zassert_equal(after.fill, POOL_SIZE - sizeof(first) - sizeof(second),
+		      "Wrong fill level");
+	zassert_equal(trng.calls, 1, "TRNG used");
+}
+
+static void test_refill(void)
+{
+	uint8_t buf[100];
+	struct entropy_cc3xx_pool_stats before = stats_get();
+	struct entropy_cc3xx_pool_stats after;
+
+	/* Below the refill threshold */
+	zassert_equal(entropy_cc3xx_pool_get(buf, sizeof(buf)), 0,
+		      "No entropy");
+	zassert_true(stats_get().fill <
+		     CONFIG_ENTROPY_CC3XX_POOL_REFILL_THRESHOLD,
+		     "Threshold not crossed");
+
+	k_sleep(REFILL_WAIT);
+
+	after = stats_get();
+	zassert_equal(after.fill, POOL_SIZE, "Pool not refilled");
+	zassert_equal(after.refills, before.refills + 1, "Wrong refill count");
+	zassert_true(after.min_fill <
+		     CONFIG_ENTROPY_CC3XX_POOL_REFILL_THRESHOLD,
+		     "Wrong lowest fill level");
+}
+
+static void test_isr(void)
+{
+	struct entropy_cc3xx_pool_stats before = stats_get();
+	struct entropy_cc3xx_pool_stats after;
+
+	zassert_equal(pool_get_in_isr(16), 16, "No entropy in interrupt");
+
+	/* Only the bytes in the pool are returned. */
+	zassert_equal(pool_get_in_isr(POOL_SIZE), POOL_SIZE - 16,
+		      "Wrong length");
+	zassert_equal(pool_get_in_isr(16), 0, "Entropy from empty pool");
+
+	after = stats_get();
+	zassert_equal(after.hits, before.hits + 1, "Wrong hit count");
+	zassert_equal(after.misses, before.misses + 2, "Wrong miss count");
+	zassert_equal(after.fill, 0, "Pool not empty");
+	zassert_equal(after.min_fill, 0, "Wrong lowest fill level");
+
+	k_sleep(REFILL_WAIT);
+
+	zassert_equal(stats_get().fill, POOL_SIZE, "Pool not refilled");
+}
+
+static void test_empty_pool(void)
+{
+	uint8_t buf[32];
+	struct entropy_cc3xx_pool_stats before;
+
+	zassert_equal(pool_get_in_isr(POOL_SIZE), POOL_SIZE, "Pool not full");
+	before = stats_get();
+
+	/* The refill work queue does not run before the test sleeps. */
+	zassert_equal(entropy_cc3xx_pool_get(buf, sizeof(buf)), 0,
+		      "No entropy from DRBG");
+	zassert_equal(stats_get().misses, before.misses + 1, "No miss");
+
+	k_sleep(REFILL_WAIT);
+
+	zassert_equal(stats_get().fill, POOL_SIZE, "Pool not refilled");
+}
+
+static void test_reseed(void)
+{
+	uint8_t buf[32];
+	uint32_t calls = trng.calls;
+	struct entropy_cc3xx_pool_stats before = stats_get();
+	struct entropy_cc3xx_pool_stats after;
+
+	zassert_equal(pool_get_in_isr(POOL_SIZE), POOL_SIZE, "Pool not full");
+
+	for (size_t i = 0; i < CONFIG_ENTROPY_CC3XX_POOL_RESEED_INTERVAL; i++) {
+		zassert_equal(entropy_cc3xx_pool_get(buf, sizeof(buf)), 0,
+			      "No entropy from DRBG");
+	}
+
+	after = stats_get();
+	zassert_equal(after.reseeds, before.reseeds + 1, "No reseed");
+	zassert_equal(trng.calls, calls + 1, "TRNG not used");
+
+	k_sleep(REFILL_WAIT);
+}
+
+static void test_source_error(void)
+{
+	uint8_t buf[32];
+	int err = 0;
+
+	zassert_equal(pool_get_in_isr(POOL_SIZE), POOL_SIZE, "Pool not full");
+
+	trng.error = -EIO;
+
+	for (size_t i = 0;
+	     (i <= CONFIG_ENTROPY_CC3XX_POOL_RESEED_INTERVAL) && !err; i++) {
+		err = entropy_cc3xx_pool_get(buf, sizeof(buf));
+	}
+
+	zassert_equal(err, -EIO, "Error not reported");
+	zassert_true(stats_get().errors > 0, "Error not counted");
+
+	/* Failed refills leave the pool empty. */
+	k_sleep(REFILL_WAIT);
+	zassert_equal(stats_get().fill, 0, "Pool filled without seed");
+
+	trng.error = 0;
+
+	zassert_equal(entropy_cc3xx_pool_get(buf, sizeof(buf)), 0,
+		      "No recovery");
+
+	k_sleep(REFILL_WAIT);
+	zassert_equal(stats_get().fill, POOL_SIZE, "Pool not refilled");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(entropy_cc3xx_pool_test,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_get),
+			 ztest_unit_test(test_refill),
+			 ztest_unit_test(test_isr),
+			 ztest_unit_test(test_empty_pool),
+			 ztest_unit_test(test_reseed),
+			 ztest_unit_test(test_source_error)
+			 );
+
+	ztest_run_test_suite(entropy_cc3xx_pool_test);
+}
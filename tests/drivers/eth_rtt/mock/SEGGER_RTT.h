@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#define SEGGER_RTT_MAX_NUM_UP_BUFFERS 3
+#define SEGGER_RTT_MAX_NUM_DOWN_BUFFERS 3
+#define SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL 2
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char *sName,
+			      void *pBuffer, unsigned BufferSize,
+			      unsigned Flags);
+int SEGGER_RTT_ConfigDownBuffer(unsigned BufferIndex, const char *sName,
+				void *pBuffer, unsigned BufferSize,
+				unsigned Flags);
+unsigned SEGGER_RTT_Read(unsigned BufferIndex, void *pBuffer,
+			 unsigned BufferSize);
+unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void *pBuffer,
+			  unsigned NumBytes);
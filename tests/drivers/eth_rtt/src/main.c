@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <net/net_if.h>
+#include <net/ethernet.h>
+#include <sys/crc.h>
+#include <SEGGER_RTT.h>
+
+#define STREAM_SIZE	8192
+
+/* SLIP special bytes */
+#define SLIP_END	0300
+#define SLIP_ESC	0333
+#define SLIP_ESC_END	0334
+#define SLIP_ESC_ESC	0335
+
+/* Frame sizes and offsets of the ARP fields */
+#define ETH_HDR_SIZE	14
+#define ARP_SIZE	(ETH_HDR_SIZE + 28)
+#define LARGE_SIZE	(ETH_HDR_SIZE + CONFIG_ETH_RTT_MTU)
+#define RESET_SIZE	38
+#define ETH_TYPE	12
+#define ARP_OPER	20
+#define ARP_SPA		28
+#define ARP_TPA		38
+
+#define PEER_MAC	0x02, 0x00, 0x5E, 0x00, 0x53, 0x01
+#define PEER_IP		192, 0, 2
+#define PEER_IP_FIRST	100
+#define MY_IP		192, 0, 2, 1
+
+#define IDLE_MS		1000
+#define ROUND_TRIPS	100
+#define BURST_CNT	16
+#define SEQ_CNT		50
+#define REPLY_WAIT	K_MSEC(200)
+
+/* Fake RTT backend */
+static struct {
+	const char *up_name;
+	const char *down_name;
+	/* Data written by the driver */
+	uint8_t up[STREAM_SIZE];
+	size_t up_len;
+	size_t up_pos;
+	/* Data read by the driver */
+	uint8_t down[STREAM_SIZE];
+	size_t down_len;
+	size_t down_pos;
+	uint32_t writes;
+	uint32_t reads;
+} rtt;
+
+/* SLIP decoder of the up channel */
+static struct {
+	uint8_t frame[LARGE_SIZE + 2];
+	size_t len;
+	bool esc;
+} slip;
+
+static K_SEM_DEFINE(up_sem, 0, 1);
+
+static const uint8_t peer_mac[] = { PEER_MAC };
+static const uint8_t my_ip[] = { MY_IP };
+static uint8_t frame[LARGE_SIZE];
+static uint8_t reply[LARGE_SIZE];
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char *sName,
+			      void *pBuffer, unsigned BufferSize,
+			      unsigned Flags)
+{
+	if (BufferIndex == CONFIG_ETH_RTT_CHANNEL) {
+		rtt.up_name = sName;
+	}
+
+	return 0;
+}
+
+int SEGGER_RTT_ConfigDownBuffer(unsigned BufferIndex, const char *sName,
+				void *pBuffer, unsigned BufferSize,
+				unsigned Flags)
+{
+	if (BufferIndex == CONFIG_ETH_RTT_CHANNEL) {
+		rtt.down_name = sName;
+	}
+
+	return 0;
+}
+
+unsigned SEGGER_RTT_Read(unsigned BufferIndex, void *pBuffer,
+			 unsigned BufferSize)
+{
+	size_t len = MIN(rtt.down_len - rtt.down_pos, BufferSize);
+
+	zassert_equal(BufferIndex, CONFIG_ETH_RTT_CHANNEL, "Wrong channel");
+
+	rtt.reads++;
+
+	memcpy(pBuffer, &rtt.down[rtt.down_pos], len);
+	rtt.down_pos += len;
+
+	if (rtt.down_pos == rtt.down_len) {
+		rtt.down_pos = 0;
+		rtt.down_len = 0;
+	}
+
+	return len;
+}
+
+unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void *pBuffer,
+			  unsigned NumBytes)
+{
+	zassert_equal(BufferIndex, CONFIG_ETH_RTT_CHANNEL, "Wrong channel");
+	zassert_true(rtt.up_len + NumBytes <= sizeof(rtt.up),
+		     "Up channel full");
+
+	memcpy(&rtt.up[rtt.up_len], pBuffer, NumBytes);
+	rtt.up_len += NumBytes;
+	rtt.writes++;
+
+	k_sem_give(&up_sem);
+
+	return NumBytes;
+}
+
+static void down_put(uint8_t byte)
+{
+	zassert_true(rtt.down_len < sizeof(rtt.down), "Down channel full");
+
+	rtt.down[rtt.down_len++] = byte;
+}
+
+static void slip_put(const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		if (data[i] == SLIP_END) {
+			down_put(SLIP_ESC);
+			down_put(SLIP_ESC_END);
+		} else if (data[i] == SLIP_ESC) {
+			down_put(SLIP_ESC);
+			down_put(SLIP_ESC_ESC);
+		} else {
+			down_put(data[i]);
+		}
+	}
+}
+
+/* Puts the frame in the down channel, as the PC side would do. */
+static void frame_inject(const uint8_t *data, size_t len)
+{
+	uint16_t crc = crc16_ccitt(0xFFFF, data, len);
+	uint8_t crc_buf[2] = { crc >> 8, crc & 0xFF };
+
+	down_put(SLIP_END);
+	slip_put(data, len);
+	slip_put(crc_buf, sizeof(crc_buf));
+	down_put(SLIP_END);
+}
+
+/* Gets the next frame written to the up channel and checks its CRC.
+ * Returns the frame length without CRC or 0 on timeout.
+ */
+static size_t frame_get(uint8_t *data, k_timeout_t timeout)
+{
+	uint16_t crc;
+	size_t len;
+
+	while (true) {
+		while (rtt.up_pos < rtt.up_len) {
+			uint8_t byte = rtt.up[rtt.up_pos++];
+
+			if (byte == SLIP_END) {
+				len = slip.len;
+				slip.len = 0;
+
+				if (len == 0) {
+					continue;
+				}
+
+				zassert_true(len > 2, "Frame too short");
+				len -= 2;
+
+				crc = crc16_ccitt(0xFFFF, slip.frame, len);
+				zassert_equal(slip.frame[len], crc >> 8,
+					      "Wrong CRC");
+				zassert_equal(slip.frame[len + 1], crc & 0xFF,
+					      "Wrong CRC");
+
+				memcpy(data, slip.frame, len);
+
+				return len;
+			}
+
+			if (slip.esc) {
+				byte = (byte == SLIP_ESC_END) ? SLIP_END :
+								SLIP_ESC;
+				slip.esc = false;
+			} else if (byte == SLIP_ESC) {
+				slip.esc = true;
+				continue;
+			}
+
+			zassert_true(slip.len < sizeof(slip.frame),
+				     "Frame too long");
+			slip.frame[slip.len++] = byte;
+		}
+
+		rtt.up_pos = 0;
+		rtt.up_len = 0;
+
+		if (k_sem_take(&up_sem, timeout) != 0) {
+			return 0;
+		}
+	}
+}
+
+/* Builds an ARP request for the interface address, padded to len bytes. */
+static void arp_request_inject(uint8_t seq, size_t len)
+{
+	static const uint8_t header[] = {
+		0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	/* Broadcast */
+		PEER_MAC,
+		0x08, 0x06,				/* ARP */
+		0x00, 0x01,				/* Ethernet */
+		0x08, 0x00,				/* IPv4 */
+		6, 4,
+		0x00, 0x01,				/* Request */
+		PEER_MAC,
+		PEER_IP,
+	};
+
+	memset(frame, 0, len);
+	memcpy(frame, header, sizeof(header));
+	frame[ARP_SPA + 3] = PEER_IP_FIRST + seq;
+	memcpy(&frame[ARP_TPA], my_ip, sizeof(my_ip));
+
+	frame_inject(frame, len);
+}
+
+static bool arp_reply_is(const uint8_t *data, size_t len)
+{
+	return (len >= ARP_SIZE) &&
+	       (data[ETH_TYPE] == 0x08) && (data[ETH_TYPE + 1] == 0x06) &&
+	       (data[ARP_OPER] == 0x00) && (data[ARP_OPER + 1] == 0x02);
+}
+
+/* Waits for the ARP reply, other frames sent by the stack are skipped. */
+static void arp_reply_wait(uint8_t seq)
+{
+	size_t len;
+
+	do {
+		len = frame_get(reply, REPLY_WAIT);
+		zassert_true(len > 0, "No reply");
+	} while (!arp_reply_is(reply, len));
+
+	zassert_mem_equal(reply, peer_mac, sizeof(peer_mac),
+			  "Wrong destination");
+	zassert_mem_equal(&reply[ARP_SPA], my_ip, sizeof(my_ip),
+			  "Wrong sender");
+	zassert_equal(reply[ARP_TPA + 3], PEER_IP_FIRST + seq,
+		      "Wrong reply order");
+}
+
+static uint32_t round_trip_us(uint8_t seq)
+{
+	uint32_t start = k_cycle_get_32();
+
+	arp_request_inject(seq, ARP_SIZE);
+	arp_reply_wait(seq);
+
+	return k_cyc_to_us_floor32(k_cycle_get_32() - start);
+}
+
+static void test_init(void)
+{
+	struct in_addr addr = { { { MY_IP } } };
+	struct net_if *iface;
+	size_t len;
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(ETHERNET));
+	zassert_not_null(iface, "No interface");
+	zassert_not_null(net_if_ipv4_addr_add(iface, &addr, NET_ADDR_MANUAL,
+					      0), "No address");
+
+	zassert_not_null(rtt.up_name, "Up channel not configured");
+	zassert_not_null(rtt.down_name, "Down channel not configured");
+	zassert_equal(strcmp(rtt.up_name, "ETH_RTT"), 0, "Wrong name");
+	zassert_equal(strcmp(rtt.down_name, "ETH_RTT"), 0, "Wrong name");
+
+	/* The driver tells that the board was reset. */
+	len = frame_get(reply, REPLY_WAIT);
+	zassert_equal(len, RESET_SIZE, "No reset frame");
+	zassert_equal(reply[ETH_TYPE], 254, "Wrong reset frame");
+	zassert_equal(reply[ETH_TYPE + 1], 255, "Wrong reset frame");
+}
+
+static void test_receive(void)
+{
+	rtt.writes = 0;
+
+	arp_request_inject(0, ARP_SIZE);
+	arp_reply_wait(0);
+
+	zassert_equal(rtt.writes, 1, "Frame not written at once");
+}
+
+static void test_large_frame(void)
+{
+	/* Frame longer than the Ethernet MTU */
+	arp_request_inject(1, LARGE_SIZE);
+	arp_reply_wait(1);
+}
+
+static void test_idle(void)
+{
+	/* The polling period reaches its maximum after a few empty polls. */
+	k_sleep(K_MSEC(2 * CONFIG_ETH_POLL_PERIOD_MS));
+
+	rtt.reads = 0;
+	k_sleep(K_MSEC(IDLE_MS));
+
+	zassert_true(rtt.reads > 0, "No polling");
+	zassert_true(rtt.reads <= IDLE_MS / CONFIG_ETH_POLL_PERIOD_MS + 1,
+		     "Polling not backed off");
+}
+
+static void test_latency(void)
+{
+	uint32_t idle_us;
+	uint32_t elapsed_us;
+	uint32_t max_us = 0;
+	uint32_t total_us = 0;
+
+	/* The first frame waits for the idle polling period at most. */
+	idle_us = round_trip_us(0);
+	zassert_true(idle_us <= (CONFIG_ETH_POLL_PERIOD_MS + 1) *
+		     USEC_PER_MSEC, "Idle latency too long");
+
+	/* Next frames are polled with the active period. */
+	for (size_t i = 0; i < ROUND_TRIPS; i++) {
+		elapsed_us = round_trip_us(i % SEQ_CNT);
+		max_us = MAX(max_us, elapsed_us);
+		total_us += elapsed_us;
+	}
+
+	zassert_true(max_us <= (CONFIG_ETH_POLL_ACTIVE_PERIOD_MS + 1) *
+		     USEC_PER_MSEC, "Polling not adapted");
+
+	TC_PRINT("Latency after idle: %u us\n", idle_us);
+	TC_PRINT("Latency when active: %u us average, %u us max\n",
+		 total_us / ROUND_TRIPS, max_us);
+}
+
+static void test_burst(void)
+{
+	uint32_t start;
+	uint32_t elapsed_us;
+
+	rtt.writes = 0;
+	start = k_cycle_get_32();
+
+	for (size_t i = 0; i < BURST_CNT; i++) {
+		arp_request_inject(i, ARP_SIZE);
+	}
+
+	for (size_t i = 0; i < BURST_CNT; i++) {
+		arp_reply_wait(i);
+	}
+
+	elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+	zassert_true(rtt.writes < BURST_CNT, "Frames not batched");
+
+	TC_PRINT("%u frames in %u us, %u RTT writes\n", BURST_CNT,
+		 elapsed_us, rtt.writes);
+	if (elapsed_us > 0) {
+		TC_PRINT("Throughput: %u frames/s, %u bytes/s\n",
+			 (uint32_t)((uint64_t)BURST_CNT * USEC_PER_SEC /
+				    elapsed_us),
+			 (uint32_t)((uint64_t)BURST_CNT * ARP_SIZE *
+				    USEC_PER_SEC / elapsed_us));
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(eth_rtt_test,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_receive),
+			 ztest_unit_test(test_large_frame),
+			 ztest_unit_test(test_idle),
+			 ztest_unit_test(test_latency),
+			 ztest_unit_test(test_burst)
+			 );
+
+	ztest_run_test_suite(eth_rtt_test);
+}
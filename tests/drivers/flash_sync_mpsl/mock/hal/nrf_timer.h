@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr/types.h>
+
+/* The timer runs in simulated time, advanced by the fake flash. */
+typedef struct nrf_timer_mock NRF_TIMER_Type;
+
+#define NRF_TIMER0 ((NRF_TIMER_Type *)NULL)
+
+typedef enum {
+	NRF_TIMER_TASK_CAPTURE0
+} nrf_timer_task_t;
+
+typedef enum {
+	NRF_TIMER_CC_CHANNEL0
+} nrf_timer_cc_channel_t;
+
+void nrf_timer_task_trigger(NRF_TIMER_Type *p_reg, nrf_timer_task_t task);
+
+uint32_t nrf_timer_cc_get(NRF_TIMER_Type *p_reg,
+			  nrf_timer_cc_channel_t cc_channel);
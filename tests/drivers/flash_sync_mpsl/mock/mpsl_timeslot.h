@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr/types.h>
+
+/* Subset of the MPSL timeslot API used by the flash synchronization */
+#define MPSL_TIMESLOT_EARLIEST_TIMEOUT_MAX_US 128000000
+
+typedef uint8_t mpsl_timeslot_session_id_t;
+
+enum MPSL_TIMESLOT_SIGNAL {
+	MPSL_TIMESLOT_SIGNAL_START,
+	MPSL_TIMESLOT_SIGNAL_TIMER0,
+	MPSL_TIMESLOT_SIGNAL_RTC0,
+	MPSL_TIMESLOT_SIGNAL_RADIO,
+	MPSL_TIMESLOT_SIGNAL_EXTEND_FAILED,
+	MPSL_TIMESLOT_SIGNAL_EXTEND_SUCCEEDED,
+	MPSL_TIMESLOT_SIGNAL_BLOCKED,
+	MPSL_TIMESLOT_SIGNAL_CANCELLED,
+	MPSL_TIMESLOT_SIGNAL_SESSION_IDLE,
+	MPSL_TIMESLOT_SIGNAL_INVALID_RETURN,
+	MPSL_TIMESLOT_SIGNAL_SESSION_CLOSED,
+	MPSL_TIMESLOT_SIGNAL_OVERSTAYED,
+};
+
+enum MPSL_TIMESLOT_SIGNAL_ACTION {
+	MPSL_TIMESLOT_SIGNAL_ACTION_NONE,
+	MPSL_TIMESLOT_SIGNAL_ACTION_EXTEND,
+	MPSL_TIMESLOT_SIGNAL_ACTION_END,
+	MPSL_TIMESLOT_SIGNAL_ACTION_REQUEST,
+};
+
+enum MPSL_TIMESLOT_HFCLK_CFG {
+	MPSL_TIMESLOT_HFCLK_CFG_XTAL_GUARANTEED,
+	MPSL_TIMESLOT_HFCLK_CFG_NO_GUARANTEE,
+};
+
+enum MPSL_TIMESLOT_PRIORITY {
+	MPSL_TIMESLOT_PRIORITY_HIGH,
+	MPSL_TIMESLOT_PRIORITY_NORMAL,
+};
+
+enum MPSL_TIMESLOT_REQUEST_TYPE {
+	MPSL_TIMESLOT_REQ_TYPE_EARLIEST,
+	MPSL_TIMESLOT_REQ_TYPE_NORMAL,
+};
+
+typedef struct {
+	uint8_t hfclk;
+	uint8_t priority;
+	uint32_t length_us;
+	uint32_t timeout_us;
+} mpsl_timeslot_request_earliest_t;
+
+typedef struct {
+	uint8_t request_type;
+	union {
+		mpsl_timeslot_request_earliest_t earliest;
+	} params;
+} mpsl_timeslot_request_t;
+
+typedef struct {
+	uint8_t callback_action;
+	union {
+		struct {
+			mpsl_timeslot_request_t *p_next;
+		} request;
+	} params;
+} mpsl_timeslot_signal_return_param_t;
+
+typedef mpsl_timeslot_signal_return_param_t *(*mpsl_timeslot_callback_t)(
+	mpsl_timeslot_session_id_t session_id, uint32_t signal);
+
+int32_t mpsl_timeslot_session_open(
+	mpsl_timeslot_callback_t mpsl_timeslot_signal_callback,
+	mpsl_timeslot_session_id_t *p_session_id);
+
+int32_t mpsl_timeslot_session_close(mpsl_timeslot_session_id_t session_id);
+
+int32_t mpsl_timeslot_request(mpsl_timeslot_session_id_t session_id,
+			      mpsl_timeslot_request_t const *p_request);
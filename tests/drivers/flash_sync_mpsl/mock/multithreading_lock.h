@@ -0,0 +1,9 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* The fake timeslot scheduler runs in the system work queue thread. */
+#define MULTITHREADING_LOCK_ACQUIRE() 0
+#define MULTITHREADING_LOCK_RELEASE()
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+/* Definitions shared with the nRF flash driver */
+#define FLASH_OP_DONE    (0)
+#define FLASH_OP_ONGOING (-1)
+
+#define FLASH_TIMEOUT_MS 1000
+
+struct flash_op_desc {
+	int (*handler)(void *context);
+	void *context;
+};
+
+int nrf_flash_sync_init(void);
+void nrf_flash_sync_set_context(uint32_t duration);
+bool nrf_flash_sync_is_required(void);
+void nrf_flash_sync_get_timestamp_begin(void);
+bool nrf_flash_sync_check_time_limit(uint32_t iteration);
+int nrf_flash_sync_exe(struct flash_op_desc *op_desc);
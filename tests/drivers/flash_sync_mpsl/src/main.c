@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <storage/flash_map.h>
+#include <mpsl.h>
+#include <mpsl_timeslot.h>
+#include <hal/nrf_timer.h>
+#include <soc_flash_nrf.h>
+#include <drivers/flash_sync_mpsl.h>
+
+/* Simulated flash timings */
+#define WORD_SIZE		sizeof(uint32_t)
+#define WORD_WRITE_US		41
+#define PAGE_SIZE		4096
+#define PAGE_ERASE_US		3000
+#define PAGE_CNT		4
+
+/* Flash time the nRF flash driver requests for each timeslot */
+#define WRITE_REQUEST_US	5000
+#define ERASE_REQUEST_US	PAGE_ERASE_US
+#define SLACK_US		100
+
+#define WRITE_SIZE		2048
+#define UNLIMITED		UINT32_MAX
+
+struct write_context {
+	off_t offset;
+	const uint8_t *data;
+	size_t len;
+};
+
+struct erase_context {
+	off_t offset;
+	size_t len;
+};
+
+/* Fake MPSL timeslot scheduler */
+static struct {
+	mpsl_timeslot_callback_t callback;
+	mpsl_timeslot_request_t request;
+	bool open;
+	bool pending;
+	/* Requests for longer timeslots are blocked. */
+	uint32_t length_limit_us;
+	uint32_t timeslots;
+	uint32_t blocked;
+	uint32_t overruns;
+	uint32_t longest_us;
+} sched;
+
+static struct k_work sched_work;
+static uint32_t timer_us;
+static uint32_t timer_capture_us;
+
+static const struct flash_area *fa;
+static uint8_t data[WRITE_SIZE];
+static uint8_t readback[WRITE_SIZE];
+
+bool mpsl_is_initialized(void)
+{
+	return true;
+}
+
+void nrf_timer_task_trigger(NRF_TIMER_Type *p_reg, nrf_timer_task_t task)
+{
+	timer_capture_us = timer_us;
+}
+
+uint32_t nrf_timer_cc_get(NRF_TIMER_Type *p_reg,
+			  nrf_timer_cc_channel_t cc_channel)
+{
+	return timer_capture_us;
+}
+
+int32_t mpsl_timeslot_session_open(
+	mpsl_timeslot_callback_t mpsl_timeslot_signal_callback,
+	mpsl_timeslot_session_id_t *p_session_id)
+{
+	zassert_false(sched.open, "Session already open");
+
+	sched.callback = mpsl_timeslot_signal_callback;
+	sched.open = true;
+	*p_session_id = 0;
+
+	return 0;
+}
+
+int32_t mpsl_timeslot_session_close(mpsl_timeslot_session_id_t session_id)
+{
+	sched.open = false;
+	sched.pending = false;
+
+	return 0;
+}
+
+int32_t mpsl_timeslot_request(mpsl_timeslot_session_id_t session_id,
+			      mpsl_timeslot_request_t const *p_request)
+{
+	zassert_true(sched.open, "Session not open");
+	zassert_false(sched.pending, "Request already pending");
+
+	sched.request = *p_request;
+	sched.pending = true;
+	k_work_submit(&sched_work);
+
+	return 0;
+}
+
+static void sched_work_fn(struct k_work *work)
+{
+	mpsl_timeslot_signal_return_param_t *ret;
+	uint32_t length_us;
+
+	while (sched.open && sched.pending) {
+		length_us = sched.request.params.earliest.length_us;
+		sched.pending = false;
+
+		if (length_us > sched.length_limit_us) {
+			sched.blocked++;
+			(void)sched.callback(0, MPSL_TIMESLOT_SIGNAL_BLOCKED);
+			continue;
+		}
+
+		timer_us = 0;
+		sched.timeslots++;
+		sched.longest_us = MAX(sched.longest_us, length_us);
+
+		ret = sched.callback(0, MPSL_TIMESLOT_SIGNAL_START);
+		if (timer_us > length_us) {
+			sched.overruns++;
+		}
+
+		zassert_not_null(ret, "No timeslot action");
+
+		if (ret->callback_action ==
+		    MPSL_TIMESLOT_SIGNAL_ACTION_REQUEST) {
+			sched.request = *ret->params.request.p_next;
+			sched.pending = true;
+		} else {
+			zassert_equal(ret->callback_action,
+				      MPSL_TIMESLOT_SIGNAL_ACTION_END,
+				      "Unexpected timeslot action");
+			(void)sched.callback(0,
+					     MPSL_TIMESLOT_SIGNAL_SESSION_IDLE);
+		}
+	}
+}
+
+static void sched_reset(uint32_t length_limit_us)
+{
+	sched.length_limit_us = length_limit_us;
+	sched.timeslots = 0;
+	sched.blocked = 0;
+	sched.overruns = 0;
+	sched.longest_us = 0;
+}
+
+/* Flash operation handlers, stepping like the nRF flash driver */
+static int write_op(void *context)
+{
+	struct write_context *w_ctx = context;
+	uint32_t i = 0;
+
+	nrf_flash_sync_get_timestamp_begin();
+
+	while (w_ctx->len >= WORD_SIZE) {
+		zassert_equal(flash_area_write(fa, w_ctx->offset, w_ctx->data,
+					       WORD_SIZE), 0, "Write failed");
+		timer_us += WORD_WRITE_US;
+
+		w_ctx->offset += WORD_SIZE;
+		w_ctx->data += WORD_SIZE;
+		w_ctx->len -= WORD_SIZE;
+
+		i++;
+		if (nrf_flash_sync_check_time_limit(i)) {
+			return FLASH_OP_ONGOING;
+		}
+	}
+
+	return FLASH_OP_DONE;
+}
+
+static int erase_op(void *context)
+{
+	struct erase_context *e_ctx = context;
+	uint32_t i = 0;
+
+	nrf_flash_sync_get_timestamp_begin();
+
+	while (e_ctx->len > 0) {
+		zassert_equal(flash_area_erase(fa, e_ctx->offset, PAGE_SIZE), 0,
+			      "Erase failed");
+		timer_us += PAGE_ERASE_US;
+
+		e_ctx->offset += PAGE_SIZE;
+		e_ctx->len -= PAGE_SIZE;
+
+		i++;
+		if (nrf_flash_sync_check_time_limit(i)) {
+			return FLASH_OP_ONGOING;
+		}
+	}
+
+	return FLASH_OP_DONE;
+}
+
+static void flash_erase(off_t offset, size_t len)
+{
+	struct erase_context e_ctx = {
+		.offset = offset,
+		.len = len
+	};
+	struct flash_op_desc op_desc = {
+		.handler = erase_op,
+		.context = &e_ctx
+	};
+
+	nrf_flash_sync_set_context(ERASE_REQUEST_US);
+	zassert_equal(nrf_flash_sync_exe(&op_desc), 0, "Erase not done");
+}
+
+static void flash_write(off_t offset, const uint8_t *src, size_t len)
+{
+	struct write_context w_ctx = {
+		.offset = offset,
+		.data = src,
+		.len = len
+	};
+	struct flash_op_desc op_desc = {
+		.handler = write_op,
+		.context = &w_ctx
+	};
+
+	nrf_flash_sync_set_context(WRITE_REQUEST_US);
+	zassert_equal(nrf_flash_sync_exe(&op_desc), 0, "Write not done");
+}
+
+static void write_verify(off_t offset, uint8_t seed)
+{
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = seed + i;
+	}
+
+	flash_write(offset, data, sizeof(data));
+
+	zassert_equal(flash_area_read(fa, offset, readback, sizeof(readback)),
+		      0, "Read failed");
+	zassert_mem_equal(readback, data, sizeof(data), "Wrong data");
+	zassert_equal(sched.overruns, 0, "Timeslot overrun");
+}
+
+static void test_init(void)
+{
+	zassert_equal(flash_area_open(FLASH_AREA_ID(storage), &fa), 0,
+		      "No flash area");
+	zassert_true(fa->fa_size >= PAGE_CNT * PAGE_SIZE,
+		     "Flash area too small");
+
+	k_work_init(&sched_work, sched_work_fn);
+
+	zassert_equal(nrf_flash_sync_init(), 0, "Not initialized");
+	zassert_true(nrf_flash_sync_is_required(), "Sync not required");
+	zassert_equal(flash_sync_mpsl_stats_get(NULL), -EINVAL,
+		      "Statistics without buffer");
+
+	flash_sync_mpsl_stats_reset();
+}
+
+static void test_erase(void)
+{
+	uint32_t timeslots;
+
+	sched_reset(UNLIMITED);
+	flash_erase(0, PAGE_CNT * PAGE_SIZE);
+
+	zassert_equal(sched.overruns, 0, "Timeslot overrun");
+	timeslots = sched.timeslots;
+
+	/* The timeslots are long enough for all pages now. */
+	sched_reset(UNLIMITED);
+	flash_erase(0, PAGE_CNT * PAGE_SIZE);
+
+	zassert_equal(sched.overruns, 0, "Timeslot overrun");
+	zassert_equal(sched.timeslots, 1, "Pages not batched");
+	zassert_true(sched.timeslots < timeslots, "Timeslots not adapted");
+
+	zassert_equal(flash_area_read(fa, 0, readback, sizeof(readback)), 0,
+		      "Read failed");
+	for (size_t i = 0; i < sizeof(readback); i++) {
+		zassert_equal(readback[i], 0xFF, "Not erased");
+	}
+}
+
+static void test_write(void)
+{
+	uint32_t timeslots;
+
+	sched_reset(UNLIMITED);
+	write_verify(0, 0);
+
+	/* The write takes longer than the requested length, the timeslots
+	 * grow until it is done.
+	 */
+	timeslots = sched.timeslots;
+	zassert_true(timeslots > 1, "Write done in one timeslot");
+	zassert_true(sched.longest_us > WRITE_REQUEST_US + SLACK_US,
+		     "Timeslot length not adapted");
+
+	/* The next write of the same size asks for longer timeslots at once. */
+	sched_reset(UNLIMITED);
+	write_verify(WRITE_SIZE, 1);
+
+	zassert_true(sched.timeslots < timeslots, "Timeslots not adapted");
+	zassert_true(sched.longest_us <=
+		     CONFIG_SOC_FLASH_NRF_RADIO_SYNC_MPSL_MAX_LENGTH_US +
+		     SLACK_US, "Timeslot too long");
+}
+
+static void test_blocked(void)
+{
+	/* Only short timeslots are granted, the requests shrink to fit. */
+	sched_reset(2 * (WRITE_REQUEST_US + SLACK_US));
+	flash_erase(2 * PAGE_SIZE, PAGE_SIZE);
+
+	sched_reset(2 * (WRITE_REQUEST_US + SLACK_US));
+	write_verify(2 * PAGE_SIZE, 2);
+
+	zassert_true(sched.blocked > 0, "No timeslot blocked");
+	zassert_true(sched.longest_us <= sched.length_limit_us,
+		     "Blocked timeslot granted");
+}
+
+static void test_stats(void)
+{
+	struct flash_sync_mpsl_stats stats;
+
+	zassert_equal(flash_sync_mpsl_stats_get(&stats), 0, "No statistics");
+
+	/* Three erases and three writes */
+	zassert_equal(stats.operations, 6, "Wrong operation count");
+	zassert_equal(stats.timeouts, 0, "Timeouts reported");
+	zassert_true(stats.timeslots >= stats.operations,
+		     "Wrong timeslot count");
+	zassert_true(stats.blocked > 0, "Wrong blocked count");
+	zassert_equal(stats.steps,
+		      2 * PAGE_CNT + 1 + 3 * WRITE_SIZE / WORD_SIZE,
+		      "Wrong step count");
+	zassert_equal(stats.busy_us, (2 * PAGE_CNT + 1) * PAGE_ERASE_US +
+		      3 * WRITE_SIZE / WORD_SIZE * WORD_WRITE_US,
+		      "Wrong busy time");
+	zassert_true(stats.latency_total_us >= stats.latency_max_us,
+		     "Wrong latency");
+
+	flash_sync_mpsl_stats_reset();
+	zassert_equal(flash_sync_mpsl_stats_get(&stats), 0, "No statistics");
+	zassert_equal(stats.operations, 0, "Statistics not reset");
+	zassert_equal(stats.steps, 0, "Statistics not reset");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(flash_sync_mpsl_test,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_erase),
+			 ztest_unit_test(test_write),
+			 ztest_unit_test(test_blocked),
+			 ztest_unit_test(test_stats)
+			 );
+
+	ztest_run_test_suite(flash_sync_mpsl_test);
+}
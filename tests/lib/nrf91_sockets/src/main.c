@@ -0,0 +1,651 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <nrf_socket.h>
+#include <modem/nrf91_poll_set.h>
+
+#define PART_SIZE	10
+#define LARGE_SIZE	600
+#define CHUNK_SIZE	7
+#define CALL_CNT	16
+#define PORT		5683
+#define HEAP_BLOCK_SIZE	256
+#define HEAP_BLOCK_CNT	(CONFIG_HEAP_MEM_POOL_SIZE / HEAP_BLOCK_SIZE)
+
+#define THREAD_CNT	CONFIG_BSD_LIBRARY_SENDMSG_BUF_COUNT
+#define THREAD_MSG_CNT	10
+#define SEND_DELAY_MS	2
+#define STACK_SIZE	1024
+
+#define SD_CNT		16
+#define POLL_SOCK_CNT	4
+#define POLL_ITERATIONS	1000
+
+struct sendto_call {
+	int sd;
+	const void *buf;
+	uint8_t data[LARGE_SIZE];
+	size_t len;
+	int flags;
+	uint16_t port;
+};
+
+/* Mocked bsdlib sockets */
+static struct {
+	int next_sd;
+	/* Largest number of bytes sent in one call, 0 if not limited */
+	size_t chunk;
+	/* Flags returned by fcntl for all sockets */
+	int fcntl_flags;
+	/* Simulated modem latency, calls are not recorded if set */
+	int delay_ms;
+	atomic_t delayed_calls;
+	struct sendto_call calls[CALL_CNT];
+	size_t call_cnt;
+	/* Events reported by poll for each socket */
+	short revents[SD_CNT];
+	/* Requested events and number of sockets in the last poll call */
+	short events[SD_CNT];
+	uint32_t poll_nfds;
+	uint32_t poll_calls;
+} mock;
+
+static uint8_t data[LARGE_SIZE];
+static int udp_sock;
+static int tcp_sock;
+static int poll_socks[POLL_SOCK_CNT];
+static struct nrf91_poll_set poll_set;
+
+static K_THREAD_STACK_ARRAY_DEFINE(stacks, THREAD_CNT, STACK_SIZE);
+static struct k_thread threads[THREAD_CNT];
+static K_SEM_DEFINE(done_sem, 0, THREAD_CNT);
+
+int nrf_socket(int family, int type, int protocol)
+{
+	zassert_true(mock.next_sd < SD_CNT, "Too many sockets");
+
+	return mock.next_sd++;
+}
+
+int nrf_close(int fildes)
+{
+	return 0;
+}
+
+ssize_t nrf_sendto(int socket, const void *message, size_t length, int flags,
+		   const void *dest_addr, nrf_socklen_t dest_len)
+{
+	struct sendto_call *call;
+
+	if (mock.delay_ms > 0) {
+		atomic_inc(&mock.delayed_calls);
+		k_sleep(K_MSEC(mock.delay_ms));
+		return length;
+	}
+
+	zassert_true(mock.call_cnt < CALL_CNT, "Too many calls");
+	zassert_true(length <= LARGE_SIZE, "Message too long");
+
+	if (mock.chunk > 0) {
+		length = MIN(length, mock.chunk);
+	}
+
+	call = &mock.calls[mock.call_cnt++];
+	call->sd = socket;
+	call->buf = message;
+	call->len = length;
+	call->flags = flags;
+	call->port = (dest_addr != NULL) ?
+		((const struct nrf_sockaddr_in *)dest_addr)->sin_port : 0;
+	memcpy(call->data, message, length);
+
+	return length;
+}
+
+/* Socket functions that are not used by the test */
+ssize_t nrf_recvfrom(int socket, void *buffer, size_t length, int flags,
+		     void *address, nrf_socklen_t *address_len)
+{
+	return -1;
+}
+
+int nrf_connect(int socket, const void *address, nrf_socklen_t address_len)
+{
+	return -1;
+}
+
+int nrf_bind(int socket, const void *address, nrf_socklen_t address_len)
+{
+	return -1;
+}
+
+int nrf_listen(int sock, int backlog)
+{
+	return -1;
+}
+
+int nrf_accept(int socket, void *address, nrf_socklen_t *address_len)
+{
+	return -1;
+}
+
+int nrf_setsockopt(int socket, int level, int option_name,
+		   const void *option_value, nrf_socklen_t option_len)
+{
+	return -1;
+}
+
+int nrf_getsockopt(int socket, int level, int option_name, void *option_value,
+		   nrf_socklen_t *option_len)
+{
+	return -1;
+}
+
+int nrf_poll(struct nrf_pollfd *fds, nrf_nfds_t nfds, int timeout)
+{
+	int ready = 0;
+
+	mock.poll_nfds = nfds;
+	mock.poll_calls++;
+
+	for (size_t i = 0; i < nfds; i++) {
+		zassert_true((fds[i].fd >= 0) && (fds[i].fd < SD_CNT),
+			     "Invalid socket");
+
+		mock.events[fds[i].fd] = fds[i].events;
+		fds[i].revents = mock.revents[fds[i].fd] &
+				 (fds[i].events | NRF_POLLERR | NRF_POLLHUP);
+		if (fds[i].revents) {
+			ready++;
+		}
+	}
+
+	return ready;
+}
+
+int nrf_fcntl(int fd, int cmd, int flags)
+{
+	if (cmd == NRF_F_GETFL) {
+		return mock.fcntl_flags;
+	}
+
+	return -1;
+}
+
+int nrf_getaddrinfo(const char *p_node, const char *p_service,
+		    const struct nrf_addrinfo *p_hints,
+		    struct nrf_addrinfo **pp_res)
+{
+	return -1;
+}
+
+void nrf_freeaddrinfo(struct nrf_addrinfo *p_res)
+{
+}
+
+static ssize_t msg_send(int sock, struct iovec *iov, size_t cnt, int flags)
+{
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = cnt
+	};
+
+	mock.call_cnt = 0;
+
+	return zsock_sendmsg(sock, &msg, flags);
+}
+
+static void call_check(size_t i, size_t offset, size_t len)
+{
+	zassert_equal(mock.calls[i].len, len, "Wrong length");
+	zassert_mem_equal(mock.calls[i].data, &data[offset], len,
+			  "Wrong data");
+}
+
+static void test_init(void)
+{
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+
+	udp_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(udp_sock >= 0, "No UDP socket");
+
+	tcp_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(tcp_sock >= 0, "No TCP socket");
+}
+
+static void test_boundaries(void)
+{
+	struct iovec iov[] = {
+		{ .iov_base = data, .iov_len = PART_SIZE },
+		{ .iov_base = &data[PART_SIZE], .iov_len = 0 },
+		{ .iov_base = &data[PART_SIZE], .iov_len = 2 * PART_SIZE },
+	};
+
+	zassert_equal(msg_send(udp_sock, iov, ARRAY_SIZE(iov), 0),
+		      3 * PART_SIZE, "Message not sent");
+
+	zassert_equal(mock.call_cnt, 1, "Message split");
+	call_check(0, 0, 3 * PART_SIZE);
+}
+
+static void test_large_message(void)
+{
+	struct iovec iov[4];
+
+	/* Larger than the sendmsg buffers */
+	for (size_t i = 0; i < ARRAY_SIZE(iov); i++) {
+		iov[i].iov_base = &data[i * LARGE_SIZE / ARRAY_SIZE(iov)];
+		iov[i].iov_len = LARGE_SIZE / ARRAY_SIZE(iov);
+	}
+
+	zassert_equal(msg_send(udp_sock, iov, ARRAY_SIZE(iov), 0),
+		      LARGE_SIZE, "Message not sent");
+
+	zassert_equal(mock.call_cnt, 1, "Message split");
+	call_check(0, 0, LARGE_SIZE);
+}
+
+static void test_single_part(void)
+{
+	struct iovec iov[] = {
+		{ .iov_base = NULL, .iov_len = 0 },
+		{ .iov_base = data, .iov_len = LARGE_SIZE },
+	};
+
+	zassert_equal(msg_send(udp_sock, iov, ARRAY_SIZE(iov), 0),
+		      LARGE_SIZE, "Message not sent");
+
+	zassert_equal(mock.call_cnt, 1, "Message split");
+	zassert_equal_ptr(mock.calls[0].buf, data, "Message copied");
+	call_check(0, 0, LARGE_SIZE);
+}
+
+static void test_address(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(PORT),
+	};
+	struct iovec iov[] = {
+		{ .iov_base = data, .iov_len = PART_SIZE },
+		{ .iov_base = &data[PART_SIZE], .iov_len = PART_SIZE },
+	};
+	struct msghdr msg = {
+		.msg_name = &addr,
+		.msg_namelen = sizeof(addr),
+		.msg_iov = iov,
+		.msg_iovlen = ARRAY_SIZE(iov)
+	};
+
+	mock.call_cnt = 0;
+
+	zassert_equal(zsock_sendmsg(udp_sock, &msg, 0), 2 * PART_SIZE,
+		      "Message not sent");
+
+	zassert_equal(mock.call_cnt, 1, "Message split");
+	zassert_equal(mock.calls[0].port, htons(PORT), "Wrong address");
+	call_check(0, 0, 2 * PART_SIZE);
+}
+
+static void test_stream(void)
+{
+	struct iovec iov[] = {
+		{ .iov_base = data, .iov_len = PART_SIZE },
+		{ .iov_base = &data[PART_SIZE], .iov_len = 2 * PART_SIZE },
+	};
+	size_t offset = 0;
+
+	/* The modem accepts only a part of the data in each call. */
+	mock.chunk = CHUNK_SIZE;
+
+	zassert_equal(msg_send(tcp_sock, iov, ARRAY_SIZE(iov), 0),
+		      3 * PART_SIZE, "Message not sent");
+
+	zassert_equal(mock.call_cnt,
+		      DIV_ROUND_UP(3 * PART_SIZE, CHUNK_SIZE),
+		      "Wrong call count");
+
+	for (size_t i = 0; i < mock.call_cnt; i++) {
+		call_check(i, offset, MIN(CHUNK_SIZE, 3 * PART_SIZE - offset));
+		offset += mock.calls[i].len;
+	}
+
+	mock.chunk = 0;
+}
+
+static void test_dontwait(void)
+{
+	struct iovec iov[] = {
+		{ .iov_base = data, .iov_len = PART_SIZE },
+		{ .iov_base = &data[PART_SIZE], .iov_len = PART_SIZE },
+	};
+
+	mock.chunk = CHUNK_SIZE;
+
+	/* Only the data accepted at once are sent. */
+	zassert_equal(msg_send(tcp_sock, iov, ARRAY_SIZE(iov), MSG_DONTWAIT),
+		      CHUNK_SIZE, "Wrong length");
+
+	zassert_equal(mock.call_cnt, 1, "Wrong call count");
+	zassert_true(mock.calls[0].flags & NRF_MSG_DONTWAIT,
+		     "Flag not passed");
+	call_check(0, 0, CHUNK_SIZE);
+
+	mock.chunk = 0;
+}
+
+static void test_nonblock(void)
+{
+	struct iovec iov[] = {
+		{ .iov_base = data, .iov_len = PART_SIZE },
+		{ .iov_base = &data[PART_SIZE], .iov_len = PART_SIZE },
+	};
+
+	mock.chunk = CHUNK_SIZE;
+	mock.fcntl_flags = NRF_O_NONBLOCK;
+
+	/* Like MSG_DONTWAIT on a non-blocking socket */
+	zassert_equal(msg_send(tcp_sock, iov, ARRAY_SIZE(iov), 0),
+		      CHUNK_SIZE, "Wrong length");
+
+	zassert_equal(mock.call_cnt, 1, "Wrong call count");
+	call_check(0, 0, CHUNK_SIZE);
+
+	mock.fcntl_flags = 0;
+	mock.chunk = 0;
+}
+
+static void test_no_memory(void)
+{
+	void *heap[HEAP_BLOCK_CNT];
+	size_t heap_cnt = 0;
+	struct iovec iov[4];
+
+	/* Larger than the sendmsg buffers, and the heap is exhausted. */
+	for (size_t i = 0; i < ARRAY_SIZE(iov); i++) {
+		iov[i].iov_base = &data[i * LARGE_SIZE / ARRAY_SIZE(iov)];
+		iov[i].iov_len = LARGE_SIZE / ARRAY_SIZE(iov);
+	}
+
+	while (heap_cnt < ARRAY_SIZE(heap)) {
+		heap[heap_cnt] = k_malloc(HEAP_BLOCK_SIZE);
+		if (heap[heap_cnt] == NULL) {
+			break;
+		}
+
+		heap_cnt++;
+	}
+
+	zassert_true(heap_cnt < ARRAY_SIZE(heap), "Heap not exhausted");
+
+	/* Datagrams can not be split. */
+	zassert_equal(msg_send(udp_sock, iov, ARRAY_SIZE(iov), 0), -1,
+		      "Message sent");
+	zassert_equal(errno, ENOMEM, "Wrong error");
+	zassert_equal(mock.call_cnt, 0, "Message split");
+
+	/* Stream parts are sent one by one. */
+	zassert_equal(msg_send(tcp_sock, iov, ARRAY_SIZE(iov), 0),
+		      LARGE_SIZE, "Message not sent");
+	zassert_equal(mock.call_cnt, ARRAY_SIZE(iov), "Wrong call count");
+
+	for (size_t i = 0; i < ARRAY_SIZE(iov); i++) {
+		call_check(i, i * iov[0].iov_len, iov[0].iov_len);
+		zassert_equal_ptr(mock.calls[i].buf, iov[i].iov_base,
+				  "Part copied");
+	}
+
+	while (heap_cnt > 0) {
+		k_free(heap[--heap_cnt]);
+	}
+}
+
+static void sender(void *p1, void *p2, void *p3)
+{
+	int sock = POINTER_TO_INT(p1);
+	struct iovec iov[] = {
+		{ .iov_base = data, .iov_len = PART_SIZE },
+		{ .iov_base = &data[PART_SIZE], .iov_len = PART_SIZE },
+	};
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = ARRAY_SIZE(iov)
+	};
+
+	for (size_t i = 0; i < THREAD_MSG_CNT; i++) {
+		zassert_equal(zsock_sendmsg(sock, &msg, 0), 2 * PART_SIZE,
+			      "Message not sent");
+	}
+
+	k_sem_give(&done_sem);
+}
+
+static void test_contention(void)
+{
+	uint32_t serial_ms = THREAD_CNT * THREAD_MSG_CNT * SEND_DELAY_MS;
+	uint32_t start;
+	uint32_t elapsed_ms;
+	int socks[THREAD_CNT];
+
+	mock.delay_ms = SEND_DELAY_MS;
+	start = k_uptime_get_32();
+
+	/* Each thread sends on its own socket. */
+	for (size_t i = 0; i < THREAD_CNT; i++) {
+		socks[i] = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		zassert_true(socks[i] >= 0, "No socket");
+
+		k_thread_create(&threads[i], stacks[i], STACK_SIZE, sender,
+				INT_TO_POINTER(socks[i]), NULL, NULL,
+				K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	}
+
+	for (size_t i = 0; i < THREAD_CNT; i++) {
+		zassert_equal(k_sem_take(&done_sem, K_MSEC(serial_ms)), 0,
+			      "Sender not done");
+	}
+
+	elapsed_ms = k_uptime_get_32() - start;
+	mock.delay_ms = 0;
+
+	for (size_t i = 0; i < THREAD_CNT; i++) {
+		zassert_equal(zsock_close(socks[i]), 0, "Socket not closed");
+	}
+
+	zassert_equal(atomic_get(&mock.delayed_calls),
+		      THREAD_CNT * THREAD_MSG_CNT, "Wrong call count");
+
+	/* Sockets do not wait for each other. */
+	zassert_true(elapsed_ms < serial_ms / 2, "Sockets serialized");
+
+	TC_PRINT("%u messages from %u threads in %u ms, %u ms serialized\n",
+		 THREAD_CNT * THREAD_MSG_CNT, THREAD_CNT, elapsed_ms,
+		 serial_ms);
+}
+
+/* Socket descriptor of the test socket, as assigned by the mock */
+static int sd_get(int sock)
+{
+	for (size_t i = 0; i < POLL_SOCK_CNT; i++) {
+		if (poll_socks[i] == sock) {
+			return mock.next_sd - POLL_SOCK_CNT + i;
+		}
+	}
+
+	zassert_unreachable("Unknown socket");
+
+	return -1;
+}
+
+static void test_poll_set_ctl(void)
+{
+	for (size_t i = 0; i < POLL_SOCK_CNT; i++) {
+		poll_socks[i] = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		zassert_true(poll_socks[i] >= 0, "No socket");
+	}
+
+	zassert_equal(nrf91_poll_set_init(NULL), -1, "Set without memory");
+	zassert_equal(errno, EINVAL, "Wrong error");
+	zassert_equal(nrf91_poll_set_init(&poll_set), 0, "Set not created");
+
+	for (size_t i = 0; i < POLL_SOCK_CNT; i++) {
+		zassert_equal(nrf91_poll_set_ctl(&poll_set, NRF91_POLL_SET_ADD,
+						 poll_socks[i], POLLIN), 0,
+			      "Socket not added");
+	}
+
+	zassert_equal(nrf91_poll_set_ctl(&poll_set, NRF91_POLL_SET_ADD,
+					 poll_socks[0], POLLIN), -1,
+		      "Socket added twice");
+	zassert_equal(errno, EEXIST, "Wrong error");
+
+	zassert_equal(nrf91_poll_set_ctl(&poll_set, NRF91_POLL_SET_ADD, -1,
+					 POLLIN), -1, "Invalid socket added");
+	zassert_equal(errno, EBADF, "Wrong error");
+
+	zassert_equal(nrf91_poll_set_ctl(&poll_set, NRF91_POLL_SET_DEL,
+					 poll_socks[0], 0), 0,
+		      "Socket not removed");
+	zassert_equal(nrf91_poll_set_ctl(&poll_set, NRF91_POLL_SET_DEL,
+					 poll_socks[0], 0), -1,
+		      "Socket removed twice");
+	zassert_equal(errno, ENOENT, "Wrong error");
+
+	zassert_equal(nrf91_poll_set_ctl(&poll_set, NRF91_POLL_SET_MOD,
+					 poll_socks[0], POLLOUT), -1,
+		      "Removed socket changed");
+	zassert_equal(errno, ENOENT, "Wrong error");
+
+	zassert_equal(nrf91_poll_set_ctl(&poll_set, NRF91_POLL_SET_ADD,
+					 poll_socks[0], POLLIN), 0,
+		      "Socket not added");
+	zassert_equal(nrf91_poll_set_ctl(&poll_set, NRF91_POLL_SET_MOD,
+					 poll_socks[1], POLLIN | POLLOUT), 0,
+		      "Socket not changed");
+	zassert_equal(nrf91_poll_set_ctl(&poll_set, -1, poll_socks[1], 0), -1,
+		      "Invalid operation done");
+	zassert_equal(errno, EINVAL, "Wrong error");
+}
+
+static void test_poll_set_wait(void)
+{
+	struct zsock_pollfd ready[POLL_SOCK_CNT];
+	int first[2];
+
+	memset(mock.revents, 0, sizeof(mock.revents));
+
+	zassert_equal(nrf91_poll_set_wait(&poll_set, ready, ARRAY_SIZE(ready),
+					  0), 0, "Socket ready");
+	zassert_equal(mock.poll_nfds, POLL_SOCK_CNT, "Wrong socket count");
+	zassert_equal(mock.events[sd_get(poll_socks[0])], NRF_POLLIN,
+		      "Wrong events");
+	zassert_equal(mock.events[sd_get(poll_socks[1])],
+		      NRF_POLLIN | NRF_POLLOUT, "Wrong events");
+
+	/* Only the ready socket is returned. */
+	mock.revents[sd_get(poll_socks[2])] = NRF_POLLIN;
+
+	zassert_equal(nrf91_poll_set_wait(&poll_set, ready, ARRAY_SIZE(ready),
+					  0), 1, "Wrong ready count");
+	zassert_equal(ready[0].fd, poll_socks[2], "Wrong socket");
+	zassert_equal(ready[0].events, POLLIN, "Wrong events");
+	zassert_equal(ready[0].revents, POLLIN, "Wrong returned events");
+
+	/* More ready sockets than entries */
+	mock.revents[sd_get(poll_socks[1])] = NRF_POLLOUT;
+	mock.revents[sd_get(poll_socks[3])] = NRF_POLLIN | NRF_POLLHUP;
+
+	zassert_equal(nrf91_poll_set_wait(&poll_set, ready, 2, 0), 2,
+		      "Wrong ready count");
+	first[0] = ready[0].fd;
+	first[1] = ready[1].fd;
+
+	/* The socket left out is returned first in the next call. */
+	zassert_equal(nrf91_poll_set_wait(&poll_set, ready, 2, 0), 2,
+		      "Wrong ready count");
+	zassert_true((ready[0].fd != first[0]) && (ready[0].fd != first[1]),
+		     "Ready socket starved");
+
+	zassert_equal(nrf91_poll_set_wait(&poll_set, ready, ARRAY_SIZE(ready),
+					  0), 3, "Wrong ready count");
+
+	for (size_t i = 0; i < 3; i++) {
+		if (ready[i].fd == poll_socks[3]) {
+			zassert_equal(ready[i].revents, POLLIN | POLLHUP,
+				      "Wrong returned events");
+		}
+	}
+
+	zassert_equal(nrf91_poll_set_wait(&poll_set, NULL, 1, 0), -1,
+		      "Wait without memory");
+	zassert_equal(errno, EINVAL, "Wrong error");
+}
+
+static void test_poll_benchmark(void)
+{
+	struct zsock_pollfd fds[POLL_SOCK_CNT];
+	struct zsock_pollfd ready[POLL_SOCK_CNT];
+	uint32_t poll_cycles;
+	uint32_t set_cycles;
+	uint32_t start;
+
+	memset(mock.revents, 0, sizeof(mock.revents));
+	mock.revents[sd_get(poll_socks[2])] = NRF_POLLIN;
+
+	for (size_t i = 0; i < POLL_SOCK_CNT; i++) {
+		fds[i].fd = poll_socks[i];
+		fds[i].events = POLLIN;
+	}
+
+	start = k_cycle_get_32();
+	for (size_t i = 0; i < POLL_ITERATIONS; i++) {
+		zassert_equal(zsock_poll(fds, ARRAY_SIZE(fds), 0), 1,
+			      "Wrong ready count");
+	}
+	poll_cycles = k_cycle_get_32() - start;
+
+	mock.poll_calls = 0;
+
+	start = k_cycle_get_32();
+	for (size_t i = 0; i < POLL_ITERATIONS; i++) {
+		zassert_equal(nrf91_poll_set_wait(&poll_set, ready,
+						  ARRAY_SIZE(ready), 0), 1,
+			      "Wrong ready count");
+	}
+	set_cycles = k_cycle_get_32() - start;
+
+	zassert_equal(mock.poll_calls, POLL_ITERATIONS, "Wrong poll count");
+
+	TC_PRINT("%u waits for %u sockets\n", POLL_ITERATIONS, POLL_SOCK_CNT);
+	TC_PRINT("poll(): %u cycles, poll set: %u cycles\n", poll_cycles,
+		 set_cycles);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf91_sockets_test,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_boundaries),
+			 ztest_unit_test(test_large_message),
+			 ztest_unit_test(test_single_part),
+			 ztest_unit_test(test_address),
+			 ztest_unit_test(test_stream),
+			 ztest_unit_test(test_dontwait),
+			 ztest_unit_test(test_nonblock),
+			 ztest_unit_test(test_no_memory),
+			 ztest_unit_test(test_contention),
+			 ztest_unit_test(test_poll_set_ctl),
+			 ztest_unit_test(test_poll_set_wait),
+			 ztest_unit_test(test_poll_benchmark)
+			 );
+
+	ztest_run_test_suite(nrf91_sockets_test);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdlib.h>
+#include <ztest.h>
+#include <sys/byteorder.h>
+#include <st25r3911b_nfca.h>
+
+/* Bitwise reference implementation, NFC Forum Digital 2.0 6.4.1.3. */
+static uint16_t crc_ref(const uint8_t *data, size_t len)
+{
+	uint32_t crc = 0x6363;
+
+	for (size_t i = 0; i < len; i++) {
+		uint8_t byte = data[i];
+
+		byte = (byte ^ (uint8_t)(crc & 0x00FF));
+		byte = (byte ^ (byte << 4));
+		crc = (crc >> 8) ^ ((uint32_t)byte << 8) ^
+		      ((uint32_t)byte << 3) ^ ((uint32_t)byte >> 4);
+	}
+
+	return crc;
+}
+
+static uint16_t crc_get(const uint8_t *data, size_t len)
+{
+	struct st25r3911b_nfca_crc crc;
+
+	zassert_equal(st25r3911b_nfca_crc_calculate(data, len, &crc), 0,
+		      NULL);
+
+	return sys_get_be16(crc.crc);
+}
+
+static void test_known_vectors(void)
+{
+	/* ISO/IEC 14443-3 Annex B examples, and the HLTA command: */
+	const uint8_t zero[] = {0x00, 0x00};
+	const uint8_t bytes[] = {0x12, 0x34};
+	const uint8_t hlta[] = {0x50, 0x00};
+
+	zassert_equal(crc_get(zero, sizeof(zero)), 0x1EA0, NULL);
+	zassert_equal(crc_get(bytes, sizeof(bytes)), 0xCF26, NULL);
+	zassert_equal(crc_get(hlta, sizeof(hlta)), 0xCD57, NULL);
+}
+
+static void test_invalid_params(void)
+{
+	struct st25r3911b_nfca_crc crc;
+	const uint8_t data[] = {0x00};
+
+	zassert_equal(st25r3911b_nfca_crc_calculate(NULL, 1, &crc), -EINVAL,
+		      NULL);
+	zassert_equal(st25r3911b_nfca_crc_calculate(data, 0, &crc), -EINVAL,
+		      NULL);
+	zassert_equal(st25r3911b_nfca_crc_calculate(data, 1, NULL), -EINVAL,
+		      NULL);
+}
+
+static void test_reference(void)
+{
+	static uint8_t data[512];
+
+	srand(0);
+
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = rand();
+	}
+
+	/* All single byte values: */
+	for (size_t i = 0; i < 256; i++) {
+		uint8_t byte = i;
+
+		zassert_equal(crc_get(&byte, 1), crc_ref(&byte, 1),
+			      "Mismatch for 0x%02x", byte);
+	}
+
+	for (size_t len = 1; len <= sizeof(data); len++) {
+		zassert_equal(crc_get(data, len), crc_ref(data, len),
+			      "Mismatch for length %u", len);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(st25r3911b_nfca_crc_test,
+			 ztest_unit_test(test_known_vectors),
+			 ztest_unit_test(test_invalid_params),
+			 ztest_unit_test(test_reference)
+			 );
+
+	ztest_run_test_suite(st25r3911b_nfca_crc_test);
+}
@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdlib.h>
+#include <ztest.h>
+#include <light_ctrl_reg.h>
+
+/* Regulator step interval used for the trace replays (in milliseconds). */
+#define STEP_INT 100
+#define STEP_INT_MAX 1600
+
+/* Default Kconfig regulator coefficients */
+#define KIU 250.0f
+#define KID 25.0f
+#define KPU 80.0f
+#define KPD 80.0f
+#define ACCURACY 2
+
+#define TARGET_LUX 500.0f
+/* Illuminance added to the room by the light at full output */
+#define LIGHT_LUX 600.0f
+
+/* Largest accepted deviation between the two regulators' outputs. */
+#define OUTPUT_TOLERANCE (UINT16_MAX / 500)
+
+/* Ambient light traces, sampled every STEP_INT ms. The regulators see the
+ * trace value plus the contribution from their own output.
+ */
+#define TRACE_LEN 600
+
+enum trace {
+	TRACE_DARK,
+	TRACE_STABLE,
+	TRACE_SUNRISE,
+	TRACE_CLOUDS,
+	TRACE_SUNSET,
+	TRACE_COUNT,
+};
+
+struct reg_float {
+	float i;
+	float kiu, kid, kpu, kpd;
+};
+
+struct reg_fixed {
+	uint32_t i;
+	int32_t kiu, kid, kpu, kpd;
+};
+
+static float daylight(enum trace trace, int step)
+{
+	switch (trace) {
+	case TRACE_DARK:
+		return 0.0f;
+	case TRACE_STABLE:
+		return 200.0f;
+	case TRACE_SUNRISE:
+		return (700.0f * step) / TRACE_LEN;
+	case TRACE_CLOUDS:
+		/* Sunny with occasional clouds passing: */
+		return ((step / 50) % 3) ? 450.0f : 120.0f;
+	case TRACE_SUNSET:
+		return 700.0f - (700.0f * step) / TRACE_LEN;
+	default:
+		return 0.0f;
+	}
+}
+
+static float ambient_get(enum trace trace, int step, uint16_t output)
+{
+	return daylight(trace, step) + (output * LIGHT_LUX) / UINT16_MAX;
+}
+
+static void reg_float_init(struct reg_float *reg)
+{
+	reg->i = 0.0f;
+	reg->kiu = KIU;
+	reg->kid = KID;
+	reg->kpu = KPU;
+	reg->kpd = KPD;
+}
+
+static void reg_fixed_init(struct reg_fixed *reg)
+{
+	reg->i = 0;
+	reg->kiu = light_ctrl_reg_coeff_q16(KIU);
+	reg->kid = light_ctrl_reg_coeff_q16(KID);
+	reg->kpu = light_ctrl_reg_coeff_q16(KPU);
+	reg->kpd = light_ctrl_reg_coeff_q16(KPD);
+}
+
+static uint16_t reg_float_step(struct reg_float *reg, float ambient,
+			       uint32_t dt, bool *idle)
+{
+	float input = light_ctrl_reg_input(TARGET_LUX, ambient, ACCURACY);
+
+	*idle = (input == 0.0f);
+
+	if (input >= 0) {
+		return light_ctrl_reg_output(&reg->i, input, reg->kpu,
+					     reg->kiu, dt);
+	}
+
+	return light_ctrl_reg_output(&reg->i, input, reg->kpd, reg->kid, dt);
+}
+
+static uint16_t reg_fixed_step(struct reg_fixed *reg, float ambient,
+			       uint32_t dt, bool *idle)
+{
+	int32_t input = light_ctrl_reg_input_q16(TARGET_LUX * 100,
+						 ambient * 100, ACCURACY);
+
+	*idle = (input == 0);
+
+	if (input >= 0) {
+		return light_ctrl_reg_output_q16(&reg->i, input, reg->kpu,
+						 reg->kiu, dt);
+	}
+
+	return light_ctrl_reg_output_q16(&reg->i, input, reg->kpd, reg->kid,
+					 dt);
+}
+
+static void test_coeff_conversion(void)
+{
+	zassert_equal(light_ctrl_reg_coeff_q16(0.0f), 0, NULL);
+	zassert_equal(light_ctrl_reg_coeff_q16(-1.0f), 0, NULL);
+	zassert_equal(light_ctrl_reg_coeff_q16(1.0f), LIGHT_CTRL_REG_Q16_ONE,
+		      NULL);
+	zassert_equal(light_ctrl_reg_coeff_q16(0.5f),
+		      LIGHT_CTRL_REG_Q16_ONE / 2, NULL);
+	zassert_equal(light_ctrl_reg_coeff_q16(1000.0f),
+		      1000 * LIGHT_CTRL_REG_Q16_ONE, NULL);
+	zassert_equal(light_ctrl_reg_coeff_q16(1e9f), INT32_MAX, NULL);
+}
+
+static void test_input_dead_zone(void)
+{
+	/* 2 % accuracy on 500 lux is a dead zone of +-5 lux: */
+	zassert_equal(light_ctrl_reg_input(500.0f, 496.0f, 2), 0.0f, NULL);
+	zassert_equal(light_ctrl_reg_input(500.0f, 504.0f, 2), 0.0f, NULL);
+	zassert_equal(light_ctrl_reg_input(500.0f, 490.0f, 2), 5.0f, NULL);
+	zassert_equal(light_ctrl_reg_input(500.0f, 510.0f, 2), -5.0f, NULL);
+
+	zassert_equal(light_ctrl_reg_input_q16(50000, 49600, 2), 0, NULL);
+	zassert_equal(light_ctrl_reg_input_q16(50000, 50400, 2), 0, NULL);
+	zassert_equal(light_ctrl_reg_input_q16(50000, 49000, 2), 500, NULL);
+	zassert_equal(light_ctrl_reg_input_q16(50000, 51000, 2), -500, NULL);
+}
+
+static void test_output_range(void)
+{
+	struct reg_float f;
+	struct reg_fixed q;
+	bool idle;
+
+	reg_float_init(&f);
+	reg_fixed_init(&q);
+
+	/* Saturate upwards, then downwards. Both regulators must clamp to the
+	 * full output range.
+	 */
+	for (int i = 0; i < 100; i++) {
+		reg_float_step(&f, 0.0f, STEP_INT, &idle);
+		reg_fixed_step(&q, 0.0f, STEP_INT, &idle);
+	}
+
+	zassert_equal(reg_float_step(&f, 0.0f, STEP_INT, &idle), UINT16_MAX,
+		      NULL);
+	zassert_equal(reg_fixed_step(&q, 0.0f, STEP_INT, &idle), UINT16_MAX,
+		      NULL);
+	zassert_equal(f.i, UINT16_MAX, NULL);
+	zassert_equal(q.i, LIGHT_CTRL_REG_Q16_SUM_MAX, NULL);
+
+	for (int i = 0; i < 1000; i++) {
+		reg_float_step(&f, 100000.0f, STEP_INT, &idle);
+		reg_fixed_step(&q, 100000.0f, STEP_INT, &idle);
+	}
+
+	zassert_equal(reg_float_step(&f, 100000.0f, STEP_INT, &idle), 0, NULL);
+	zassert_equal(reg_fixed_step(&q, 100000.0f, STEP_INT, &idle), 0, NULL);
+	zassert_equal(f.i, 0.0f, NULL);
+	zassert_equal(q.i, 0, NULL);
+}
+
+static void test_trace_replay(void)
+{
+	for (enum trace trace = 0; trace < TRACE_COUNT; trace++) {
+		struct reg_float f;
+		struct reg_fixed q;
+		uint16_t out_f = 0;
+		uint16_t out_q = 0;
+		int max_diff = 0;
+		bool idle;
+
+		reg_float_init(&f);
+		reg_fixed_init(&q);
+
+		for (int step = 0; step < TRACE_LEN; step++) {
+			/* Both regulators are fed the ambient light caused by
+			 * the float regulator, so that they follow the same
+			 * trajectory:
+			 */
+			float ambient = ambient_get(trace, step, out_f);
+
+			out_f = reg_float_step(&f, ambient, STEP_INT, &idle);
+			out_q = reg_fixed_step(&q, ambient, STEP_INT, &idle);
+
+			max_diff = MAX(max_diff, abs(out_f - out_q));
+		}
+
+		TC_PRINT("Trace %u: max deviation %d\n", trace, max_diff);
+		zassert_true(max_diff <= OUTPUT_TOLERANCE,
+			     "Trace %u deviates by %d", trace, max_diff);
+	}
+}
+
+static void test_closed_loop(void)
+{
+	/* Run each regulator in its own feedback loop, and make sure both
+	 * settle within the dead zone on the stable trace:
+	 */
+	struct reg_float f;
+	struct reg_fixed q;
+	uint16_t out_f = 0;
+	uint16_t out_q = 0;
+	bool idle;
+
+	reg_float_init(&f);
+	reg_fixed_init(&q);
+
+	for (int step = 0; step < TRACE_LEN; step++) {
+		out_f = reg_float_step(
+			&f, ambient_get(TRACE_STABLE, step, out_f), STEP_INT,
+			&idle);
+		out_q = reg_fixed_step(
+			&q, ambient_get(TRACE_STABLE, step, out_q), STEP_INT,
+			&idle);
+	}
+
+	zassert_equal(light_ctrl_reg_input(
+			      TARGET_LUX, ambient_get(TRACE_STABLE, 0, out_f),
+			      ACCURACY),
+		      0.0f, NULL);
+	zassert_equal(light_ctrl_reg_input_q16(
+			      TARGET_LUX * 100,
+			      ambient_get(TRACE_STABLE, 0, out_q) * 100,
+			      ACCURACY),
+		      0, NULL);
+}
+
+static void test_adaptive_interval(void)
+{
+	zassert_equal(light_ctrl_reg_interval_next(STEP_INT, false, STEP_INT,
+						   STEP_INT_MAX),
+		      STEP_INT, NULL);
+	zassert_equal(light_ctrl_reg_interval_next(STEP_INT, true, STEP_INT,
+						   STEP_INT_MAX),
+		      2 * STEP_INT, NULL);
+	zassert_equal(light_ctrl_reg_interval_next(STEP_INT_MAX, true,
+						   STEP_INT, STEP_INT_MAX),
+		      STEP_INT_MAX, NULL);
+	zassert_equal(light_ctrl_reg_interval_next(STEP_INT_MAX, false,
+						   STEP_INT, STEP_INT_MAX),
+		      STEP_INT, NULL);
+
+	/* Replay the stable trace with the adaptive scheduler, and verify
+	 * that it settles with fewer steps than the fixed interval:
+	 */
+	struct reg_fixed q;
+	uint32_t interval = STEP_INT;
+	uint32_t steps = 0;
+	uint16_t out = 0;
+	bool idle;
+
+	reg_fixed_init(&q);
+
+	for (uint32_t t = 0; t < TRACE_LEN * STEP_INT; t += interval) {
+		float ambient = ambient_get(TRACE_STABLE, t / STEP_INT, out);
+
+		out = reg_fixed_step(&q, ambient, interval, &idle);
+		interval = light_ctrl_reg_interval_next(interval, idle,
+							STEP_INT, STEP_INT_MAX);
+		steps++;
+	}
+
+	TC_PRINT("Adaptive steps: %u (fixed: %u)\n", steps, TRACE_LEN);
+	zassert_true(steps < TRACE_LEN / 2, "Too many steps: %u", steps);
+	zassert_equal(light_ctrl_reg_input_q16(
+			      TARGET_LUX * 100,
+			      ambient_get(TRACE_STABLE, 0, out) * 100,
+			      ACCURACY),
+		      0, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(light_ctrl_reg_test,
+			 ztest_unit_test(test_coeff_conversion),
+			 ztest_unit_test(test_input_dead_zone),
+			 ztest_unit_test(test_output_range),
+			 ztest_unit_test(test_trace_replay),
+			 ztest_unit_test(test_closed_loop),
+			 ztest_unit_test(test_adaptive_interval)
+			 );
+
+	ztest_run_test_suite(light_ctrl_reg_test);
+}
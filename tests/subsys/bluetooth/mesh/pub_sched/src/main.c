@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <bluetooth/mesh.h>
+#include "pub_sched.h"
+#include "mesh/foundation.h"
+#include "mesh/access.h"
+
+#define SLOT_LEN CONFIG_BT_MESH_PUB_SCHED_SLOT
+#define QUEUE_SIZE CONFIG_BT_MESH_PUB_SCHED_QUEUE_SIZE
+#define MSG_SIZE CONFIG_BT_MESH_PUB_SCHED_MSG_SIZE
+#define PUB_BUF_SIZE 32
+#define MOD_COUNT 2
+#define SENT_MAX 16
+
+/* Waits until the deferred publications of the current slot are sent. */
+#define SLOT_WAIT K_MSEC(SLOT_LEN + 10)
+
+#define OP_A 0x01
+#define OP_B 0x02
+#define OP_2 0x82, 0x04
+#define OP_2_OTHER 0x82, 0x05
+
+static struct {
+	struct bt_mesh_model *mod;
+	uint8_t data[PUB_BUF_SIZE];
+	size_t len;
+} sent[SENT_MAX];
+static size_t sent_count;
+
+static bool provisioned;
+static int publish_err;
+static int32_t period[MOD_COUNT];
+
+static struct net_buf_simple pub_msg[MOD_COUNT];
+static uint8_t pub_msg_data[MOD_COUNT][PUB_BUF_SIZE];
+static struct bt_mesh_model_pub pub[MOD_COUNT];
+static struct bt_mesh_model mods[MOD_COUNT];
+
+/* Mocks of the mesh stack: */
+
+bool bt_mesh_is_provisioned(void)
+{
+	return provisioned;
+}
+
+uint8_t bt_mesh_net_transmit_get(void)
+{
+	return 0;
+}
+
+int bt_mesh_model_publish(struct bt_mesh_model *model)
+{
+	if (publish_err) {
+		return publish_err;
+	}
+
+	zassert_true(sent_count < SENT_MAX, "Too many publications");
+
+	/* The access layer retransmits the publish buffer: */
+	model->pub->count = BT_MESH_PUB_TRANSMIT_COUNT(model->pub->retransmit);
+
+	sent[sent_count].mod = model;
+	sent[sent_count].len = model->pub->msg->len;
+	memcpy(sent[sent_count].data, model->pub->msg->data,
+	       model->pub->msg->len);
+	sent_count++;
+
+	return 0;
+}
+
+int32_t bt_mesh_model_pub_period_get(struct bt_mesh_model *mod)
+{
+	return period[mod - mods];
+}
+
+void bt_mesh_model_foreach(void (*func)(struct bt_mesh_model *mod,
+					struct bt_mesh_elem *elem,
+					bool vnd, bool primary,
+					void *user_data),
+			   void *user_data)
+{
+	for (int i = 0; i < MOD_COUNT; i++) {
+		func(&mods[i], NULL, false, true, user_data);
+	}
+}
+
+static void pub_timeout(struct k_work *work)
+{
+}
+
+static uint32_t slot_remaining(void)
+{
+	return SLOT_LEN - (k_uptime_get_32() % SLOT_LEN);
+}
+
+/* Offset of the timer's expiry from the closest slot start, allowing for
+ * the extra tick added to the timeouts.
+ */
+static uint32_t slot_offset(struct k_delayed_work *timer)
+{
+	uint32_t deadline =
+		k_uptime_get_32() + k_delayed_work_remaining_get(timer) + 1;
+
+	return deadline % SLOT_LEN;
+}
+
+static void send(struct bt_mesh_model *mod, int expected, size_t len, ...)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, PUB_BUF_SIZE + 8);
+	va_list args;
+
+	va_start(args, len);
+	for (size_t i = 0; i < len; i++) {
+		net_buf_simple_add_u8(&buf, va_arg(args, int));
+	}
+	va_end(args);
+
+	zassert_equal(pub_sched_publish(mod, &buf), expected,
+		      "Unexpected return value");
+}
+
+static void expect_sent(int index, struct bt_mesh_model *mod, size_t len, ...)
+{
+	va_list args;
+
+	zassert_true(index < sent_count, "Publication %d not sent", index);
+	zassert_equal_ptr(sent[index].mod, mod, "Wrong model");
+	zassert_equal(sent[index].len, len, "Wrong length");
+
+	va_start(args, len);
+	for (int i = 0; i < len; i++) {
+		zassert_equal(sent[index].data[i], va_arg(args, int),
+			      "Wrong data at %d", i);
+	}
+	va_end(args);
+}
+
+static void setup(void)
+{
+	/* Flush anything left over from the previous test: */
+	k_sleep(SLOT_WAIT);
+
+	for (int i = 0; i < MOD_COUNT; i++) {
+		pub_msg[i].__buf = pub_msg_data[i];
+		pub_msg[i].size = PUB_BUF_SIZE;
+		net_buf_simple_reset(&pub_msg[i]);
+
+		k_delayed_work_cancel(&pub[i].timer);
+		pub[i].mod = &mods[i];
+		pub[i].msg = &pub_msg[i];
+		pub[i].addr = 0xc000;
+		pub[i].count = 0;
+		pub[i].retransmit = 0;
+		mods[i].id = 0x1000 + i;
+		mods[i].pub = &pub[i];
+		period[i] = 0;
+	}
+
+	provisioned = true;
+	publish_err = 0;
+	sent_count = 0;
+	bt_mesh_pub_sched_stats_reset();
+}
+
+static void test_deferred(void)
+{
+	struct bt_mesh_pub_sched_stats stats;
+
+	setup();
+
+	send(&mods[0], 0, 2, OP_A, 1);
+	zassert_equal(sent_count, 0, "Not deferred");
+
+	k_sleep(SLOT_WAIT);
+
+	zassert_equal(sent_count, 1, "Not sent");
+	expect_sent(0, &mods[0], 2, OP_A, 1);
+
+	bt_mesh_pub_sched_stats_get(&stats);
+	zassert_equal(stats.deferred, 1, "Wrong deferred count");
+	zassert_equal(stats.msgs, 1, "Wrong message count");
+	zassert_true(stats.airtime_us > 0, "No airtime");
+}
+
+static void test_same_opcode(void)
+{
+	struct bt_mesh_pub_sched_stats stats;
+
+	setup();
+
+	send(&mods[0], 0, 2, OP_A, 1);
+	send(&mods[0], 0, 2, OP_A, 2);
+	send(&mods[0], 0, 3, OP_2, 1);
+	send(&mods[0], 0, 3, OP_2, 2);
+	k_sleep(SLOT_WAIT);
+
+	/* Only the latest message for each opcode is sent: */
+	zassert_equal(sent_count, 2, "Wrong number of publications");
+	expect_sent(0, &mods[0], 2, OP_A, 2);
+	expect_sent(1, &mods[0], 3, OP_2, 2);
+
+	bt_mesh_pub_sched_stats_get(&stats);
+	zassert_equal(stats.deferred, 2, "Wrong deferred count");
+	zassert_equal(stats.superseded, 2, "Wrong superseded count");
+}
+
+static void test_different_messages(void)
+{
+	setup();
+
+	/* Messages with different opcodes or from different models are all
+	 * sent, in order:
+	 */
+	send(&mods[0], 0, 2, OP_A, 1);
+	send(&mods[0], 0, 2, OP_B, 2);
+	send(&mods[1], 0, 2, OP_A, 3);
+	send(&mods[0], 0, 3, OP_2_OTHER, 4);
+	k_sleep(SLOT_WAIT);
+
+	zassert_equal(sent_count, 4, "Wrong number of publications");
+	expect_sent(0, &mods[0], 2, OP_A, 1);
+	expect_sent(1, &mods[0], 2, OP_B, 2);
+	expect_sent(2, &mods[1], 2, OP_A, 3);
+	expect_sent(3, &mods[0], 3, OP_2_OTHER, 4);
+}
+
+static void test_retransmit(void)
+{
+	setup();
+
+	/* The messages from a model with a publication being retransmitted
+	 * wait for the retransmissions to end:
+	 */
+	pub[0].retransmit = BT_MESH_PUB_TRANSMIT(1, 50);
+	send(&mods[0], 0, 2, OP_A, 1);
+	send(&mods[0], 0, 2, OP_B, 2);
+	send(&mods[1], 0, 2, OP_A, 3);
+	k_sleep(SLOT_WAIT);
+
+	zassert_equal(sent_count, 2, "Wrong number of publications");
+	expect_sent(0, &mods[0], 2, OP_A, 1);
+	expect_sent(1, &mods[1], 2, OP_A, 3);
+
+	k_sleep(K_MSEC(SLOT_LEN));
+	zassert_equal(sent_count, 2, "Sent during retransmissions");
+
+	pub[0].count = 0;
+	k_sleep(SLOT_WAIT);
+
+	zassert_equal(sent_count, 3, "Not sent after retransmissions");
+	expect_sent(2, &mods[0], 2, OP_B, 2);
+}
+
+static void test_not_deferred(void)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, PUB_BUF_SIZE);
+	struct bt_mesh_pub_sched_stats stats;
+
+	setup();
+
+	/* Messages that don't fit in a queue entry are sent immediately: */
+	net_buf_simple_add_u8(&buf, OP_A);
+	net_buf_simple_add(&buf, MSG_SIZE);
+	zassert_equal(pub_sched_publish(&mods[0], &buf), 0, "Failed");
+	zassert_equal(sent_count, 1, "Not sent immediately");
+
+	/* Messages that don't fit in the queue are sent immediately: */
+	for (int i = 0; i < QUEUE_SIZE; i++) {
+		send(&mods[1], 0, 1, OP_A + i);
+	}
+
+	zassert_equal(sent_count, 1, "Sent too early");
+	send(&mods[1], 0, 1, OP_A + QUEUE_SIZE);
+	zassert_equal(sent_count, 2, "Not sent immediately");
+	expect_sent(1, &mods[1], 1, OP_A + QUEUE_SIZE);
+
+	/* Immediate publications are counted too: */
+	zassert_equal(pub_sched_publish_now(&mods[0], &buf), 0, "Failed");
+	zassert_equal(sent_count, 3, "Not sent immediately");
+
+	bt_mesh_pub_sched_stats_get(&stats);
+	zassert_equal(stats.msgs, 3, "Wrong message count");
+
+	k_sleep(SLOT_WAIT);
+	zassert_equal(sent_count, 3 + QUEUE_SIZE, "Queue not sent");
+}
+
+static void test_errors(void)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, PUB_BUF_SIZE + 8);
+	struct bt_mesh_pub_sched_stats stats;
+
+	setup();
+
+	net_buf_simple_add(&buf, PUB_BUF_SIZE + 1);
+	zassert_equal(pub_sched_publish(&mods[0], &buf), -EMSGSIZE,
+		      "Too long message accepted");
+
+	pub[0].addr = BT_MESH_ADDR_UNASSIGNED;
+	send(&mods[0], -EADDRNOTAVAIL, 1, OP_A);
+	pub[0].addr = 0xc000;
+
+	provisioned = false;
+	send(&mods[0], -EAGAIN, 1, OP_A);
+	provisioned = true;
+
+	/* Errors from immediate publications are returned: */
+	publish_err = -ENOBUFS;
+	for (int i = 0; i < QUEUE_SIZE; i++) {
+		send(&mods[0], 0, 1, OP_A + i);
+	}
+
+	send(&mods[0], -ENOBUFS, 1, OP_A + QUEUE_SIZE);
+
+	/* Errors from deferred publications are counted: */
+	k_sleep(SLOT_WAIT);
+
+	bt_mesh_pub_sched_stats_get(&stats);
+	zassert_equal(stats.failed, QUEUE_SIZE + 1, "Wrong failure count");
+	zassert_equal(stats.msgs, 0, "Failed messages counted as sent");
+	zassert_equal(sent_count, 0, "Failed messages sent");
+}
+
+static void test_periodic_align(void)
+{
+	setup();
+
+	/* Periodic publication pending, in the middle of a slot: */
+	period[0] = 1000;
+	k_delayed_work_submit(&pub[0].timer,
+			      K_MSEC(slot_remaining() + 4 * SLOT_LEN +
+				     SLOT_LEN / 4));
+
+	/* Retransmissions are not moved: */
+	period[1] = 1000;
+	pub[1].count = 2;
+	k_delayed_work_submit(&pub[1].timer,
+			      K_MSEC(slot_remaining() + 3 * SLOT_LEN +
+				     SLOT_LEN / 4));
+
+	send(&mods[0], 0, 1, OP_A);
+	k_sleep(SLOT_WAIT);
+	zassert_equal(sent_count, 1, "Not sent");
+
+	zassert_true(slot_offset(&pub[0].timer) <= 2,
+		     "Periodic publication not aligned");
+	zassert_true(slot_offset(&pub[1].timer) > 2, "Retransmission moved");
+
+	k_delayed_work_cancel(&pub[0].timer);
+	k_delayed_work_cancel(&pub[1].timer);
+}
+
+void test_main(void)
+{
+	for (int i = 0; i < MOD_COUNT; i++) {
+		k_delayed_work_init(&pub[i].timer, pub_timeout);
+	}
+
+	ztest_test_suite(pub_sched_test,
+			 ztest_unit_test(test_deferred),
+			 ztest_unit_test(test_same_opcode),
+			 ztest_unit_test(test_different_messages),
+			 ztest_unit_test(test_retransmit),
+			 ztest_unit_test(test_not_deferred),
+			 ztest_unit_test(test_errors),
+			 ztest_unit_test(test_periodic_align));
+
+	ztest_run_test_suite(pub_sched_test);
+}
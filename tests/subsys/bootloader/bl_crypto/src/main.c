@@ -5,6 +5,7 @@
  */
 
 #include <ztest.h>
+#include <linker/linker-defs.h>
 
 #include "bl_crypto.h"
 #include "test_vector.c"
@@ -175,6 +176,61 @@ void test_sha256(void)
 	test_sha256_string(hash_in, 65, hash_res65, true);
 }
 
+/* Length of the flash region hashed in test_sha256_flash(). */
+#define FLASH_HASH_LEN 0x8000
+
+static uint32_t sha256_chunked(uint8_t *output, const uint8_t *data,
+			uint32_t data_len, uint32_t chunk_len)
+{
+	bl_sha256_ctx_t ctx;
+	uint32_t start = k_cycle_get_32();
+	int rc = bl_sha256_init(&ctx);
+
+	zassert_equal(0, rc, "bl_sha256_init returned %d", rc);
+
+	for (uint32_t i = 0; i < data_len; i += chunk_len) {
+		rc = bl_sha256_update(&ctx, &data[i],
+				MIN(chunk_len, data_len - i));
+		zassert_equal(0, rc, "bl_sha256_update returned %d", rc);
+	}
+
+	rc = bl_sha256_finalize(&ctx, output);
+	zassert_equal(0, rc, "bl_sha256_finalize returned %d", rc);
+
+	return k_cyc_to_us_floor32(k_cycle_get_32() - start);
+}
+
+/* Hash a large region of flash, both in one go and in chunks of different
+ * sizes, and check that the results are identical. Prints the time spent on
+ * each for comparison.
+ */
+void test_sha256_flash(void)
+{
+	const uint8_t *data = (const uint8_t *)&_image_rom_start;
+	const uint32_t chunk_lens[] = {64, 0x400, 0x1000};
+	uint8_t expected[32];
+	uint8_t output[32];
+	uint32_t time_us;
+
+	time_us = sha256_chunked(expected, data, FLASH_HASH_LEN,
+				FLASH_HASH_LEN);
+	TC_PRINT("Hashed 0x%x bytes of flash in one update: %u us\n",
+		FLASH_HASH_LEN, time_us);
+
+	for (size_t i = 0; i < ARRAY_SIZE(chunk_lens); i++) {
+		time_us = sha256_chunked(output, data, FLASH_HASH_LEN,
+					chunk_lens[i]);
+		TC_PRINT("Hashed 0x%x bytes of flash in 0x%x byte chunks: %u us\n",
+			FLASH_HASH_LEN, chunk_lens[i], time_us);
+		zassert_mem_equal(expected, output, sizeof(output),
+				"Digest differs for chunk length 0x%x",
+				chunk_lens[i]);
+	}
+
+	zassert_equal(0, bl_sha256_verify(data, FLASH_HASH_LEN, expected),
+		NULL);
+}
+
 void test_bl_root_of_trust_verify(void)
 {
 
@@ -211,6 +267,7 @@ void test_main(void)
 	ztest_test_suite(test_bl_crypto,
 			 ztest_unit_test(test_bl_root_of_trust_verify),
 			 ztest_unit_test(test_sha256),
+			 ztest_unit_test(test_sha256_flash),
 			 ztest_unit_test(test_ecdsa_verify)
 	);
 	ztest_run_test_suite(test_bl_crypto);
@@ -9,6 +9,39 @@
 #include "bl_storage.h"
 #include "power/reboot.h"
 
+void test_validation_cache(void)
+{
+	uint8_t hash[VALIDATION_CACHE_HASH_LEN];
+	uint16_t num_entries = num_validation_cache_entries();
+	int ret;
+
+	zassert_equal(CONFIG_SB_NUM_VALIDATION_CACHE_ENTRIES, num_entries,
+		NULL);
+
+	for (int i = 0; i < sizeof(hash); i++) {
+		hash[i] = i;
+	}
+
+	zassert_false(validation_cache_check(hash, 1), NULL);
+	zassert_equal(-EINVAL, validation_cache_store(hash, 0xFFFF, 0), NULL);
+	ret = validation_cache_store(hash, 1, 0);
+	zassert_equal(0, ret, "ret %d\r\n", ret);
+	zassert_true(validation_cache_check(hash, 1), NULL);
+	zassert_false(validation_cache_check(hash, 2), NULL);
+
+	hash[sizeof(hash) - 1] ^= 0xFF;
+	zassert_false(validation_cache_check(hash, 1), NULL);
+
+	for (int i = 1; i < num_entries; i++) {
+		hash[0] = i;
+		zassert_equal(0, validation_cache_store(hash, 1, 0), NULL);
+		zassert_true(validation_cache_check(hash, 1), NULL);
+	}
+	hash[0] = num_entries;
+	zassert_equal(-ENOMEM, validation_cache_store(hash, 1, 0), NULL);
+	zassert_false(validation_cache_check(hash, 1), NULL);
+}
+
 void test_monotonic_counter(void)
 {
 	int ret;
@@ -40,6 +73,7 @@ void test_monotonic_counter(void)
 void test_main(void)
 {
 	ztest_test_suite(test_bl_storage,
+			 ztest_unit_test(test_validation_cache),
 			 ztest_unit_test(test_monotonic_counter)
 	);
 	ztest_run_test_suite(test_bl_storage);
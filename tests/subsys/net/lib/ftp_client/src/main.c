@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/ftp_client.h>
+
+/* The test runs a minimal FTP server on the loopback interface. It serves
+ * a single file held in memory, whatever the name, and can drop the
+ * connection in the middle of a transfer to exercise resuming.
+ */
+
+#define SERVER_ADDR		"127.0.0.1"
+#define SERVER_PORT		2121
+#define DATA_PORT		2122
+#define FILE_NAME		"test.bin"
+#define FILE_SIZE		100000
+#define DROP_AT_GET		40000
+#define DROP_AT_PUT		30000
+#define SERVER_CHUNK		1000
+
+#define SERVER_STACK_SIZE	4096
+#define SERVER_PRIORITY		K_PRIO_PREEMPT(5)
+#define CLIENT_STACK_SIZE	2048
+#define CLIENT_PRIORITY		K_PRIO_PREEMPT(5)
+
+static K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread;
+static K_SEM_DEFINE(server_ready, 0, 1);
+
+static struct {
+	uint8_t file[FILE_SIZE];
+	size_t file_len;
+	size_t rest;
+	/* File offset at which both connections are closed, 0 if never */
+	size_t drop_at;
+	/* Wait for a command after the first chunk of the next download */
+	bool wait_command;
+	/* A command was received during the last download */
+	bool pipelined;
+} server;
+
+static uint8_t src_data[FILE_SIZE];
+static uint8_t rx_data[FILE_SIZE];
+
+static K_THREAD_STACK_DEFINE(client_stack, CLIENT_STACK_SIZE);
+static struct k_thread client_thread;
+static K_SEM_DEFINE(transfer_started, 0, 1);
+static K_SEM_DEFINE(pwd_done, 0, 1);
+static int pwd_result;
+
+static int reply_codes[16];
+static int reply_count;
+
+static int send_all(int sock, const void *data, size_t len)
+{
+	const uint8_t *ptr = data;
+	int ret;
+
+	while (len > 0) {
+		ret = send(sock, ptr, len, 0);
+		if (ret < 0) {
+			return -errno;
+		}
+		ptr += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int server_reply(int sock, const char *msg)
+{
+	return send_all(sock, msg, strlen(msg));
+}
+
+static bool server_retr(int ctrl, int data_listen)
+{
+	struct pollfd fds[1];
+	size_t end = server.file_len;
+	size_t pos = server.rest;
+	bool drop = false;
+	int data;
+
+	if (server.drop_at > pos && server.drop_at < end) {
+		end = server.drop_at;
+		drop = true;
+		server.drop_at = 0;
+	}
+
+	server_reply(ctrl, "150 Opening BINARY mode data connection\r\n");
+	data = accept(data_listen, NULL, NULL);
+	if (data < 0) {
+		server_reply(ctrl, "425 Can't open data connection\r\n");
+		return true;
+	}
+	while (pos < end) {
+		size_t len = MIN(SERVER_CHUNK, end - pos);
+
+		if (send_all(data, server.file + pos, len)) {
+			break;
+		}
+		pos += len;
+
+		if (server.wait_command) {
+			server.wait_command = false;
+			fds[0].fd = ctrl;
+			fds[0].events = POLLIN;
+			server.pipelined = poll(fds, 1, 5 * MSEC_PER_SEC) > 0;
+		}
+	}
+	close(data);
+	server.rest = 0;
+	if (drop) {
+		return false;
+	}
+	server_reply(ctrl, "226 Transfer complete\r\n");
+
+	return true;
+}
+
+static bool server_stor(int ctrl, int data_listen)
+{
+	bool drop = false;
+	int data;
+	int ret;
+
+	server_reply(ctrl, "150 Ok to send data\r\n");
+	data = accept(data_listen, NULL, NULL);
+	if (data < 0) {
+		server_reply(ctrl, "425 Can't open data connection\r\n");
+		return true;
+	}
+	server.file_len = MIN(server.rest, server.file_len);
+	server.rest = 0;
+	while (server.file_len < sizeof(server.file)) {
+		ret = recv(data, server.file + server.file_len,
+			   sizeof(server.file) - server.file_len, 0);
+		if (ret <= 0) {
+			break;
+		}
+		server.file_len += ret;
+		if (server.drop_at > 0 && server.file_len >= server.drop_at) {
+			server.drop_at = 0;
+			drop = true;
+			break;
+		}
+	}
+	close(data);
+	if (drop) {
+		return false;
+	}
+	server_reply(ctrl, "226 Transfer complete\r\n");
+
+	return true;
+}
+
+static bool server_command(int ctrl, int data_listen, char *cmd)
+{
+	char buf[64];
+
+	if (strncmp(cmd, "USER", 4) == 0) {
+		server_reply(ctrl, "331 Please specify the password\r\n");
+	} else if (strncmp(cmd, "PASS", 4) == 0) {
+		server_reply(ctrl, "230 Login successful\r\n");
+	} else if (strncmp(cmd, "OPTS", 4) == 0 ||
+		   strncmp(cmd, "TYPE", 4) == 0 ||
+		   strncmp(cmd, "NOOP", 4) == 0) {
+		server_reply(ctrl, "200 OK\r\n");
+	} else if (strncmp(cmd, "PWD", 3) == 0) {
+		server_reply(ctrl, "257 \"/\" is the current directory\r\n");
+	} else if (strncmp(cmd, "SYST", 4) == 0) {
+		server_reply(ctrl, "215 UNIX Type: L8\r\n");
+	} else if (strncmp(cmd, "STAT", 4) == 0) {
+		server_reply(ctrl, "211-FTP server status:\r\n"
+				   "     Logged in\r\n"
+				   "211 End of status\r\n");
+	} else if (strncmp(cmd, "PASV", 4) == 0) {
+		snprintf(buf, sizeof(buf),
+			 "227 Entering Passive Mode (127,0,0,1,%d,%d)\r\n",
+			 DATA_PORT >> 8, DATA_PORT & 0xFF);
+		server_reply(ctrl, buf);
+	} else if (strncmp(cmd, "REST", 4) == 0) {
+		server.rest = strtoul(cmd + 5, NULL, 10);
+		server_reply(ctrl, "350 Restart position accepted\r\n");
+	} else if (strncmp(cmd, "SIZE", 4) == 0) {
+		snprintf(buf, sizeof(buf), "213 %u\r\n",
+			 (unsigned int)server.file_len);
+		server_reply(ctrl, buf);
+	} else if (strncmp(cmd, "RETR", 4) == 0) {
+		return server_retr(ctrl, data_listen);
+	} else if (strncmp(cmd, "STOR", 4) == 0) {
+		return server_stor(ctrl, data_listen);
+	} else if (strncmp(cmd, "QUIT", 4) == 0) {
+		server_reply(ctrl, "221 Goodbye\r\n");
+		return false;
+	} else {
+		server_reply(ctrl, "502 Command not implemented\r\n");
+	}
+
+	return true;
+}
+
+static void server_session(int ctrl, int data_listen)
+{
+	char buf[256];
+	size_t len = 0;
+	char *end;
+	int ret;
+
+	server_reply(ctrl, "220 Test server ready\r\n");
+	while (true) {
+		ret = recv(ctrl, buf + len, sizeof(buf) - len - 1, 0);
+		if (ret <= 0) {
+			return;
+		}
+		len += ret;
+		buf[len] = '\0';
+
+		/* Several commands can arrive at once */
+		while ((end = strstr(buf, "\r\n")) != NULL) {
+			*end = '\0';
+			if (!server_command(ctrl, data_listen, buf)) {
+				return;
+			}
+			len -= end + 2 - buf;
+			memmove(buf, end + 2, len + 1);
+		}
+	}
+}
+
+static int server_listen(uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port)
+	};
+	int sock;
+
+	inet_pton(AF_INET, SERVER_ADDR, &addr.sin_addr);
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(sock >= 0, "socket failed: %d", errno);
+	zassert_equal(bind(sock, (struct sockaddr *)&addr, sizeof(addr)), 0,
+		      "bind failed: %d", errno);
+	zassert_equal(listen(sock, 1), 0, "listen failed: %d", errno);
+
+	return sock;
+}
+
+static void server_run(void *p1, void *p2, void *p3)
+{
+	int ctrl_listen = server_listen(SERVER_PORT);
+	int data_listen = server_listen(DATA_PORT);
+	int ctrl;
+
+	k_sem_give(&server_ready);
+	while (true) {
+		ctrl = accept(ctrl_listen, NULL, NULL);
+		if (ctrl < 0) {
+			continue;
+		}
+		server_session(ctrl, data_listen);
+		close(ctrl);
+	}
+}
+
+static void ctrl_callback(const uint8_t *msg, uint16_t len)
+{
+	if (reply_count < ARRAY_SIZE(reply_codes)) {
+		reply_codes[reply_count++] = atoi((const char *)msg);
+	}
+}
+
+static void data_callback(const uint8_t *msg, uint16_t len)
+{
+}
+
+static int rx_consumer(size_t offset, const uint8_t *data, size_t len,
+		       void *user_data)
+{
+	zassert_true(offset + len <= sizeof(rx_data), "too much data");
+	memcpy(rx_data + offset, data, len);
+
+	return 0;
+}
+
+static int src_producer(size_t offset, uint8_t *buf, size_t size,
+			void *user_data)
+{
+	size_t len = MIN(size, sizeof(src_data) - offset);
+
+	memcpy(buf, src_data + offset, len);
+
+	return len;
+}
+
+static void connect_server(void)
+{
+	zassert_equal(ftp_open(SERVER_ADDR, SERVER_PORT, -1), FTP_CODE_200,
+		      "open failed");
+	zassert_equal(ftp_login("user", "password"), FTP_CODE_230,
+		      "login failed");
+	zassert_equal(ftp_type(FTP_TYPE_BINARY), FTP_CODE_200,
+		      "type failed");
+}
+
+static void test_init(void)
+{
+	for (int i = 0; i < sizeof(src_data); i++) {
+		src_data[i] = (i * 7) ^ (i >> 8);
+	}
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_run,
+			NULL, NULL, NULL, SERVER_PRIORITY, 0, K_NO_WAIT);
+	zassert_equal(k_sem_take(&server_ready, K_SECONDS(1)), 0,
+		      "server not started");
+
+	zassert_equal(ftp_init(ctrl_callback, data_callback), 0,
+		      "init failed");
+	connect_server();
+}
+
+static void test_status(void)
+{
+	/* SYST and STAT are pipelined, STAT has a multi-line reply */
+	reply_count = 0;
+	zassert_equal(ftp_status(), FTP_CODE_211, "status failed");
+	zassert_equal(reply_count, 2, "wrong number of replies");
+	zassert_equal(reply_codes[0], FTP_CODE_215, "wrong SYST reply");
+	zassert_equal(reply_codes[1], FTP_CODE_211, "wrong STAT reply");
+}
+
+static void test_put_get(void)
+{
+	size_t offset = 0;
+	size_t size = 0;
+
+	/* Larger than what fits a uint16_t length */
+	zassert_equal(ftp_put(FILE_NAME, src_data, sizeof(src_data)),
+		      FTP_CODE_226, "put failed");
+	zassert_equal(server.file_len, sizeof(src_data), "wrong size stored");
+	zassert_mem_equal(server.file, src_data, sizeof(src_data),
+			  "wrong data stored");
+
+	zassert_equal(ftp_size(FILE_NAME, &size), FTP_CODE_213,
+		      "size failed");
+	zassert_equal(size, sizeof(src_data), "wrong size");
+
+	memset(rx_data, 0, sizeof(rx_data));
+	zassert_equal(ftp_get_stream(FILE_NAME, &offset, rx_consumer, NULL),
+		      FTP_CODE_226, "get failed");
+	zassert_equal(offset, sizeof(src_data), "wrong size received");
+	zassert_mem_equal(rx_data, src_data, sizeof(src_data),
+			  "wrong data received");
+}
+
+static void test_get_resume(void)
+{
+	size_t offset = 0;
+	int ret;
+
+	memset(rx_data, 0, sizeof(rx_data));
+	server.drop_at = DROP_AT_GET;
+	ret = ftp_get_stream(FILE_NAME, &offset, rx_consumer, NULL);
+	zassert_true(ret < 0, "transfer not interrupted: %d", ret);
+	zassert_equal(offset, DROP_AT_GET, "wrong size received");
+
+	(void)ftp_close();
+	connect_server();
+
+	zassert_equal(ftp_get_stream(FILE_NAME, &offset, rx_consumer, NULL),
+		      FTP_CODE_226, "resume failed");
+	zassert_equal(offset, sizeof(src_data), "wrong size received");
+	zassert_mem_equal(rx_data, src_data, sizeof(src_data),
+			  "wrong data received");
+}
+
+static void test_put_resume(void)
+{
+	size_t offset = 0;
+	int ret;
+
+	memset(server.file, 0, sizeof(server.file));
+	server.file_len = 0;
+	server.drop_at = DROP_AT_PUT;
+	ret = ftp_put_stream(FILE_NAME, &offset, src_producer, NULL);
+	zassert_true(ret < 0, "transfer not interrupted: %d", ret);
+
+	(void)ftp_close();
+	connect_server();
+
+	/* Resume from what the server has stored */
+	zassert_equal(ftp_size(FILE_NAME, &offset), FTP_CODE_213,
+		      "size failed");
+	zassert_true(offset >= DROP_AT_PUT && offset <= sizeof(src_data),
+		     "wrong size stored: %u", (unsigned int)offset);
+	zassert_equal(ftp_put_stream(FILE_NAME, &offset, src_producer, NULL),
+		      FTP_CODE_226, "resume failed");
+	zassert_equal(offset, sizeof(src_data), "wrong size sent");
+	zassert_equal(server.file_len, sizeof(src_data), "wrong size stored");
+	zassert_mem_equal(server.file, src_data, sizeof(src_data),
+			  "wrong data stored");
+}
+
+static void pwd_client(void *p1, void *p2, void *p3)
+{
+	k_sem_take(&transfer_started, K_FOREVER);
+	pwd_result = ftp_pwd();
+	k_sem_give(&pwd_done);
+}
+
+static int start_consumer(size_t offset, const uint8_t *data, size_t len,
+			 void *user_data)
+{
+	if (offset == 0) {
+		/* Let the other thread send its command */
+		k_sem_give(&transfer_started);
+	}
+
+	return rx_consumer(offset, data, len, user_data);
+}
+
+static void test_pipelined_command(void)
+{
+	size_t offset = 0;
+
+	k_thread_create(&client_thread, client_stack,
+			K_THREAD_STACK_SIZEOF(client_stack), pwd_client,
+			NULL, NULL, NULL, CLIENT_PRIORITY, 0, K_NO_WAIT);
+
+	memset(rx_data, 0, sizeof(rx_data));
+	reply_count = 0;
+	server.pipelined = false;
+	server.wait_command = true;
+	zassert_equal(ftp_get_stream(FILE_NAME, &offset, start_consumer, NULL),
+		      FTP_CODE_226, "get failed");
+	zassert_equal(k_sem_take(&pwd_done, K_SECONDS(5)), 0,
+		      "pwd not completed");
+	zassert_equal(pwd_result, FTP_CODE_257, "pwd failed");
+	zassert_true(server.pipelined, "pwd not sent during the transfer");
+	zassert_mem_equal(rx_data, src_data, sizeof(src_data),
+			  "wrong data received");
+
+	/* PASV, then the replies in the order of the commands */
+	zassert_equal(reply_count, 3, "wrong number of replies");
+	zassert_equal(reply_codes[0], FTP_CODE_227, "wrong PASV reply");
+	zassert_equal(reply_codes[1], FTP_CODE_226, "wrong RETR reply");
+	zassert_equal(reply_codes[2], FTP_CODE_257, "wrong PWD reply");
+}
+
+static void test_close(void)
+{
+	zassert_equal(ftp_close(), FTP_CODE_221, "close failed");
+	zassert_equal(ftp_uninit(), 0, "uninit failed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(ftp_client_test,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_status),
+			 ztest_unit_test(test_put_get),
+			 ztest_unit_test(test_get_resume),
+			 ztest_unit_test(test_put_resume),
+			 ztest_unit_test(test_pipelined_command),
+			 ztest_unit_test(test_close)
+			 );
+
+	ztest_run_test_suite(ftp_client_test);
+}
@@ -0,0 +1,437 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ztest.h>
+#include <net/icalendar_parser.h>
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+#include <time.h>
+#endif
+
+#define MAX_PROPS		32
+#define MAX_EVENTS		8
+#define MAX_VALUE		1024
+#define FUZZ_ROUNDS		2000
+#define FUZZ_MAX_CHUNK		64
+#define BENCH_EVENTS		300
+#define BENCH_CHUNK		1024
+#define BENCH_ROUNDS		20
+
+#define DESC1 "The quarterly design review covers the new modem firmware, "
+#define DESC2 "the power profiling results from the field trials, and the "
+#define DESC3 "plan for the next release; bring your notes, questions and "
+#define DESC4 "any measurements: they help us decide, before the deadline."
+#define LONG_SUMMARY "A summary which is far too long to fit in the " \
+		     "component buffer of the parser"
+
+static const char calendar[] =
+	"BEGIN:VCALENDAR\r\n"
+	"VERSION:2.0\r\n"
+	"PRODID:-//Nordic Semiconductor//Test//EN\r\n"
+	"BEGIN:VTIMEZONE\r\n"
+	"TZID:Europe/Oslo\r\n"
+	"END:VTIMEZONE\r\n"
+	"BEGIN:VEVENT\r\n"
+	"DTSTART;TZID=Europe/Oslo:20201019T100000\r\n"
+	"DTEND;TZID=Europe/Oslo:20201019T110000\r\n"
+	"SUMMARY:Design review\r\n"
+	"LOCATION;ALTREP=\"http://example.com/room:1\":Room 1\r\n"
+	"DESCRIPTION:" DESC1 "\r\n " DESC2 "\r\n\t" DESC3 "\r\n " DESC4 "\r\n"
+	"BEGIN:VALARM\r\n"
+	"ACTION:DISPLAY\r\n"
+	"DESCRIPTION:Reminder\r\n"
+	"TRIGGER:-PT15M\r\n"
+	"END:VALARM\r\n"
+	"END:VEVENT\r\n"
+	"BEGIN:VTODO\r\n"
+	"SUMMARY:Not supported\r\n"
+	"END:VTODO\r\n"
+	"BEGIN:VEVENT\r\n"
+	"SUMMARY:" LONG_SUMMARY "\r\n"
+	"DTSTART:20201020T090000Z\r\n"
+	"END:VEVENT\r\n"
+	"END:VCALENDAR\r\n";
+
+#define CALENDAR_LEN	(sizeof(calendar) - 1)
+
+struct prop_record {
+	char name[CONFIG_ICAL_PARSER_NAME_SIZE + 1];
+	char params[CONFIG_ICAL_PARSER_PARAMS_SIZE + 1];
+	char value[MAX_VALUE + 1];
+	size_t len;
+	bool complete;
+};
+
+struct parse_result {
+	struct prop_record props[MAX_PROPS];
+	size_t prop_count;
+	struct ical_parser_evt events[MAX_EVENTS];
+	size_t event_count;
+};
+
+static struct parse_result reference;
+static struct parse_result result;
+static struct icalendar_parser parser;
+
+/* Input of the current parsing, to check that values are not copied */
+static const char *input;
+static size_t input_len;
+static int stop_after_events;
+static bool stop_on_slice;
+
+static char bench_calendar[BENCH_EVENTS * 512];
+static size_t bench_len;
+static size_t bench_event_count;
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+/* Simulated time does not advance while the CPU is busy, use the host clock
+ * instead.
+ */
+static uint64_t timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static uint64_t elapsed_ns(uint64_t start)
+{
+	return timestamp() - start;
+}
+#else
+static uint64_t timestamp(void)
+{
+	return k_cycle_get_32();
+}
+
+static uint64_t elapsed_ns(uint64_t start)
+{
+	return k_cyc_to_ns_floor64(k_cycle_get_32() - (uint32_t)start);
+}
+#endif
+
+static uint32_t rand_state = 2463534242;
+
+static uint32_t xorshift32(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+
+	return rand_state;
+}
+
+static int event_callback(const struct ical_parser_evt *evt)
+{
+	zassert_true(result.event_count < MAX_EVENTS, "Too many events");
+	result.events[result.event_count++] = *evt;
+
+	if (stop_after_events > 0 && --stop_after_events == 0) {
+		return 1;
+	}
+
+	return 0;
+}
+
+static int prop_callback(const struct ical_property *prop)
+{
+	struct prop_record *rec;
+
+	if (prop->len > 0) {
+		zassert_true(prop->value >= input &&
+			     prop->value + prop->len <= input + input_len,
+			     "Value copied");
+	}
+
+	if (prop->offset == 0 &&
+	    (result.prop_count == 0 ||
+	     result.props[result.prop_count - 1].complete)) {
+		zassert_true(result.prop_count < MAX_PROPS, "Too many props");
+		rec = &result.props[result.prop_count++];
+		memset(rec, 0, sizeof(*rec));
+		strcpy(rec->name, prop->name);
+		strcpy(rec->params, prop->params);
+	} else {
+		zassert_true(result.prop_count > 0, "No property");
+		rec = &result.props[result.prop_count - 1];
+	}
+
+	zassert_false(rec->complete, "Slice after the last one");
+	zassert_equal(prop->offset, rec->len, "Wrong offset");
+	zassert_true(rec->len + prop->len <= MAX_VALUE, "Value too long");
+	memcpy(rec->value + rec->len, prop->value, prop->len);
+	rec->len += prop->len;
+	rec->complete = prop->last;
+
+	return (stop_on_slice && !prop->last) ? 1 : 0;
+}
+
+static void parse_init(const char *data, size_t len)
+{
+	memset(&result, 0, sizeof(result));
+	input = data;
+	input_len = len;
+	stop_after_events = 0;
+	stop_on_slice = false;
+
+	zassert_equal(ical_parser_init(&parser, event_callback), 0, NULL);
+	zassert_equal(ical_parser_property_callback_set(&parser,
+							prop_callback), 0,
+		      NULL);
+}
+
+static void parse_chunk(const char *data, size_t len)
+{
+	zassert_equal(ical_parser_parse(&parser, data, len), len,
+		      "Not all parsed");
+}
+
+static void check_result(void)
+{
+	zassert_equal(result.prop_count, reference.prop_count,
+		      "Wrong number of properties");
+	zassert_equal(result.event_count, reference.event_count,
+		      "Wrong number of events");
+
+	for (size_t i = 0; i < result.prop_count; i++) {
+		const struct prop_record *rec = &result.props[i];
+		const struct prop_record *ref = &reference.props[i];
+
+		zassert_true(rec->complete, "Property %d not complete", (int)i);
+		zassert_equal(strcmp(rec->name, ref->name), 0, "Wrong name");
+		zassert_equal(strcmp(rec->params, ref->params), 0,
+			      "Wrong params");
+		zassert_equal(rec->len, ref->len, "Wrong value length");
+		zassert_mem_equal(rec->value, ref->value, rec->len,
+				  "Wrong value");
+	}
+	for (size_t i = 0; i < result.event_count; i++) {
+		zassert_mem_equal(&result.events[i], &reference.events[i],
+				  sizeof(struct ical_parser_evt),
+				  "Wrong event %d", (int)i);
+	}
+}
+
+static const struct prop_record *find_prop(const char *name,
+					   const char *value)
+{
+	for (size_t i = 0; i < reference.prop_count; i++) {
+		const struct prop_record *rec = &reference.props[i];
+
+		if (!strcmp(rec->name, name) &&
+		    (value == NULL || !strcmp(rec->value, value))) {
+			return rec;
+		}
+	}
+
+	return NULL;
+}
+
+static void test_whole(void)
+{
+	const struct ical_parser_evt *evt;
+	const struct prop_record *rec;
+
+	parse_init(calendar, CALENDAR_LEN);
+	parse_chunk(calendar, CALENDAR_LEN);
+	reference = result;
+
+	/* Every content line is a property */
+	zassert_equal(reference.prop_count, 26, "Wrong number of properties");
+
+	zassert_equal(reference.event_count, 4, "Wrong number of events");
+	zassert_equal(reference.events[0].id, ICAL_EVT_VTIMEZONE, NULL);
+	zassert_equal(reference.events[0].error,
+		      ICAL_ERROR_COM_NOT_SUPPORTED, NULL);
+	zassert_equal(reference.events[2].id, ICAL_EVT_VTODO, NULL);
+
+	evt = &reference.events[1];
+	zassert_equal(evt->id, ICAL_EVT_VEVENT, NULL);
+	zassert_equal(evt->error, ICAL_ERROR_NONE, NULL);
+	zassert_equal(strcmp(evt->ical_com.summary, "Design review"), 0,
+		      NULL);
+	zassert_equal(strcmp(evt->ical_com.location, "Room 1"), 0, NULL);
+	zassert_equal(strcmp(evt->ical_com.dtstart, "20201019T100000"), 0,
+		      NULL);
+	zassert_equal(strcmp(evt->ical_com.dtend, "20201019T110000"), 0,
+		      NULL);
+	/* Unfolded, and not overwritten by the nested VALARM */
+	zassert_equal(strcmp(evt->ical_com.description,
+			     DESC1 DESC2 DESC3 DESC4), 0, NULL);
+
+	evt = &reference.events[3];
+	zassert_equal(evt->id, ICAL_EVT_VEVENT, NULL);
+	zassert_equal(evt->error, ICAL_ERROR_SUMMARY, NULL);
+	zassert_equal(strcmp(evt->ical_com.dtstart, "20201020T090000Z"), 0,
+		      NULL);
+
+	/* Full values are available through the property callback */
+	zassert_not_null(find_prop("SUMMARY", LONG_SUMMARY), NULL);
+	rec = find_prop("LOCATION", NULL);
+	zassert_not_null(rec, NULL);
+	zassert_equal(strcmp(rec->params,
+			     "ALTREP=\"http://example.com/room:1\""), 0, NULL);
+	zassert_not_null(find_prop("END", "VCALENDAR"), NULL);
+}
+
+static void test_split_points(void)
+{
+	for (size_t split = 0; split <= CALENDAR_LEN; split++) {
+		parse_init(calendar, CALENDAR_LEN);
+		parse_chunk(calendar, split);
+		parse_chunk(calendar + split, CALENDAR_LEN - split);
+		check_result();
+	}
+}
+
+static void test_single_bytes(void)
+{
+	parse_init(calendar, CALENDAR_LEN);
+	for (size_t i = 0; i < CALENDAR_LEN; i++) {
+		parse_chunk(calendar + i, 1);
+	}
+	check_result();
+}
+
+static void test_fuzz_chunks(void)
+{
+	for (int round = 0; round < FUZZ_ROUNDS; round++) {
+		size_t pos = 0;
+
+		parse_init(calendar, CALENDAR_LEN);
+		while (pos < CALENDAR_LEN) {
+			size_t len = MIN(xorshift32() % (FUZZ_MAX_CHUNK + 1),
+					 CALENDAR_LEN - pos);
+
+			parse_chunk(calendar + pos, len);
+			pos += len;
+		}
+		check_result();
+	}
+}
+
+static void test_stop(void)
+{
+	size_t parsed;
+	size_t pos = 0;
+
+	parse_init(calendar, CALENDAR_LEN);
+	stop_after_events = 2;
+	parsed = ical_parser_parse(&parser, calendar, CALENDAR_LEN);
+	zassert_true(parsed < CALENDAR_LEN, "Parsing not stopped");
+	zassert_true(parser.stopped, "Stop not reported");
+	zassert_equal(result.event_count, 2, "Wrong number of events");
+	zassert_equal(strncmp(calendar + parsed - strlen("END:VEVENT\r\n"),
+			      "END:VEVENT\r\n", strlen("END:VEVENT\r\n")), 0,
+		      "Not stopped after the component");
+
+	/* The rest is parsed on the next call */
+	pos = parsed;
+	parsed = ical_parser_parse(&parser, calendar + pos,
+				   CALENDAR_LEN - pos);
+	zassert_equal(pos + parsed, CALENDAR_LEN, "Not all parsed");
+	zassert_false(parser.stopped, NULL);
+	check_result();
+}
+
+static void test_stop_end_of_data(void)
+{
+	size_t split = strlen("BEGIN:VCAL");
+	size_t parsed;
+
+	parse_init(calendar, CALENDAR_LEN);
+
+	/* Stopped by the slice at the end of the data, which is parsed */
+	stop_on_slice = true;
+	parsed = ical_parser_parse(&parser, calendar, split);
+	zassert_equal(parsed, split, "Slice not parsed");
+	zassert_true(parser.stopped, "Stop not reported");
+
+	stop_on_slice = false;
+	parse_chunk(calendar + split, CALENDAR_LEN - split);
+	zassert_false(parser.stopped, NULL);
+	check_result();
+}
+
+static void bench_init(void)
+{
+	for (int i = 0; i < BENCH_EVENTS; i++) {
+		bench_len += snprintf(bench_calendar + bench_len,
+				      sizeof(bench_calendar) - bench_len,
+				      "%s"
+				      "BEGIN:VEVENT\r\n"
+				      "DTSTART:20201019T%02d0000Z\r\n"
+				      "DTEND:20201019T%02d3000Z\r\n"
+				      "SUMMARY:Meeting %d\r\n"
+				      "LOCATION:Room %d\r\n"
+				      "DESCRIPTION:" DESC1 "\r\n " DESC2
+				      "\r\n " DESC3 "\r\n " DESC4 "\r\n"
+				      "END:VEVENT\r\n"
+				      "%s",
+				      i == 0 ? "BEGIN:VCALENDAR\r\n"
+					       "VERSION:2.0\r\n" : "",
+				      i % 24, i % 24, i, i % 10,
+				      i == BENCH_EVENTS - 1 ?
+					"END:VCALENDAR\r\n" : "");
+	}
+	zassert_true(bench_len < sizeof(bench_calendar), "Buffer too small");
+}
+
+static int bench_callback(const struct ical_parser_evt *evt)
+{
+	zassert_equal(evt->error, ICAL_ERROR_NONE, "Event error");
+	bench_event_count++;
+
+	return 0;
+}
+
+static void test_benchmark(void)
+{
+	uint64_t start;
+	uint64_t ns;
+
+	bench_init();
+
+	start = timestamp();
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		/* Fragments as received from download_client */
+		zassert_equal(ical_parser_init(&parser, bench_callback), 0,
+			      NULL);
+		for (size_t pos = 0; pos < bench_len; pos += BENCH_CHUNK) {
+			size_t len = MIN(BENCH_CHUNK, bench_len - pos);
+
+			zassert_equal(ical_parser_parse(&parser,
+							bench_calendar + pos,
+							len), len, NULL);
+		}
+	}
+	ns = elapsed_ns(start);
+
+	zassert_equal(bench_event_count, BENCH_EVENTS * BENCH_ROUNDS,
+		      "Wrong number of events");
+	TC_PRINT("Parsed %u bytes: %u kB/s\n",
+		 (uint32_t)(bench_len * BENCH_ROUNDS),
+		 (uint32_t)((uint64_t)bench_len * BENCH_ROUNDS * NSEC_PER_SEC /
+			    1024 / MAX(ns, 1)));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(icalendar_parser_test,
+			 ztest_unit_test(test_whole),
+			 ztest_unit_test(test_split_points),
+			 ztest_unit_test(test_single_bytes),
+			 ztest_unit_test(test_fuzz_chunks),
+			 ztest_unit_test(test_stop),
+			 ztest_unit_test(test_stop_end_of_data),
+			 ztest_unit_test(test_benchmark)
+			 );
+
+	ztest_run_test_suite(icalendar_parser_test);
+}
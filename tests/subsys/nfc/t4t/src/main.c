@@ -0,0 +1,583 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <sys/byteorder.h>
+#include <nfc/t4t/apdu.h>
+#include <nfc/t4t/cc_file.h>
+#include <nfc/t4t/hl_procedure.h>
+#include <nfc/t4t/isodep.h>
+
+#define NDEF_FILE_ID 0xE104
+#define NDEF_NLEN_SIZE 2
+#define NDEF_FILE_SIZE 4098
+#define NDEF_MSG_LEN 4000
+
+#define ISODEP_TX_BUF_SIZE 8192
+#define ISODEP_RX_BUF_SIZE 4608
+
+#define TAG_FRAME_MAX 4096
+#define TAG_CRC_LEN 2
+
+#define PCB_I_BLOCK 0x02
+#define PCB_R_ACK 0xA2
+#define PCB_BLOCK_NUM 0x01
+#define PCB_CHAINING BIT(4)
+#define PCB_TYPE_MASK 0xE2
+
+#define RATS_CMD 0xE0
+#define ATS_T0_TB_PRESENT BIT(5)
+
+#define INS_SELECT 0xA4
+#define INS_READ 0xB0
+#define INS_UPDATE 0xD6
+
+#define SW_OK 0x9000
+#define SW_WRONG_LENGTH 0x6700
+#define SW_NOT_FOUND 0x6A82
+#define SW_INS_NOT_SUPPORTED 0x6D00
+
+#define CC_FILE_ID 0xE103
+#define CC_FILE_LEN 15
+
+static const uint16_t frame_size_map[] = {16, 24, 32, 40, 48, 64, 96, 128, 256,
+					  512, 1024, 2048, 4096};
+
+/* Tag configuration used by a single test scenario. */
+struct tag_cfg {
+	enum nfc_t4t_isodep_fsd fsd;
+	uint8_t fsci;
+	uint16_t mle;
+	uint16_t mlc;
+	bool extended_apdu;
+};
+
+struct tag_stats {
+	uint32_t frames;
+	uint32_t apdus;
+	uint32_t cycles;
+};
+
+/* Simulated Type 4 Tag. */
+static struct {
+	const struct tag_cfg *cfg;
+	struct tag_stats stats;
+	uint16_t fsd;
+	uint16_t selected_file;
+	uint8_t cc[CC_FILE_LEN];
+	uint8_t ndef[NDEF_FILE_SIZE];
+
+	/* C-APDU received with chained I-blocks. */
+	uint8_t capdu[TAG_FRAME_MAX + 8];
+	size_t capdu_len;
+
+	/* R-APDU sent with chained I-blocks. */
+	uint8_t rapdu[NDEF_FILE_SIZE + 2];
+	size_t rapdu_len;
+	size_t rapdu_sent;
+
+	uint8_t block_num;
+} tag;
+
+/* Frame sent by the Reader/Writer, waiting for the tag. */
+static struct {
+	uint8_t data[TAG_FRAME_MAX];
+	size_t len;
+	bool pending;
+} reader_frame;
+
+static uint8_t tag_frame[TAG_FRAME_MAX];
+
+static uint8_t isodep_tx_buf[ISODEP_TX_BUF_SIZE];
+static uint8_t isodep_rx_buf[ISODEP_RX_BUF_SIZE];
+
+NFC_T4T_CC_DESC_DEF(t4t_cc, 1);
+
+static uint8_t ndef_buf[NDEF_FILE_SIZE];
+static uint8_t ndef_update_buf[NDEF_MSG_LEN + NDEF_NLEN_SIZE];
+static size_t ndef_read_len;
+static bool tag_selected;
+static bool hl_selected;
+static bool cc_read;
+static bool ndef_updated;
+static int transfer_err;
+
+static size_t rapdu_finish(uint16_t status, size_t data_len)
+{
+	sys_put_be16(status, &tag.rapdu[data_len]);
+
+	return data_len + sizeof(status);
+}
+
+static size_t apdu_process(const uint8_t *apdu, size_t len)
+{
+	uint8_t ins = apdu[1];
+	uint16_t offset = sys_get_be16(&apdu[2]);
+	const uint8_t *data = &apdu[5];
+	uint16_t lc = 0;
+	uint16_t le = 0;
+	const uint8_t *file;
+	size_t file_len;
+
+	tag.stats.apdus++;
+
+	/* Decode Lc and Le, ISO/IEC 7816-4 5.1. */
+	if (len == 5) {
+		le = apdu[4] ? apdu[4] : 256;
+	} else if ((len == 7) && (apdu[4] == 0)) {
+		le = sys_get_be16(&apdu[5]);
+	} else if (len > 5) {
+		if (apdu[4]) {
+			lc = apdu[4];
+		} else {
+			lc = sys_get_be16(&apdu[5]);
+			data = &apdu[7];
+		}
+	}
+
+	if ((!tag.cfg->extended_apdu) && ((len > 5 + 255) || (le > 256))) {
+		return rapdu_finish(SW_WRONG_LENGTH, 0);
+	}
+
+	switch (ins) {
+	case INS_SELECT:
+		if (offset == NFC_T4T_APDU_SELECT_BY_FILE_ID) {
+			tag.selected_file = sys_get_be16(data);
+		}
+
+		return rapdu_finish(SW_OK, 0);
+
+	case INS_READ:
+		if (tag.selected_file == CC_FILE_ID) {
+			file = tag.cc;
+			file_len = sizeof(tag.cc);
+		} else {
+			file = tag.ndef;
+			file_len = sizeof(tag.ndef);
+		}
+
+		if ((le > tag.cfg->mle) || (offset + le > file_len)) {
+			return rapdu_finish(SW_WRONG_LENGTH, 0);
+		}
+
+		memcpy(tag.rapdu, &file[offset], le);
+
+		return rapdu_finish(SW_OK, le);
+
+	case INS_UPDATE:
+		if (tag.selected_file != NDEF_FILE_ID) {
+			return rapdu_finish(SW_NOT_FOUND, 0);
+		}
+
+		if ((lc > tag.cfg->mlc) || (offset + lc > sizeof(tag.ndef))) {
+			return rapdu_finish(SW_WRONG_LENGTH, 0);
+		}
+
+		memcpy(&tag.ndef[offset], data, lc);
+
+		return rapdu_finish(SW_OK, 0);
+
+	default:
+		return rapdu_finish(SW_INS_NOT_SUPPORTED, 0);
+	}
+}
+
+static size_t tag_rapdu_chunk(void)
+{
+	/* The tag frame can not exceed FSD, including the CRC. */
+	size_t max = tag.fsd - TAG_CRC_LEN - 1;
+	size_t len = MIN(max, tag.rapdu_len - tag.rapdu_sent);
+
+	tag_frame[0] = PCB_I_BLOCK | tag.block_num;
+
+	if (tag.rapdu_sent + len < tag.rapdu_len) {
+		tag_frame[0] |= PCB_CHAINING;
+	}
+
+	memcpy(&tag_frame[1], &tag.rapdu[tag.rapdu_sent], len);
+	tag.rapdu_sent += len;
+
+	return len + 1;
+}
+
+static size_t tag_process(const uint8_t *frame, size_t len)
+{
+	uint8_t pcb = frame[0];
+
+	if (pcb == RATS_CMD) {
+		tag.fsd = frame_size_map[frame[1] >> 4];
+
+		/* ATS: TL, T0 and TB with FWI and SFGI set to 0. */
+		tag_frame[0] = 3;
+		tag_frame[1] = ATS_T0_TB_PRESENT | tag.cfg->fsci;
+		tag_frame[2] = 0;
+
+		return 3;
+	}
+
+	if ((pcb & PCB_TYPE_MASK) == PCB_I_BLOCK) {
+		zassert_true(len - 1 + tag.capdu_len <= sizeof(tag.capdu),
+			     "C-APDU too long");
+		zassert_true(len + TAG_CRC_LEN <= frame_size_map[tag.cfg->fsci],
+			     "Frame exceeds FSC");
+
+		memcpy(&tag.capdu[tag.capdu_len], &frame[1], len - 1);
+		tag.capdu_len += len - 1;
+		tag.block_num = pcb & PCB_BLOCK_NUM;
+
+		if (pcb & PCB_CHAINING) {
+			tag_frame[0] = PCB_R_ACK | tag.block_num;
+			return 1;
+		}
+
+		tag.rapdu_len = apdu_process(tag.capdu, tag.capdu_len);
+		tag.rapdu_sent = 0;
+		tag.capdu_len = 0;
+
+		return tag_rapdu_chunk();
+	}
+
+	if ((pcb & PCB_TYPE_MASK) == PCB_R_ACK) {
+		/* Continue chained R-APDU. */
+		tag.block_num = pcb & PCB_BLOCK_NUM;
+
+		return tag_rapdu_chunk();
+	}
+
+	zassert_unreachable("Unexpected frame 0x%02x", pcb);
+
+	return 0;
+}
+
+/* Exchange frames between the Reader/Writer and the tag until the Reader/Writer
+ * has nothing more to send.
+ */
+static void exchange_run(void)
+{
+	uint32_t start = k_cycle_get_32();
+	size_t len;
+	int err;
+
+	while (reader_frame.pending) {
+		reader_frame.pending = false;
+		tag.stats.frames++;
+
+		len = tag_process(reader_frame.data, reader_frame.len);
+
+		err = nfc_t4t_isodep_data_received(tag_frame, len, 0);
+		zassert_equal(err, 0, "ISO-DEP receive error %d", err);
+	}
+
+	tag.stats.cycles += k_cycle_get_32() - start;
+}
+
+static void isodep_data_received(const uint8_t *data, size_t data_len)
+{
+	int err = nfc_t4t_hl_procedure_on_data_received(data, data_len);
+
+	if (err) {
+		transfer_err = err;
+	}
+}
+
+static void isodep_selected(const struct nfc_t4t_isodep_tag *t4t_tag)
+{
+	tag_selected = true;
+}
+
+static void isodep_ready_to_send(uint8_t *data, size_t data_len, uint32_t ftd)
+{
+	zassert_false(reader_frame.pending, "Frame overrun");
+	zassert_true(data_len <= sizeof(reader_frame.data), NULL);
+
+	memcpy(reader_frame.data, data, data_len);
+	reader_frame.len = data_len;
+	reader_frame.pending = true;
+}
+
+static void isodep_error(int err)
+{
+	transfer_err = err;
+}
+
+static const struct nfc_t4t_isodep_cb isodep_cb = {
+	.data_received = isodep_data_received,
+	.selected = isodep_selected,
+	.ready_to_send = isodep_ready_to_send,
+	.error = isodep_error,
+};
+
+static void hl_selected_cb(enum nfc_t4t_hl_procedure_select type)
+{
+	hl_selected = true;
+}
+
+static void hl_cc_read(struct nfc_t4t_cc_file *cc)
+{
+	cc_read = true;
+}
+
+static void hl_ndef_read(uint16_t file_id, const uint8_t *data, size_t len)
+{
+	zassert_equal(file_id, NDEF_FILE_ID, NULL);
+	ndef_read_len = len;
+}
+
+static void hl_ndef_updated(uint16_t file_id)
+{
+	zassert_equal(file_id, NDEF_FILE_ID, NULL);
+	ndef_updated = true;
+}
+
+static const struct nfc_t4t_hl_procedure_cb hl_cb = {
+	.selected = hl_selected_cb,
+	.cc_read = hl_cc_read,
+	.ndef_read = hl_ndef_read,
+	.ndef_updated = hl_ndef_updated,
+};
+
+static void tag_init(const struct tag_cfg *cfg)
+{
+	uint8_t *cc = tag.cc;
+
+	memset(&tag, 0, sizeof(tag));
+	tag.cfg = cfg;
+
+	/* CC file with a single NDEF File Control TLV. */
+	sys_put_be16(CC_FILE_LEN, cc);
+	cc[2] = 0x20;
+	sys_put_be16(cfg->mle, &cc[3]);
+	sys_put_be16(cfg->mlc, &cc[5]);
+	cc[7] = NFC_T4T_TLV_BLOCK_TYPE_NDEF_FILE_CONTROL_TLV;
+	cc[8] = 6;
+	sys_put_be16(NDEF_FILE_ID, &cc[9]);
+	sys_put_be16(NDEF_FILE_SIZE, &cc[11]);
+	cc[13] = 0;
+	cc[14] = 0;
+
+	sys_put_be16(NDEF_MSG_LEN, tag.ndef);
+	for (size_t i = 0; i < NDEF_MSG_LEN; i++) {
+		tag.ndef[NDEF_NLEN_SIZE + i] = i * 7;
+	}
+
+	transfer_err = 0;
+	tag_selected = false;
+}
+
+static void step_check(bool *done)
+{
+	exchange_run();
+
+	zassert_equal(transfer_err, 0, "Transfer error %d", transfer_err);
+	zassert_true(*done, "Procedure not completed");
+
+	*done = false;
+}
+
+static void tag_session_run(const struct tag_cfg *cfg,
+			    struct tag_stats *read_stats,
+			    struct tag_stats *update_stats)
+{
+	int err;
+
+	tag_init(cfg);
+
+	err = nfc_t4t_isodep_rats_send(cfg->fsd, 0);
+	zassert_equal(err, 0, "RATS error %d", err);
+	step_check(&tag_selected);
+
+	/* Wait for the Frame Waiting Time after ATS. */
+	k_sleep(K_MSEC(2));
+
+	err = nfc_t4t_hl_procedure_ndef_tag_app_select();
+	zassert_equal(err, 0, NULL);
+	step_check(&hl_selected);
+
+	err = nfc_t4t_hl_procedure_cc_select();
+	zassert_equal(err, 0, NULL);
+	step_check(&hl_selected);
+
+	err = nfc_t4t_hl_procedure_cc_read(&NFC_T4T_CC_DESC(t4t_cc));
+	zassert_equal(err, 0, NULL);
+	step_check(&cc_read);
+
+	err = nfc_t4t_hl_procedure_ndef_file_select(NDEF_FILE_ID);
+	zassert_equal(err, 0, NULL);
+	step_check(&hl_selected);
+
+	/* NDEF Read procedure. */
+	memset(&tag.stats, 0, sizeof(tag.stats));
+	memset(ndef_buf, 0, sizeof(ndef_buf));
+
+	err = nfc_t4t_hl_procedure_ndef_read(&NFC_T4T_CC_DESC(t4t_cc), ndef_buf,
+					     sizeof(ndef_buf));
+	zassert_equal(err, 0, NULL);
+	exchange_run();
+
+	zassert_equal(transfer_err, 0, "Transfer error %d", transfer_err);
+	zassert_equal(ndef_read_len, NDEF_MSG_LEN + NDEF_NLEN_SIZE, NULL);
+	zassert_mem_equal(ndef_buf, tag.ndef, ndef_read_len, NULL);
+
+	*read_stats = tag.stats;
+
+	/* NDEF Update procedure. */
+	memset(&tag.stats, 0, sizeof(tag.stats));
+
+	sys_put_be16(NDEF_MSG_LEN, ndef_update_buf);
+	for (size_t i = 0; i < NDEF_MSG_LEN; i++) {
+		ndef_update_buf[NDEF_NLEN_SIZE + i] = i * 13;
+	}
+
+	err = nfc_t4t_hl_procedure_ndef_update(&NFC_T4T_CC_DESC(t4t_cc),
+					       ndef_update_buf,
+					       sizeof(ndef_update_buf));
+	zassert_equal(err, 0, NULL);
+	step_check(&ndef_updated);
+
+	zassert_mem_equal(tag.ndef, ndef_update_buf, sizeof(ndef_update_buf),
+			  NULL);
+
+	*update_stats = tag.stats;
+}
+
+static void test_apdu_extended_encode(void)
+{
+	int err;
+	uint8_t buf[300 + 9];
+	uint8_t data[300];
+	uint16_t len;
+	struct nfc_t4t_apdu_comm apdu;
+
+	/* Short Le. */
+	nfc_t4t_apdu_comm_clear(&apdu);
+	apdu.instruction = INS_READ;
+	apdu.parameter = 0x0102;
+	apdu.resp_len = 256;
+	len = sizeof(buf);
+
+	err = nfc_t4t_apdu_comm_encode(&apdu, buf, &len);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(len, 5, NULL);
+	zassert_equal(buf[4], 0x00, NULL);
+
+	/* Extended Le without Lc. */
+	apdu.resp_len = 1000;
+	len = sizeof(buf);
+
+	err = nfc_t4t_apdu_comm_encode(&apdu, buf, &len);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(len, 7, NULL);
+	zassert_equal(buf[4], 0x00, NULL);
+	zassert_equal(sys_get_be16(&buf[5]), 1000, NULL);
+
+	/* Extended Lc with Le, both fields in extended format. */
+	apdu.instruction = INS_UPDATE;
+	apdu.data.buff = data;
+	apdu.data.len = sizeof(data);
+	apdu.resp_len = 16;
+	len = sizeof(buf);
+
+	err = nfc_t4t_apdu_comm_encode(&apdu, buf, &len);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(len, 4 + 3 + sizeof(data) + 2, NULL);
+	zassert_equal(buf[4], 0x00, NULL);
+	zassert_equal(sys_get_be16(&buf[5]), sizeof(data), NULL);
+	zassert_equal(sys_get_be16(&buf[7 + sizeof(data)]), 16, NULL);
+
+	/* Not enough space in the buffer. */
+	len = sizeof(buf) - 1;
+
+	err = nfc_t4t_apdu_comm_encode(&apdu, buf, &len);
+	zassert_equal(err, -ENOMEM, NULL);
+}
+
+static void test_ndef_throughput(void)
+{
+	/* Tag limited to short frames and short APDUs. */
+	static const struct tag_cfg short_cfg = {
+		.fsd = NFC_T4T_ISODEP_FSD_256,
+		.fsci = 8,
+		.mle = 255,
+		.mlc = 255,
+		.extended_apdu = false,
+	};
+	/* Tag with 1 kB frames and extended length APDUs. The APDUs are
+	 * longer than the frames, so I-block chaining is used both ways.
+	 */
+	static const struct tag_cfg ext_cfg = {
+		.fsd = NFC_T4T_ISODEP_FSD_1024,
+		.fsci = 10,
+		.mle = 4000,
+		.mlc = 4000,
+		.extended_apdu = true,
+	};
+	/* Tag with 4 kB frames, each APDU fits in a single frame. */
+	static const struct tag_cfg large_cfg = {
+		.fsd = NFC_T4T_ISODEP_FSD_4096,
+		.fsci = 12,
+		.mle = 2048,
+		.mlc = 2048,
+		.extended_apdu = true,
+	};
+	struct tag_stats short_read, short_update;
+	struct tag_stats ext_read, ext_update;
+	struct tag_stats large_read, large_update;
+
+	tag_session_run(&short_cfg, &short_read, &short_update);
+	tag_session_run(&ext_cfg, &ext_read, &ext_update);
+	tag_session_run(&large_cfg, &large_read, &large_update);
+
+	TC_PRINT("NDEF read %u bytes: frames/APDUs/cycles\n", NDEF_MSG_LEN);
+	TC_PRINT("  short:    %u/%u/%u\n", short_read.frames, short_read.apdus,
+		 short_read.cycles);
+	TC_PRINT("  extended: %u/%u/%u\n", ext_read.frames, ext_read.apdus,
+		 ext_read.cycles);
+	TC_PRINT("  large:    %u/%u/%u\n", large_read.frames, large_read.apdus,
+		 large_read.cycles);
+	TC_PRINT("NDEF update %u bytes: frames/APDUs/cycles\n", NDEF_MSG_LEN);
+	TC_PRINT("  short:    %u/%u/%u\n", short_update.frames,
+		 short_update.apdus, short_update.cycles);
+	TC_PRINT("  extended: %u/%u/%u\n", ext_update.frames, ext_update.apdus,
+		 ext_update.cycles);
+	TC_PRINT("  large:    %u/%u/%u\n", large_update.frames,
+		 large_update.apdus, large_update.cycles);
+
+	zassert_true(ext_read.apdus < short_read.apdus, NULL);
+	zassert_true(ext_read.frames < short_read.frames, NULL);
+	zassert_true(ext_update.apdus < short_update.apdus, NULL);
+	zassert_true(ext_update.frames < short_update.frames, NULL);
+	zassert_true(large_read.frames <= ext_read.frames, NULL);
+	zassert_true(large_update.frames <= ext_update.frames, NULL);
+}
+
+static void test_fsd_unsupported(void)
+{
+	int err = nfc_t4t_isodep_rats_send(NFC_T4T_ISODEP_FSD_4096 + 1, 0);
+
+	zassert_equal(err, -EINVAL, NULL);
+}
+
+void test_main(void)
+{
+	int err;
+
+	err = nfc_t4t_isodep_init(isodep_tx_buf, sizeof(isodep_tx_buf),
+				  isodep_rx_buf, sizeof(isodep_rx_buf),
+				  &isodep_cb);
+	zassert_equal(err, 0, NULL);
+
+	err = nfc_t4t_hl_procedure_cb_register(&hl_cb);
+	zassert_equal(err, 0, NULL);
+
+	ztest_test_suite(nfc_t4t_test,
+			 ztest_unit_test(test_apdu_extended_encode),
+			 ztest_unit_test(test_ndef_throughput),
+			 ztest_unit_test(test_fsd_unsupported)
+			 );
+
+	ztest_run_test_suite(nfc_t4t_test);
+}
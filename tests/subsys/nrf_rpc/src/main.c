@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <nrf_rpc.h>
+#include "nrf_rpc_os.h"
+#include "nrf_rpc_rpmsg.h"
+#include "rp_ll.h"
+
+#define PACKET_SIZE	16
+#define LARGE_SIZE	(CONFIG_NRF_RPC_TR_LOOPBACK_BUF_SIZE + 1)
+#define EVENT_CNT	20
+#define REMOTE_THREADS	3
+#define BURST_CNT	100
+#define ROUND_TRIPS	1000
+#define RECEIVE_WAIT	K_MSEC(100)
+
+/* First byte of the test packets */
+enum packet_type {
+	PACKET_DATA,
+	PACKET_EVENT,
+	PACKET_PING,
+	PACKET_PONG,
+};
+
+static struct {
+	uint8_t data[BURST_CNT][PACKET_SIZE];
+	size_t len[BURST_CNT];
+	size_t cnt;
+} received;
+
+static K_SEM_DEFINE(received_sem, 0, BURST_CNT);
+static K_SEM_DEFINE(pong_sem, 0, 1);
+
+static int packet_send(enum packet_type type, uint8_t value, size_t len)
+{
+	uint8_t *buf;
+
+	nrf_rpc_tr_alloc_tx_buf(&buf, len);
+
+	memset(buf, value, len);
+	buf[0] = type;
+
+	return nrf_rpc_tr_send(buf, len);
+}
+
+static void receive_handler(const uint8_t *packet, size_t len)
+{
+	zassert_true(len > 0, "Empty packet");
+
+	switch (packet[0]) {
+	case PACKET_PING:
+		zassert_equal(packet_send(PACKET_PONG, 0, len), 0,
+			      "Pong not sent");
+		break;
+
+	case PACKET_PONG:
+		k_sem_give(&pong_sem);
+		break;
+
+	default:
+		zassert_true(received.cnt < BURST_CNT, "Too many packets");
+		zassert_true(len <= PACKET_SIZE, "Packet too long");
+
+		memcpy(received.data[received.cnt], packet, len);
+		received.len[received.cnt] = len;
+		received.cnt++;
+		k_sem_give(&received_sem);
+
+		/* Like the other core, once the event is handled. */
+		if (packet[0] == PACKET_EVENT) {
+			nrf_rpc_os_remote_release();
+		}
+		break;
+	}
+}
+
+static void received_wait(size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		zassert_equal(k_sem_take(&received_sem, RECEIVE_WAIT), 0,
+			      "Packet not received");
+	}
+
+	zassert_equal(k_sem_take(&received_sem, RECEIVE_WAIT), -EAGAIN,
+		      "Unexpected packet");
+}
+
+static void received_check(enum packet_type type, size_t cnt)
+{
+	zassert_equal(received.cnt, cnt, "Wrong packet count");
+
+	for (size_t i = 0; i < cnt; i++) {
+		zassert_equal(received.len[i], PACKET_SIZE, "Wrong length");
+		zassert_equal(received.data[i][0], type, "Wrong type");
+		zassert_equal(received.data[i][1], (uint8_t)i,
+			      "Wrong packet order");
+	}
+
+	received.cnt = 0;
+}
+
+static struct rp_ll_loopback_stats stats_get(void)
+{
+	struct rp_ll_loopback_stats stats;
+
+	rp_ll_loopback_stats_get(&stats);
+
+	return stats;
+}
+
+/* Sends an event the way nRF RPC does, holding a remote thread until the
+ * other core has handled it.
+ */
+static int event_send(uint8_t value)
+{
+	uint8_t *buf;
+	int err;
+
+	nrf_rpc_tr_alloc_tx_buf(&buf, PACKET_SIZE);
+
+	memset(buf, value, PACKET_SIZE);
+	buf[0] = PACKET_EVENT;
+
+	nrf_rpc_os_remote_reserve();
+
+	err = nrf_rpc_tr_send(buf, PACKET_SIZE);
+	if (err) {
+		nrf_rpc_os_remote_release();
+	}
+
+	return err;
+}
+
+static void thread_pool_handler(const uint8_t *data, size_t len)
+{
+}
+
+static void test_init(void)
+{
+	zassert_equal(nrf_rpc_os_init(thread_pool_handler), 0,
+		      "OS layer not initialized");
+	zassert_equal(nrf_rpc_tr_init(receive_handler), 0,
+		      "Transport not initialized");
+
+	/* Known to nRF RPC after the initialization. */
+	nrf_rpc_os_remote_count(REMOTE_THREADS);
+}
+
+static void test_zero_copy(void)
+{
+	uint8_t *buf;
+
+	rp_ll_loopback_stats_reset();
+
+	nrf_rpc_tr_alloc_tx_buf(&buf, PACKET_SIZE);
+	zassert_true(rp_ll_buf_is_shared(buf), "Not in shared memory");
+
+	memset(buf, 0, PACKET_SIZE);
+	buf[0] = PACKET_DATA;
+	zassert_equal(nrf_rpc_tr_send(buf, PACKET_SIZE), 0, "Not sent");
+
+	received_wait(1);
+	received_check(PACKET_DATA, 1);
+
+	zassert_equal(stats_get().packets, 1, "Wrong frame count");
+	zassert_equal(stats_get().copies, 0, "Packet copied");
+}
+
+static void test_large_packet(void)
+{
+	uint8_t *buf;
+
+	nrf_rpc_tr_alloc_tx_buf(&buf, LARGE_SIZE);
+	zassert_false(rp_ll_buf_is_shared(buf), "Too large for shared memory");
+
+	memset(buf, 0, LARGE_SIZE);
+	zassert_equal(nrf_rpc_tr_send(buf, LARGE_SIZE), -NRF_ENOMEM,
+		      "Too large packet sent");
+}
+
+static void test_free(void)
+{
+	uint8_t *buf;
+
+	rp_ll_loopback_stats_reset();
+
+	/* Unused buffers are given back, all of them can be used again. */
+	for (size_t i = 0; i < 2 * CONFIG_NRF_RPC_TR_LOOPBACK_BUF_COUNT; i++) {
+		nrf_rpc_tr_alloc_tx_buf(&buf, PACKET_SIZE);
+		zassert_true(rp_ll_buf_is_shared(buf), "No shared buffer");
+		nrf_rpc_tr_free_tx_buf(buf);
+	}
+
+	received_wait(0);
+	zassert_equal(received.cnt, 0, "Freed buffer received");
+}
+
+static void test_batch(void)
+{
+	struct rp_ll_loopback_stats stats;
+
+	rp_ll_loopback_stats_reset();
+
+	nrf_rpc_rpmsg_batch_begin();
+
+	for (size_t i = 0; i < EVENT_CNT; i++) {
+		zassert_equal(packet_send(PACKET_DATA, i, PACKET_SIZE), 0,
+			      "Not sent");
+	}
+
+	/* Nothing is sent before the batch ends. */
+	zassert_equal(k_sem_take(&received_sem, RECEIVE_WAIT), -EAGAIN,
+		      "Packet sent in batch");
+
+	zassert_equal(nrf_rpc_rpmsg_batch_end(), 0, "Batch not sent");
+
+	received_wait(EVENT_CNT);
+	received_check(PACKET_DATA, EVENT_CNT);
+
+	stats = stats_get();
+	zassert_equal(stats.packets, 1, "Packets not coalesced");
+	zassert_equal(stats.copies, 0, "Packets copied");
+}
+
+static void test_batch_overflow(void)
+{
+	uint8_t *buf;
+
+	rp_ll_loopback_stats_reset();
+
+	nrf_rpc_rpmsg_batch_begin();
+
+	/* More packets than fit in one frame, one too large for any frame. */
+	for (size_t i = 0; i < BURST_CNT - 1; i++) {
+		zassert_equal(packet_send(PACKET_DATA, i, PACKET_SIZE), 0,
+			      "Not sent");
+	}
+
+	nrf_rpc_tr_alloc_tx_buf(&buf, LARGE_SIZE);
+	zassert_false(rp_ll_buf_is_shared(buf), "Too large for shared memory");
+	nrf_rpc_tr_free_tx_buf(buf);
+
+	/* Nested batch */
+	nrf_rpc_rpmsg_batch_begin();
+	zassert_equal(packet_send(PACKET_DATA, BURST_CNT - 1, PACKET_SIZE), 0,
+		      "Not sent");
+	zassert_equal(nrf_rpc_rpmsg_batch_end(), 0, "Batch not sent");
+
+	zassert_equal(nrf_rpc_rpmsg_batch_end(), 0, "Batch not sent");
+
+	received_wait(BURST_CNT);
+	received_check(PACKET_DATA, BURST_CNT);
+
+	zassert_true(stats_get().packets > 1, "Frame overflow");
+	zassert_true(stats_get().packets < BURST_CNT / 2,
+		     "Packets not coalesced");
+}
+
+static void test_batch_remote_threads(void)
+{
+	rp_ll_loopback_stats_reset();
+
+	/* More events than there are threads to handle them on the other
+	 * core.
+	 */
+	nrf_rpc_rpmsg_batch_begin();
+
+	for (size_t i = 0; i < EVENT_CNT; i++) {
+		zassert_equal(event_send(i), 0, "Not sent");
+	}
+
+	zassert_equal(nrf_rpc_rpmsg_batch_end(), 0, "Batch not sent");
+
+	received_wait(EVENT_CNT);
+	received_check(PACKET_EVENT, EVENT_CNT);
+
+	zassert_true(stats_get().packets >= EVENT_CNT / REMOTE_THREADS,
+		     "Batch exceeds the remote threads");
+	zassert_true(stats_get().packets < EVENT_CNT, "Packets not coalesced");
+}
+
+static void test_benchmark(void)
+{
+	struct rp_ll_loopback_stats stats;
+	uint32_t start;
+	uint32_t elapsed_us;
+
+	rp_ll_loopback_stats_reset();
+	start = k_cycle_get_32();
+
+	for (size_t i = 0; i < ROUND_TRIPS; i++) {
+		zassert_equal(packet_send(PACKET_PING, 0, PACKET_SIZE), 0,
+			      "Ping not sent");
+		zassert_equal(k_sem_take(&pong_sem, RECEIVE_WAIT), 0,
+			      "No pong");
+	}
+
+	elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+	stats = stats_get();
+
+	zassert_equal(stats.packets, 2 * ROUND_TRIPS, "Wrong frame count");
+	zassert_equal(stats.copies, 0, "Packets copied");
+
+	TC_PRINT("%u round trips in %u us\n", ROUND_TRIPS, elapsed_us);
+	if (elapsed_us > 0) {
+		TC_PRINT("Round trip latency: %u us, %u calls/s\n",
+			 elapsed_us / ROUND_TRIPS,
+			 (uint32_t)((uint64_t)ROUND_TRIPS * USEC_PER_SEC /
+				    elapsed_us));
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_rpc_transport_test,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_zero_copy),
+			 ztest_unit_test(test_large_packet),
+			 ztest_unit_test(test_free),
+			 ztest_unit_test(test_batch),
+			 ztest_unit_test(test_batch_overflow),
+			 ztest_unit_test(test_batch_remote_threads),
+			 ztest_unit_test(test_benchmark)
+			 );
+
+	ztest_run_test_suite(nrf_rpc_transport_test);
+}
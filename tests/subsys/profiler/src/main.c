@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <sys/byteorder.h>
+#include <profiler.h>
+
+#define DATA_EVENTS		50
+#define BURST_EVENTS		1000
+#define DATA_ARGS		2
+#define ADDRESS_BASE		0x20001000
+#define RECORD_ID_DROPPED	0xFF
+#define FLUSH_WAIT		K_MSEC(2 * \
+				       CONFIG_PROFILER_NORDIC_FLUSH_PERIOD_MS)
+
+/* Size of a data event in the trace if it was not compacted */
+#define DATA_EVENT_SIZE		(sizeof(uint8_t) + sizeof(uint32_t) + \
+				 DATA_ARGS * sizeof(uint32_t))
+
+/* Commands sent by the host tools */
+enum command {
+	COMMAND_START	= 1,
+	COMMAND_STOP	= 2,
+	COMMAND_INFO	= 3
+};
+
+struct decoded_event {
+	uint8_t id;
+	uint32_t timestamp;
+	uint32_t args[DATA_ARGS];
+};
+
+static const char *data_names[] = {"value1", "value2"};
+static const enum profiler_arg data_types[] = {PROFILER_ARG_U32,
+					       PROFILER_ARG_S32};
+
+static uint16_t no_data_event_id;
+static uint16_t data_event_id;
+
+static uint8_t trace[CONFIG_PROFILER_NORDIC_DATA_BUFFER_SIZE];
+static size_t trace_len;
+
+static struct decoded_event events[BURST_EVENTS];
+static size_t event_cnt;
+static uint32_t dropped_cnt;
+
+/* Values the compact trace format deltas refer to */
+static struct {
+	uint32_t timestamp;
+	uint32_t args[DATA_ARGS];
+} last;
+
+static void profile_no_data_event(void)
+{
+	struct log_event_buf buf;
+
+	profiler_log_start(&buf);
+	profiler_log_send(&buf, no_data_event_id);
+}
+
+static void profile_data_event(uint32_t val1, int32_t val2)
+{
+	struct log_event_buf buf;
+
+	profiler_log_start(&buf);
+	profiler_log_encode_u32(&buf, val1);
+	profiler_log_encode_u32(&buf, val2);
+	profiler_log_send(&buf, data_event_id);
+}
+
+static void command_send(enum command command)
+{
+	zassert_equal(profiler_nordic_mem_command_write(command), 0,
+		      "Command not accepted");
+
+	if (command == COMMAND_START) {
+		memset(&last, 0, sizeof(last));
+	}
+
+	/* The command wakes up the profiler thread. */
+	k_sleep(FLUSH_WAIT);
+}
+
+static uint32_t varint_decode(const uint8_t **pos, const uint8_t *end)
+{
+	uint32_t value = 0;
+	uint8_t byte;
+
+	for (size_t shift = 0; ; shift += 7) {
+		zassert_true(*pos < end, "Truncated varint");
+		zassert_true(shift < 32, "Varint too long");
+
+		byte = *(*pos)++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80)) {
+			return value;
+		}
+	}
+}
+
+static uint32_t field_decode(const uint8_t **pos, const uint8_t *end,
+			     uint32_t *prev)
+{
+	uint32_t value;
+
+	if (!IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT)) {
+		zassert_true(end - *pos >= sizeof(uint32_t), "Truncated field");
+		value = sys_get_le32(*pos);
+		*pos += sizeof(uint32_t);
+		return value;
+	}
+
+	value = varint_decode(pos, end);
+	*prev += (value >> 1) ^ -(value & 1);
+
+	return *prev;
+}
+
+static void trace_read(void)
+{
+	const uint8_t *pos = trace;
+	const uint8_t *end;
+
+	k_sleep(FLUSH_WAIT);
+	trace_len = profiler_nordic_mem_data_read(trace, sizeof(trace));
+	end = trace + trace_len;
+
+	event_cnt = 0;
+	dropped_cnt = 0;
+
+	while (pos < end) {
+		struct decoded_event *evt = &events[event_cnt];
+		size_t arg_cnt = 0;
+
+		evt->id = *pos++;
+
+		if (IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT) &&
+		    (evt->id == RECORD_ID_DROPPED)) {
+			dropped_cnt += varint_decode(&pos, end);
+			continue;
+		}
+
+		zassert_true(event_cnt < ARRAY_SIZE(events), "Too many events");
+
+		if (evt->id == data_event_id) {
+			arg_cnt = DATA_ARGS;
+		} else {
+			zassert_equal(evt->id, no_data_event_id,
+				      "Unknown event type");
+		}
+
+		evt->timestamp = field_decode(&pos, end, &last.timestamp);
+		for (size_t i = 0; i < arg_cnt; i++) {
+			evt->args[i] = field_decode(&pos, end, &last.args[i]);
+		}
+
+		event_cnt++;
+	}
+}
+
+static void test_init(void)
+{
+	no_data_event_id = profiler_register_event_type("no data event", NULL,
+							NULL, 0);
+	data_event_id = profiler_register_event_type("data event", data_names,
+						     data_types, DATA_ARGS);
+
+	zassert_equal(profiler_init(), 0, "Profiler not initialized");
+}
+
+static void test_info(void)
+{
+	static const char expected[] =
+		"no data event,0\n"
+		"data event,1,u32,s32,value1,value2\n"
+		"\n";
+	char info[CONFIG_PROFILER_NORDIC_INFO_BUFFER_SIZE];
+	const char *descr = info;
+	size_t len;
+
+	command_send(COMMAND_INFO);
+
+	len = profiler_nordic_mem_info_read((uint8_t *)info,
+					    sizeof(info) - 1);
+	info[len] = '\0';
+
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT)) {
+		zassert_true(strncmp(descr, "!format,compact\n",
+				     strlen("!format,compact\n")) == 0,
+			     "No format line");
+		descr += strlen("!format,compact\n");
+	}
+
+	zassert_true(strcmp(descr, expected) == 0, "Wrong descriptions");
+}
+
+static void test_not_started(void)
+{
+	profile_no_data_event();
+	profile_data_event(ADDRESS_BASE, 0);
+
+	trace_read();
+	zassert_equal(trace_len, 0, "Events sent before start");
+}
+
+static void test_events(void)
+{
+	command_send(COMMAND_START);
+
+	for (size_t i = 0; i < DATA_EVENTS; i++) {
+		profile_no_data_event();
+		profile_data_event(ADDRESS_BASE + 16 * i, -(int32_t)i);
+	}
+
+	trace_read();
+	zassert_equal(event_cnt, 2 * DATA_EVENTS, "Events missing");
+	zassert_equal(dropped_cnt, 0, "Events dropped");
+
+	for (size_t i = 0; i < event_cnt; i++) {
+		const struct decoded_event *evt = &events[i];
+
+		if (i > 0) {
+			zassert_true(evt->timestamp >= events[i - 1].timestamp,
+				     "Wrong timestamp");
+		}
+
+		if (i % 2 == 0) {
+			zassert_equal(evt->id, no_data_event_id, "Wrong event");
+			continue;
+		}
+
+		zassert_equal(evt->id, data_event_id, "Wrong event");
+		zassert_equal(evt->args[0], ADDRESS_BASE + 16 * (i / 2),
+			      "Wrong value1");
+		zassert_equal((int32_t)evt->args[1], -(int32_t)(i / 2),
+			      "Wrong value2");
+	}
+
+	TC_PRINT("%u events in %zu bytes\n", 2 * DATA_EVENTS, trace_len);
+
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT)) {
+		zassert_true(2 * trace_len < DATA_EVENTS *
+			     (DATA_EVENT_SIZE + sizeof(uint8_t) +
+			      sizeof(uint32_t)), "Trace not compacted");
+	}
+}
+
+static void test_drops(void)
+{
+	/* No flush in between, most of the events do not fit in the staging
+	 * buffer.
+	 */
+	for (size_t i = 0; i < BURST_EVENTS; i++) {
+		profile_data_event(ADDRESS_BASE, i);
+	}
+
+	trace_read();
+	zassert_true(event_cnt > 0, "No events");
+	zassert_true(event_cnt < BURST_EVENTS, "No events dropped");
+
+	for (size_t i = 0; i < event_cnt; i++) {
+		zassert_equal(events[i].args[1], i, "Wrong event");
+	}
+
+	if (IS_ENABLED(CONFIG_PROFILER_NORDIC_COMPACT)) {
+		zassert_equal(event_cnt + dropped_cnt, BURST_EVENTS,
+			      "Dropped events not reported");
+	}
+
+	/* Events that fit are sent again. */
+	for (size_t i = 0; i < DATA_EVENTS; i++) {
+		profile_data_event(ADDRESS_BASE, i);
+	}
+
+	trace_read();
+	zassert_equal(event_cnt, DATA_EVENTS, "Events missing");
+	zassert_equal(dropped_cnt, 0, "Events dropped");
+}
+
+static void test_stop(void)
+{
+	command_send(COMMAND_STOP);
+
+	profile_no_data_event();
+	profile_data_event(ADDRESS_BASE, 0);
+
+	trace_read();
+	zassert_equal(trace_len, 0, "Events sent after stop");
+}
+
+static void test_term(void)
+{
+	profiler_term();
+}
+
+void test_main(void)
+{
+	ztest_test_suite(profiler_test,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_info),
+			 ztest_unit_test(test_not_started),
+			 ztest_unit_test(test_events),
+			 ztest_unit_test(test_drops),
+			 ztest_unit_test(test_stop),
+			 ztest_unit_test(test_term)
+			 );
+
+	ztest_run_test_suite(profiler_test);
+}